@@ -21,7 +21,11 @@
     for X in $(seq 1 $N_CLASSES); do echo "$STATES_PER_CLASS" >> ${RESULT_DIR}/hmm_definition.vector ; done
 
     ### LINEAR ALIGNMENT #######################################################
-    ./utils/linear_alignment.py data/${SPLIT}.train.labels data/${SPLIT}.train.transcripts ${RESULT_DIR}/hmm_definition.vector ${RESULT_DIR}/train.labels
+    OPTIONS="--hmm-estimation.hmm-file=${RESULT_DIR}/hmm_definition.vector \
+             --features.label-reader.feature-cache=data/${SPLIT}.train.transcripts \
+             --features.frame-label-reader.feature-cache=data/${SPLIT}.train.labels \
+             --features.label-writer.feature-cache=${RESULT_DIR}/train.labels"
+    ../../src/Hmm/hmm-tool --action=linear-alignment --log-file=log/linear-alignment.log $OPTIONS
 
 
 ################################################################################
@@ -54,8 +58,10 @@
         rm ${RESULT_DIR}/*epoch*
 
         ### TRANSITION PROBABILITY AND STATE PRIOR #############################
-        ./utils/transition_probabilities.py ${RESULT_DIR}/train.labels ${RESULT_DIR}/transition_probabilities.vector
-        ./utils/prior.py ${RESULT_DIR}/train.labels ${RESULT_DIR}/prior.vector
+        OPTIONS="--features.label-reader.feature-cache=${RESULT_DIR}/train.labels \
+                 --hmm-estimation.transition-probability-file=${RESULT_DIR}/transition_probabilities.vector \
+                 --hmm-estimation.prior-file=${RESULT_DIR}/prior.vector"
+        ../../src/Hmm/hmm-tool --action=estimate-hmm-parameters --log-file=log/estimation.iter-$ITER.log $OPTIONS
 
         ### REALIGNMENT ########################################################
         OPTIONS="--neural-network.output-layer.number-of-units=${N_HMM_STATES}"
@@ -66,8 +72,12 @@
         if [ $ITER -lt $MAX_ITER ]; then
             NEXT_ITER=$(( $ITER + 1 ))
             mkdir -p results/iter-${NEXT_ITER}
-            N_CLASSES=$(head -n1 ${RESULT_DIR}/hmm_definition.vector)
-            ./utils/reestimate_hmm.py log/realign.iter-${ITER}.log $N_CLASSES $FRAMES_PER_STATE results/iter-${NEXT_ITER}/hmm_definition.vector results/iter-${NEXT_ITER}/train.labels
+            OPTIONS="--hmm-estimation.hmm-file=${RESULT_DIR}/hmm_definition.vector \
+                     --hmm-estimation.frames-per-state=$FRAMES_PER_STATE \
+                     --hmm-estimation.new-hmm-file=results/iter-${NEXT_ITER}/hmm_definition.vector \
+                     --features.label-reader.feature-cache=${RESULT_DIR}/realignment.labels \
+                     --features.label-writer.feature-cache=results/iter-${NEXT_ITER}/train.labels"
+            ../../src/Hmm/hmm-tool --action=reestimate-hmm --log-file=log/reestimation.iter-$ITER.log $OPTIONS
         fi
 
     done
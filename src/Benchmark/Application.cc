@@ -0,0 +1,54 @@
+/*
+ * Copyright 2016 Alexander Richard
+ *
+ * This file is part of Squirrel.
+ *
+ * Licensed under the Academic Free License 3.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * You should have received a copy of the License along with Squirrel.
+ * If not, see <https://opensource.org/licenses/AFL-3.0>.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ */
+
+#include "Application.hh"
+#include "HashMapBenchmark.hh"
+#include "GruBenchmark.hh"
+#include "ReducedPrecisionBenchmark.hh"
+#include <iostream>
+
+using namespace Benchmark;
+
+APPLICATION(Benchmark::Application)
+
+const Core::ParameterEnum Application::paramAction_("action", "none, hash-map, gru, reduced-precision", "none");
+
+void Application::main() {
+
+	switch (Core::Configuration::config(paramAction_)) {
+	case hashMap:
+		{
+		HashMapBenchmark benchmark;
+		benchmark.run();
+		}
+		break;
+	case gru:
+		{
+		GruBenchmark benchmark;
+		benchmark.run();
+		}
+		break;
+	case reducedPrecision:
+		{
+		ReducedPrecisionBenchmark benchmark;
+		benchmark.run();
+		}
+		break;
+	case none:
+	default:
+		std::cerr << "No action given. Abort." << std::endl;
+		exit(1);
+	}
+}
@@ -0,0 +1,145 @@
+/*
+ * Copyright 2016 Alexander Richard
+ *
+ * This file is part of Squirrel.
+ *
+ * Licensed under the Academic Free License 3.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * You should have received a copy of the License along with Squirrel.
+ * If not, see <https://opensource.org/licenses/AFL-3.0>.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ */
+
+#include "GruBenchmark.hh"
+#include <Core/Utils.hh>
+#include <Math/Random.hh>
+
+using namespace Benchmark;
+
+const Core::ParameterInt GruBenchmark::paramNumberOfUnits_("number-of-units", 512, "benchmark");
+
+const Core::ParameterInt GruBenchmark::paramBatchSize_("batch-size", 32, "benchmark");
+
+const Core::ParameterInt GruBenchmark::paramNumberOfTimeframes_("number-of-timeframes", 200, "benchmark");
+
+GruBenchmark::GruBenchmark() :
+		nUnits_(Core::Configuration::config(paramNumberOfUnits_)),
+		batchSize_(Core::Configuration::config(paramBatchSize_)),
+		nTimeframes_(Core::Configuration::config(paramNumberOfTimeframes_))
+{
+	require_gt(nUnits_, 0);
+	require_gt(batchSize_, 0);
+	require_gt(nTimeframes_, 0);
+}
+
+void GruBenchmark::generateInput() {
+	input_.resize(4 * nTimeframes_);
+	for (u32 i = 0; i < input_.size(); i++) {
+		input_.at(i).resize(nUnits_, batchSize_);
+		for (u32 j = 0; j < input_.at(i).size(); j++)
+			input_.at(i).at(j % nUnits_, j / nUnits_) = Math::Random::random((Float)-2.0, (Float)2.0);
+	}
+	errorSignal_.resize(nUnits_, batchSize_);
+	for (u32 j = 0; j < errorSignal_.size(); j++)
+		errorSignal_.at(j % nUnits_, j / nUnits_) = Math::Random::random((Float)-1.0, (Float)1.0);
+	gates_.resize(4 * nTimeframes_);
+	output_.resize(nTimeframes_);
+	gateErrors_.resize(4);
+	for (u32 t = 0; t < nTimeframes_; t++)
+		output_.at(t).resize(nUnits_, batchSize_);
+	for (u32 i = 0; i < 4; i++)
+		gateErrors_.at(i).resize(nUnits_, batchSize_);
+}
+
+void GruBenchmark::loadInput() {
+	for (u32 i = 0; i < input_.size(); i++) {
+		gates_.at(i).resize(nUnits_, batchSize_);
+		gates_.at(i).copy(input_.at(i));
+	}
+}
+
+void GruBenchmark::composedForward(u32 t) {
+	Math::Matrix<f32>& h = output_.at(t);
+	gates_.at(4*t).sigmoid();
+	gates_.at(4*t + 1).sigmoid();
+	h.copy(gates_.at(4*t + 1));
+	h.elementwiseMultiplication(gates_.at(4*t + 3));
+	gates_.at(4*t + 2).add(h);
+	gates_.at(4*t + 2).tanh();
+	h.copy(gates_.at(4*t + 2));
+	if (t > 0)
+		h.add(output_.at(t-1), (f32)-1.0);
+	h.elementwiseMultiplication(gates_.at(4*t));
+	if (t > 0)
+		h.add(output_.at(t-1));
+}
+
+void GruBenchmark::composedBackward(u32 t) {
+	gateErrors_.at(0).copy(gates_.at(4*t + 2));
+	if (t > 0)
+		gateErrors_.at(0).add(output_.at(t-1), (f32)-1.0);
+	gateErrors_.at(0).elementwiseMultiplicationWithSigmoidDerivative(gates_.at(4*t));
+	gateErrors_.at(0).elementwiseMultiplication(errorSignal_);
+	gateErrors_.at(2).copy(errorSignal_);
+	gateErrors_.at(2).elementwiseMultiplicationWithTanhDerivative(gates_.at(4*t + 2));
+	gateErrors_.at(2).elementwiseMultiplication(gates_.at(4*t));
+	gateErrors_.at(1).copy(gateErrors_.at(2));
+	gateErrors_.at(1).elementwiseMultiplicationWithSigmoidDerivative(gates_.at(4*t + 1));
+	gateErrors_.at(1).elementwiseMultiplication(gates_.at(4*t + 3));
+	gateErrors_.at(3).copy(gateErrors_.at(2));
+	gateErrors_.at(3).elementwiseMultiplication(gates_.at(4*t + 1));
+}
+
+void GruBenchmark::fusedForward(u32 t) {
+	output_.at(t).gruForward(gates_.at(4*t), gates_.at(4*t + 1), gates_.at(4*t + 2), gates_.at(4*t + 3),
+			(t > 0 ? &(output_.at(t-1)) : 0));
+}
+
+void GruBenchmark::fusedBackward(u32 t) {
+	errorSignal_.gruBackward(gates_.at(4*t), gates_.at(4*t + 1), gates_.at(4*t + 2), gates_.at(4*t + 3),
+			(t > 0 ? &(output_.at(t-1)) : 0),
+			gateErrors_.at(0), gateErrors_.at(1), gateErrors_.at(2), gateErrors_.at(3));
+}
+
+void GruBenchmark::benchmark(bool fused) {
+	Core::Utils::Timer forwardTimer, backwardTimer;
+	loadInput();
+	forwardTimer.run();
+	for (u32 t = 0; t < nTimeframes_; t++) {
+		if (fused)
+			fusedForward(t);
+		else
+			composedForward(t);
+	}
+	forwardTimer.stop();
+	// the error signal of the output is the same for all timeframes, the recurrent part is not of interest here
+	backwardTimer.run();
+	for (s32 t = nTimeframes_ - 1; t >= 0; t--) {
+		if (fused)
+			fusedBackward(t);
+		else
+			composedBackward(t);
+	}
+	backwardTimer.stop();
+	f32 checksum = output_.back().sum();
+	for (u32 i = 0; i < 4; i++)
+		checksum += gateErrors_.at(i).sum();
+	Core::Log::openTag(fused ? "fused" : "composed");
+	Core::Log::os("forward: ") << forwardTimer.time() * 1000000.0 / nTimeframes_ << "us per timeframe";
+	Core::Log::os("backward: ") << backwardTimer.time() * 1000000.0 / nTimeframes_ << "us per timeframe";
+	Core::Log::os("checksum: ") << checksum;
+	Core::Log::closeTag();
+}
+
+void GruBenchmark::run() {
+	generateInput();
+	Core::Log::openTag("gru-benchmark");
+	Core::Log::os("Benchmark ") << nTimeframes_ << " timeframes of a gated recurrent unit layer with "
+			<< nUnits_ << " units and batch size " << batchSize_ << ".";
+	benchmark(false);
+	benchmark(true);
+	Core::Log::closeTag();
+}
@@ -0,0 +1,60 @@
+/*
+ * Copyright 2016 Alexander Richard
+ *
+ * This file is part of Squirrel.
+ *
+ * Licensed under the Academic Free License 3.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * You should have received a copy of the License along with Squirrel.
+ * If not, see <https://opensource.org/licenses/AFL-3.0>.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ */
+
+#ifndef BENCHMARK_GRUBENCHMARK_HH_
+#define BENCHMARK_GRUBENCHMARK_HH_
+
+#include <Core/CommonHeaders.hh>
+#include <Math/Matrix.hh>
+
+namespace Benchmark {
+
+/*
+ * GruBenchmark
+ * compares the per-timeframe latency of the gated recurrent unit computations (without the matrix products),
+ * once composed of the single matrix operations and once with the fused kernels Math::Matrix::gruForward/gruBackward
+ */
+class GruBenchmark
+{
+private:
+	static const Core::ParameterInt paramNumberOfUnits_;
+	static const Core::ParameterInt paramBatchSize_;
+	static const Core::ParameterInt paramNumberOfTimeframes_;
+	u32 nUnits_;
+	u32 batchSize_;
+	u32 nTimeframes_;
+	// pre-activations of update gate, reset gate, candidate, and recurrent candidate, and the output error signal
+	std::vector< Math::Matrix<f32> > input_;
+	Math::Matrix<f32> errorSignal_;
+	// working matrices
+	std::vector< Math::Matrix<f32> > gates_;
+	std::vector< Math::Matrix<f32> > output_;
+	std::vector< Math::Matrix<f32> > gateErrors_;
+	void generateInput();
+	void loadInput();
+	void composedForward(u32 t);
+	void composedBackward(u32 t);
+	void fusedForward(u32 t);
+	void fusedBackward(u32 t);
+	void benchmark(bool fused);
+public:
+	GruBenchmark();
+	virtual ~GruBenchmark() {}
+	void run();
+};
+
+} // namespace
+
+#endif /* BENCHMARK_GRUBENCHMARK_HH_ */
@@ -0,0 +1,100 @@
+/*
+ * Copyright 2016 Alexander Richard
+ *
+ * This file is part of Squirrel.
+ *
+ * Licensed under the Academic Free License 3.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * You should have received a copy of the License along with Squirrel.
+ * If not, see <https://opensource.org/licenses/AFL-3.0>.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ */
+
+#include "HashMapBenchmark.hh"
+#include <Core/HashMap.hh>
+#include <Core/FlatHashMap.hh>
+#include <Core/Utils.hh>
+#include <Math/Random.hh>
+
+using namespace Benchmark;
+
+namespace {
+
+class Key {
+public:
+	u32 key;
+	Key() : key(0) {}
+	Key(u32 _key) : key(_key) {}
+	bool operator==(const Key& k) const { return key == k.key; }
+	static u32 hash(const Key& k) { return 31 * k.key; }
+};
+
+class KeyHash {
+public:
+	u32 operator()(const Key& k) const { return Core::hashMix(Key::hash(k)); }
+};
+
+} // namespace
+
+const Core::ParameterInt HashMapBenchmark::paramNumberOfKeys_("number-of-keys", 100000, "benchmark");
+
+const Core::ParameterInt HashMapBenchmark::paramNumberOfRepetitions_("number-of-repetitions", 100, "benchmark");
+
+HashMapBenchmark::HashMapBenchmark() :
+		nKeys_(Core::Configuration::config(paramNumberOfKeys_)),
+		nRepetitions_(Core::Configuration::config(paramNumberOfRepetitions_))
+{
+	require_gt(nKeys_, 0);
+	require_gt(nRepetitions_, 0);
+}
+
+void HashMapBenchmark::generateKeys() {
+	keys_.resize(nKeys_);
+	// each key occurs twice on average, i.e. half of the insertions are updates of existing entries
+	for (u32 i = 0; i < nKeys_; i++)
+		keys_.at(i) = Math::Random::randomInt((u32)0, nKeys_ / 2);
+}
+
+template<class T>
+void HashMapBenchmark::benchmark(T& map, const std::string& name) {
+	Core::Utils::Timer insertTimer, findTimer, clearTimer;
+	u32 nFound = 0;
+	for (u32 r = 0; r < nRepetitions_; r++) {
+		insertTimer.run();
+		for (u32 i = 0; i < nKeys_; i++)
+			map.insert(Key(keys_[i]), (Float)i);
+		insertTimer.stop();
+		findTimer.run();
+		for (u32 i = 0; i < nKeys_; i++)
+			nFound += (map.find(Key(i)) != 0 ? 1 : 0);
+		findTimer.stop();
+		clearTimer.run();
+		map.clear();
+		clearTimer.stop();
+	}
+	Float nOperations = (Float)nKeys_ * nRepetitions_;
+	Core::Log::openTag(name.c_str());
+	Core::Log::os("insert: ") << insertTimer.time() << "s (" << nOperations / std::max(insertTimer.time(), (Float)0.001) << " operations/s)";
+	Core::Log::os("find: ") << findTimer.time() << "s (" << nOperations / std::max(findTimer.time(), (Float)0.001) << " operations/s)";
+	Core::Log::os("clear: ") << clearTimer.time() << "s for " << nRepetitions_ << " calls";
+	Core::Log::os("found ") << nFound / nRepetitions_ << " of " << nKeys_ << " keys";
+	Core::Log::closeTag();
+}
+
+void HashMapBenchmark::run() {
+	generateKeys();
+	Core::Log::openTag("hash-map-benchmark");
+	Core::Log::os("Benchmark ") << nKeys_ << " insertions and lookups, " << nRepetitions_ << " repetitions.";
+	{
+		Core::HashMap<Key, Float> map(Key::hash);
+		benchmark(map, "hash-map");
+	}
+	{
+		Core::FlatHashMap<Key, Float, KeyHash> map;
+		benchmark(map, "flat-hash-map");
+	}
+	Core::Log::closeTag();
+}
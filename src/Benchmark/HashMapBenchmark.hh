@@ -0,0 +1,47 @@
+/*
+ * Copyright 2016 Alexander Richard
+ *
+ * This file is part of Squirrel.
+ *
+ * Licensed under the Academic Free License 3.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * You should have received a copy of the License along with Squirrel.
+ * If not, see <https://opensource.org/licenses/AFL-3.0>.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ */
+
+#ifndef BENCHMARK_HASHMAPBENCHMARK_HH_
+#define BENCHMARK_HASHMAPBENCHMARK_HH_
+
+#include <Core/CommonHeaders.hh>
+
+namespace Benchmark {
+
+/*
+ * HashMapBenchmark
+ * compares insert/find/clear throughput of Core::HashMap and Core::FlatHashMap
+ * the access pattern mimics the Viterbi decoding: fill the map with (partially colliding) keys, look them up, clear the map
+ */
+class HashMapBenchmark
+{
+private:
+	static const Core::ParameterInt paramNumberOfKeys_;
+	static const Core::ParameterInt paramNumberOfRepetitions_;
+	u32 nKeys_;
+	u32 nRepetitions_;
+	std::vector<u32> keys_;
+	void generateKeys();
+	template<class T>
+	void benchmark(T& map, const std::string& name);
+public:
+	HashMapBenchmark();
+	virtual ~HashMapBenchmark() {}
+	void run();
+};
+
+} // namespace
+
+#endif /* BENCHMARK_HASHMAPBENCHMARK_HH_ */
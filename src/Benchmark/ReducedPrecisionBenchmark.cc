@@ -0,0 +1,122 @@
+/*
+ * Copyright 2016 Alexander Richard
+ *
+ * This file is part of Squirrel.
+ *
+ * Licensed under the Academic Free License 3.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * You should have received a copy of the License along with Squirrel.
+ * If not, see <https://opensource.org/licenses/AFL-3.0>.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ */
+
+#include "ReducedPrecisionBenchmark.hh"
+#include <Core/Utils.hh>
+#include <Math/Random.hh>
+
+using namespace Benchmark;
+
+const Core::ParameterInt ReducedPrecisionBenchmark::paramNumberOfInputs_("number-of-inputs", 1024, "benchmark");
+
+const Core::ParameterInt ReducedPrecisionBenchmark::paramNumberOfOutputs_("number-of-outputs", 1024, "benchmark");
+
+const Core::ParameterInt ReducedPrecisionBenchmark::paramBatchSize_("batch-size", 16, "benchmark");
+
+const Core::ParameterInt ReducedPrecisionBenchmark::paramNumberOfIterations_("number-of-iterations", 100, "benchmark");
+
+ReducedPrecisionBenchmark::ReducedPrecisionBenchmark() :
+		nInputs_(Core::Configuration::config(paramNumberOfInputs_)),
+		nOutputs_(Core::Configuration::config(paramNumberOfOutputs_)),
+		batchSize_(Core::Configuration::config(paramBatchSize_)),
+		nIterations_(Core::Configuration::config(paramNumberOfIterations_)),
+		referenceTime_(0)
+{
+	require_gt(nInputs_, 0);
+	require_gt(nOutputs_, 0);
+	require_gt(batchSize_, 0);
+	require_gt(nIterations_, 0);
+}
+
+void ReducedPrecisionBenchmark::generateInput() {
+	// weights as after a typical random initialization, inputs in the range of sigmoid activations
+	weights_.resize(nInputs_, nOutputs_);
+	for (u32 j = 0; j < nOutputs_; j++) {
+		for (u32 i = 0; i < nInputs_; i++)
+			weights_.at(i, j) = Math::Random::random((f32)-0.1, (f32)0.1);
+	}
+	input_.resize(nInputs_, batchSize_);
+	for (u32 j = 0; j < batchSize_; j++) {
+		for (u32 i = 0; i < nInputs_; i++)
+			input_.at(i, j) = Math::Random::random((f32)0.0, (f32)1.0);
+	}
+	reference_.resize(nOutputs_, batchSize_);
+	output_.resize(nOutputs_, batchSize_);
+}
+
+void ReducedPrecisionBenchmark::benchmarkFullPrecision() {
+	Core::Utils::Timer timer;
+	timer.run();
+	for (u32 n = 0; n < nIterations_; n++) {
+		reference_.setToZero();
+		reference_.addMatrixProduct(weights_, input_, 0, 1, true, false);
+	}
+	timer.stop();
+	referenceTime_ = timer.time() / nIterations_;
+	Core::Log::openTag("float32");
+	Core::Log::os("latency: ") << referenceTime_ * 1000000.0 << "us per product";
+	Core::Log::os("weights: ") << (u64)weights_.nRows() * weights_.nColumns() * sizeof(f32) << " bytes";
+	Core::Log::closeTag();
+}
+
+void ReducedPrecisionBenchmark::benchmark(Math::ReducedPrecisionMatrix::Precision precision, bool calibrate) {
+	Math::ReducedPrecisionMatrix weights;
+	weights.set(weights_, precision);
+	if (calibrate) {
+		weights.observeInput(input_);
+		weights.finishCalibration();
+	}
+	Core::Utils::Timer timer;
+	timer.run();
+	for (u32 n = 0; n < nIterations_; n++) {
+		output_.setToZero();
+		weights.addTransposedProduct(input_, output_);
+	}
+	timer.stop();
+	f64 time = timer.time() / nIterations_;
+	// deviation from the full precision result, relative to the largest absolute output
+	f64 maxReference = 0, maxError = 0, sumError = 0;
+	for (u32 j = 0; j < batchSize_; j++) {
+		for (u32 i = 0; i < nOutputs_; i++) {
+			f64 error = std::abs(output_.at(i, j) - reference_.at(i, j));
+			maxReference = std::max(maxReference, (f64)std::abs(reference_.at(i, j)));
+			maxError = std::max(maxError, error);
+			sumError += error;
+		}
+	}
+	const char* names[] = { "float32", "bfloat16", "float16", "int8" };
+	std::string name(names[precision]);
+	if (precision == Math::ReducedPrecisionMatrix::int8)
+		name.append(calibrate ? "-calibrated" : "-dynamic");
+	Core::Log::openTag(name.c_str());
+	Core::Log::os("latency: ") << time * 1000000.0 << "us per product (speed-up " << referenceTime_ / time << ")";
+	Core::Log::os("weights: ") << weights.nBytes() << " bytes";
+	Core::Log::os("relative max. error: ") << maxError / maxReference;
+	Core::Log::os("relative mean error: ") << sumError / ((f64)nOutputs_ * batchSize_) / maxReference;
+	Core::Log::closeTag();
+}
+
+void ReducedPrecisionBenchmark::run() {
+	generateInput();
+	Core::Log::openTag("reduced-precision-benchmark");
+	Core::Log::os("Benchmark ") << nIterations_ << " products of a " << nInputs_ << "x" << nOutputs_
+			<< " weight matrix with a batch of size " << batchSize_ << ".";
+	benchmarkFullPrecision();
+	benchmark(Math::ReducedPrecisionMatrix::bfloat16, false);
+	benchmark(Math::ReducedPrecisionMatrix::float16, false);
+	benchmark(Math::ReducedPrecisionMatrix::int8, false);
+	benchmark(Math::ReducedPrecisionMatrix::int8, true);
+	Core::Log::closeTag();
+}
@@ -0,0 +1,58 @@
+/*
+ * Copyright 2016 Alexander Richard
+ *
+ * This file is part of Squirrel.
+ *
+ * Licensed under the Academic Free License 3.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * You should have received a copy of the License along with Squirrel.
+ * If not, see <https://opensource.org/licenses/AFL-3.0>.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ */
+
+#ifndef BENCHMARK_REDUCEDPRECISIONBENCHMARK_HH_
+#define BENCHMARK_REDUCEDPRECISIONBENCHMARK_HH_
+
+#include <Core/CommonHeaders.hh>
+#include <Math/Matrix.hh>
+#include <Math/ReducedPrecision.hh>
+
+namespace Benchmark {
+
+/*
+ * ReducedPrecisionBenchmark
+ * compares the forward product y = W^T x of a weight connection in full precision (blas)
+ * with the reduced precision products (bfloat16, float16, int8 with and without calibrated input scale)
+ * with respect to latency, memory of the weights, and deviation from the full precision result
+ */
+class ReducedPrecisionBenchmark
+{
+private:
+	static const Core::ParameterInt paramNumberOfInputs_;
+	static const Core::ParameterInt paramNumberOfOutputs_;
+	static const Core::ParameterInt paramBatchSize_;
+	static const Core::ParameterInt paramNumberOfIterations_;
+	u32 nInputs_;
+	u32 nOutputs_;
+	u32 batchSize_;
+	u32 nIterations_;
+	Math::Matrix<f32> weights_;
+	Math::Matrix<f32> input_;
+	Math::Matrix<f32> reference_;
+	Math::Matrix<f32> output_;
+	f64 referenceTime_;
+	void generateInput();
+	void benchmarkFullPrecision();
+	void benchmark(Math::ReducedPrecisionMatrix::Precision precision, bool calibrate);
+public:
+	ReducedPrecisionBenchmark();
+	virtual ~ReducedPrecisionBenchmark() {}
+	void run();
+};
+
+} // namespace
+
+#endif /* BENCHMARK_REDUCEDPRECISIONBENCHMARK_HH_ */
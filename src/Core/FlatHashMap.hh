@@ -0,0 +1,263 @@
+/*
+ * Copyright 2016 Alexander Richard
+ *
+ * This file is part of Squirrel.
+ *
+ * Licensed under the Academic Free License 3.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * You should have received a copy of the License along with Squirrel.
+ * If not, see <https://opensource.org/licenses/AFL-3.0>.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ */
+
+#ifndef CORE_FLATHASHMAP_HH_
+#define CORE_FLATHASHMAP_HH_
+
+#include <Core/CommonHeaders.hh>
+#include <algorithm>
+
+namespace Core {
+
+/*
+ * finalizer to spread the bits of a weak hash value over all bits
+ */
+inline u32 hashMix(u32 h) {
+	h = ((h >> 16) ^ h) * 0x45d9f3b;
+	h = ((h >> 16) ^ h) * 0x45d9f3b;
+	return (h >> 16) ^ h;
+}
+
+/*
+ * FlatHashMap
+ * open addressing hash map with linear probing, all entries are stored in a single contiguous array
+ * @typename K key class, needs a default constructor and an == operator of the form bool K::operator==(const K& key) const { ... }
+ * @typename V value class, needs a default constructor
+ * @typename H hash function class, needs an operator of the form u32 H::operator()(const K& key) const { ... }
+ *             the hash value is used without further mixing (see hashMix), so identity hashes of bounded keys lead to direct addressing
+ * removed entries are marked as removed until the next clear or rehash
+ * clear only resets the slots that have been used since the last clear, so its cost is proportional to the number of insertions
+ * the iteration order is unspecified (insertions may reuse the slots of removed entries),
+ * iterators stay valid if entries are removed (but not if entries are inserted)
+ */
+template<typename K, typename V, typename H>
+class FlatHashMap
+{
+public:
+	class Entry {
+	public:
+		K key;
+		V value;
+	public:
+		Entry() {}
+		Entry(const K& key, const V& value) : key(key), value(value) {}
+	};
+
+	class iterator {
+	private:
+		FlatHashMap* map_;
+		u32 position_; // position in the list of used slots
+		void skipUnused() { while ((position_ < map_->usedSlots_.size()) && (map_->states_[map_->usedSlots_[position_]] != occupied)) position_++; }
+	public:
+		iterator(FlatHashMap* map, u32 position) : map_(map), position_(position) { skipUnused(); }
+		Entry& operator*() const { return map_->slots_[map_->usedSlots_[position_]]; }
+		Entry* operator->() const { return &(map_->slots_[map_->usedSlots_[position_]]); }
+		iterator& operator++() { position_++; skipUnused(); return *this; }
+		bool operator==(const iterator& it) const { return (map_ == it.map_) && (position_ == it.position_); }
+		bool operator!=(const iterator& it) const { return !(*this == it); }
+	};
+
+private:
+	friend class iterator;
+	enum SlotState { empty = 0, occupied = 1, removed = 2 };
+	std::vector<Entry> slots_;
+	std::vector<u8> states_;
+	std::vector<u32> usedSlots_; // all slots that are not empty, in order of their first use
+	H hash_;
+	u32 size_;
+	u32 findSlot(const K& key) const;
+	void rehash(u32 capacity);
+public:
+	/*
+	 * @param hash the hash function object
+	 * @param capacity initial number of slots (rounded up to a power of two)
+	 */
+	FlatHashMap(const H& hash = H(), u32 capacity = 16);
+	virtual ~FlatHashMap() {}
+	/*
+	 * @return number of elements in the hash map
+	 */
+	u32 size() const { return size_; }
+	/*
+	 * @return number of slots
+	 */
+	u32 capacity() const { return slots_.size(); }
+	/*
+	 * remove all entries, the capacity is kept
+	 */
+	void clear();
+	/*
+	 * make sure that n elements can be stored without rehashing
+	 */
+	void reserve(u32 n);
+	/*
+	 * replace the hash function (map must be empty)
+	 */
+	void setHashFunction(const H& hash);
+	/*
+	 * @param key the key to look up
+	 * @return pointer to the entry with the given key or 0 if key not found (invalidated by insertions)
+	 */
+	Entry* find(const K& key);
+	/*
+	 * @param key the key to use for the value. If key already exists, it will be overwritten
+	 * @param value the value to be inserted
+	 * @return a pointer to the inserted entry (invalidated by further insertions)
+	 */
+	Entry* insert(const K& key, const V& value);
+	/*
+	 * @param key the key of the entry to be removed from the hash map
+	 */
+	void remove(const K& key);
+	/*
+	 * exchange the content of two hash maps
+	 */
+	void swap(FlatHashMap& hashMap);
+	iterator begin() { return iterator(this, 0); }
+	iterator end() { return iterator(this, usedSlots_.size()); }
+};
+
+template<typename K, typename V, typename H>
+FlatHashMap<K,V,H>::FlatHashMap(const H& hash, u32 capacity) :
+	hash_(hash),
+	size_(0)
+{
+	u32 n = 1;
+	while (n < capacity)
+		n *= 2;
+	slots_.resize(n);
+	states_.resize(n, empty);
+}
+
+template<typename K, typename V, typename H>
+u32 FlatHashMap<K,V,H>::findSlot(const K& key) const {
+	u32 mask = slots_.size() - 1;
+	u32 i = hash_(key) & mask;
+	while (states_[i] != empty) {
+		if ((states_[i] == occupied) && (slots_[i].key == key))
+			return i;
+		i = (i + 1) & mask;
+	}
+	return Types::max<u32>();
+}
+
+template<typename K, typename V, typename H>
+void FlatHashMap<K,V,H>::rehash(u32 capacity) {
+	std::vector<Entry> slots(capacity);
+	std::vector<u8> states(capacity, empty);
+	std::vector<u32> usedSlots;
+	usedSlots.reserve(size_);
+	u32 mask = capacity - 1;
+	// reinsert occupied entries in the order of their insertion
+	for (u32 j = 0; j < usedSlots_.size(); j++) {
+		u32 slot = usedSlots_[j];
+		if (states_[slot] != occupied)
+			continue;
+		u32 i = hash_(slots_[slot].key) & mask;
+		while (states[i] != empty)
+			i = (i + 1) & mask;
+		slots[i] = slots_[slot];
+		states[i] = occupied;
+		usedSlots.push_back(i);
+	}
+	slots_.swap(slots);
+	states_.swap(states);
+	usedSlots_.swap(usedSlots);
+}
+
+template<typename K, typename V, typename H>
+void FlatHashMap<K,V,H>::clear() {
+	for (u32 i = 0; i < usedSlots_.size(); i++)
+		states_[usedSlots_[i]] = empty;
+	usedSlots_.clear();
+	size_ = 0;
+}
+
+template<typename K, typename V, typename H>
+void FlatHashMap<K,V,H>::reserve(u32 n) {
+	// maximal load factor is 0.5
+	u32 capacity = slots_.size();
+	while (capacity < 2 * n)
+		capacity *= 2;
+	if (capacity > slots_.size())
+		rehash(capacity);
+}
+
+template<typename K, typename V, typename H>
+void FlatHashMap<K,V,H>::setHashFunction(const H& hash) {
+	require_eq(size_, 0);
+	clear();
+	hash_ = hash;
+}
+
+template<typename K, typename V, typename H>
+typename FlatHashMap<K,V,H>::Entry* FlatHashMap<K,V,H>::find(const K& key) {
+	u32 i = findSlot(key);
+	return (i == Types::max<u32>() ? 0 : &(slots_[i]));
+}
+
+template<typename K, typename V, typename H>
+typename FlatHashMap<K,V,H>::Entry* FlatHashMap<K,V,H>::insert(const K& key, const V& value) {
+	// keep load factor (including removed entries) below 0.5, grow only if the map is actually full
+	if (2 * (usedSlots_.size() + 1) > slots_.size())
+		rehash(2 * (size_ + 1) > slots_.size() / 2 ? 2 * slots_.size() : slots_.size());
+	u32 mask = slots_.size() - 1;
+	u32 i = hash_(key) & mask;
+	u32 firstRemoved = Types::max<u32>();
+	while (states_[i] != empty) {
+		if (states_[i] == occupied) {
+			if (slots_[i].key == key) {
+				slots_[i].value = value;
+				return &(slots_[i]);
+			}
+		}
+		else if (firstRemoved == Types::max<u32>()) {
+			firstRemoved = i;
+		}
+		i = (i + 1) & mask;
+	}
+	// reuse a removed slot on the probing path if possible
+	if (firstRemoved != Types::max<u32>())
+		i = firstRemoved;
+	else
+		usedSlots_.push_back(i);
+	slots_[i].key = key;
+	slots_[i].value = value;
+	states_[i] = occupied;
+	size_++;
+	return &(slots_[i]);
+}
+
+template<typename K, typename V, typename H>
+void FlatHashMap<K,V,H>::remove(const K& key) {
+	u32 i = findSlot(key);
+	if (i != Types::max<u32>()) {
+		states_[i] = removed;
+		size_--;
+	}
+}
+
+template<typename K, typename V, typename H>
+void FlatHashMap<K,V,H>::swap(FlatHashMap& hashMap) {
+	slots_.swap(hashMap.slots_);
+	states_.swap(hashMap.states_);
+	usedSlots_.swap(hashMap.usedSlots_);
+	std::swap(hash_, hashMap.hash_);
+	std::swap(size_, hashMap.size_);
+}
+
+} // namespace
+
+#endif /* CORE_FLATHASHMAP_HH_ */
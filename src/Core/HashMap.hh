@@ -33,6 +33,7 @@ namespace Core {
  * HashMap
  * @typename K key class, needs to have an == operator of the form bool K::operator==(const K& key) const { ... }
  * @typename V value class
+ * removed entries are kept in a pool and reused for later insertions, i.e. no memory is allocated once the map reached its maximal size
  */
 template<typename K, typename V>
 class HashMap
@@ -51,9 +52,14 @@ private:
 	std::vector< Entry* > bucketStartNode_;
 	std::vector< Entry* > bucketEndNode_;
 	Entry* head_;
+	std::vector< Entry* > freeEntries_;
 	u32 (*hashFunction_)(const K&);
 	u32 size_;
 	u32 hash(const K& key) const;
+	Entry* newEntry(const K& key, const V& value);
+	// entries are owned by the hash map, so copying is not allowed
+	HashMap(const HashMap& hashMap);
+	HashMap& operator=(const HashMap& hashMap);
 public:
 	/*
 	 * @param hashFunction function of the form hashFunction(const K&) to generate an integer from the Key
@@ -85,6 +91,10 @@ public:
 	 * @param key the key of the entry to be removed from the hash map
 	 */
 	void remove(const K& key);
+	/*
+	 * exchange the content of two hash maps (same hash function required)
+	 */
+	void swap(HashMap& hashMap);
 	/*
 	 * @return pointer to first entry in the list
 	 */
@@ -107,6 +117,8 @@ HashMap<K,V>::HashMap(u32(*hashFunction)(const K&), u32 nBuckets) :
 template<typename K, typename V>
 HashMap<K,V>::~HashMap() {
 	clear();
+	for (u32 i = 0; i < freeEntries_.size(); i++)
+		delete freeEntries_[i];
 }
 
 template<typename K, typename V>
@@ -118,12 +130,25 @@ u32 HashMap<K,V>::hash(const K& key) const {
     return h % bucketStartNode_.size();
 }
 
+template<typename K, typename V>
+typename HashMap<K,V>::Entry* HashMap<K,V>::newEntry(const K& key, const V& value) {
+	if (freeEntries_.empty())
+		return new Entry(key, value);
+	Entry* entry = freeEntries_.back();
+	freeEntries_.pop_back();
+	entry->key = key;
+	entry->value = value;
+	entry->next = 0;
+	entry->prev = 0;
+	return entry;
+}
+
 template<typename K, typename V>
 void HashMap<K,V>::clear() {
 	while (head_ != 0) {
 		Entry* entry = head_;
 		head_ = head_->next;
-		delete entry;
+		freeEntries_.push_back(entry);
 	}
 	for (u32 i = 0; i < bucketStartNode_.size(); i++) {
 		bucketStartNode_[i] = 0;
@@ -149,7 +174,7 @@ typename HashMap<K,V>::Entry* HashMap<K,V>::insert(const K& key, const V& value)
 	if (entry == 0) {
 		// insert new entry
 		u32 h = hash(key);
-		entry = new Entry(key, value);
+		entry = newEntry(key, value);
 		if (bucketStartNode_[h] == 0) {
 			entry->next = head_;
 			if (head_ != 0) head_->prev = entry;
@@ -184,11 +209,21 @@ void HashMap<K,V>::remove(const K& key) {
 		if (bucketStartNode_[h] == bucketEndNode_[h]) bucketStartNode_[h] = bucketEndNode_[h] = 0;
 		else if (entry == bucketStartNode_[h]) bucketStartNode_[h] = entry->next;
 		else if (entry == bucketEndNode_[h]) bucketEndNode_[h] = entry->prev;
-		delete entry;
+		freeEntries_.push_back(entry);
 		size_--;
 	}
 }
 
+template<typename K, typename V>
+void HashMap<K,V>::swap(HashMap& hashMap) {
+	require(hashFunction_ == hashMap.hashFunction_);
+	bucketStartNode_.swap(hashMap.bucketStartNode_);
+	bucketEndNode_.swap(hashMap.bucketEndNode_);
+	freeEntries_.swap(hashMap.freeEntries_);
+	std::swap(head_, hashMap.head_);
+	std::swap(size_, hashMap.size_);
+}
+
 } // namespace
 
 #endif /* CORE_HASHMAP_HH_ */
@@ -44,6 +44,31 @@ bool IOStream::getline(std::string& str) {
 	return true;
 }
 
+/* default bulk read/write based on the element-wise operators */
+template<typename T>
+static void readValues(IOStream& stream, T* dst, u64 n) {
+	for (u64 i = 0; i < n; i++)
+		stream >> dst[i];
+}
+
+template<typename T>
+static void writeValues(IOStream& stream, const T* src, u64 n) {
+	for (u64 i = 0; i < n; i++) {
+		if (i > 0)
+			stream << ' ';
+		stream << src[i];
+	}
+}
+
+void IOStream::read(u32* dst, u64 n) { readValues(*this, dst, n); }
+void IOStream::read(s32* dst, u64 n) { readValues(*this, dst, n); }
+void IOStream::read(f32* dst, u64 n) { readValues(*this, dst, n); }
+void IOStream::read(f64* dst, u64 n) { readValues(*this, dst, n); }
+void IOStream::write(const u32* src, u64 n) { writeValues(*this, src, n); }
+void IOStream::write(const s32* src, u64 n) { writeValues(*this, src, n); }
+void IOStream::write(const f32* src, u64 n) { writeValues(*this, src, n); }
+void IOStream::write(const f64* src, u64 n) { writeValues(*this, src, n); }
+
 /* ------------------------------------------------------------------------- */
 /*
  * BinaryStream
@@ -133,6 +158,37 @@ void BinaryStream::get(char* data, u32 size) {
 	}
 }
 
+void BinaryStream::readBytes(char* data, u64 nBytes) {
+	// first use the bytes that are already buffered
+	u64 nBuffered = std::min(nBytes, unreadBufferedBytes_);
+	memcpy(data, buffer_ + bufferPointer_, nBuffered);
+	bufferPointer_ += nBuffered;
+	unreadBufferedBytes_ -= nBuffered;
+	data += nBuffered;
+	nBytes -= nBuffered;
+	if (nBytes == 0)
+		return;
+	if (nBytes > remainingBytes_) {
+		std::cout << "Error: BinaryStream::readBytes: Requested more bytes than left in file. Abort." << std::endl;
+		exit(1);
+	}
+	// large blocks are read directly into the destination, small ones through the buffer
+	if (nBytes >= bufferSize_) {
+		stream_.read(data, nBytes);
+		remainingBytes_ -= nBytes;
+	}
+	else {
+		readBuffer();
+		memcpy(data, buffer_, nBytes);
+		bufferPointer_ += nBytes;
+		unreadBufferedBytes_ -= nBytes;
+	}
+}
+
+void BinaryStream::writeBytes(const char* data, u64 nBytes) {
+	stream_.write(data, nBytes);
+}
+
 IOStream& BinaryStream::operator<<(void (*fptr)(std::ostream&)) { fptr(stream_); return *this; }
 
 IOStream& BinaryStream::operator<<(u8 n) { stream_.write((const char*) &n, sizeof(u8)); return *this; }
@@ -357,6 +413,30 @@ IOStream& CompressedStream::operator>>(f64& n) { in_ >> n; return *this; }
 IOStream& CompressedStream::operator>>(bool& n) { in_ >> n; return *this; }
 IOStream& CompressedStream::operator>>(char& n) { in_ >> n; return *this; }
 
+template<typename T>
+static void readValues(std::istream& stream, T* dst, u64 n) {
+	for (u64 i = 0; i < n; i++)
+		stream >> dst[i];
+}
+
+template<typename T>
+static void writeValues(std::ostream& stream, const T* src, u64 n) {
+	for (u64 i = 0; i < n; i++) {
+		if (i > 0)
+			stream << ' ';
+		stream << src[i];
+	}
+}
+
+void CompressedStream::read(u32* dst, u64 n) { readValues(in_, dst, n); }
+void CompressedStream::read(s32* dst, u64 n) { readValues(in_, dst, n); }
+void CompressedStream::read(f32* dst, u64 n) { readValues(in_, dst, n); }
+void CompressedStream::read(f64* dst, u64 n) { readValues(in_, dst, n); }
+void CompressedStream::write(const u32* src, u64 n) { writeValues(out_, src, n); }
+void CompressedStream::write(const s32* src, u64 n) { writeValues(out_, src, n); }
+void CompressedStream::write(const f32* src, u64 n) { writeValues(out_, src, n); }
+void CompressedStream::write(const f64* src, u64 n) { writeValues(out_, src, n); }
+
 /* ------------------------------------------------------------------------- */
 // ----------------------------------------------------------------------------
 // Internal classes to implement gzstream. See header file for user classes.
@@ -108,6 +108,19 @@ public:
 	virtual IOStream& operator>>(bool&) = 0;
 	virtual IOStream& operator>>(char&) = 0;
 	virtual bool getline(std::string&); // reads a '\n'-terminated string
+
+	/*
+	 * bulk read/write of n values
+	 * default implementation uses the element-wise operators (values are separated by blanks when writing)
+	 */
+	virtual void read(u32* dst, u64 n);
+	virtual void read(s32* dst, u64 n);
+	virtual void read(f32* dst, u64 n);
+	virtual void read(f64* dst, u64 n);
+	virtual void write(const u32* src, u64 n);
+	virtual void write(const s32* src, u64 n);
+	virtual void write(const f32* src, u64 n);
+	virtual void write(const f64* src, u64 n);
 };
 
 
@@ -127,6 +140,8 @@ private:
 	virtual void readBuffer();
 	virtual char get();
 	virtual void get(char* data, u32 size);
+	void readBytes(char* data, u64 nBytes);
+	void writeBytes(const char* data, u64 nBytes);
 public:
 	using Precursor::operator>>;
 public:
@@ -164,6 +179,16 @@ public:
 	virtual IOStream& operator>>(f64&);
 	virtual IOStream& operator>>(bool&);
 	virtual IOStream& operator>>(char&);
+
+	/* bulk read/write: large blocks bypass the internal buffer */
+	virtual void read(u32* dst, u64 n) { readBytes((char*) dst, n * sizeof(u32)); }
+	virtual void read(s32* dst, u64 n) { readBytes((char*) dst, n * sizeof(s32)); }
+	virtual void read(f32* dst, u64 n) { readBytes((char*) dst, n * sizeof(f32)); }
+	virtual void read(f64* dst, u64 n) { readBytes((char*) dst, n * sizeof(f64)); }
+	virtual void write(const u32* src, u64 n) { writeBytes((const char*) src, n * sizeof(u32)); }
+	virtual void write(const s32* src, u64 n) { writeBytes((const char*) src, n * sizeof(s32)); }
+	virtual void write(const f32* src, u64 n) { writeBytes((const char*) src, n * sizeof(f32)); }
+	virtual void write(const f64* src, u64 n) { writeBytes((const char*) src, n * sizeof(f64)); }
 };
 
 /*
@@ -345,6 +370,16 @@ public:
 	virtual IOStream& operator>>(f64&);
 	virtual IOStream& operator>>(bool&);
 	virtual IOStream& operator>>(char&);
+
+	/* bulk read/write: formatted values directly from/to the gz stream */
+	virtual void read(u32* dst, u64 n);
+	virtual void read(s32* dst, u64 n);
+	virtual void read(f32* dst, u64 n);
+	virtual void read(f64* dst, u64 n);
+	virtual void write(const u32* src, u64 n);
+	virtual void write(const s32* src, u64 n);
+	virtual void write(const f32* src, u64 n);
+	virtual void write(const f64* src, u64 n);
 };
 
 } // namespace
@@ -32,6 +32,10 @@ const ParameterString Log::paramLogFile("log-file", "stdout");
 
 Log* Log::theInstance_ = 0;
 
+__thread bool Log::isMuted_ = false;
+
+std::ostream Log::nullStream_(0);
+
 u32 Log::indentationLevel() {
 	return tags_.size();
 }
@@ -75,6 +79,15 @@ Log::Log() :
 		os_(&(std::cout))
 {}
 
+void Log::redirect(const char* filename) {
+	Log::getInstance()->setOutputFile(filename);
+	(*(Log::getInstance()->os_)) << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>";
+}
+
+void Log::mute(bool isMuted) {
+	isMuted_ = isMuted;
+}
+
 void Log::finalize() {
 	// close all open tags
 	while (Log::getInstance()->tags_.size() > 0) {
@@ -94,6 +107,8 @@ void Log::finalize() {
 }
 
 std::ostream& Log::os(const char* msg) {
+	if (isMuted_)
+		return nullStream_;
 	std::ostream* os;
 	os = Log::getInstance()->os_;
 	(*os) << std::endl;
@@ -103,6 +118,8 @@ std::ostream& Log::os(const char* msg) {
 }
 
 void Log::openTag(const char* tag, const char* description) {
+	if (isMuted_)
+		return;
 	std::string strTag(tag);
 	// replace spaces
 	Core::Utils::replaceChar(strTag, ' ', '_');
@@ -118,6 +135,8 @@ void Log::openTag(const char* tag, const char* description) {
 }
 
 void Log::closeTag() {
+	if (isMuted_)
+		return;
 	std::string tag(Log::getInstance()->tags_.back());
 	Log::getInstance()->tags_.pop_back();
 	Log::os() << "</" << tag << ">";
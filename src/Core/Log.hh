@@ -46,6 +46,8 @@ private:
 	void setOutputFile(const char* filename);
 
 	static Log* theInstance_;
+	static __thread bool isMuted_;	// per thread
+	static std::ostream nullStream_;
 	static Log* getInstance();
 	Log();
 public:
@@ -53,6 +55,10 @@ public:
 	static void openTag(const char* tag, const char* description = "");
 	static void openTag(std::string& tag) { Log::openTag(tag.c_str()); }
 	static void closeTag();
+	// continue logging in the given file (e.g. in a forked worker process)
+	static void redirect(const char* filename);
+	// discard all log messages of the calling thread (e.g. in all but one of several threads doing the same work)
+	static void mute(bool isMuted);
 	static void finalize();
 };
 
@@ -48,6 +48,14 @@ inline s32 get_max_threads(){
 #endif
 }
 
+inline s32 get_thread_num(){
+#ifdef MODULE_OPENMP
+    return omp_get_thread_num();
+#else
+    return 0;
+#endif
+}
+
 inline void set_num_threads(int nThreads){
 #ifdef MODULE_OPENMP
     omp_set_num_threads(nThreads);
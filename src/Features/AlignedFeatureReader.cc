@@ -50,7 +50,9 @@ BaseAlignedFeatureReader::BaseAlignedFeatureReader(const char* name) :
 AlignedFeatureReader::AlignedFeatureReader(const char* name) :
 		Precursor(name),
 		BaseAlignedFeatureReader(name),
-		targetReader_(name, targetCacheFile_, bufferSize_, false)
+		targetReader_(name, targetCacheFile_, bufferSize_, false),
+		isTargetExpanded_(false),
+		label_(0)
 {}
 
 void AlignedFeatureReader::initialize() {
@@ -78,7 +80,13 @@ void AlignedFeatureReader::newEpoch() {
 
 const Math::Vector<Float>& AlignedFeatureReader::next() {
 	const Math::Vector<Float>& v = Precursor::next();
-	target_.copy(targetReader_.next());
+	if (targetReader_.isLabelCache()) {
+		label_ = targetReader_.nextLabel();
+		isTargetExpanded_ = false;
+	}
+	else {
+		target_.copy(targetReader_.next());
+	}
 	return v;
 }
 
@@ -89,9 +97,29 @@ u32 AlignedFeatureReader::targetDimension() const {
 
 const Math::Vector<Float>& AlignedFeatureReader::target() const {
 	require(isInitialized_);
+	if (targetReader_.isLabelCache() && !isTargetExpanded_) {
+		target_.setToZero();
+		target_.at(label_) = 1.0;
+		isTargetExpanded_ = true;
+	}
 	return target_;
 }
 
+bool AlignedFeatureReader::hasLabelTargets() const {
+	require(isInitialized_);
+	return targetReader_.isLabelCache();
+}
+
+u32 AlignedFeatureReader::label() const {
+	require(hasLabelTargets());
+	return label_;
+}
+
+void AlignedFeatureReader::setTargetLabels(const std::vector<u32>& labels) {
+	require(hasLabelTargets());
+	targetReader_.setLabels(labels);
+}
+
 /*
  * LabeledFeatureReader
  */
@@ -107,11 +135,6 @@ void LabeledFeatureReader::initialize() {
 	Precursor::initialize();
 }
 
-u32 LabeledFeatureReader::label() const {
-	require(isInitialized_);
-	return target_.argAbsMax();
-}
-
 u32 LabeledFeatureReader::nClasses() const {
 	require(isInitialized_);
 	return targetReader_.featureDimension();
@@ -123,7 +146,9 @@ u32 LabeledFeatureReader::nClasses() const {
 AlignedSequenceFeatureReader::AlignedSequenceFeatureReader(const char* name) :
 		Precursor(name),
 		BaseAlignedFeatureReader(name),
-		targetReader_(name, targetCacheFile_, bufferSize_, false)
+		targetReader_(name, targetCacheFile_, bufferSize_, false),
+		isTargetExpanded_(false),
+		label_(0)
 {}
 
 void AlignedSequenceFeatureReader::initialize() {
@@ -149,6 +174,11 @@ void AlignedSequenceFeatureReader::sortSequences() {
 	targetReader_.reorderBufferedFeatures(reorderedIndices_);
 }
 
+void AlignedSequenceFeatureReader::bucketSequences() {
+	Precursor::bucketSequences();
+	targetReader_.reorderBufferedFeatures(reorderedIndices_);
+}
+
 void AlignedSequenceFeatureReader::newEpoch() {
 	Precursor::newEpoch();
 	targetReader_.newEpoch();
@@ -156,7 +186,13 @@ void AlignedSequenceFeatureReader::newEpoch() {
 
 const Math::Matrix<Float>& AlignedSequenceFeatureReader::next() {
 	const Math::Matrix<Float>& v = Precursor::next();
-	target_.copy(targetReader_.next());
+	if (targetReader_.isLabelCache()) {
+		label_ = targetReader_.nextLabel();
+		isTargetExpanded_ = false;
+	}
+	else {
+		target_.copy(targetReader_.next());
+	}
 	return v;
 }
 
@@ -167,9 +203,24 @@ u32 AlignedSequenceFeatureReader::targetDimension() const {
 
 const Math::Vector<Float>& AlignedSequenceFeatureReader::target() const {
 	require(isInitialized_);
+	if (targetReader_.isLabelCache() && !isTargetExpanded_) {
+		target_.setToZero();
+		target_.at(label_) = 1.0;
+		isTargetExpanded_ = true;
+	}
 	return target_;
 }
 
+bool AlignedSequenceFeatureReader::hasLabelTargets() const {
+	require(isInitialized_);
+	return targetReader_.isLabelCache();
+}
+
+u32 AlignedSequenceFeatureReader::label() const {
+	require(hasLabelTargets());
+	return label_;
+}
+
 /*
  * LabeledSequenceFeatureReader
  */
@@ -185,11 +236,6 @@ void LabeledSequenceFeatureReader::initialize() {
 	Precursor::initialize();
 }
 
-u32 LabeledSequenceFeatureReader::label() const {
-	require(isInitialized_);
-	return target_.argAbsMax();
-}
-
 u32 LabeledSequenceFeatureReader::nClasses() const {
 	require(isInitialized_);
 	return targetReader_.featureDimension();
@@ -201,7 +247,8 @@ u32 LabeledSequenceFeatureReader::nClasses() const {
 TemporallyAlignedSequenceFeatureReader::TemporallyAlignedSequenceFeatureReader(const char* name) :
 		Precursor(name),
 		BaseAlignedFeatureReader(name),
-		targetReader_(name, targetCacheFile_, bufferSize_, false, false)
+		targetReader_(name, targetCacheFile_, bufferSize_, false, false),
+		isTargetExpanded_(false)
 {}
 
 void TemporallyAlignedSequenceFeatureReader::initialize() {
@@ -231,6 +278,11 @@ void TemporallyAlignedSequenceFeatureReader::sortSequences() {
 	targetReader_.reorderBufferedFeatures(reorderedIndices_);
 }
 
+void TemporallyAlignedSequenceFeatureReader::bucketSequences() {
+	Precursor::bucketSequences();
+	targetReader_.reorderBufferedFeatures(reorderedIndices_);
+}
+
 void TemporallyAlignedSequenceFeatureReader::newEpoch() {
 	Precursor::newEpoch();
 	targetReader_.newEpoch();
@@ -238,14 +290,23 @@ void TemporallyAlignedSequenceFeatureReader::newEpoch() {
 
 const Math::Matrix<Float>& TemporallyAlignedSequenceFeatureReader::next() {
 	const Math::Matrix<Float>& v = Precursor::next();
-	const Math::Matrix<Float>& t = targetReader_.next();
-	if (t.nColumns() != v.nColumns()) {
+	u32 targetLength = 0;
+	if (targetReader_.isLabelCache()) {
+		labelSequence_ = targetReader_.nextLabelSequence();
+		targetLength = labelSequence_.size();
+		isTargetExpanded_ = false;
+	}
+	else {
+		const Math::Matrix<Float>& t = targetReader_.next();
+		targetLength = t.nColumns();
+		target_.resize(t.nRows(), t.nColumns());
+		target_.copy(t);
+	}
+	if (targetLength != v.nColumns()) {
 		std::cerr << "Error: Sequence lengths in cache " << getCacheFilename() << " do not match sequence lengths in target cache "
 				<< targetReader_.getCacheFilename() << ". Abort." << std::endl;
 		exit(1);
 	}
-	target_.resize(t.nRows(), t.nColumns());
-	target_.copy(t);
 	return v;
 }
 
@@ -256,9 +317,26 @@ u32 TemporallyAlignedSequenceFeatureReader::targetDimension() const {
 
 const Math::Matrix<Float>& TemporallyAlignedSequenceFeatureReader::target() const {
 	require(isInitialized_);
+	if (targetReader_.isLabelCache() && !isTargetExpanded_) {
+		target_.resize(targetReader_.featureDimension(), labelSequence_.size());
+		target_.setToZero();
+		for (u32 t = 0; t < labelSequence_.size(); t++)
+			target_.at(labelSequence_.at(t), t) = 1.0;
+		isTargetExpanded_ = true;
+	}
 	return target_;
 }
 
+bool TemporallyAlignedSequenceFeatureReader::hasLabelTargets() const {
+	require(isInitialized_);
+	return targetReader_.isLabelCache();
+}
+
+const std::vector<u32>& TemporallyAlignedSequenceFeatureReader::labelSequence() const {
+	require(hasLabelTargets());
+	return labelSequence_;
+}
+
 /*
  * TemporallyLabeledSequenceFeatureReader
  */
@@ -274,20 +352,6 @@ void TemporallyLabeledSequenceFeatureReader::initialize() {
 	Precursor::initialize();
 }
 
-const Math::Matrix<Float>& TemporallyLabeledSequenceFeatureReader::next() {
-	const Math::Matrix<Float>& v = Precursor::next();
-	labelSequence_.clear();
-	for (u32 i = 0; i < target_.nColumns(); i++) {
-		labelSequence_.push_back(target_.argAbsMax(i));
-	}
-	return v;
-}
-
-const std::vector<u32>& TemporallyLabeledSequenceFeatureReader::labelSequence() const {
-	require(isInitialized_);
-	return labelSequence_;
-}
-
 u32 TemporallyLabeledSequenceFeatureReader::nClasses() const {
 	require(isInitialized_);
 	return targetReader_.featureDimension();
@@ -54,7 +54,9 @@ private:
 	typedef FeatureReader Precursor;
 protected:
 	FeatureReader targetReader_;
-	Math::Vector<Float> target_;
+	mutable Math::Vector<Float> target_;
+	mutable bool isTargetExpanded_;		// label targets are only expanded to one-hot vectors on request
+	u32 label_;
 
 	virtual void shuffleIndices();
 public:
@@ -72,6 +74,18 @@ public:
 	 * @return the corresponding target vector
 	 */
 	const Math::Vector<Float>& target() const;
+	/*
+	 * @return true if the target cache is a label cache
+	 */
+	bool hasLabelTargets() const;
+	/*
+	 * @return the corresponding label (only if the target cache is a label cache)
+	 */
+	u32 label() const;
+	/*
+	 * replace the labels of the target cache (one per feature vector, in cache order), see FeatureReader::setLabels
+	 */
+	void setTargetLabels(const std::vector<u32>& labels);
 };
 
 /**
@@ -89,11 +103,6 @@ public:
 	virtual ~LabeledFeatureReader() {}
 	virtual void initialize();
 
-	/*
-	 * @return the corresponding label
-	 */
-	u32 label() const;
-
 	/*
 	 * @return the number of classes
 	 */
@@ -111,10 +120,13 @@ private:
 	typedef SequenceFeatureReader Precursor;
 protected:
 	FeatureReader targetReader_;
-	Math::Vector<Float> target_;
+	mutable Math::Vector<Float> target_;
+	mutable bool isTargetExpanded_;		// label targets are only expanded to one-hot vectors on request
+	u32 label_;
 
 	virtual void shuffleIndices();
 	virtual void sortSequences();
+	virtual void bucketSequences();
 public:
 	AlignedSequenceFeatureReader(const char* name = "features.aligned-feature-reader");
 	virtual ~AlignedSequenceFeatureReader() {}
@@ -130,6 +142,14 @@ public:
 	 * @return the corresponding target vector
 	 */
 	const Math::Vector<Float>& target() const;
+	/*
+	 * @return true if the target cache is a label cache
+	 */
+	bool hasLabelTargets() const;
+	/*
+	 * @return the corresponding label (only if the target cache is a label cache)
+	 */
+	u32 label() const;
 };
 
 /**
@@ -148,11 +168,6 @@ public:
 	virtual ~LabeledSequenceFeatureReader() {}
 	virtual void initialize();
 
-	/*
-	 * @return the corresponding label
-	 */
-	u32 label() const;
-
 	/*
 	 * @return the number of classes
 	 */
@@ -170,10 +185,13 @@ private:
 	typedef SequenceFeatureReader Precursor;
 protected:
 	SequenceFeatureReader targetReader_;
-	Math::Matrix<Float> target_;
+	mutable Math::Matrix<Float> target_;
+	mutable bool isTargetExpanded_;		// label targets are only expanded to one-hot vectors on request
+	std::vector<u32> labelSequence_;
 
 	virtual void shuffleIndices();
 	virtual void sortSequences();
+	virtual void bucketSequences();
 public:
 	TemporallyAlignedSequenceFeatureReader(const char* name = "features.aligned-feature-reader");
 	virtual ~TemporallyAlignedSequenceFeatureReader() {}
@@ -189,6 +207,14 @@ public:
 	 * @return the corresponding target matrix
 	 */
 	const Math::Matrix<Float>& target() const;
+	/*
+	 * @return true if the target cache is a sequence label cache
+	 */
+	bool hasLabelTargets() const;
+	/*
+	 * @return the corresponding label sequence (only if the target cache is a sequence label cache)
+	 */
+	const std::vector<u32>& labelSequence() const;
 };
 
 /**
@@ -201,17 +227,10 @@ class TemporallyLabeledSequenceFeatureReader : public TemporallyAlignedSequenceF
 private:
 	typedef TemporallyAlignedSequenceFeatureReader Precursor;
 	const Math::Matrix<Float>& target() const { return Precursor::target(); }
-	std::vector<u32> labelSequence_;
 public:
 	TemporallyLabeledSequenceFeatureReader(const char* name = "features.labeled-feature-reader");
 	virtual ~TemporallyLabeledSequenceFeatureReader() {}
 	virtual void initialize();
-	virtual const Math::Matrix<Float>& next();
-
-	/*
-	 * @return the corresponding label sequence
-	 */
-	const std::vector<u32>& labelSequence() const;
 
 	/*
 	 * @return the number of classes
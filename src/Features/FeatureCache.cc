@@ -22,6 +22,9 @@
 
 #include "FeatureCache.hh"
 #include <stdlib.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
 
 using namespace Features;
 
@@ -29,6 +32,9 @@ const Core::ParameterBool FeatureCache::paramLogCacheInformation_("log-cache-inf
 
 const Core::ParameterFloat FeatureCache::paramRawScale_("raw-scale", 1.0, "features.feature-cache"); // set to 1.0/255.0 if images should be in range [0,1]
 
+// memory map binary vector/sequence/label caches instead of reading them through a stream
+const Core::ParameterBool FeatureCache::paramMemoryMapping_("memory-mapping", false, "features.feature-cache");
+
 FeatureCache::FeatureCache() :
 		currentCacheIndex_(0),
 		cacheFile_(0),
@@ -42,13 +48,29 @@ FeatureCache::FeatureCache() :
 		height_(0),
 		channels_(0),
 		inputBuffer_(0),
-		rawScale_(Core::Configuration::config(paramRawScale_))
+		rawScale_(Core::Configuration::config(paramRawScale_)),
+		useMemoryMapping_(Core::Configuration::config(paramMemoryMapping_)),
+		isMapped_(false),
+		isAlignedMapping_(false),
+		mappedData_(0),
+		mappedSize_(0),
+		nextMappedIndex_(0)
 {}
 
+FeatureCache::~FeatureCache() {
+	unmapCacheFile();
+}
+
 void FeatureCache::initialize(const std::string& cacheFilename) {
 	require(!cacheFilename.empty());
 	validateCacheHeaders(cacheFilename);
 
+	if (useMemoryMapping_ && (typeid(*cacheFile_) == typeid(Core::BinaryStream)) &&
+			((featureType_ == vectors) || (featureType_ == sequences) || (featureType_ == labels) || (featureType_ == sequencelabels))) {
+		cacheFile_->close();
+		mapCacheFile(cacheFilename);
+	}
+
 	if (logCacheInformation_) {
 		logCacheInformation(cacheFilename);
 	}
@@ -91,14 +113,7 @@ void FeatureCache::convertImageToVector(cv::Mat& image, u32 column) {
 }
 
 void FeatureCache::convertStringToVector(std::string& str, u32 column) {
-	if ((featureType_ == labels) || (featureType_ == sequencelabels)) {
-		u32 label = atoi(str.c_str());
-		if (label >= featureDim_)
-			Core::Error::msg("FeatureCache::convertStringToVector: label index is ") << label << " but maximum allowed is " << featureDim_ - 1 << "." << Core::Error::abort;
-		inputBuffer_.fill(0, column, featureDim_-1, column, 0);
-		inputBuffer_.at(label, column) = 1.0;
-	}
-	else if ((featureType_ == vectors) || (featureType_ == sequences)) {
+	if ((featureType_ == vectors) || (featureType_ == sequences)) {
 		std::vector< std::string > tokenized;
 		Core::Utils::tokenizeString(tokenized, str);
 		if (tokenized.size() != featureDim_)
@@ -110,13 +125,24 @@ void FeatureCache::convertStringToVector(std::string& str, u32 column) {
 
 void FeatureCache::fillInputBuffer() {
 	require_lt(currentCacheIndex_, caches_.size());
+	// labels are stored as indices, so they need to be converted to one-hot vectors...
+	if ((featureType_ == labels) || (featureType_ == sequencelabels)) {
+		readLabels();
+		inputBuffer_.resize(featureDim_, labelBuffer_.size());
+		inputBuffer_.setToZero();
+		for (u32 t = 0; t < labelBuffer_.size(); t++)
+			inputBuffer_.at(labelBuffer_.at(t), t) = 1.0;
+		return;
+	}
+	if (isMapped_) {
+		readMapped();
+		return;
+	}
 	switch(featureType_) {
 	case vectors:
-	case labels:
 		readVector();
 		break;
 	case sequences:
-	case sequencelabels:
 		readSequence();
 		break;
 	case images:
@@ -138,18 +164,7 @@ void FeatureCache::readVector() {
 	// read binary file
 	if (typeid(*cacheFile_) == typeid(Core::BinaryStream)) {
 		inputBuffer_.resize(featureDim_, 1);
-		// either labels...
-		if ((featureType_ == labels)) {
-			inputBuffer_.setToZero();
-			u32 label;
-			(*cacheFile_) >> label;
-			inputBuffer_.at(label, 0) = 1.0;
-		}
-		// .. or feature vectors
-		else {
-			for (u32 d = 0; d < featureDim_; d++)
-				(*cacheFile_) >> inputBuffer_.at(d, 0);
-		}
+		cacheFile_->read(inputBuffer_.begin(), featureDim_);
 	}
 	// read ascii/gzipped file
 	else {
@@ -167,21 +182,8 @@ void FeatureCache::readSequence() {
 		u32 seqSize;
 		(*cacheFile_) >> seqSize;
 		inputBuffer_.resize(featureDim_, seqSize);
-		// either sequence labels...
-		if (featureType_ == sequencelabels) {
-			inputBuffer_.setToZero();
-			u32 label;
-			for (u32 t = 0; t < seqSize; t++) {
-				(*cacheFile_) >> label;
-				inputBuffer_.at(label, t) = 1.0;
-			}
-		}
-		// ... sequence of feature vectors
-		else {
-			for (u32 t = 0; t < seqSize; t++)
-				for (u32 d = 0; d < featureDim_; d++)
-					(*cacheFile_) >> inputBuffer_.at(d, t);
-		}
+		// frames are stored consecutively, i.e. in column-major order
+		cacheFile_->read(inputBuffer_.begin(), (u64)featureDim_ * seqSize);
 	}
 	// read ascii/gzipped file
 	else {
@@ -197,6 +199,126 @@ void FeatureCache::readSequence() {
 	}
 }
 
+void FeatureCache::readMapped() {
+	require_lt(nextMappedIndex_, offsets_.size());
+	const char* data = mappedData_ + offsets_[nextMappedIndex_];
+	u32 length = 1;
+	if (featureType_ == sequences) {
+		memcpy(&length, data, sizeof(u32));
+		data += sizeof(u32);
+	}
+	// aligned feature vectors are directly used from the read-only mapped memory, unaligned ones are copied
+	if (isAlignedMapping_) {
+		inputBuffer_.useExternalMemory(const_cast<f32*>(reinterpret_cast<const f32*>(data)), featureDim_, length);
+	}
+	else {
+		inputBuffer_.resize(featureDim_, length);
+		memcpy(inputBuffer_.begin(), data, (u64)featureDim_ * length * sizeof(f32));
+	}
+	nextMappedIndex_++;
+}
+
+void FeatureCache::readLabels() {
+	u32 length = 1;
+	if (isMapped_) {
+		require_lt(nextMappedIndex_, offsets_.size());
+		const char* data = mappedData_ + offsets_[nextMappedIndex_];
+		if (featureType_ == sequencelabels) {
+			memcpy(&length, data, sizeof(u32));
+			data += sizeof(u32);
+		}
+		labelBuffer_.resize(length);
+		if (length > 0)
+			memcpy(&(labelBuffer_.at(0)), data, length * sizeof(u32));
+		nextMappedIndex_++;
+	}
+	else if (typeid(*cacheFile_) == typeid(Core::BinaryStream)) {
+		if (featureType_ == sequencelabels)
+			(*cacheFile_) >> length;
+		labelBuffer_.resize(length);
+		if (length > 0)
+			cacheFile_->read(&(labelBuffer_.at(0)), length);
+	}
+	// ascii/gzipped file: one label per line, label sequences are terminated by #
+	else {
+		labelBuffer_.clear();
+		std::string line;
+		if (featureType_ == labels) {
+			if (!cacheFile_->getline(line))
+				Core::Error::msg("FeatureCache::readLabels: unexpected end of file.") << Core::Error::abort;
+			labelBuffer_.push_back(atoi(line.c_str()));
+		}
+		else {
+			while ((cacheFile_->getline(line)) && (line.compare("#") != 0))
+				labelBuffer_.push_back(atoi(line.c_str()));
+		}
+	}
+	for (u32 t = 0; t < labelBuffer_.size(); t++) {
+		if (labelBuffer_.at(t) >= featureDim_)
+			Core::Error::msg("FeatureCache::readLabels: label index is ") << labelBuffer_.at(t) << " but maximum allowed is " << featureDim_ - 1 << "." << Core::Error::abort;
+	}
+}
+
+void FeatureCache::mapCacheFile(const std::string& cacheFilename) {
+	int fd = open(cacheFilename.c_str(), O_RDONLY);
+	if (fd < 0)
+		Core::Error::msg("FeatureCache::mapCacheFile: could not open ") << cacheFilename << "." << Core::Error::abort;
+	struct stat fileStatus;
+	if (fstat(fd, &fileStatus) != 0)
+		Core::Error::msg("FeatureCache::mapCacheFile: could not determine size of ") << cacheFilename << "." << Core::Error::abort;
+	mappedSize_ = fileStatus.st_size;
+	// read-only mapping, the feature readers copy the data before modifying it
+	void* data = mmap(0, mappedSize_, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (data == MAP_FAILED)
+		Core::Error::msg("FeatureCache::mapCacheFile: failed to map ") << cacheFilename << " into memory." << Core::Error::abort;
+	mappedData_ = (const char*)data;
+	isMapped_ = true;
+	buildOffsetIndex();
+}
+
+void FeatureCache::unmapCacheFile() {
+	if (isMapped_) {
+		munmap(const_cast<char*>(mappedData_), mappedSize_);
+		mappedData_ = 0;
+		mappedSize_ = 0;
+		offsets_.clear();
+		isMapped_ = false;
+	}
+}
+
+void FeatureCache::buildOffsetIndex() {
+	// skip the two header lines
+	u64 offset = 0;
+	for (u32 nLines = 0; nLines < 2; offset++) {
+		if (offset >= mappedSize_)
+			Core::Error::msg("FeatureCache::buildOffsetIndex: incomplete cache header.") << Core::Error::abort;
+		if (mappedData_[offset] == '\n')
+			nLines++;
+	}
+	// the mapping starts at a page boundary and all entries have a size of a multiple of four bytes,
+	// so the data is aligned iff the text header is
+	isAlignedMapping_ = (offset % sizeof(f32) == 0);
+	bool isSequence = (featureType_ == sequences) || (featureType_ == sequencelabels);
+	u64 bytesPerFrame = ((featureType_ == labels) || (featureType_ == sequencelabels)) ? sizeof(u32) : featureDim_ * sizeof(f32);
+	offsets_.resize(isSequence ? nSequences_ : cacheSize_);
+	u64 nFrames = 0;
+	for (u32 i = 0; i < offsets_.size(); i++) {
+		offsets_[i] = offset;
+		u32 length = 1;
+		if (isSequence) {
+			if (offset + sizeof(u32) > mappedSize_)
+				Core::Error::msg("FeatureCache::buildOffsetIndex: cache contains less sequences than specified in the header.") << Core::Error::abort;
+			memcpy(&length, mappedData_ + offset, sizeof(u32));
+			offset += sizeof(u32);
+		}
+		offset += length * bytesPerFrame;
+		nFrames += length;
+	}
+	if ((offset > mappedSize_) || (nFrames != cacheSize_))
+		Core::Error::msg("FeatureCache::buildOffsetIndex: cache size does not match the size specified in the header.") << Core::Error::abort;
+}
+
 void FeatureCache::readImage(const std::string& imageFile, u32 column) {
 #ifdef MODULE_OPENCV
 	cv::Mat image = cv::imread(imageFile);
@@ -219,8 +341,9 @@ void FeatureCache::readVideo(const std::vector<std::string>& videoFrames) {
 
 void FeatureCache::reset() {
 	currentCacheIndex_ = 0;
-	// re-open cache file
-	if ((featureType_ == vectors) || (featureType_ == sequences) || (featureType_ == labels) || (featureType_ == sequencelabels)) {
+	nextMappedIndex_ = 0;
+	// re-open cache file (not necessary if the cache is memory mapped)
+	if (!isMapped_ && ((featureType_ == vectors) || (featureType_ == sequences) || (featureType_ == labels) || (featureType_ == sequencelabels))) {
 		cacheFile_->close();
 		cacheFile_->open(caches_[currentCacheIndex_].cacheFilename.back().c_str(), std::ios::in);
 		// skip header
@@ -341,6 +464,26 @@ const Math::Matrix<Float>& FeatureCache::next() {
 	return inputBuffer_;
 }
 
+const std::vector<u32>& FeatureCache::nextLabels() {
+	require((featureType_ == labels) || (featureType_ == sequencelabels));
+	require_lt(currentCacheIndex_, caches_.size());
+	readLabels();
+	return labelBuffer_;
+}
+
+void FeatureCache::skip() {
+	if (isMapped_) {
+		require_lt(nextMappedIndex_, offsets_.size());
+		nextMappedIndex_++;
+	}
+	else if ((featureType_ == labels) || (featureType_ == sequencelabels)) {
+		readLabels();
+	}
+	else {
+		fillInputBuffer();
+	}
+}
+
 void FeatureCache::logCacheInformation(const std::string& cacheFilename) {
 	Core::Log::openTag("feature-cache.information", cacheFilename.c_str());
 	switch (featureType_) {
@@ -356,6 +499,8 @@ void FeatureCache::logCacheInformation(const std::string& cacheFilename) {
 	Core::Log::os("feature vector dimension: ") << featureDim_;
 	if ((featureType_ == sequences) || (featureType_ == videos) || (featureType_ == sequencelabels))
 		Core::Log::os("number of feature sequences: ") << nSequences_;
+	if (isMapped_)
+		Core::Log::os("cache is memory mapped") << (isAlignedMapping_ ? "" : " (unaligned, feature vectors are copied)");
 	Core::Log::closeTag();
 }
 
@@ -53,6 +53,7 @@ class FeatureCache
 private:
 	static const Core::ParameterBool paramLogCacheInformation_;
 	static const Core::ParameterFloat paramRawScale_;
+	static const Core::ParameterBool paramMemoryMapping_;
 public:
 	enum FeatureType { none = 0, vectors = 1, sequences = 2, images = 3, videos = 4, labels = 5, sequencelabels = 6};
 private:
@@ -82,8 +83,18 @@ private:
 	u32 channels_;
 
 	Math::Matrix<f32> inputBuffer_;
+	std::vector<u32> labelBuffer_;	// label indices of the most recently read label/label sequence
 
 	Float rawScale_;
+	// memory mapped binary caches (inputBuffer_ is a view into the mapped file)
+	bool useMemoryMapping_;
+	bool isMapped_;
+	bool isAlignedMapping_;		// the feature vectors in the mapped file are aligned, so they can be used without copying
+	const char* mappedData_;	// read-only mapping, the views into it must not be modified
+	u64 mappedSize_;
+	std::vector<u64> offsets_;		// byte offset of each vector/label/sequence in the mapped file
+	u32 nextMappedIndex_;			// index of the next entry in offsets_ to be returned by next()
+
 	static FeatureType getType(Core::IOStream* stream);
 
 	void convertImageToVector(cv::Mat& image, u32 column = 0);
@@ -92,6 +103,12 @@ private:
 	void readSequence();
 	void readVideo(const std::vector<std::string>& videoFrames);
 	void readImage(const std::string& imageFile, u32 column = 0);
+	void readMapped();
+	void readLabels();
+
+	void mapCacheFile(const std::string& cacheFilename);
+	void unmapCacheFile();
+	void buildOffsetIndex();
 
 	std::vector<u32> getCacheHeaderSpecifications();
 	void fillInputBuffer();
@@ -100,7 +117,7 @@ private:
 	void logCacheInformation(const std::string& cacheFilename);
 public:
 	FeatureCache();
-	virtual ~FeatureCache() {}
+	virtual ~FeatureCache();
 	virtual void initialize(const std::string& cacheFilename);
 
 	void setLogCacheInformation(bool logCacheInformation);
@@ -122,9 +139,20 @@ public:
 	/**
 	 * use this functions to access the data
 	 * @return the next float/int in the cache(s) (header excluded)
+	 * for memory mapped caches the returned matrix is a view into the mapped file and is valid until the next call
 	 */
 	const Math::Matrix<Float>& next();
 
+	/**
+	 * label caches only: read the next label (sequence) as class indices without expanding it to one-hot vectors
+	 */
+	const std::vector<u32>& nextLabels();
+
+	/**
+	 * skip the next feature vector/sequence without returning it (cheap for memory mapped caches)
+	 */
+	void skip();
+
 	/**
 	 * return the FeatureType of the specified cache file
 	 */
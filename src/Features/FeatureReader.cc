@@ -39,6 +39,11 @@ const Core::ParameterBool BaseFeatureReader::paramShuffleBuffer_("shuffle-buffer
 
 const Core::ParameterStringList BaseFeatureReader::paramPreprocessingSteps_("preprocessors", "", "features.feature-reader");
 
+// deterministic sharding of the cache, e.g. for data parallel training
+const Core::ParameterInt BaseFeatureReader::paramNumberOfShards_("number-of-shards", 1, "features.feature-reader");
+
+const Core::ParameterInt BaseFeatureReader::paramShardIndex_("shard-index", 0, "features.feature-reader");
+
 BaseFeatureReader::BaseFeatureReader(const char* name) :
 		name_(name),
 		cacheFile_(Core::Configuration::config(paramCacheFile_, name_)),
@@ -52,6 +57,9 @@ BaseFeatureReader::BaseFeatureReader(const char* name) :
 		nextFeatureIndex_(0),
 		currentFeatureIndex_(0),
 		preprocessorNames_(Core::Configuration::config(paramPreprocessingSteps_, name_)),
+		nShards_(Core::Configuration::config(paramNumberOfShards_, name_)),
+		shardIndex_(Core::Configuration::config(paramShardIndex_, name_)),
+		nextCacheEntry_(0),
 		isInitialized_(false)
 {}
 
@@ -69,6 +77,9 @@ BaseFeatureReader::BaseFeatureReader(const char* name, const std::string& cacheF
 		nextFeatureIndex_(0),
 		currentFeatureIndex_(0),
 		preprocessorNames_(preprocessors),
+		nShards_(Core::Configuration::config(paramNumberOfShards_, name_)),
+		shardIndex_(Core::Configuration::config(paramShardIndex_, name_)),
+		nextCacheEntry_(0),
 		isInitialized_(false)
 {}
 
@@ -77,8 +88,11 @@ void BaseFeatureReader::initialize() {
 		std::cerr << "FeatureReader " << name_ << ": no cache file specified. Abort." << std::endl;
 		exit(1);
 	}
+	require_gt(nShards_, 0);
+	require_lt(shardIndex_, nShards_);
 	// initialize cache file
 	cache_.initialize(cacheFile_);
+	nextCacheEntry_ = 0;
 	// create and initialize preprocessors
 	if ( ((cache_.featureType() == FeatureCache::labels) || (cache_.featureType() == FeatureCache::sequencelabels) )
 			&& (preprocessorNames_.size() != 0)) {
@@ -127,7 +141,9 @@ void BaseFeatureReader::readFeatureVector(Math::Matrix<Float>& f) {
 	case FeatureCache::images:
 	case FeatureCache::labels:
 		{
+		skipToShard();
 		const Math::Matrix<Float>& next = cache_.next();
+		nextCacheEntry_++;
 		f.resize(next.nRows(), next.nColumns());
 		f.copy(next);
 		}
@@ -145,9 +161,18 @@ void BaseFeatureReader::readFeatureSequence(Math::Matrix<Float>& f) {
 	case FeatureCache::videos:
 	case FeatureCache::sequencelabels:
 		{
+		skipToShard();
 		const Math::Matrix<Float>& next = cache_.next();
-		f.resize(next.nRows(), next.nColumns());
-		f.copy(next);
+		nextCacheEntry_++;
+		// memory mapped cache: share the read-only mapped memory instead of copying the sequence
+		// (only if no preprocessor works on the sequence, the shared sequence must never be modified)
+		if ((!next.ownsMemory()) && (preprocessors_.size() == 0)) {
+			f.useExternalMemory(const_cast<Float*>(next.begin()), next.nRows(), next.nColumns());
+		}
+		else {
+			f.resize(next.nRows(), next.nColumns());
+			f.copy(next);
+		}
 		}
 		break;
 	default:
@@ -156,6 +181,21 @@ void BaseFeatureReader::readFeatureSequence(Math::Matrix<Float>& f) {
 	}
 }
 
+const std::vector<u32>& BaseFeatureReader::readLabels() {
+	require(isLabelCache());
+	skipToShard();
+	const std::vector<u32>& labels = cache_.nextLabels();
+	nextCacheEntry_++;
+	return labels;
+}
+
+void BaseFeatureReader::skipToShard() {
+	while (nextCacheEntry_ % nShards_ != shardIndex_) {
+		cache_.skip();
+		nextCacheEntry_++;
+	}
+}
+
 void BaseFeatureReader::applyPreprocessors(Math::Matrix<Float>& in, Math::Matrix<Float>& out) {
 	for (u32 p = 0; p < preprocessors_.size(); p++) {
 		preprocessors_.at(p)->work(in, out);
@@ -172,10 +212,7 @@ void BaseFeatureReader::shuffleIndices() {
 	std::random_shuffle(reorderedIndices_.begin(), reorderedIndices_.end(), Math::Random::randomIntBelow);
 }
 
-u32 BaseFeatureReader::nextFeature() {
-	require(isInitialized_);
-	// there must be at least one more feature vector to process
-	require(nProcessedFeatures_ < cache_.cacheSize());
+void BaseFeatureReader::prepareNextFeature() {
 	// check if buffer needs to be refilled
 	if (allBufferedFeaturesRead()) {
 		fillBuffer();
@@ -184,6 +221,13 @@ u32 BaseFeatureReader::nextFeature() {
 			shuffleIndices();
 		}
 	}
+}
+
+u32 BaseFeatureReader::nextFeature() {
+	require(isInitialized_);
+	// there must be at least one more feature vector to process
+	require(nProcessedFeatures_ < shardSize(cache_.cacheSize()));
+	prepareNextFeature();
 	require_lt(nextFeatureIndex_, nBufferedFeatures_);
 	u32 index = nextFeatureIndex_;
 	if (reorderBuffer_) {
@@ -206,6 +250,10 @@ FeatureCache::FeatureType BaseFeatureReader::getFeatureType() const {
 	return cache_.featureType();
 }
 
+bool BaseFeatureReader::isLabelCache() const {
+	return (cache_.featureType() == FeatureCache::labels) || (cache_.featureType() == FeatureCache::sequencelabels);
+}
+
 const std::string& BaseFeatureReader::getCacheFilename() const {
 	return cacheFile_;
 }
@@ -216,7 +264,9 @@ bool BaseFeatureReader::shuffleBuffer() const {
 
 u32 BaseFeatureReader::totalNumberOfFeatures() const {
 	require(isInitialized_);
-	return cache_.cacheSize();
+	if (isSequenceReader() && (nShards_ > 1))
+		return cache_.cacheSize();
+	return shardSize(cache_.cacheSize());
 }
 
 u32 BaseFeatureReader::featureDimension() const {
@@ -231,9 +281,10 @@ void BaseFeatureReader::newEpoch() {
 	require(isInitialized_);
 	resetBuffer();
 	// if cache does not fit completely into buffer...
-	if  (   ((!isSequenceReader())   && (cache_.cacheSize() > bufferSize_))   ||
-			(  isSequenceReader()    && (cache_.nSequences() > bufferSize_))   ) {
+	if  (   ((!isSequenceReader())   && (shardSize(cache_.cacheSize()) > bufferSize_))   ||
+			(  isSequenceReader()    && (shardSize(cache_.nSequences()) > bufferSize_))   ) {
 		cache_.reset();
+		nextCacheEntry_ = 0;
 		nBufferedFeatures_ = 0;
 	}
 	// generate a new random order
@@ -241,7 +292,7 @@ void BaseFeatureReader::newEpoch() {
 		shuffleIndices();
 	}
 	nProcessedFeatures_ = 0;
-	nRemainingFeaturesInCache_ = cache_.cacheSize();
+	nRemainingFeaturesInCache_ = shardSize(cache_.cacheSize());
 }
 
 /*
@@ -268,17 +319,19 @@ void FeatureReader::initialize() {
 		Precursor::initialize();
 		if (shuffleBuffer_)
 			Math::Random::initializeSRand();
-		nRemainingFeaturesInCache_ = cache_.cacheSize();
+		nRemainingFeaturesInCache_ = shardSize(cache_.cacheSize());
 		if (bufferSize_ == 0) {
 			Core::Log::openTag("feature-reader");
-			Core::Log::os("buffer size is 0. Set buffer size to ") << cache_.cacheSize() << (" (#features in cache).");
+			Core::Log::os("buffer size is 0. Set buffer size to ") << shardSize(cache_.cacheSize()) << (" (#features in cache).");
 			Core::Log::closeTag();
-			bufferSize_ = cache_.cacheSize();
+			bufferSize_ = shardSize(cache_.cacheSize());
 			buffer_.resize(bufferSize_);
 		}
 		labelBuffer_.resize(cache_.featureDim());
 		// if the cache has sequence format, read whole sequences at once
 		needsContext_ = (cache_.featureType() == FeatureCache::sequences) || (cache_.featureType() == FeatureCache::videos) || (cache_.featureType() == FeatureCache::sequencelabels);
+		if (needsContext_ && (nShards_ > 1))
+			Core::Error::msg("FeatureReader::initialize: sharding of frame-wise read sequence caches is not supported.") << Core::Error::abort;
 		isInitialized_ = true;
 	}
 }
@@ -288,23 +341,27 @@ void FeatureReader::bufferNext() {
 	require(nBufferedFeatures_ < bufferSize_);
 	Math::Matrix<Float> in;
 
-	if (!needsContext_) {
+	if (isLabelCache()) {
+		/* label caches: only store the class index (labels of a sequence cache are read at once) */
+		if (prebufferPointer_ == 0)
+			prebufferedLabels_ = readLabels();
+		buffer_.at(nBufferedFeatures_).resize(1);
+		buffer_.at(nBufferedFeatures_).at(0) = prebufferedLabels_.at(prebufferPointer_);
+		prebufferPointer_++;
+		if (prebufferPointer_ >= prebufferedLabels_.size())
+			prebufferPointer_ = 0;
+	}
+	else if (!needsContext_) {
 		/* if no context required: read a single feature vector */
 		Math::Matrix<Float> out;
 		readFeatureVector(in);
 		applyPreprocessors(in, out);
 		// store result in buffer
-		if ((cache_.featureType() == FeatureCache::labels) || (cache_.featureType() == FeatureCache::sequencelabels)) {
-			buffer_.at(nBufferedFeatures_).resize(1);
-			buffer_.at(nBufferedFeatures_).at(0) = out.argAbsMax(0);
-		}
-		else {
-			buffer_.at(nBufferedFeatures_).swap(out);
-		}
+		buffer_.at(nBufferedFeatures_).swap(out);
 	}
 	else {
 		/* ensure the feature cache is a sequence cache */
-		if (! ((cache_.featureType() == FeatureCache::sequences) || (cache_.featureType() == FeatureCache::videos) || (cache_.featureType() == FeatureCache::sequencelabels)) )
+		if (! ((cache_.featureType() == FeatureCache::sequences) || (cache_.featureType() == FeatureCache::videos)) )
 			Core::Error::msg("FeatureReader: Preprocessors need sequence context but cache-file is not in sequence format.") << Core::Error::abort;
 		/* if context required: read a sequence */
 		if (prebufferPointer_ == 0) {
@@ -312,13 +369,7 @@ void FeatureReader::bufferNext() {
 			applyPreprocessors(in, prebufferedSequence_);
 		}
 		// store result in buffer
-		if ((cache_.featureType() == FeatureCache::labels) || (cache_.featureType() == FeatureCache::sequencelabels)) {
-			buffer_.at(nBufferedFeatures_).resize(1);
-			buffer_.at(nBufferedFeatures_).at(0) = prebufferedSequence_.argAbsMax(prebufferPointer_);
-		}
-		else {
-			prebufferedSequence_.getColumn(prebufferPointer_, buffer_.at(nBufferedFeatures_));
-		}
+		prebufferedSequence_.getColumn(prebufferPointer_, buffer_.at(nBufferedFeatures_));
 		prebufferPointer_++;
 		if (prebufferPointer_ >= prebufferedSequence_.nColumns())
 			prebufferPointer_ = 0;
@@ -327,13 +378,13 @@ void FeatureReader::bufferNext() {
 
 bool FeatureReader::hasFeatures() const {
 	require(isInitialized_);
-	return (nProcessedFeatures_ < cache_.cacheSize());
+	return (nProcessedFeatures_ < shardSize(cache_.cacheSize()));
 }
 
 const Math::Vector<Float>& FeatureReader::next() {
 	u32 index = nextFeature();
 	currentFeatureIndex_ = index;
-	if ((cache_.featureType() == FeatureCache::labels) || (cache_.featureType() == FeatureCache::sequencelabels)) {
+	if (isLabelCache()) {
 		labelBuffer_.setToZero();
 		labelBuffer_.at((u32)buffer_.at(index).at(0)) = 1.0;
 		return labelBuffer_;
@@ -343,22 +394,59 @@ const Math::Vector<Float>& FeatureReader::next() {
 	}
 }
 
+u32 FeatureReader::nextLabel() {
+	require(isLabelCache());
+	u32 index = nextFeature();
+	currentFeatureIndex_ = index;
+	return (u32)buffer_.at(index).at(0);
+}
+
+void FeatureReader::setLabels(const std::vector<u32>& labels) {
+	require(isInitialized_);
+	require(isLabelCache());
+	require_eq(labels.size(), totalNumberOfFeatures());
+	if ((bufferSize_ < labels.size()) || (nShards_ > 1))
+		Core::Error::msg("FeatureReader::setLabels: the complete label cache ") << cacheFile_ << " must be buffered." << Core::Error::abort;
+	// nothing has been buffered yet: the given labels replace the cache content
+	if (nBufferedFeatures_ == 0) {
+		resetBuffer();
+		nBufferedFeatures_ = labels.size();
+		nRemainingFeaturesInCache_ = 0;
+	}
+	require_eq(nBufferedFeatures_, labels.size());
+	for (u32 i = 0; i < labels.size(); i++) {
+		require_lt(labels.at(i), cache_.featureDim());
+		buffer_.at(i).resize(1);
+		buffer_.at(i).at(0) = labels.at(i);
+	}
+}
+
 /*
  * SequenceFeatureReader
  */
 const Core::ParameterBool SequenceFeatureReader::paramSortSequences_("sort-sequences", false, "features.feature-reader");
 
+// group the buffered sequences into buckets of sequences with similar length and read the buckets in random order
+// (use the mini-batch size as bucket size and a multiple of it as buffer size to minimize the padding within the mini-batches)
+const Core::ParameterInt SequenceFeatureReader::paramBucketSize_("bucket-size", 0, "features.feature-reader");
+
 SequenceFeatureReader::SequenceFeatureReader(const char* name) :
 		Precursor(name),
 		buffer_(bufferSize_),
 		currentSequenceLength_(0),
-		sortSequences_(Core::Configuration::config(paramSortSequences_, name_))
+		sortSequences_(Core::Configuration::config(paramSortSequences_, name_)),
+		bucketSize_(Core::Configuration::config(paramBucketSize_, name_))
 {
 	if (shuffleBuffer_ && sortSequences_) {
 		std::cerr << "SequenceFeatureReader: shuffle-buffer and sort-sequences cannot be selected at the same time" << std::endl;
 		exit(1);
 	}
-	reorderBuffer_ = (reorderBuffer_ || sortSequences_);
+	// the buckets are read in random order, so bucketing replaces both, shuffling and sorting
+	if ((bucketSize_ > 0) && (shuffleBuffer_ || sortSequences_)) {
+		std::cerr << "SequenceFeatureReader: bucket-size cannot be combined with shuffle-buffer or sort-sequences" << std::endl;
+		exit(1);
+	}
+	reorderBuffer_ = (reorderBuffer_ || sortSequences_ || (bucketSize_ > 0));
 }
 
 SequenceFeatureReader::SequenceFeatureReader(const char* name, const std::string& cacheFile, u32 bufferSize, bool shuffleBuffer,
@@ -366,24 +454,25 @@ SequenceFeatureReader::SequenceFeatureReader(const char* name, const std::string
 		Precursor(name, cacheFile, bufferSize, shuffleBuffer, preprocessors),
 		buffer_(bufferSize_),
 		currentSequenceLength_(0),
-		sortSequences_(sortSequences)
+		sortSequences_(sortSequences),
+		bucketSize_(0)
 {}
 
 void SequenceFeatureReader::initialize() {
 	if (!isInitialized_) {
 		Precursor::initialize();
-		if (shuffleBuffer_)
+		if (shuffleBuffer_ || (bucketSize_ > 0))
 			Math::Random::initializeSRand();
 		if ((!cache_.featureType() == FeatureCache::sequences) || (!cache_.featureType() == FeatureCache::videos) || (!cache_.featureType() == FeatureCache::sequencelabels)) {
 			std::cerr << "Error: Cache " << cacheFile_ << " is not in sequence format. Abort." << std::endl;
 			exit(1);
 		}
-		nRemainingFeaturesInCache_ = cache_.nSequences();
+		nRemainingFeaturesInCache_ = shardSize(cache_.nSequences());
 		if (bufferSize_ == 0) {
 			Core::Log::openTag("feature-reader");
-			Core::Log::os("buffer size is 0. Set buffer size to ") << cache_.nSequences() << (" (#sequences in cache).");
+			Core::Log::os("buffer size is 0. Set buffer size to ") << shardSize(cache_.nSequences()) << (" (#sequences in cache).");
 			Core::Log::closeTag();
-			bufferSize_ = cache_.nSequences();
+			bufferSize_ = shardSize(cache_.nSequences());
 			buffer_.resize(bufferSize_);
 		}
 		isInitialized_ = true;
@@ -398,57 +487,96 @@ void SequenceFeatureReader::sortSequences() {
 	std::sort(reorderedIndices_.begin(), reorderedIndices_.end(), SequenceLengthComparator(this));
 }
 
+void SequenceFeatureReader::bucketSequences() {
+	// random order of sequences with equal length
+	std::vector<u32> indices(nBufferedFeatures_);
+	for (u32 i = 0; i < nBufferedFeatures_; i++)
+		indices.at(i) = i;
+	std::random_shuffle(indices.begin(), indices.end(), Math::Random::randomIntBelow);
+	std::stable_sort(indices.begin(), indices.end(), SequenceLengthComparator(this));
+	// consecutive sequences in the sorted order form a bucket, the buckets are read in random order
+	u32 nBuckets = (nBufferedFeatures_ + bucketSize_ - 1) / bucketSize_;
+	std::vector<u32> buckets(nBuckets);
+	for (u32 b = 0; b < nBuckets; b++)
+		buckets.at(b) = b;
+	std::random_shuffle(buckets.begin(), buckets.end(), Math::Random::randomIntBelow);
+	reorderedIndices_.clear();
+	for (u32 b = 0; b < nBuckets; b++) {
+		u32 end = std::min((buckets.at(b) + 1) * bucketSize_, nBufferedFeatures_);
+		for (u32 i = buckets.at(b) * bucketSize_; i < end; i++)
+			reorderedIndices_.push_back(indices.at(i));
+	}
+}
+
 void SequenceFeatureReader::fillBuffer() {
 	Precursor::fillBuffer();
 	if (sortSequences_) {
 		sortSequences();
 	}
+	if (bucketSize_ > 0) {
+		bucketSequences();
+	}
 }
 
 void SequenceFeatureReader::bufferNext() {
 	require(nRemainingFeaturesInCache_ > 0);
 	require(nBufferedFeatures_ < bufferSize_);
 
-	// read a feature sequence
-	Math::Matrix<Float> in;
-	readFeatureSequence(in);
-	currentSequenceLength_ = in.nColumns();
-	if (cache_.featureType() == FeatureCache::sequencelabels) {
-		Math::Vector<u32> tmp(in.nColumns());
-		in.argMax(tmp);
-		buffer_.at(nBufferedFeatures_).resize(1, in.nColumns());
-		buffer_.at(nBufferedFeatures_).copy(tmp.begin());
+	// label sequences are stored as a single row of class indices
+	if (isLabelCache()) {
+		const std::vector<u32>& labels = readLabels();
+		currentSequenceLength_ = labels.size();
+		buffer_.at(nBufferedFeatures_).resize(1, labels.size());
+		for (u32 t = 0; t < labels.size(); t++)
+			buffer_.at(nBufferedFeatures_).at(0, t) = labels.at(t);
 	}
+	// read a feature sequence
 	else {
+		Math::Matrix<Float> in;
+		readFeatureSequence(in);
+		currentSequenceLength_ = in.nColumns();
 		applyPreprocessors(in, buffer_.at(nBufferedFeatures_));
 	}
 }
 
 u32 SequenceFeatureReader::totalNumberOfSequences() const {
-	return cache_.nSequences();
+	return shardSize(cache_.nSequences());
 }
 
 bool SequenceFeatureReader::hasSequences() const {
 	require(isInitialized_);
-	return (nProcessedFeatures_ < cache_.nSequences());
+	return (nProcessedFeatures_ < shardSize(cache_.nSequences()));
 }
 
 bool SequenceFeatureReader::areSequencesSorted() const {
 	return sortSequences_;
 }
 
+u32 SequenceFeatureReader::nextSequenceLength() {
+	require(isInitialized_);
+	require(hasSequences());
+	prepareNextFeature();
+	require_lt(nextFeatureIndex_, nBufferedFeatures_);
+	u32 index = (reorderBuffer_ ? reorderedIndices_.at(nextFeatureIndex_) : nextFeatureIndex_);
+	return buffer_.at(index).nColumns();
+}
+
 void SequenceFeatureReader::newEpoch() {
 	Precursor::newEpoch();
-	nRemainingFeaturesInCache_ = cache_.nSequences();
+	nRemainingFeaturesInCache_ = shardSize(cache_.nSequences());
+	// if the buffer is kept (whole cache fits into it), draw a new order of the buckets
+	if ((bucketSize_ > 0) && (nBufferedFeatures_ > 0)) {
+		bucketSequences();
+	}
 }
 
 const Math::Matrix<Float>& SequenceFeatureReader::next() {
 	// there must be at least one more feature sequence to process
-	require(nProcessedFeatures_ < cache_.nSequences());
+	require(nProcessedFeatures_ < shardSize(cache_.nSequences()));
 	u32 index = nextFeature();
 	currentFeatureIndex_ = index;
-	// if feature cache
-	if (cache_.featureType() == FeatureCache::sequencelabels) {
+	// if label cache
+	if (isLabelCache()) {
 		labelBuffer_.resize(cache_.featureDim(), buffer_.at(index).nColumns());
 		labelBuffer_.setToZero();
 		for (u32 col = 0; col < labelBuffer_.nColumns(); col++)
@@ -460,6 +588,17 @@ const Math::Matrix<Float>& SequenceFeatureReader::next() {
 	}
 }
 
+const std::vector<u32>& SequenceFeatureReader::nextLabelSequence() {
+	require(isLabelCache());
+	require(nProcessedFeatures_ < shardSize(cache_.nSequences()));
+	u32 index = nextFeature();
+	currentFeatureIndex_ = index;
+	labelSequence_.resize(buffer_.at(index).nColumns());
+	for (u32 t = 0; t < labelSequence_.size(); t++)
+		labelSequence_.at(t) = (u32)buffer_.at(index).at(0, t);
+	return labelSequence_;
+}
+
 /*
  * LabelReader
  */
@@ -482,11 +621,6 @@ void LabelReader::initialize() {
 	}
 }
 
-u32 LabelReader::nextLabel() {
-	const Math::Vector<Float>& v = Precursor::next();
-	return v.argAbsMax();
-}
-
 /*
  * SequenceLabelReader
  */
@@ -508,12 +642,3 @@ void SequenceLabelReader::initialize() {
 		Core::Error::msg("Error: SequenceLabelReader must not have any preprocessors.") << Core::Error::abort;
 	}
 }
-
-const std::vector<u32>& SequenceLabelReader::nextLabelSequence() {
-	const Math::Matrix<Float>& m = Precursor::next();
-	labels_.resize(m.nColumns());
-	for (u32 i = 0; i < labels_.size(); i++) {
-		labels_.at(i) = m.argAbsMax(i);
-	}
-	return labels_;
-}
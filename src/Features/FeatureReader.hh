@@ -40,6 +40,8 @@ private:
 	static const Core::ParameterInt paramBufferSize_;
 	static const Core::ParameterBool paramShuffleBuffer_;
 	static const Core::ParameterStringList paramPreprocessingSteps_;
+	static const Core::ParameterInt paramNumberOfShards_;
+	static const Core::ParameterInt paramShardIndex_;
 protected:
 	const char* name_;				// name of the feature reader (important, if multiple feature readers exist)
 
@@ -58,6 +60,12 @@ protected:
 	std::vector<std::string> preprocessorNames_;	// names of the preprocessors
 	std::vector<Preprocessor*> preprocessors_;		// sequence of preprocessors applied to the features
 
+	// sharding: only the cache entries shardIndex_, shardIndex_ + nShards_, ... are read
+	// all shards have the same size, the remaining (less than nShards_) entries are not used
+	u32 nShards_;
+	u32 shardIndex_;
+	u32 nextCacheEntry_;							// index of the entry that the next call of cache_.next() returns
+
 	bool isInitialized_;
 
 	void resetBuffer();
@@ -66,9 +74,13 @@ protected:
 	bool allBufferedFeaturesRead();
 	void readFeatureVector(Math::Matrix<Float>& f);
 	void readFeatureSequence(Math::Matrix<Float>& f);
+	const std::vector<u32>& readLabels();		// label caches: next label (sequence) as class indices
 	void applyPreprocessors(Math::Matrix<Float>& in, Math::Matrix<Float>& out);
+	void skipToShard();				// skip cache entries that belong to other shards
+	u32 shardSize(u32 nEntries) const { return nEntries / nShards_; }
 	virtual void bufferNext() = 0;
-	virtual bool isSequenceReader() = 0;
+	virtual bool isSequenceReader() const = 0;
+	void prepareNextFeature();		// fill buffer and shuffle indices if all buffered features have been read
 	u32 nextFeature();				// get index of next feature (and fill buffer, shuffle indices)
 public:
 	BaseFeatureReader(const char* name);
@@ -99,6 +111,11 @@ public:
 	 */
 	FeatureCache::FeatureType getFeatureType() const;
 
+	/*
+	 * @return true if the cache is a label or sequence label cache
+	 */
+	bool isLabelCache() const;
+
 	/*
 	 * @return the file name of the feature cache
 	 */
@@ -110,10 +127,17 @@ public:
 	bool shuffleBuffer() const;
 
 	/*
-	 * @return the total number of features in the cache
+	 * @return the total number of features in the cache (in the shard of this reader)
+	 * for sequence readers with more than one shard, the number of features in the complete cache is returned
 	 */
 	u32 totalNumberOfFeatures() const;
 
+	/*
+	 * @return the number of shards and the index of the shard that is read
+	 */
+	u32 nShards() const { return nShards_; }
+	u32 shardIndex() const { return shardIndex_; }
+
 	/*
 	 * @return the dimension of a feature vector
 	 */
@@ -139,8 +163,9 @@ protected:
 	bool needsContext_;
 	Math::Matrix<Float> prebufferedSequence_;
 	Math::Vector<Float> labelBuffer_; // only used if cache is a label cache, labelBuffer will contain a 1-hot encoding
+	std::vector<u32> prebufferedLabels_;
 	u32 prebufferPointer_;
-	virtual bool isSequenceReader() { return false; }
+	virtual bool isSequenceReader() const { return false; }
 	virtual void bufferNext();
 public:
 	FeatureReader(const char* name = "features.feature-reader");
@@ -159,6 +184,17 @@ public:
 	 * @return the next feature vector to be processed (with index currentFeatureIndex_)
 	 */
 	virtual const Math::Vector<Float>& next();
+
+	/*
+	 * label caches only: same as next() but returns the class index instead of a one-hot vector
+	 */
+	u32 nextLabel();
+
+	/*
+	 * label caches only: replace the buffered labels by the given labels (one per cache entry, in cache order)
+	 * the complete cache must fit into the buffer, the current read position and buffer order are kept
+	 */
+	void setLabels(const std::vector<u32>& labels);
 };
 
 /**
@@ -173,6 +209,7 @@ class SequenceFeatureReader : public BaseFeatureReader
 private:
 	typedef BaseFeatureReader Precursor;
 	static const Core::ParameterBool paramSortSequences_;
+	static const Core::ParameterInt paramBucketSize_;
 private:
 	/* helper struct for sorting the sequences according to their length */
 	struct SequenceLengthComparator {
@@ -186,13 +223,16 @@ private:
 protected:
 	std::vector< Math::Matrix<Float> > buffer_;	// the feature buffer
 	Math::Matrix<Float> labelBuffer_;           // only used if cache is a label cache, labelBuffer will contain a 1-hot encoding
+	std::vector<u32> labelSequence_;
 	u32 currentSequenceLength_;					// number of feature vectors in the current sequence
 	bool sortSequences_;						// sort sequences according to length in descending order if true
+	u32 bucketSize_;							// number of sequences of similar length that are read consecutively (0: no bucketing)
 
 	virtual void fillBuffer();
-	virtual bool isSequenceReader() { return true; }
+	virtual bool isSequenceReader() const { return true; }
 	virtual void bufferNext();
 	virtual void sortSequences();
+	virtual void bucketSequences();
 public:
 	SequenceFeatureReader(const char* name = "features.feature-reader");
 	SequenceFeatureReader(const char* name, const std::string& cacheFile, u32 bufferSize, bool shuffleBuffer,
@@ -216,6 +256,11 @@ public:
 	 */
 	bool areSequencesSorted() const;
 
+	/*
+	 * @return the length of the sequence that is returned by the next call of next() (fills the buffer if necessary)
+	 */
+	u32 nextSequenceLength();
+
 	/*
 	 * resets the buffer such that all feature sequences can again be accessed via next()
 	 */
@@ -225,6 +270,11 @@ public:
 	 * @return the next feature sequence to be processed (with index currentFeatureIndex_)
 	 */
 	virtual const Math::Matrix<Float>& next();
+
+	/*
+	 * sequence label caches only: same as next() but returns the class indices instead of one-hot vectors
+	 */
+	const std::vector<u32>& nextLabelSequence();
 };
 
 /**
@@ -242,11 +292,6 @@ public:
 	virtual ~LabelReader() {}
 
 	virtual void initialize();
-
-	/*
-	 * @return the next label
-	 */
-	u32 nextLabel();
 };
 
 /**
@@ -258,19 +303,12 @@ class SequenceLabelReader : public SequenceFeatureReader
 {
 private:
 	typedef SequenceFeatureReader Precursor;
-protected:
-	std::vector<u32> labels_;
 public:
 	SequenceLabelReader(const char* name = "features.label-reader");
 	SequenceLabelReader(const char* name, const std::string& cacheFile, u32 bufferSize, bool shuffleBuffer, bool sortSequences);
 	virtual ~SequenceLabelReader() {}
 
 	virtual void initialize();
-
-	/*
-	 * @return the next label sequence
-	 */
-	const std::vector<u32>& nextLabelSequence();
 };
 
 } // namespace
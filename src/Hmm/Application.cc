@@ -22,9 +22,12 @@
 
 #include "Application.hh"
 #include "GrammarGenerator.hh"
+#include "HmmEstimator.hh"
 #include "ViterbiDecoding.hh"
 #include <Features/FeatureReader.hh>
 #include <Features/FeatureWriter.hh>
+#include <Nn/Trainer.hh>
+#include <Core/OpenMPWrapper.hh>
 #include <iostream>
 #include <sstream>
 
@@ -32,7 +35,33 @@ using namespace Hmm;
 
 APPLICATION(Hmm::Application)
 
-const Core::ParameterEnum Application::paramAction_("action", "none, generate-grammar, viterbi-decoding, realignment", "none");
+const Core::ParameterEnum Application::paramAction_("action", "none, generate-grammar, viterbi-decoding, realignment, linear-alignment, estimate-hmm-parameters, reestimate-hmm, training-realignment", "none");
+
+// number of sequences that are decoded in parallel
+const Core::ParameterInt Application::paramNumberOfThreads_("number-of-threads", 1, "viterbi-decoding");
+
+// number of sequences that are scored before they are decoded in parallel (only used if number-of-threads > 1)
+const Core::ParameterInt Application::paramBatchSize_("batch-size", 64, "viterbi-decoding");
+
+// mini-batch size of the neural network training (training-realignment)
+const Core::ParameterInt Application::paramTrainingBatchSize_("batch-size", 1, "");
+
+// number of alternations between training and realignment
+const Core::ParameterInt Application::paramNumberOfIterations_("number-of-iterations", 1, "training-realignment");
+
+// number of training epochs before each realignment
+const Core::ParameterInt Application::paramEpochsPerIteration_("epochs-per-iteration", 1, "training-realignment");
+
+// estimate the loop probabilities and the state prior from each new alignment
+const Core::ParameterBool Application::paramEstimateHmmParameters_("estimate-hmm-parameters", true, "training-realignment");
+
+Application::DecodingBatch::DecodingBatch(u32 batchSize) :
+		frameScores(batchSize),
+		labelSequences(batchSize),
+		scores(batchSize),
+		segmentations(batchSize),
+		recognitions(batchSize)
+{}
 
 void Application::main() {
 
@@ -50,13 +79,53 @@ void Application::main() {
 	case realignment:
 		realign();
 		break;
+	case linearAlignment:
+		{
+		HmmEstimator e;
+		e.linearAlignment();
+		}
+		break;
+	case estimateHmmParameters:
+		{
+		HmmEstimator e;
+		e.estimateParameters();
+		}
+		break;
+	case reestimateHmm:
+		{
+		HmmEstimator e;
+		e.reestimate();
+		}
+		break;
+	case trainingRealignment:
+		trainRealign();
+		break;
 	case none:
 	default:
 		Core::Error::msg("No action given.") << Core::Error::abort;
 	}
 }
 
+void Application::logResult(Float score, const std::vector<ViterbiDecoding::ActionSegment>& segmentation) {
+	Core::Log::openTag("sequence");
+	Core::Log::openTag("score");
+	Core::Log::os() << score;
+	Core::Log::closeTag();
+	Core::Log::openTag("recognized");
+	std::stringstream s;
+	for (u32 i = 0; i < segmentation.size(); i++)
+		s << segmentation.at(i).label << ":" << segmentation.at(i).length << " ";
+	Core::Log::os(s.str().c_str());
+	Core::Log::closeTag();
+	Core::Log::closeTag();
+}
+
 void Application::decode() {
+	if (Core::Configuration::config(paramNumberOfThreads_) > 1) {
+		decodeParallel(false);
+		return;
+	}
+
 	ViterbiDecoding v;
 	v.initialize();
 	v.sanityCheck();
@@ -68,17 +137,7 @@ void Application::decode() {
 
 	while (reader.hasSequences()) {
 		Float score = v.decode(reader.next());
-		Core::Log::openTag("sequence");
-		Core::Log::openTag("score");
-		Core::Log::os() << score;
-		Core::Log::closeTag();
-		Core::Log::openTag("recognized");
-		std::stringstream s;
-		for (u32 i = 0; i < v.segmentation().size(); i++)
-			s << v.segmentation().at(i).label << ":" << v.segmentation().at(i).length << " ";
-		Core::Log::os(s.str().c_str());
-		Core::Log::closeTag();
-		Core::Log::closeTag();
+		logResult(score, v.segmentation());
 		labelWriter.write(v.framewiseRecognition());
 	}
 
@@ -86,6 +145,11 @@ void Application::decode() {
 }
 
 void Application::realign() {
+	if (Core::Configuration::config(paramNumberOfThreads_) > 1) {
+		decodeParallel(true);
+		return;
+	}
+
 	ViterbiDecoding v;
 	v.initialize();
 
@@ -100,19 +164,194 @@ void Application::realign() {
 
 	while (reader.hasSequences()) {
 		Float score = v.realign(reader.next(), labelReader.nextLabelSequence());
-		Core::Log::openTag("sequence");
-		Core::Log::openTag("score");
-		Core::Log::os() << score;
-		Core::Log::closeTag();
-		Core::Log::openTag("recognized");
-		std::stringstream s;
-		for (u32 i = 0; i < v.segmentation().size(); i++)
-			s << v.segmentation().at(i).label << ":" << v.segmentation().at(i).length << " ";
-		Core::Log::os(s.str().c_str());
-		Core::Log::closeTag();
-		Core::Log::closeTag();
+		logResult(score, v.segmentation());
 		labelWriter.write(v.framewiseRecognition());
 	}
 
 	labelWriter.finalize();
 }
+
+void Application::decodeBatch(std::vector<ViterbiDecoding*>& decoders, bool realignment, u32 nSequences, DecodingBatch& batch) {
+#pragma omp parallel for schedule(dynamic) num_threads(decoders.size())
+	for (u32 i = 0; i < nSequences; i++) {
+		ViterbiDecoding& decoder = *decoders.at(Core::omp::get_thread_num());
+		if (realignment)
+			batch.scores.at(i) = decoder.realign(batch.frameScores.at(i), batch.labelSequences.at(i));
+		else
+			batch.scores.at(i) = decoder.decode(batch.frameScores.at(i));
+		batch.segmentations.at(i) = decoder.segmentation();
+		batch.recognitions.at(i) = decoder.framewiseRecognition();
+	}
+}
+
+void Application::decodeParallel(bool realignment) {
+	u32 nThreads = Core::Configuration::config(paramNumberOfThreads_);
+	u32 batchSize = Core::Configuration::config(paramBatchSize_);
+	require_gt(batchSize, 0);
+
+	// this decoder only computes the frame scores, the actual decoding is done by one decoder per thread
+	ViterbiDecoding v;
+	v.initialize();
+	if (!realignment)
+		v.sanityCheck();
+	if (!v.scorer().isFramewise())
+		Core::Error::msg("Application::decodeParallel: parallel decoding is only possible with a framewise scorer.") << Core::Error::abort;
+	std::vector<ViterbiDecoding*> decoders(nThreads);
+	for (u32 i = 0; i < nThreads; i++) {
+		decoders.at(i) = new ViterbiDecoding;
+		decoders.at(i)->initialize(true, &(v.lengthModel()));
+	}
+
+	Features::SequenceFeatureReader reader;
+	Features::SequenceLabelReader labelReader;
+	reader.initialize();
+	if (realignment) {
+		labelReader.initialize();
+		if (reader.totalNumberOfSequences() != labelReader.totalNumberOfSequences())
+			Core::Error::msg("Application::realign: features.feature-reader and features.label-reader need to have the same number of sequence.") << Core::Error::abort;
+	}
+	Features::SequenceLabelWriter labelWriter;
+	labelWriter.initialize(reader.totalNumberOfFeatures(), v.nOutputClasses(), reader.totalNumberOfSequences());
+
+	DecodingBatch batch(batchSize);
+	while (reader.hasSequences()) {
+		// precompute the frame scores of the next batch of sequences
+		u32 nSequences = 0;
+		while ((nSequences < batchSize) && (reader.hasSequences())) {
+			v.scorer().frameScores(reader.next(), batch.frameScores.at(nSequences));
+			if (realignment)
+				batch.labelSequences.at(nSequences) = labelReader.nextLabelSequence();
+			nSequences++;
+		}
+		decodeBatch(decoders, realignment, nSequences, batch);
+		// write the results in input order
+		for (u32 i = 0; i < nSequences; i++) {
+			logResult(batch.scores.at(i), batch.segmentations.at(i));
+			labelWriter.write(batch.recognitions.at(i));
+		}
+	}
+
+	labelWriter.finalize();
+	for (u32 i = 0; i < nThreads; i++)
+		delete decoders.at(i);
+}
+
+void Application::realignAll(FramewiseNeuralNetworkScorer& scorer, std::vector<ViterbiDecoding*>& decoders,
+		Features::SequenceFeatureReader& reader, Features::SequenceLabelReader& labelReader,
+		std::vector< std::vector<u32> >& alignments) {
+	u32 batchSize = Core::Configuration::config(paramBatchSize_);
+	require_gt(batchSize, 0);
+	// the readers do not shuffle, so after a new epoch the sequences are read in cache order again
+	if (!reader.hasSequences()) {
+		reader.newEpoch();
+		labelReader.newEpoch();
+	}
+	alignments.resize(reader.totalNumberOfSequences());
+	DecodingBatch batch(batchSize);
+	u32 nProcessedSequences = 0;
+	while (reader.hasSequences()) {
+		u32 nSequences = 0;
+		while ((nSequences < batchSize) && (reader.hasSequences())) {
+			scorer.frameScores(reader.next(), batch.frameScores.at(nSequences));
+			batch.labelSequences.at(nSequences) = labelReader.nextLabelSequence();
+			nSequences++;
+		}
+		decodeBatch(decoders, true, nSequences, batch);
+		for (u32 i = 0; i < nSequences; i++) {
+			logResult(batch.scores.at(i), batch.segmentations.at(i));
+			alignments.at(nProcessedSequences + i).swap(batch.recognitions.at(i));
+		}
+		nProcessedSequences += nSequences;
+	}
+}
+
+void Application::trainRealign() {
+	u32 nThreads = Core::Configuration::config(paramNumberOfThreads_);
+	u32 batchSize = Core::Configuration::config(paramTrainingBatchSize_);
+	u32 nIterations = Core::Configuration::config(paramNumberOfIterations_);
+	u32 epochsPerIteration = Core::Configuration::config(paramEpochsPerIteration_);
+	bool estimateHmmParameters = Core::Configuration::config(paramEstimateHmmParameters_);
+	require_gt(nThreads, 0);
+	require_gt(batchSize, 0);
+
+	// the trainer keeps the network and the training data (features and alignment) in memory
+	Nn::Trainer* trainer = Nn::Trainer::createTrainer();
+	trainer->initialize();
+	Nn::MinibatchGenerator& minibatchGenerator = trainer->minibatchGenerator();
+
+	// the realignment scores the frames with the network of the trainer
+	FramewiseNeuralNetworkScorer scorer(trainer->network());
+	scorer.initialize();
+	std::vector<ViterbiDecoding*> decoders(nThreads);
+	for (u32 i = 0; i < nThreads; i++) {
+		decoders.at(i) = new ViterbiDecoding;
+		decoders.at(i)->initialize(true, (i == 0 ? 0 : &(decoders.at(0)->lengthModel())));
+	}
+	u32 nStates = decoders.at(0)->nOutputClasses();
+	if ((nStates != scorer.nClasses()) || (nStates != trainer->network().outputDimension()))
+		Core::Error::msg("Application::trainRealign: the realignment must output hmm states (viterbi-decoding.output = hmm-states) "
+				"and the network must have one output per hmm state.") << Core::Error::abort;
+
+	// the sequences are realigned in cache order, which is the order of the label targets of the training data
+	// note: the trainer buffers the training features, so a buffer-size of features.feature-reader smaller than the cache
+	// avoids a second copy of the features in memory (the sequences are then re-read from the cache in each realignment)
+	Features::SequenceFeatureReader reader;
+	Features::SequenceLabelReader labelReader;
+	reader.initialize();
+	labelReader.initialize();
+	if (reader.shuffleBuffer())
+		Core::Error::msg("Application::trainRealign: features.feature-reader must not shuffle the sequences.") << Core::Error::abort;
+	if (reader.totalNumberOfSequences() != labelReader.totalNumberOfSequences())
+		Core::Error::msg("Application::trainRealign: features.feature-reader and features.label-reader need to have the same number of sequence.") << Core::Error::abort;
+	if (reader.totalNumberOfFeatures() != minibatchGenerator.totalNumberOfFeatures())
+		Core::Error::msg("Application::trainRealign: features.feature-reader and the training data need to have the same number of frames.") << Core::Error::abort;
+
+	std::vector< std::vector<u32> > alignments;
+	std::vector<u32> targets(reader.totalNumberOfFeatures());
+	for (u32 iteration = 0; iteration < nIterations; iteration++) {
+		Core::Log::openTag("training-realignment.iteration");
+		Core::Log::os("Start iteration ") << iteration + 1;
+		// training
+		for (u32 epoch = 0; epoch < epochsPerIteration; epoch++) {
+			Core::Log::os("Start epoch ") << trainer->nProcessedEpochs() + 1;
+			trainer->estimator().setEpoch(trainer->nProcessedEpochs() + 1);
+			trainer->processEpoch(batchSize);
+			trainer->finishEpoch();
+		}
+		// realignment (without the dropout noise of the training)
+		trainer->network().setDropout(false);
+		realignAll(scorer, decoders, reader, labelReader, alignments);
+		trainer->network().setDropout(true);
+		u32 t = 0;
+		for (u32 i = 0; i < alignments.size(); i++) {
+			std::copy(alignments.at(i).begin(), alignments.at(i).end(), targets.begin() + t);
+			t += alignments.at(i).size();
+		}
+		minibatchGenerator.setTargetLabels(targets);
+		if (estimateHmmParameters) {
+			Math::Vector<Float> loopProbabilities;
+			Math::Vector<Float> prior;
+			HmmEstimator::estimateParameters(alignments, nStates, loopProbabilities, prior);
+			for (u32 i = 0; i < nThreads; i++)
+				decoders.at(i)->setLoopProbabilities(loopProbabilities);
+			if (scorer.hasPrior())
+				scorer.setPrior(prior);
+		}
+		Core::Log::closeTag();
+	}
+
+	if (trainer->saveFrequency() == 0) // save at least at the end of the training
+		trainer->network().saveNeuralNetworkParameters();
+	trainer->finalize();
+
+	// write the final alignment
+	Features::SequenceLabelWriter labelWriter;
+	labelWriter.initialize(targets.size(), nStates, alignments.size());
+	for (u32 i = 0; i < alignments.size(); i++)
+		labelWriter.write(alignments.at(i));
+	labelWriter.finalize();
+
+	for (u32 i = 0; i < nThreads; i++)
+		delete decoders.at(i);
+	delete trainer;
+}
@@ -25,6 +25,9 @@
 
 #include "Core/CommonHeaders.hh"
 #include "Core/Application.hh"
+#include "ViterbiDecoding.hh"
+#include "Scorer.hh"
+#include <Features/FeatureReader.hh>
 
 namespace Hmm {
 
@@ -32,12 +35,41 @@ class Application: public Core::Application
 {
 private:
 	static const Core::ParameterEnum paramAction_;
-	enum Actions { none, generateGrammar, viterbiDecoding, realignment };
+	static const Core::ParameterInt paramNumberOfThreads_;
+	static const Core::ParameterInt paramBatchSize_;
+	static const Core::ParameterInt paramTrainingBatchSize_;
+	static const Core::ParameterInt paramNumberOfIterations_;
+	static const Core::ParameterInt paramEpochsPerIteration_;
+	static const Core::ParameterBool paramEstimateHmmParameters_;
+	enum Actions { none, generateGrammar, viterbiDecoding, realignment, linearAlignment, estimateHmmParameters, reestimateHmm, trainingRealignment };
+	/* results of a batch of sequences that are decoded in parallel */
+	struct DecodingBatch {
+		std::vector< Math::Matrix<Float> > frameScores;
+		std::vector< std::vector<u32> > labelSequences;
+		std::vector<Float> scores;
+		std::vector< std::vector<ViterbiDecoding::ActionSegment> > segmentations;
+		std::vector< std::vector<u32> > recognitions;
+		DecodingBatch(u32 batchSize);
+	};
+	void logResult(Float score, const std::vector<ViterbiDecoding::ActionSegment>& segmentation);
+	/* decode (or realign) the first nSequences sequences of the batch in parallel, one decoder per thread */
+	void decodeBatch(std::vector<ViterbiDecoding*>& decoders, bool realignment, u32 nSequences, DecodingBatch& batch);
+	/* decode (or realign) batches of sequences in parallel, one decoder per thread */
+	void decodeParallel(bool realignment);
+	/* realign all sequences with the frame scores of the given scorer, the alignments are stored in cache order */
+	void realignAll(FramewiseNeuralNetworkScorer& scorer, std::vector<ViterbiDecoding*>& decoders,
+			Features::SequenceFeatureReader& reader, Features::SequenceLabelReader& labelReader,
+			std::vector< std::vector<u32> >& alignments);
 public:
 	virtual ~Application() {}
 	virtual void main();
 	void decode();
 	void realign();
+	/*
+	 * alternate neural network training and realignment in one process: the network, the features, and the alignment stay
+	 * in memory and the realigned hmm states are directly used as targets of the next training epochs
+	 */
+	void trainRealign();
 };
 
 } // namespace
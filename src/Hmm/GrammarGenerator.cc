@@ -179,6 +179,13 @@ NGramGenerator::Count NGramGenerator::LmTree::countSingletons(u32 level) const {
 /*** End LmTree ***/
 
 
+u32 NGramGenerator::ContextHash::operator()(const Context& c) const {
+	u32 h = 0;
+	for (u32 i = 0; i < c.size(); i++)
+		h = 31 * h + (u32)c.at(i);
+	return Core::hashMix(h);
+}
+
 NGramGenerator::NGramGenerator() :
 		nGramOrder_(Core::Configuration::config(paramNGramOrder_)),
 		backingOff_(Core::Configuration::config(paramBackingOff_)),
@@ -220,6 +227,15 @@ void NGramGenerator::estimateDiscountingParameter() {
 }
 
 Float NGramGenerator::probability(const Context& c) {
+	Core::FlatHashMap<Context, Float, ContextHash>::Entry* entry = probabilities_.find(c);
+	if (entry != 0)
+		return entry->value;
+	Float p = computeProbability(c);
+	probabilities_.insert(c, p);
+	return p;
+}
+
+Float NGramGenerator::computeProbability(const Context& c) {
 	require_gt(c.size(), 1);
 	Context context = c;
 	u32 historyLength = context.size() - 2;
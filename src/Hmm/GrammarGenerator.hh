@@ -25,6 +25,7 @@
 
 #include <Core/CommonHeaders.hh>
 #include <Core/Tree.hh>
+#include <Core/FlatHashMap.hh>
 #include <set>
 #include <sstream>
 #include <Features/FeatureReader.hh>
@@ -92,6 +93,10 @@ private:
 		Count countSingletons(u32 level) const;
 	};
 	/*** End LmTree ***/
+	class ContextHash {
+	public:
+		u32 operator()(const Context& c) const;
+	};
 
 	static const Word root;
 private:
@@ -108,6 +113,9 @@ protected:
 	u32 lexiconSize_; // number of words in the dictionary
 	LmTree lmTree_;
 	std::vector<Float> lambda_;
+	// memoized probabilities, backing-off evaluates the same lower order contexts many times
+	Core::FlatHashMap<Context, Float, ContextHash> probabilities_;
+	Float computeProbability(const Context& c);
 	Float probability(const Context& c);
 	void accumulate(const std::vector<u32>& sequence);
 	void estimateDiscountingParameter();
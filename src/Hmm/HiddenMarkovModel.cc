@@ -68,14 +68,23 @@ void HiddenMarkovModel::initialize() {
 	// load transition probabilities
 	if (transitionProbabilityFile_.empty())
 		Core::Error::msg("HiddenMarkovModel::initialize: transition-probability-file not specified.") << Core::Error::abort;
-	loopScores_.read(transitionProbabilityFile_);
+	Math::Vector<Float> loopProbabilities;
+	loopProbabilities.read(transitionProbabilityFile_);
+	setLoopProbabilities(loopProbabilities);
+
+	isInitialized_ = true;
+}
+
+void HiddenMarkovModel::setLoopProbabilities(const Math::Vector<Float>& loopProbabilities) {
+	if (loopProbabilities.size() != nStates_)
+		Core::Error::msg("HiddenMarkovModel: expected ") << nStates_ << " loop probabilities but got " << loopProbabilities.size() << "." << Core::Error::abort;
+	loopScores_.resize(loopProbabilities.size());
+	loopScores_.copy(loopProbabilities);
 	forwardScores_.resize(loopScores_.size());
 	forwardScores_.fill(1.0);
 	forwardScores_.add(loopScores_, (Float)-1.0);
 	loopScores_.log();
 	forwardScores_.log();
-
-	isInitialized_ = true;
 }
 
 
@@ -88,6 +88,10 @@ public:
 	 * @return log transition probability from stateFrom to stateTo
 	 */
 	Float transitionScore(u32 stateFrom, u32 stateTo) const;
+	/*
+	 * replace the loop probability of each state (the forward probability is one minus the loop probability)
+	 */
+	virtual void setLoopProbabilities(const Math::Vector<Float>& loopProbabilities);
 
 	/*
 	 * factory
@@ -108,6 +112,8 @@ public:
 	SingleStateHiddenMarkovModel();
 	virtual ~SingleStateHiddenMarkovModel() {}
 	virtual void initialize();
+	/* single state hmms have no transition probabilities */
+	virtual void setLoopProbabilities(const Math::Vector<Float>& loopProbabilities) {}
 };
 
 } // namespace
@@ -0,0 +1,275 @@
+/*
+ * Copyright 2016 Alexander Richard
+ *
+ * This file is part of Squirrel.
+ *
+ * Licensed under the Academic Free License 3.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * You should have received a copy of the License along with Squirrel.
+ * If not, see <https://opensource.org/licenses/AFL-3.0>.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ */
+
+#include "HmmEstimator.hh"
+#include <Core/OpenMPWrapper.hh>
+#include <algorithm>
+
+using namespace Hmm;
+
+// current hmm definition (number of states per class)
+const Core::ParameterString HmmEstimator::paramHmmFile_("hmm-file", "", "hmm-estimation");
+
+// output of reestimate-hmm
+const Core::ParameterString HmmEstimator::paramNewHmmFile_("new-hmm-file", "", "hmm-estimation");
+
+// outputs of estimate-hmm-parameters, a file is only written if it is specified
+const Core::ParameterString HmmEstimator::paramTransitionProbabilityFile_("transition-probability-file", "", "hmm-estimation");
+
+const Core::ParameterString HmmEstimator::paramPriorFile_("prior-file", "", "hmm-estimation");
+
+// average number of frames per hmm state for the reestimation of the hmm definition
+const Core::ParameterInt HmmEstimator::paramFramesPerState_("frames-per-state", 10, "hmm-estimation");
+
+const Core::ParameterInt HmmEstimator::paramNumberOfThreads_("number-of-threads", 1, "hmm-estimation");
+
+// number of sequences that are read before they are processed in parallel
+const Core::ParameterInt HmmEstimator::paramBatchSize_("batch-size", 64, "hmm-estimation");
+
+HmmEstimator::HmmEstimator() :
+		hmmFile_(Core::Configuration::config(paramHmmFile_)),
+		newHmmFile_(Core::Configuration::config(paramNewHmmFile_)),
+		transitionProbabilityFile_(Core::Configuration::config(paramTransitionProbabilityFile_)),
+		priorFile_(Core::Configuration::config(paramPriorFile_)),
+		framesPerState_(Core::Configuration::config(paramFramesPerState_)),
+		nThreads_(Core::Configuration::config(paramNumberOfThreads_)),
+		batchSize_(Core::Configuration::config(paramBatchSize_))
+{
+	require_gt(nThreads_, 0);
+	require_gt(batchSize_, 0);
+}
+
+void HmmEstimator::readHmm() {
+	if (hmmFile_.empty())
+		Core::Error::msg("HmmEstimator: hmm-estimation.hmm-file not specified.") << Core::Error::abort;
+	Math::Vector<u32> statesPerClass;
+	statesPerClass.read(hmmFile_);
+	setHmm(statesPerClass);
+}
+
+void HmmEstimator::setHmm(const Math::Vector<u32>& statesPerClass) {
+	require_gt(statesPerClass.size(), 0);
+	statesPerClass_.resize(statesPerClass.size());
+	statesPerClass_.copy(statesPerClass);
+	startStates_.resize(statesPerClass_.size());
+	startStates_.at(0) = 0;
+	for (u32 c = 1; c < statesPerClass_.size(); c++)
+		startStates_.at(c) = startStates_.at(c-1) + statesPerClass_.at(c-1);
+	stateToClass_.resize(statesPerClass_.sum());
+	for (u32 c = 0; c < statesPerClass_.size(); c++) {
+		if (statesPerClass_.at(c) == 0)
+			Core::Error::msg("HmmEstimator: class ") << c << " has no hmm states." << Core::Error::abort;
+		for (u32 s = 0; s < statesPerClass_.at(c); s++)
+			stateToClass_.at(startStates_.at(c) + s) = c;
+	}
+}
+
+u32 HmmEstimator::readBatch(Features::SequenceLabelReader& reader, std::vector< std::vector<u32> >& batch) {
+	u32 nSequences = 0;
+	while ((nSequences < batchSize_) && (reader.hasSequences())) {
+		batch.at(nSequences) = reader.nextLabelSequence();
+		nSequences++;
+	}
+	return nSequences;
+}
+
+void HmmEstimator::segment(const std::vector<u32>& alignment, std::vector<Segment>& segmentation) const {
+	segmentation.clear();
+	for (u32 t = 0; t < alignment.size(); t++) {
+		u32 state = alignment.at(t);
+		if (state >= stateToClass_.size())
+			Core::Error::msg("HmmEstimator::segment: hmm state ") << state << " exceeds the number of hmm states." << Core::Error::abort;
+		// a new class instance starts if the class changes or the (left-to-right) hmm jumps back,
+		// a single-state class stays in its state, so repeated instances of it are not detected
+		if ((t == 0) || (stateToClass_.at(state) != segmentation.back().label) || (state < alignment.at(t-1)))
+			segmentation.push_back(Segment(stateToClass_.at(state), 1));
+		else
+			segmentation.back().length++;
+	}
+}
+
+void HmmEstimator::alignSegment(const Segment& segment, std::vector<u32>& alignment) const {
+	Float stateLength = (Float)segment.length / statesPerClass_.at(segment.label);
+	for (u32 t = 0; t < segment.length; t++)
+		alignment.push_back(startStates_.at(segment.label) + std::min((u32)(t / stateLength), statesPerClass_.at(segment.label) - 1));
+}
+
+void HmmEstimator::accumulate(const std::vector<u32>& alignment, std::vector<u32>& loops, std::vector<u32>& total) {
+	for (u32 t = 0; t < alignment.size(); t++) {
+		require_lt(alignment.at(t), total.size());
+		total.at(alignment.at(t))++;
+		if ((t + 1 < alignment.size()) && (alignment.at(t) == alignment.at(t+1)))
+			loops.at(alignment.at(t))++;
+	}
+}
+
+void HmmEstimator::computeParameters(const std::vector<u32>& loops, const std::vector<u32>& total,
+		Math::Vector<Float>& loopProbabilities, Math::Vector<Float>& prior) {
+	u32 nFrames = 0;
+	for (u32 s = 0; s < total.size(); s++)
+		nFrames += total.at(s);
+	loopProbabilities.resize(total.size());
+	prior.resize(total.size());
+	for (u32 s = 0; s < total.size(); s++) {
+		loopProbabilities.at(s) = (Float)loops.at(s) / std::max(1u, total.at(s));
+		prior.at(s) = (Float)total.at(s) / std::max(1u, nFrames);
+	}
+}
+
+void HmmEstimator::linearAlignment() {
+	readHmm();
+	Features::SequenceLabelReader transcriptReader;
+	Features::SequenceLabelReader frameReader("features.frame-label-reader");
+	transcriptReader.initialize();
+	frameReader.initialize();
+	if (transcriptReader.totalNumberOfSequences() != frameReader.totalNumberOfSequences())
+		Core::Error::msg("HmmEstimator::linearAlignment: features.label-reader and features.frame-label-reader need to have the same number of sequences.") << Core::Error::abort;
+	if (transcriptReader.featureDimension() != statesPerClass_.size())
+		Core::Error::msg("HmmEstimator::linearAlignment: number of classes of the transcripts and the hmm do not match.") << Core::Error::abort;
+	Features::SequenceLabelWriter labelWriter;
+	labelWriter.initialize(frameReader.totalNumberOfFeatures(), stateToClass_.size(), frameReader.totalNumberOfSequences());
+
+	std::vector< std::vector<u32> > transcripts(batchSize_);
+	std::vector<u32> lengths(batchSize_);
+	std::vector< std::vector<u32> > alignments(batchSize_);
+	while (transcriptReader.hasSequences()) {
+		u32 nSequences = readBatch(transcriptReader, transcripts);
+		// only the lengths of the framewise label sequences are needed
+		for (u32 i = 0; i < nSequences; i++)
+			lengths.at(i) = frameReader.nextLabelSequence().size();
+#pragma omp parallel for schedule(dynamic) num_threads(nThreads_)
+		for (u32 i = 0; i < nSequences; i++) {
+			// expand the transcript to its hmm states and distribute them linearly over the sequence
+			std::vector<u32> hmmTranscript;
+			for (u32 j = 0; j < transcripts.at(i).size(); j++) {
+				u32 c = transcripts.at(i).at(j);
+				for (u32 s = 0; s < statesPerClass_.at(c); s++)
+					hmmTranscript.push_back(startStates_.at(c) + s);
+			}
+			require_gt(hmmTranscript.size(), 0);
+			Float stateLength = (Float)lengths.at(i) / hmmTranscript.size();
+			alignments.at(i).resize(lengths.at(i));
+			for (u32 t = 0; t < lengths.at(i); t++)
+				alignments.at(i).at(t) = hmmTranscript.at(std::min((u32)(t / stateLength), (u32)hmmTranscript.size() - 1));
+		}
+		for (u32 i = 0; i < nSequences; i++)
+			labelWriter.write(alignments.at(i));
+	}
+
+	labelWriter.finalize();
+}
+
+void HmmEstimator::estimateParameters() {
+	if (transitionProbabilityFile_.empty() && priorFile_.empty())
+		Core::Error::msg("HmmEstimator::estimateParameters: neither transition-probability-file nor prior-file specified.") << Core::Error::abort;
+	Features::SequenceLabelReader reader;
+	reader.initialize();
+	u32 nStates = reader.featureDimension();
+
+	// per-thread statistics, accumulated after the last batch
+	std::vector< std::vector<u32> > loops(nThreads_, std::vector<u32>(nStates, 0));
+	std::vector< std::vector<u32> > total(nThreads_, std::vector<u32>(nStates, 0));
+	std::vector< std::vector<u32> > alignments(batchSize_);
+	while (reader.hasSequences()) {
+		u32 nSequences = readBatch(reader, alignments);
+#pragma omp parallel for schedule(dynamic) num_threads(nThreads_)
+		for (u32 i = 0; i < nSequences; i++) {
+			u32 thread = Core::omp::get_thread_num();
+			accumulate(alignments.at(i), loops.at(thread), total.at(thread));
+		}
+	}
+	for (u32 thread = 1; thread < nThreads_; thread++) {
+		for (u32 s = 0; s < nStates; s++) {
+			loops.at(0).at(s) += loops.at(thread).at(s);
+			total.at(0).at(s) += total.at(thread).at(s);
+		}
+	}
+
+	Math::Vector<Float> loopProbabilities;
+	Math::Vector<Float> prior;
+	computeParameters(loops.at(0), total.at(0), loopProbabilities, prior);
+	if (!transitionProbabilityFile_.empty())
+		loopProbabilities.write(transitionProbabilityFile_);
+	if (!priorFile_.empty())
+		prior.write(priorFile_);
+}
+
+void HmmEstimator::estimateParameters(const std::vector< std::vector<u32> >& alignments, u32 nStates,
+		Math::Vector<Float>& loopProbabilities, Math::Vector<Float>& prior) {
+	std::vector<u32> loops(nStates, 0);
+	std::vector<u32> total(nStates, 0);
+	for (u32 i = 0; i < alignments.size(); i++)
+		accumulate(alignments.at(i), loops, total);
+	computeParameters(loops, total, loopProbabilities, prior);
+}
+
+void HmmEstimator::reestimate() {
+	if (newHmmFile_.empty())
+		Core::Error::msg("HmmEstimator::reestimate: hmm-estimation.new-hmm-file not specified.") << Core::Error::abort;
+	readHmm();
+	Features::SequenceLabelReader reader;
+	reader.initialize();
+	if (reader.featureDimension() != stateToClass_.size())
+		Core::Error::msg("HmmEstimator::reestimate: number of hmm states of the alignment and the hmm do not match.") << Core::Error::abort;
+	u32 nClasses = statesPerClass_.size();
+
+	// segment the alignment into class instances and count frames and instances per class
+	std::vector< std::vector<Segment> > segmentations(reader.totalNumberOfSequences());
+	std::vector< std::vector<u32> > alignments(batchSize_);
+	u32 nProcessedSequences = 0;
+	while (reader.hasSequences()) {
+		u32 nSequences = readBatch(reader, alignments);
+#pragma omp parallel for schedule(dynamic) num_threads(nThreads_)
+		for (u32 i = 0; i < nSequences; i++)
+			segment(alignments.at(i), segmentations.at(nProcessedSequences + i));
+		nProcessedSequences += nSequences;
+	}
+	std::vector<u32> classFrames(nClasses, 0);
+	std::vector<u32> classInstances(nClasses, 0);
+	for (u32 i = 0; i < segmentations.size(); i++) {
+		for (u32 j = 0; j < segmentations.at(i).size(); j++) {
+			classFrames.at(segmentations.at(i).at(j).label) += segmentations.at(i).at(j).length;
+			classInstances.at(segmentations.at(i).at(j).label)++;
+		}
+	}
+
+	// new number of states per class, classes that do not occur in the alignment keep their number of states
+	Math::Vector<u32> statesPerClass(nClasses);
+	for (u32 c = 0; c < nClasses; c++) {
+		if (classInstances.at(c) == 0)
+			statesPerClass.at(c) = statesPerClass_.at(c);
+		else
+			statesPerClass.at(c) = std::max(1u, (u32)((Float)classFrames.at(c) / classInstances.at(c) / framesPerState_));
+	}
+	setHmm(statesPerClass);
+	statesPerClass_.write(newHmmFile_);
+
+	// linear alignment of the new hmm states within each class instance
+	Features::SequenceLabelWriter labelWriter;
+	labelWriter.initialize(reader.totalNumberOfFeatures(), stateToClass_.size(), segmentations.size());
+	for (u32 offset = 0; offset < segmentations.size(); offset += batchSize_) {
+		u32 nSequences = std::min(batchSize_, (u32)segmentations.size() - offset);
+#pragma omp parallel for schedule(dynamic) num_threads(nThreads_)
+		for (u32 i = 0; i < nSequences; i++) {
+			alignments.at(i).clear();
+			for (u32 j = 0; j < segmentations.at(offset + i).size(); j++)
+				alignSegment(segmentations.at(offset + i).at(j), alignments.at(i));
+		}
+		for (u32 i = 0; i < nSequences; i++)
+			labelWriter.write(alignments.at(i));
+	}
+
+	labelWriter.finalize();
+}
@@ -0,0 +1,104 @@
+/*
+ * Copyright 2016 Alexander Richard
+ *
+ * This file is part of Squirrel.
+ *
+ * Licensed under the Academic Free License 3.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * You should have received a copy of the License along with Squirrel.
+ * If not, see <https://opensource.org/licenses/AFL-3.0>.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ */
+
+#ifndef HMM_HMMESTIMATOR_HH_
+#define HMM_HMMESTIMATOR_HH_
+
+#include <Core/CommonHeaders.hh>
+#include <Math/Vector.hh>
+#include <Features/FeatureReader.hh>
+#include <Features/FeatureWriter.hh>
+
+namespace Hmm {
+
+/*
+ * HmmEstimator
+ * estimates hmm definitions, transition probabilities, state priors, and linear alignments from sequence label caches
+ * the sequences are read in a single pass and processed in parallel in batches of batch-size sequences
+ */
+class HmmEstimator
+{
+private:
+	static const Core::ParameterString paramHmmFile_;
+	static const Core::ParameterString paramNewHmmFile_;
+	static const Core::ParameterString paramTransitionProbabilityFile_;
+	static const Core::ParameterString paramPriorFile_;
+	static const Core::ParameterInt paramFramesPerState_;
+	static const Core::ParameterInt paramNumberOfThreads_;
+	static const Core::ParameterInt paramBatchSize_;
+public:
+	/* a segment of an alignment, i.e. consecutive frames of the same class instance */
+	struct Segment {
+		u32 label;
+		u32 length;
+		Segment(u32 _label, u32 _length) : label(_label), length(_length) {}
+	};
+protected:
+	std::string hmmFile_;
+	std::string newHmmFile_;
+	std::string transitionProbabilityFile_;
+	std::string priorFile_;
+	u32 framesPerState_;
+	u32 nThreads_;
+	u32 batchSize_;
+	Math::Vector<u32> statesPerClass_;
+	Math::Vector<u32> startStates_;
+	Math::Vector<u32> stateToClass_;
+
+	void readHmm();
+	void setHmm(const Math::Vector<u32>& statesPerClass);
+	u32 readBatch(Features::SequenceLabelReader& reader, std::vector< std::vector<u32> >& batch);
+	/*
+	 * split a framewise hmm state alignment into its class instances
+	 * a new instance starts if the class changes or the left-to-right hmm jumps back to a previous state,
+	 * consecutive instances of the same single-state class can not be separated and are merged
+	 */
+	void segment(const std::vector<u32>& alignment, std::vector<Segment>& segmentation) const;
+	// distribute the hmm states of the segment's class linearly over the segment
+	void alignSegment(const Segment& segment, std::vector<u32>& alignment) const;
+	// loop and state counts of a hmm state alignment
+	static void accumulate(const std::vector<u32>& alignment, std::vector<u32>& loops, std::vector<u32>& total);
+	static void computeParameters(const std::vector<u32>& loops, const std::vector<u32>& total,
+			Math::Vector<Float>& loopProbabilities, Math::Vector<Float>& prior);
+public:
+	HmmEstimator();
+	virtual ~HmmEstimator() {}
+
+	/*
+	 * linear alignment of the hmm states of the transcripts in features.label-reader,
+	 * the sequence lengths are given by the label cache in features.frame-label-reader
+	 */
+	void linearAlignment();
+	/*
+	 * loop probabilities and/or state prior of the hmm state alignment in features.label-reader
+	 */
+	void estimateParameters();
+	/*
+	 * loop probabilities and state prior of the given hmm state alignments (one per sequence)
+	 */
+	static void estimateParameters(const std::vector< std::vector<u32> >& alignments, u32 nStates,
+			Math::Vector<Float>& loopProbabilities, Math::Vector<Float>& prior);
+	/*
+	 * new number of states per class (frames-per-state frames per state on average) and
+	 * linear alignment of the new hmm states within the class instances of the hmm state alignment in features.label-reader
+	 * the class instances are recovered from the hmm states (see segment), so if a transcript contains
+	 * the same single-state class twice in a row, both instances are counted as one
+	 */
+	void reestimate();
+};
+
+} // namespace
+
+#endif /* HMM_HMMESTIMATOR_HH_ */
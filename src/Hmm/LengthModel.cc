@@ -21,6 +21,7 @@
  */
 
 #include "LengthModel.hh"
+#include <math.h>
 
 using namespace Hmm;
 
@@ -29,11 +30,33 @@ const Core::ParameterEnum LengthModel::paramLengthModelType_("type",
 
 const Core::ParameterBool LengthModel::paramIsFramewise_("is-framewise", true, "length-model");
 
+// longer segments are scored without the precomputed tables
+const Core::ParameterInt LengthModel::paramMaximalTableLength_("maximal-table-length", 1000, "length-model");
+
 LengthModel::LengthModel() :
 		type_((LengthModelType)Core::Configuration::config(paramLengthModelType_)),
-		isFramewise_(Core::Configuration::config(paramIsFramewise_))
+		isFramewise_(Core::Configuration::config(paramIsFramewise_)),
+		maxTableLength_(Core::Configuration::config(paramMaximalTableLength_)),
+		tableLength_(0),
+		stateStride_(0),
+		scale_(1.0)
 {}
 
+void LengthModel::precomputeScores(u32 nStates, u32 maxLength, Float scale) {
+	scale_ = scale;
+	tableLength_ = std::min(maxLength, maxTableLength_) + 1;
+	u32 nTabulatedStates = (isStateDependent() ? nStates : 1);
+	stateStride_ = (isStateDependent() ? tableLength_ : 0);
+	frameScoreTable_.resize((u64)nTabulatedStates * tableLength_);
+	segmentScoreTable_.resize((u64)nTabulatedStates * tableLength_);
+	for (u32 state = 0; state < nTabulatedStates; state++) {
+		for (u32 length = 0; length < tableLength_; length++) {
+			frameScoreTable_[(u64)state * tableLength_ + length] = scale_ * frameScore(length, state);
+			segmentScoreTable_[(u64)state * tableLength_ + length] = scale_ * segmentScore(length, state);
+		}
+	}
+}
+
 LengthModel* LengthModel::create() {
 	switch ((LengthModelType) Core::Configuration::config(paramLengthModelType_)) {
 	case none:
@@ -79,16 +102,14 @@ void PoissonLengthModel::initialize() {
 	rescalingFactor_.setToZero();
 	if (rescale_) {
 		for (u32 state = 0; state < lambda_.size(); state++) {
-			Float logFak = 0;
-			for (u32 k = 2; k <= lambda_.at(state); k++)
-				logFak += std::log(k);
+			Float logFak = ::lgamma(std::floor(lambda_.at(state)) + 1);
 			rescalingFactor_.at(state) = round(lambda_.at(state)) * std::log(round(lambda_.at(state))) - round(lambda_.at(state)) - logFak;
 		}
 	}
 	isInitialized_ = true;
 }
 
-Float PoissonLengthModel::frameScore(u32 length, u32 state) {
+Float PoissonLengthModel::frameScore(u32 length, u32 state) const {
 	require(isInitialized_);
 	require_lt(state, lambda_.size());
 	if (!isFramewise_) return 0.0;
@@ -99,14 +120,13 @@ Float PoissonLengthModel::frameScore(u32 length, u32 state) {
 		return std::log(lambda_.at(state)) - std::log(length);
 }
 
-Float PoissonLengthModel::segmentScore(u32 length, u32 state) {
+Float PoissonLengthModel::segmentScore(u32 length, u32 state) const {
 	require(isInitialized_);
 	require_lt(state, lambda_.size());
 	if (isFramewise_) return 0.0;
 
-	Float logFak = 0;
-	for (u32 k = 2; k <= length; k++)
-		logFak += std::log(k);
+	// log(length!)
+	Float logFak = ::lgamma((Float)length + 1);
 	return length * std::log(lambda_.at(state)) - lambda_.at(state) - logFak - rescalingFactor_.at(state);
 }
 
@@ -123,7 +143,7 @@ ThresholdLengthModel::ThresholdLengthModel() :
 		epsilon_(Core::Configuration::config(paramEpsilon_))
 {}
 
-Float ThresholdLengthModel::frameScore(u32 length, u32 state) {
+Float ThresholdLengthModel::frameScore(u32 length, u32 state) const {
 	if (!isFramewise_) return 0.0;
 
 	if (length <= threshold_)
@@ -132,7 +152,7 @@ Float ThresholdLengthModel::frameScore(u32 length, u32 state) {
 		return std::log(epsilon_);
 }
 
-Float ThresholdLengthModel::segmentScore(u32 length, u32 state) {
+Float ThresholdLengthModel::segmentScore(u32 length, u32 state) const {
 	if (isFramewise_) return 0.0;
 
 	if (length <= threshold_)
@@ -148,7 +168,7 @@ LinearDecayLengthModel::LinearDecayLengthModel() :
 		Precursor()
 {}
 
-Float LinearDecayLengthModel::frameScore(u32 length, u32 state) {
+Float LinearDecayLengthModel::frameScore(u32 length, u32 state) const {
 	if (!isFramewise_) return 0.0;
 
 	if (length <= threshold_)
@@ -159,7 +179,7 @@ Float LinearDecayLengthModel::frameScore(u32 length, u32 state) {
 		return std::log(epsilon_);
 }
 
-Float LinearDecayLengthModel::segmentScore(u32 length, u32 state) {
+Float LinearDecayLengthModel::segmentScore(u32 length, u32 state) const {
 	if (isFramewise_) return 0.0;
 
 	if (length <= threshold_)
@@ -180,12 +200,12 @@ MonotoneGaussianLengthModel::MonotoneGaussianLengthModel() :
 		meanLength_(Core::Configuration::config(paramMeanLength_))
 {}
 
-Float MonotoneGaussianLengthModel::frameScore(u32 length, u32 state) {
+Float MonotoneGaussianLengthModel::frameScore(u32 length, u32 state) const {
 	if (!isFramewise_) return 0.0;
 	return -0.5 * (2 * length - 1) / (meanLength_ * meanLength_);
 }
 
-Float MonotoneGaussianLengthModel::segmentScore(u32 length, u32 state) {
+Float MonotoneGaussianLengthModel::segmentScore(u32 length, u32 state) const {
 	if (isFramewise_) return 0.0;
 	return -0.5 * (length * length) / (meanLength_ * meanLength_);
 }
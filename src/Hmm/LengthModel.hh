@@ -34,19 +34,47 @@ class LengthModel
 private:
 	static const Core::ParameterEnum paramLengthModelType_;
 	static const Core::ParameterBool paramIsFramewise_;
+	static const Core::ParameterInt paramMaximalTableLength_;
 public:
 	enum LengthModelType { none, poisson, threshold, linearDecay, monotoneGaussian };
 protected:
 	LengthModelType type_;
 	bool isFramewise_;
+	// scaled frame and segment scores for the lengths 0,...,tableLength_-1 (see precomputeScores)
+	u32 maxTableLength_;
+	u32 tableLength_;
+	u32 stateStride_;		// 0 if the scores do not depend on the state
+	Float scale_;
+	std::vector<Float> frameScoreTable_;
+	std::vector<Float> segmentScoreTable_;
+	virtual bool isStateDependent() const { return false; }
 public:
 	LengthModel();
 	virtual ~LengthModel() {}
 	LengthModelType type() const { return type_; }
 	bool isFramewise() const { return isFramewise_; }
 	virtual void initialize() {}
-	virtual Float frameScore(u32 length, u32 state) { return 0.0; }
-	virtual Float segmentScore(u32 length, u32 state) { return 0.0; }
+	virtual Float frameScore(u32 length, u32 state) const { return 0.0; }
+	virtual Float segmentScore(u32 length, u32 state) const { return 0.0; }
+
+	/*
+	 * tabulate the scaled frame and segment scores of all states for lengths up to maxLength
+	 * (at most length-model.maximal-table-length), afterwards the model is only read
+	 */
+	void precomputeScores(u32 nStates, u32 maxLength, Float scale);
+	/*
+	 * scale * frameScore(length, state) and scale * segmentScore(length, state), table lookups after precomputeScores
+	 */
+	Float scaledFrameScore(u32 length, u32 state) const {
+		if (length < tableLength_)
+			return frameScoreTable_[state * stateStride_ + length];
+		return scale_ * frameScore(length, state);
+	}
+	Float scaledSegmentScore(u32 length, u32 state) const {
+		if (length < tableLength_)
+			return segmentScoreTable_[state * stateStride_ + length];
+		return scale_ * segmentScore(length, state);
+	}
 
 	/*
 	 * factory
@@ -70,12 +98,13 @@ protected:
 	Math::Vector<Float> lambda_;
 	Math::Vector<Float> rescalingFactor_;
 	bool isInitialized_;
+	virtual bool isStateDependent() const { return true; }
 public:
 	PoissonLengthModel();
 	virtual ~PoissonLengthModel() {}
 	virtual void initialize();
-	virtual Float frameScore(u32 length, u32 state);
-	virtual Float segmentScore(u32 length, u32 state);
+	virtual Float frameScore(u32 length, u32 state) const;
+	virtual Float segmentScore(u32 length, u32 state) const;
 };
 
 /*
@@ -94,8 +123,8 @@ protected:
 public:
 	ThresholdLengthModel();
 	virtual ~ThresholdLengthModel() {}
-	virtual Float frameScore(u32 length, u32 state);
-	virtual Float segmentScore(u32 length, u32 state);
+	virtual Float frameScore(u32 length, u32 state) const;
+	virtual Float segmentScore(u32 length, u32 state) const;
 };
 
 /*
@@ -109,8 +138,8 @@ private:
 public:
 	LinearDecayLengthModel();
 	virtual ~LinearDecayLengthModel() {}
-	virtual Float frameScore(u32 length, u32 state);
-	virtual Float segmentScore(u32 length, u32 state);
+	virtual Float frameScore(u32 length, u32 state) const;
+	virtual Float segmentScore(u32 length, u32 state) const;
 };
 
 /*
@@ -126,8 +155,8 @@ private:
 public:
 	MonotoneGaussianLengthModel();
 	virtual ~MonotoneGaussianLengthModel() {}
-	virtual Float frameScore(u32 length, u32 state);
-	virtual Float segmentScore(u32 length, u32 state);
+	virtual Float frameScore(u32 length, u32 state) const;
+	virtual Float segmentScore(u32 length, u32 state) const;
 };
 
 } // namespace
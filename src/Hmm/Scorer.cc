@@ -46,6 +46,16 @@ void Scorer::setSequence(const Math::Matrix<Float>& sequence) {
 	sequence_ = &sequence;
 }
 
+void Scorer::frameScores(const Math::Matrix<Float>& sequence, Math::Matrix<Float>& scores) {
+	require(isFramewise());
+	setSequence(sequence);
+	scores.resize(nClasses_, sequence.nColumns());
+	for (u32 t = 0; t < sequence.nColumns(); t++) {
+		for (u32 c = 0; c < nClasses_; c++)
+			scores.at(c, t) = frameScore(t, c);
+	}
+}
+
 Scorer* Scorer::create() {
 	switch ((ScorerType) Core::Configuration::config(paramScorerType_)) {
 	case framewiseNeuralNetworkScorer:
@@ -62,6 +72,29 @@ Scorer* Scorer::create() {
 }
 
 
+/*
+ * PrecomputedScorer
+ */
+PrecomputedScorer::PrecomputedScorer(u32 nClasses) :
+		Precursor()
+{
+	nClasses_ = nClasses;
+}
+
+Float PrecomputedScorer::frameScore(u32 t, u32 c) {
+	require(sequence_);
+	require_lt(c, sequence_->nRows());
+	require_lt(t, sequence_->nColumns());
+	return sequence_->at(c, t);
+}
+
+const Float* PrecomputedScorer::frameScoreColumn(u32 t) {
+	require(sequence_);
+	require_lt(t, sequence_->nColumns());
+	return &(sequence_->at(0, t));
+}
+
+
 /*
  * FramewiseNeuralNetworkScorer
  */
@@ -78,12 +111,25 @@ FramewiseNeuralNetworkScorer::FramewiseNeuralNetworkScorer() :
 		priorFile_(Core::Configuration::config(paramPriorFile_)),
 		priorScale_(Core::Configuration::config(paramPriorScale_)),
 		logarithmizeNetworkOutput_(Core::Configuration::config(paramLogarithmizeNetworkOutput_)),
-		batchSize_(Core::Configuration::config(paramBatchSize_))
+		batchSize_(Core::Configuration::config(paramBatchSize_)),
+		network_(ownNetwork_),
+		ownsNetwork_(true)
+{}
+
+FramewiseNeuralNetworkScorer::FramewiseNeuralNetworkScorer(Nn::NeuralNetwork& network) :
+		Precursor(),
+		priorFile_(Core::Configuration::config(paramPriorFile_)),
+		priorScale_(Core::Configuration::config(paramPriorScale_)),
+		logarithmizeNetworkOutput_(Core::Configuration::config(paramLogarithmizeNetworkOutput_)),
+		batchSize_(Core::Configuration::config(paramBatchSize_)),
+		network_(network),
+		ownsNetwork_(false)
 {}
 
 void FramewiseNeuralNetworkScorer::initialize() {
 	Precursor::initialize();
-	network_.initialize();
+	if (ownsNetwork_)
+		network_.initialize();
 	nClasses_ = network_.outputDimension();
 	prior_.resize(nClasses_);
 	// initialize prior
@@ -100,6 +146,17 @@ void FramewiseNeuralNetworkScorer::initialize() {
 		prior_.log();
 }
 
+void FramewiseNeuralNetworkScorer::setPrior(const Math::Vector<Float>& prior) {
+	require(isInitialized_);
+	require(hasPrior());
+	if (prior.size() != nClasses_)
+		Core::Error::msg("FramewiseNeuralNetworkScorer::setPrior: prior must be a ") << nClasses_ << " dimensional vector." << Core::Error::abort;
+	prior_.finishComputation(false);
+	prior_.copy(prior);
+	prior_.initComputation();
+	prior_.log();
+}
+
 void FramewiseNeuralNetworkScorer::setSequence(const Math::Matrix<Float>& sequence) {
 	scores_.initComputation();
 	scores_.resize(network_.outputDimension(), sequence.nColumns());
@@ -145,81 +202,117 @@ Float FramewiseNeuralNetworkScorer::frameScore(u32 t, u32 c) {
 	return scores_.at(c, t);
 }
 
+void FramewiseNeuralNetworkScorer::frameScores(const Math::Matrix<Float>& sequence, Math::Matrix<Float>& scores) {
+	setSequence(sequence);
+	scores.resize(scores_.nRows(), scores_.nColumns());
+	scores.copy(scores_.begin());
+}
+
+const Float* FramewiseNeuralNetworkScorer::frameScoreColumn(u32 t) {
+	require(isInitialized_);
+	require_lt(t, scores_.nColumns());
+	return &(scores_.at(0, t));
+}
+
 
 /*
  * SegmentScorer
  */
 const Core::ParameterBool SegmentScorer::paramScaleSegmentByLength_("scale-segment-by-length", true, "scorer");
 
+// number of end frames for which the segment scores are kept
+const Core::ParameterInt SegmentScorer::paramNumberOfCachedFrames_("number-of-cached-frames", 2, "scorer");
+
 SegmentScorer::SegmentScorer() :
 		Precursor(),
 		scaleSegmentByLength_(Core::Configuration::config(paramScaleSegmentByLength_)),
-		t_start_(Types::max<u32>()),
-		t_end_(Types::max<u32>())
-{}
+		cache_(Core::Configuration::config(paramNumberOfCachedFrames_))
+{
+	require_gt(cache_.size(), 0);
+}
 
 void SegmentScorer::initialize() {
 	Precursor::initialize();
-	prior_.finishComputation();
 	networkInput_.resize(network_.inputDimension(), batchSize_);
 }
 
-void SegmentScorer::generateVector(u32 t_start, u32 t_end, u32 column, Nn::Matrix& result) {
-	require_le(t_start, t_end);
-	require_eq(result.nRows(), sequence_.nRows());
-	require_lt(column, result.nColumns());
+void SegmentScorer::generateSegmentVectors(u32 t_end, u32 firstLength, u32 nLengths) {
+	require_le(firstLength + nLengths - 1, t_end + 1);
+	require_eq(networkInput_.nRows(), sequence_.nRows());
+	u32 D = sequence_.nRows();
+	const Float* end = &(sequence_.at(0, t_end));
+	// one column per segment length, the segment mean is the difference of two prefix sums
 #pragma omp parallel for
-	for (u32 row = 0; row < sequence_.nRows(); row++) {
-		result.at(row, column) = sequence_.at(row, t_end);
-		if (t_start > 0) {
-			result.at(row, column) -= sequence_.at(row, t_start - 1);
+	for (u32 column = 0; column < nLengths; column++) {
+		u32 length = firstLength + column;
+		Float* result = &(networkInput_.at(0, column));
+		if (length == t_end + 1) {
+			for (u32 d = 0; d < D; d++)
+				result[d] = end[d] / length;
+		}
+		else {
+			const Float* start = &(sequence_.at(0, t_end - length));
+			for (u32 d = 0; d < D; d++)
+				result[d] = (end[d] - start[d]) / length;
 		}
-		result.at(row, column) /= t_end - t_start + 1;
 	}
 }
 
 void SegmentScorer::setSequence(const Math::Matrix<Float>& sequence) {
 	sequence_.copyStructure(sequence);
 	sequence_.copy(sequence);
+	u32 D = sequence_.nRows();
 	for (u32 col = 1; col < sequence_.nColumns(); col++) {
-#pragma omp parallel for
-		for (u32 row = 0; row < sequence_.nRows(); row++) {
-			sequence_.at(row, col) += sequence_.at(row, col-1);
+		const Float* previous = &(sequence_.at(0, col - 1));
+		Float* current = &(sequence_.at(0, col));
+		for (u32 d = 0; d < D; d++)
+			current[d] += previous[d];
+	}
+	// scores of the previous sequence are invalid
+	for (u32 i = 0; i < cache_.size(); i++)
+		cache_[i].t_end = Types::max<u32>();
+}
+
+void SegmentScorer::scoreSegments(CachedFrame& frame, u32 maxLength) {
+	// segments are scored in batches of up to batchSize_ lengths, all shorter segments are scored first
+	while (frame.nLengths < maxLength) {
+		u32 firstLength = frame.nLengths + 1;
+		u32 nLengths = std::min(batchSize_, frame.t_end + 1 - frame.nLengths);
+		networkInput_.finishComputation(false);
+		networkInput_.resize(network_.inputDimension(), nLengths);
+		generateSegmentVectors(frame.t_end, firstLength, nLengths);
+		network_.forward(networkInput_);
+		scores_.initComputation();
+		scores_.copyStructure(network_.outputLayer().latestActivations(0));
+		scores_.copy(network_.outputLayer().latestActivations(0));
+		if (logarithmizeNetworkOutput_)
+			scores_.log();
+		scores_.addToAllColumns(prior_, (Float)-1.0);
+		scores_.finishComputation();
+		frame.scores.resize((u64)(frame.nLengths + nLengths) * nClasses_);
+		for (u32 column = 0; column < nLengths; column++) {
+			const Float* src = &(scores_.at(0, column));
+			Float* dest = &(frame.scores[(u64)(frame.nLengths + column) * nClasses_]);
+			Float scale = (scaleSegmentByLength_ ? firstLength + column : 1);
+			for (u32 c = 0; c < nClasses_; c++)
+				dest[c] = scale * src[c];
 		}
+		frame.nLengths += nLengths;
 	}
 }
 
 Float SegmentScorer::segmentScore(u32 t, u32 length, u32 c) {
 	require(isInitialized_);
-	u32 T = sequence_.nColumns();
-	require_lt(t, T);
-	u32 t_end = t;
-	u32 t_start = t_end - length + 1;
-	// are the scores already precomputed or do we have to compute them first?
-	if ((t_start < t_start_) || (t_start > t_start_ + batchSize_ - 1) || (t_end != t_end_)) {
-		// update for which t and t_start the scores are precomputed
-		t_start_ = std::max((s32)t_end - (s32)batchSize_ + 1, 0);
-		if (t_end - t_start + 1 > batchSize_)
-			t_start_ = t_start;
-		t_end_ = t_end;
-
-		for (u32 column = 0; column < t_end_ - t_start_ + 1; column++) {
-			generateVector(t_start_ + column, t_end_, column, networkInput_);
-		}
-        network_.forward(networkInput_);
-        networkInput_.finishComputation(false);
-        scores_.initComputation();
-        scores_.copyStructure(network_.outputLayer().latestActivations(0));
-        scores_.copy(network_.outputLayer().latestActivations(0));
-        scores_.finishComputation();
+	require_lt(t, sequence_.nColumns());
+	require_le(length, t + 1);
+	require_gt(length, 0);
+	require_lt(c, nClasses_);
+	CachedFrame& frame = cache_[t % cache_.size()];
+	if (frame.t_end != t) {
+		frame.t_end = t;
+		frame.nLengths = 0;
 	}
-
-	u32 column = (t_start - t_start_);
-    Float segmentScore = scores_.at(c, column);
-    if (logarithmizeNetworkOutput_)
-        segmentScore = std::log(segmentScore);
-    segmentScore -= prior_.at(c);
-	if (scaleSegmentByLength_)
-		segmentScore *= length;
-	return segmentScore;
+	if (length > frame.nLengths)
+		scoreSegments(frame, length);
+	return frame.scores[(u64)(length - 1) * nClasses_ + c];
 }
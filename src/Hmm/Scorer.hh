@@ -47,6 +47,18 @@ public:
 	virtual void setSequence(const Math::Matrix<Float>& sequence);
 	virtual Float frameScore(u32 t, u32 c) { return 0.0; }
 	virtual Float segmentScore(u32 t, u32 length, u32 c) { return 0.0; }
+	/*
+	 * @return true if the scorer only provides frame scores, i.e. all scores of a sequence can be precomputed
+	 */
+	virtual bool isFramewise() const { return true; }
+	/*
+	 * compute the frame scores of all classes for the given sequence (nClasses x sequence length)
+	 */
+	virtual void frameScores(const Math::Matrix<Float>& sequence, Math::Matrix<Float>& scores);
+	/*
+	 * @return pointer to the frame scores of all classes at frame t (contiguous in memory) or 0 if the scorer does not store them
+	 */
+	virtual const Float* frameScoreColumn(u32 t) { return 0; }
 
 	/*
 	 * factory
@@ -55,6 +67,21 @@ public:
 };
 
 
+/*
+ * scorer for precomputed frame scores, the scores (nClasses x sequence length) are passed via setSequence
+ */
+class PrecomputedScorer : public Scorer
+{
+private:
+	typedef Scorer Precursor;
+public:
+	PrecomputedScorer(u32 nClasses);
+	virtual ~PrecomputedScorer() {}
+	virtual Float frameScore(u32 t, u32 c);
+	virtual const Float* frameScoreColumn(u32 t);
+};
+
+
 class FramewiseNeuralNetworkScorer : public Scorer
 {
 private:
@@ -69,14 +96,24 @@ protected:
 	bool logarithmizeNetworkOutput_;
 	u32 batchSize_;
 	Nn::Vector prior_;
-	Nn::NeuralNetwork network_;
+	Nn::NeuralNetwork ownNetwork_;
+	Nn::NeuralNetwork& network_;
+	bool ownsNetwork_;
 	Nn::Matrix scores_;
 public:
 	FramewiseNeuralNetworkScorer();
+	/* score with an already initialized network that is owned by someone else (e.g. a trainer) */
+	FramewiseNeuralNetworkScorer(Nn::NeuralNetwork& network);
 	virtual ~FramewiseNeuralNetworkScorer() {}
 	virtual void initialize();
+	/* true if the scores are divided by a state prior (scorer.prior-file is given) */
+	bool hasPrior() const { return !priorFile_.empty(); }
+	/* replace the state prior (probabilities, not logarithmized), only possible if the scorer has a prior */
+	void setPrior(const Math::Vector<Float>& prior);
 	virtual void setSequence(const Math::Matrix<Float>& sequence);
 	virtual Float frameScore(u32 t, u32 c);
+	virtual void frameScores(const Math::Matrix<Float>& sequence, Math::Matrix<Float>& scores);
+	virtual const Float* frameScoreColumn(u32 t);
 };
 
 
@@ -84,13 +121,20 @@ class SegmentScorer : public FramewiseNeuralNetworkScorer
 {
 private:
 	static const Core::ParameterBool paramScaleSegmentByLength_;
+	static const Core::ParameterInt paramNumberOfCachedFrames_;
 	typedef FramewiseNeuralNetworkScorer Precursor;
+	/* scores of all segments ending in frame t_end with length 1,...,nLengths */
+	struct CachedFrame {
+		u32 t_end;
+		u32 nLengths;
+		std::vector<Float> scores; // nClasses x nLengths (column-major)
+	};
 	bool scaleSegmentByLength_;
-	Math::Matrix<Float> sequence_;
+	Math::Matrix<Float> sequence_; // prefix sums over the frames of the sequence
 	Nn::Matrix networkInput_;
-	u32 t_start_; // start frame for which scores have been precomputed
-	u32 t_end_; // end frame for which scores have been precomputed
-	void generateVector(u32 t_start, u32 t_end, u32 column, Nn::Matrix& result);
+	std::vector<CachedFrame> cache_; // ring buffer indexed by t_end
+	void generateSegmentVectors(u32 t_end, u32 firstLength, u32 nLengths);
+	void scoreSegments(CachedFrame& frame, u32 maxLength);
 public:
 	SegmentScorer();
 	virtual ~SegmentScorer() {}
@@ -98,6 +142,8 @@ public:
 	virtual void setSequence(const Math::Matrix<Float>& sequence);
 	virtual Float frameScore(u32 t, u32 c) { return 0.0; }
 	virtual Float segmentScore(u32 t, u32 length, u32 c);
+	virtual bool isFramewise() const { return false; }
+	virtual const Float* frameScoreColumn(u32 t) { return 0; }
 };
 
 } // namespace
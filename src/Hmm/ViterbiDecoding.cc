@@ -27,23 +27,74 @@ using namespace Hmm;
 /*
  * TracebackNode
  */
-ViterbiDecoding::TracebackNode::TracebackNode(u32 _state, TracebackNode* _predecessor) :
+ViterbiDecoding::TracebackNode::TracebackNode(u32 _state, u32 _predecessor) :
 		predecessor(_predecessor),
 		state(_state),
-		nSuccessors(0),
-		isActionBoundary(false)
-{
-	if (predecessor != 0)
-		predecessor->nSuccessors++;
+		isActionBoundary(false),
+		isMarked(false)
+{}
+
+/*
+ * TracebackArena
+ */
+const u32 ViterbiDecoding::TracebackArena::none = Types::max<u32>();
+
+ViterbiDecoding::TracebackArena::TracebackArena() :
+		collectionSize_(1024)
+{}
+
+u32 ViterbiDecoding::TracebackArena::newNode(u32 state, u32 predecessor) {
+	if (freeNodes_.empty()) {
+		nodes_.push_back(TracebackNode(state, predecessor));
+		return nodes_.size() - 1;
+	}
+	u32 index = freeNodes_.back();
+	freeNodes_.pop_back();
+	nodes_[index] = TracebackNode(state, predecessor);
+	return index;
+}
+
+void ViterbiDecoding::TracebackArena::mark(u32 index) {
+	// stop as soon as an already marked node is reached, its predecessors are marked, too
+	while ((index != none) && (!nodes_[index].isMarked)) {
+		nodes_[index].isMarked = true;
+		index = nodes_[index].predecessor;
+	}
 }
 
-ViterbiDecoding::TracebackNode::~TracebackNode() {
-	require_eq(nSuccessors, 0);
-	if (predecessor != 0) {
-		predecessor->nSuccessors--;
-		if (predecessor->nSuccessors == 0)
-			delete predecessor;
+u32 ViterbiDecoding::TracebackArena::markCommonAncestor(std::vector<u32>& nodes) {
+	// all nodes have the same depth, so their tracebacks are followed level by level until they merge
+	std::vector<u32> predecessors;
+	for (u32 i = 0; i < nodes.size(); i++)
+		nodes_[nodes[i]].isMarked = true;
+	while (nodes.size() > 1) {
+		predecessors.clear();
+		for (u32 i = 0; i < nodes.size(); i++) {
+			u32 predecessor = nodes_[nodes[i]].predecessor;
+			if ((predecessor != none) && (!nodes_[predecessor].isMarked)) {
+				nodes_[predecessor].isMarked = true;
+				predecessors.push_back(predecessor);
+			}
+		}
+		nodes.swap(predecessors);
 	}
+	return (nodes.size() == 1 ? nodes[0] : none);
+}
+
+void ViterbiDecoding::TracebackArena::sweep() {
+	freeNodes_.clear();
+	for (u32 i = 0; i < nodes_.size(); i++) {
+		if (nodes_[i].isMarked)
+			nodes_[i].isMarked = false;
+		else
+			freeNodes_.push_back(i);
+	}
+	collectionSize_ = std::max(collectionSize_, 2 * nUsedNodes());
+}
+
+void ViterbiDecoding::TracebackArena::reset() {
+	nodes_.clear();
+	freeNodes_.clear();
 }
 
 /*
@@ -68,30 +119,26 @@ u32 ViterbiDecoding::HypothesisKey::hash(const HypothesisKey& k) {
 		return (31 * ((31 * k.context) ^ k.state)) ^ k.length;
 }
 
+u32 ViterbiDecoding::HypothesisKey::Hash::operator()(const HypothesisKey& k) const {
+	// direct addressing, sequence end hypotheses (state Types::max<u32>()) are mapped to the additional state nStates
+	if (nStates > 0)
+		return k.context * (nStates + 1) + std::min(k.state, nStates);
+	else
+		return Core::hashMix(HypothesisKey::hash(k));
+}
+
 /*
  * ViterbiDecoding::HypothesisNode
  */
-ViterbiDecoding::HypothesisNode::HypothesisNode(u32 state) :
+ViterbiDecoding::HypothesisNode::HypothesisNode() :
 		score(-Types::inf<Float>()),
-		traceback(new TracebackNode(state, 0))
+		traceback(TracebackArena::none)
 {}
 
-ViterbiDecoding::HypothesisNode::~HypothesisNode() {
-	if ((traceback != 0) && (traceback->nSuccessors == 0))
-		delete traceback;
-}
-
-void ViterbiDecoding::HypothesisNode::update(Float _score, TracebackNode* predecessorTraceback, bool isActionBoundary) {
-	if (_score > score) {
-		score = _score;
-		traceback->isActionBoundary = isActionBoundary;
-		if (traceback->predecessor != 0)
-			traceback->predecessor->nSuccessors--;
-		traceback->predecessor = predecessorTraceback;
-		if (traceback->predecessor != 0)
-			traceback->predecessor->nSuccessors++;
-	}
-}
+ViterbiDecoding::HypothesisNode::HypothesisNode(u32 _traceback) :
+		score(-Types::inf<Float>()),
+		traceback(_traceback)
+{}
 
 /*
  * ViterbiDecoding::HypothesisList
@@ -100,37 +147,58 @@ const Core::ParameterFloat ViterbiDecoding::HypothesisList::paramPruningThreshol
 
 const Core::ParameterInt ViterbiDecoding::HypothesisList::paramMaxHypotheses_("max-hypotheses", Types::max<u32>(), "viterbi-decoding");
 
-ViterbiDecoding::HypothesisList::HypothesisList() :
-		hashmap_(HypothesisKey::hash),
+// maximal number of (context, state) pairs for which the hypotheses are directly addressed (only if length model is framewise)
+const Core::ParameterInt ViterbiDecoding::HypothesisList::paramMaxDenseTableSize_("maximal-dense-table-size", 1048576, "viterbi-decoding");
+
+// approximate max-hypotheses pruning based on a histogram of the scores instead of an exact selection
+const Core::ParameterBool ViterbiDecoding::HypothesisList::paramHistogramPruning_("histogram-pruning", false, "viterbi-decoding");
+
+const Core::ParameterInt ViterbiDecoding::HypothesisList::paramNumberOfHistogramBins_("number-of-histogram-bins", 100, "viterbi-decoding");
+
+ViterbiDecoding::HypothesisList::HypothesisList(TracebackArena& arena) :
+		arena_(arena),
 		pruningThreshold_(Core::Configuration::config(paramPruningThreshold_)),
-		maxHypotheses_(Core::Configuration::config(paramMaxHypotheses_))
+		maxHypotheses_(Core::Configuration::config(paramMaxHypotheses_)),
+		maxDenseTableSize_(Core::Configuration::config(paramMaxDenseTableSize_)),
+		histogramPruning_(Core::Configuration::config(paramHistogramPruning_)),
+		nHistogramBins_(Core::Configuration::config(paramNumberOfHistogramBins_)),
+		isDense_(false)
 {
 	require_ge(pruningThreshold_, 0);
+	require_gt(nHistogramBins_, 0);
 }
 
 bool ViterbiDecoding::HypothesisList::compare(Hypothesis* a, Hypothesis* b) {
 	return a->value.score > b->value.score; // sort from best score to worst score
 }
 
+void ViterbiDecoding::HypothesisList::initialize(u32 nContexts, u32 nStates) {
+	require_eq(nHypotheses(), 0);
+	// one additional state for the sequence end hypotheses
+	u64 size = (u64)nContexts * (nStates + 1);
+	isDense_ = HypothesisKey::disregardLength && (size <= maxDenseTableSize_);
+	hashmap_.setHashFunction(HypothesisKey::Hash(isDense_ ? nStates : 0));
+	// with direct addressing, all possible keys fit into the map without collisions
+	if (isDense_)
+		hashmap_.reserve(size);
+}
+
 void ViterbiDecoding::HypothesisList::remove(const HypothesisKey& key) {
 	hashmap_.remove(key);
 }
 
-void ViterbiDecoding::HypothesisList::update(const HypothesisKey& key, Float score, TracebackNode* predecessorTraceback, bool isActionBoundary) {
+void ViterbiDecoding::HypothesisList::update(const HypothesisKey& key, Float score, u32 predecessorTraceback, bool isActionBoundary) {
 	Hypothesis *hypothesis = hashmap_.find(key);
-	// insert if key does not yet exist and score is not too bad
-	if (hypothesis == 0) {
-		HypothesisNode value(key.state);
-		// TODO remove this dirty hack for avoiding that the traceback pointer is deleted when the hash map calls the destructor of the copy of value during inserting
-		TracebackNode* traceback = value.traceback;
-		value.traceback = 0;
-		hypothesis = hashmap_.insert(key, value);
-		hypothesis->value.traceback = traceback;
-	}
-	if (hypothesis != 0) {
-		if (score > hypothesis->value.score)
-			hypothesis->key.length = key.length;
-		hypothesis->value.update(score, predecessorTraceback, isActionBoundary);
+	// insert if key does not yet exist
+	if (hypothesis == 0)
+		hypothesis = hashmap_.insert(key, HypothesisNode(arena_.newNode(key.state)));
+	// the traceback node of a new hypothesis is not referenced by other nodes yet, so it can be modified in place
+	if (score > hypothesis->value.score) {
+		hypothesis->key.length = key.length;
+		hypothesis->value.score = score;
+		TracebackNode& traceback = arena_.node(hypothesis->value.traceback);
+		traceback.predecessor = predecessorTraceback;
+		traceback.isActionBoundary = isActionBoundary;
 	}
 }
 
@@ -138,48 +206,142 @@ void ViterbiDecoding::HypothesisList::clear() {
 	hashmap_.clear();
 }
 
-void ViterbiDecoding::HypothesisList::prune(u32 maxLength) {
-	if (HypothesisKey::disregardLength)
-		maxLength = 1;
+void ViterbiDecoding::HypothesisList::swap(HypothesisList& hyp) {
+	require_eq(isDense_, hyp.isDense_);
+	hashmap_.swap(hyp.hashmap_);
+}
+
+void ViterbiDecoding::HypothesisList::markTracebacks() {
+	for (iterator h = begin(); h != end(); ++h)
+		arena_.mark(h->value.traceback);
+}
+
+u32 ViterbiDecoding::HypothesisList::histogramBin(const Hypothesis& h, Float bestScore) const {
+	// bins are equally spaced between the best score of the hypothesis length and the worst score that survives pruning
+	u32 l = lengthIndex(h);
+	Float range = bestScores_[l] - std::max(worstScores_[l], bestScore - pruningThreshold_);
+	if (range <= 0)
+		return 0;
+	Float bin = (bestScores_[l] - h.value.score) / range * nHistogramBins_;
+	// also catches infinite scores
+	if (!(bin < nHistogramBins_))
+		return nHistogramBins_ - 1;
+	return (u32)bin;
+}
 
-	/* score threshold pruning */
-	if (pruningThreshold_ < Types::inf<Float>()) {
-		// store best scores
-		std::vector< Float > bestScore(maxLength, -Types::inf<Float>());
-		for (Hypothesis* h = hashmap_.begin(); h != hashmap_.end(); h = h->next) {
-			u32 l = (HypothesisKey::disregardLength ? 0 : h->key.length-1);
-			if (bestScore[l] < h->value.score) bestScore[l] = h->value.score;
+void ViterbiDecoding::HypothesisList::selectionPruning(Float bestScore) {
+	// each length into one vector of hypotheses, hypotheses below the score threshold are removed right away
+	for (u32 l = 0; l < bins_.size(); l++)
+		bins_[l].clear();
+	bins_.resize(bestScores_.size());
+	for (iterator h = begin(); h != end(); ++h) {
+		u32 l = lengthIndex(*h);
+		if (h->value.score + pruningThreshold_ < bestScore)
+			remove(h->key);
+		// only lengths with too many hypotheses need a selection
+		else if (nHypothesesPerLength_[l] > maxHypotheses_)
+			bins_[l].push_back(&(*h));
+	}
+	// keep the best maxHypotheses_ hypotheses of each length
+	for (u32 l = 0; l < bins_.size(); l++) {
+		if (maxHypotheses_ < bins_[l].size()) {
+			std::nth_element(bins_[l].begin(), bins_[l].begin() + maxHypotheses_, bins_[l].end(), compare);
+			for (u32 i = maxHypotheses_; i < bins_[l].size(); i++)
+				remove(bins_[l][i]->key);
 		}
-		// prune bad scores
-		for (u32 l = 0; l < maxLength; l++) {
-			// remove all bad hypotheses
-			for (Hypothesis* h = hashmap_.begin(); h != hashmap_.end(); h = h->next) {
-				if (h->value.score + pruningThreshold_ < bestScore[l])
-					hashmap_.remove(h->key);
+	}
+}
+
+void ViterbiDecoding::HypothesisList::histogramPruning(Float bestScore) {
+	// histograms are only needed for lengths with too many hypotheses
+	u32 nLengths = bestScores_.size();
+	u32 nHistograms = 0;
+	histogramOffsets_.assign(nLengths, Types::max<u32>());
+	for (u32 l = 0; l < nLengths; l++) {
+		if (nHypothesesPerLength_[l] > maxHypotheses_) {
+			histogramOffsets_[l] = nHistograms * nHistogramBins_;
+			nHistograms++;
+		}
+	}
+	histogram_.assign(nHistograms * nHistogramBins_, 0);
+	cutoffs_.assign(nLengths, nHistogramBins_);
+	// count the hypotheses that survive threshold pruning per length and score bin
+	for (iterator h = begin(); h != end(); ++h) {
+		u32 offset = histogramOffsets_[lengthIndex(*h)];
+		if ((offset != Types::max<u32>()) && (h->value.score + pruningThreshold_ >= bestScore))
+			histogram_[offset + histogramBin(*h, bestScore)]++;
+	}
+	// for each length, find the first bin that would exceed maxHypotheses_ (but keep at least the best bin)
+	for (u32 l = 0; l < nLengths; l++) {
+		if (histogramOffsets_[l] == Types::max<u32>())
+			continue;
+		u32 count = 0;
+		for (u32 bin = 0; bin < nHistogramBins_; bin++) {
+			count += histogram_[histogramOffsets_[l] + bin];
+			if (count > maxHypotheses_) {
+				cutoffs_[l] = std::max(bin, (u32)1);
+				break;
 			}
 		}
 	}
+	for (iterator h = begin(); h != end(); ++h) {
+		u32 l = lengthIndex(*h);
+		if ((h->value.score + pruningThreshold_ < bestScore) ||
+				((cutoffs_[l] < nHistogramBins_) && (histogramBin(*h, bestScore) >= cutoffs_[l])))
+			remove(h->key);
+	}
+}
 
-	/* max hypotheses pruning */
-	if (maxHypotheses_ < Types::max<u32>()) {
-		// each length into one vector of hypotheses
-		std::vector< std::vector<Hypothesis*> > hyp(maxLength);
-		for (Hypothesis* h = hashmap_.begin(); h != hashmap_.end(); h = h->next) {
-			u32 l = (HypothesisKey::disregardLength ? 0 : h->key.length-1);
-			hyp.at(l).push_back(h);
+void ViterbiDecoding::HypothesisList::prune() {
+	bool thresholdPruning = (pruningThreshold_ < Types::inf<Float>());
+	// if there are not more than maxHypotheses_ hypotheses in total, no length can have more
+	bool maxHypothesesPruning = (maxHypotheses_ < nHypotheses());
+	if ((!thresholdPruning) && (!maxHypothesesPruning))
+		return;
+
+	// best score over all hypotheses (the score threshold is relative to it) and best/worst score per length
+	Float bestScore = -Types::inf<Float>();
+	bestScores_.clear();
+	worstScores_.clear();
+	nHypothesesPerLength_.clear();
+	for (iterator h = begin(); h != end(); ++h) {
+		u32 l = lengthIndex(*h);
+		if (l >= bestScores_.size()) {
+			bestScores_.resize(l + 1, -Types::inf<Float>());
+			worstScores_.resize(l + 1, Types::inf<Float>());
+			nHypothesesPerLength_.resize(l + 1, 0);
 		}
-		// prune all but best maxHypotheses_ hypotheses
-		for (u32 l = 0; l < maxLength; l++) {
-			if (maxHypotheses_ < hyp[l].size()) {
-				// sort hypotheses from best to worst score
-				std::sort(hyp[l].begin(), hyp[l].end(), compare);
-				// keep at most the best maxHypotheses nodes
-				for (u32 i = maxHypotheses_; i < hyp[l].size(); i++) {
-					hashmap_.remove(hyp[l].at(i)->key);
-				}
-			}
+		nHypothesesPerLength_[l]++;
+		bestScore = std::max(bestScore, h->value.score);
+		bestScores_[l] = std::max(bestScores_[l], h->value.score);
+		worstScores_[l] = std::min(worstScores_[l], h->value.score);
+	}
+
+	if (!maxHypothesesPruning) {
+		for (iterator h = begin(); h != end(); ++h) {
+			if (h->value.score + pruningThreshold_ < bestScore)
+				remove(h->key);
 		}
 	}
+	else if (histogramPruning_) {
+		histogramPruning(bestScore);
+	}
+	else {
+		selectionPruning(bestScore);
+	}
+}
+
+/*
+ * ViterbiDecoding::HypothesisBatch
+ */
+void ViterbiDecoding::HypothesisBatch::resize(u32 size) {
+	context.resize(size);
+	state.resize(size);
+	length.resize(size);
+	traceback.resize(size);
+	score.resize(size);
+	loopScore.resize(size);
+	exitScore.resize(size);
 }
 
 /*
@@ -193,41 +355,129 @@ const Core::ParameterFloat ViterbiDecoding::paramLengthModelScale_("length-model
 
 const Core::ParameterInt ViterbiDecoding::paramMaximalLength_("maximal-length", Types::max<u32>(), "viterbi-decoding");
 
+// online decoding: write the part of the traceback all hypotheses agree on to the output and release it during decoding
+const Core::ParameterBool ViterbiDecoding::paramPartialTraceback_("partial-traceback", false, "viterbi-decoding");
+
 ViterbiDecoding::ViterbiDecoding() :
 		outputType_((ViterbiOutput) Core::Configuration::config(paramViterbiOutput_)),
 		grammarScale_(Core::Configuration::config(paramGrammarScale_)),
 		lengthModelScale_(Core::Configuration::config(paramLengthModelScale_)),
 		maxLength_(Core::Configuration::config(paramMaximalLength_)),
+		partialTraceback_(Core::Configuration::config(paramPartialTraceback_)),
 		grammar_(0),
 		scorer_(0),
 		lengthModel_(0),
+		ownsLengthModel_(true),
 		hmm_(0),
-		isInitialized_(false)
+		isInitialized_(false),
+		oldHyp_(tracebackArena_),
+		newHyp_(tracebackArena_),
+		fixedNode_(TracebackArena::none),
+		segmentListener_(0),
+		nFixedSegments_(0),
+		useLengthModel_(false),
+		useSegmentScores_(false)
 {}
 
 ViterbiDecoding::~ViterbiDecoding() {
 	delete grammar_;
 	delete scorer_;
-	delete lengthModel_;
+	if (ownsLengthModel_)
+		delete lengthModel_;
 	delete hmm_;
 }
 
-void ViterbiDecoding::initialize() {
+void ViterbiDecoding::initialize(bool usePrecomputedScores, const LengthModel* sharedLengthModel) {
 	grammar_ = Grammar::create();
 	grammar_->initialize();
-	scorer_ = Scorer::create();
-	scorer_->initialize();
-	lengthModel_ = LengthModel::create();
-	lengthModel_->initialize();
+	hmm_ = HiddenMarkovModel::create();
+	hmm_->initialize();
+	// the score tables of a shared length model have already been computed by its owner
+	if (sharedLengthModel) {
+		lengthModel_ = sharedLengthModel;
+		ownsLengthModel_ = false;
+	}
+	else {
+		LengthModel* lengthModel = LengthModel::create();
+		lengthModel->initialize();
+		lengthModel->precomputeScores(hmm_->nStates(), maxLength_, lengthModelScale_);
+		lengthModel_ = lengthModel;
+	}
 	if (lengthModel_->isFramewise())
 		HypothesisKey::disregardLength = true;
 	else
 		HypothesisKey::disregardLength = false;
-	hmm_ = HiddenMarkovModel::create();
-	hmm_->initialize();
+	if (usePrecomputedScores)
+		scorer_ = new PrecomputedScorer(hmm_->nStates());
+	else
+		scorer_ = Scorer::create();
+	scorer_->initialize();
+	initializeTables();
 	isInitialized_ = true;
 }
 
+void ViterbiDecoding::initializeTables() {
+	u32 nStates = hmm_->nStates();
+	loopScores_.resize(nStates);
+	forwardScores_.resize(nStates);
+	isEndState_.resize(nStates);
+	startLengthScores_.resize(nStates);
+	for (u32 s = 0; s < nStates; s++) {
+		loopScores_[s] = hmm_->transitionScore(s, s);
+		// for end states, this is the score of the transition to the start state of another class
+		forwardScores_[s] = hmm_->transitionScore(s, s + 1);
+		isEndState_[s] = (hmm_->isEndState(s) ? 1 : 0);
+		startLengthScores_[s] = lengthModel_->scaledFrameScore(1, s);
+	}
+	useLengthModel_ = (lengthModel_->type() != LengthModel::none);
+	useSegmentScores_ = !scorer_->isFramewise();
+}
+
+void ViterbiDecoding::setLoopProbabilities(const Math::Vector<Float>& loopProbabilities) {
+	require(isInitialized_);
+	hmm_->setLoopProbabilities(loopProbabilities);
+	initializeTables();
+}
+
+void ViterbiDecoding::initializeGrammarTransitions() {
+	// grammar may change with each sequence (realignment)
+	grammarTransitions_.resize(grammar_->nNonterminals());
+	for (u32 context = 0; context < grammar_->nNonterminals(); context++) {
+		grammarTransitions_[context].clear();
+		const std::vector<Grammar::Rule>& rules = grammar_->rules(context);
+		for (u32 rule = 0; rule < rules.size(); rule++) {
+			// transitions to sequence end symbol are treated separately at the end of the sequence
+			if (rules.at(rule).context == grammar_->endSymbol())
+				continue;
+			grammarTransitions_[context].push_back(GrammarTransition(rules.at(rule).context,
+					hmm_->startState(rules.at(rule).label), grammarScale_ * rules.at(rule).logProbability));
+		}
+	}
+}
+
+const Float* ViterbiDecoding::frameScores(u32 t) {
+	const Float* scores = scorer_->frameScoreColumn(t);
+	if (scores == 0) {
+		frameScoreBuffer_.resize(hmm_->nStates());
+		for (u32 s = 0; s < hmm_->nStates(); s++)
+			frameScoreBuffer_[s] = scorer_->frameScore(t, s);
+		scores = &(frameScoreBuffer_[0]);
+	}
+	return scores;
+}
+
+void ViterbiDecoding::gather(HypothesisList& hyp) {
+	batch_.resize(hyp.nHypotheses());
+	u32 i = 0;
+	for (HypothesisIterator h = hyp.begin(); h != hyp.end(); ++h, i++) {
+		batch_.context[i] = h->key.context;
+		batch_.state[i] = h->key.state;
+		batch_.length[i] = h->key.length;
+		batch_.traceback[i] = h->value.traceback;
+		batch_.score[i] = h->value.score;
+	}
+}
+
 void ViterbiDecoding::sanityCheck() {
 	// check number of hmm states
 	if (hmm_->nStates() != scorer_->nClasses())
@@ -240,73 +490,158 @@ void ViterbiDecoding::sanityCheck() {
 }
 
 void ViterbiDecoding::decodeFrame(u32 t, HypothesisList& oldHyp, HypothesisList& newHyp) {
-	// for each hypothesis in oldHyp create the valid new hypotheses
-	for (Hypothesis* h = oldHyp.begin(); h != oldHyp.end(); h = h->next) {
-		/* loop transition (stay in the same hmm state) */
-		HypothesisKey key(h->key.context, h->key.state, h->key.length + 1);
-		Float score = h->value.score + hmm_->transitionScore(key.state, key.state)
-				      + scorer_->frameScore(t, key.state) + lengthModelScale_ * lengthModel_->frameScore(key.length, key.state);
-		if (HypothesisKey::disregardLength || (key.length <= maxLength_))
-			newHyp.update(key, score, h->value.traceback);
-		/* hmm end state: hypothesize action end and start new hypothesis using grammar */
-		if (hmm_->isEndState(h->key.state)) {
-			// ... start a new class hypothesis for each transition allowed by the grammar
-			const std::vector<Grammar::Rule>& rules = grammar_->rules(h->key.context);
-			for (u32 rule = 0; rule < rules.size(); rule++) {
-				// exclude transitions to sequence end symbol as long as we are not at the end of the sequence
-				if (rules.at(rule).context == grammar_->endSymbol())
-					continue;
-				HypothesisKey key(rules.at(rule).context, hmm_->startState(rules.at(rule).label), 1);
-				score = h->value.score + lengthModelScale_ * lengthModel_->segmentScore(h->key.length, h->key.state)
-						+ scorer_->segmentScore(t-1, h->key.length, h->key.state)
-						+ grammarScale_ * rules.at(rule).logProbability + hmm_->transitionScore(h->key.state, key.state)
-						+ scorer_->frameScore(t, key.state) + lengthModelScale_ * lengthModel_->frameScore(key.length, key.state);
-				newHyp.update(key, score, h->value.traceback, true);
+	gather(oldHyp);
+	u32 n = batch_.size();
+	if (n == 0)
+		return;
+	const Float* frame = frameScores(t);
+	const u32* state = &(batch_.state[0]);
+	const u32* length = &(batch_.length[0]);
+	Float* loopScore = &(batch_.loopScore[0]);
+	Float* exitScore = &(batch_.exitScore[0]);
+
+	/* scores of all hypotheses for staying in the current state and for ending the current segment */
+	for (u32 i = 0; i < n; i++) {
+		loopScore[i] = batch_.score[i] + loopScores_[state[i]] + frame[state[i]];
+		exitScore[i] = batch_.score[i];
+	}
+	if (useLengthModel_) {
+		for (u32 i = 0; i < n; i++) {
+			loopScore[i] += lengthModel_->scaledFrameScore(length[i] + 1, state[i]);
+			exitScore[i] += lengthModel_->scaledSegmentScore(length[i], state[i]);
+		}
+	}
+	if (useSegmentScores_) {
+		for (u32 i = 0; i < n; i++)
+			exitScore[i] += scorer_->segmentScore(t-1, length[i], state[i]);
+	}
+
+	/* loop and forward transitions */
+	bestExits_.clear();
+	for (u32 i = 0; i < n; i++) {
+		u32 s = state[i];
+		if (HypothesisKey::disregardLength || (length[i] + 1 <= maxLength_))
+			newHyp.update(HypothesisKey(batch_.context[i], s, length[i] + 1), loopScore[i], batch_.traceback[i]);
+		/* hmm end state: action end, start new hypotheses using the grammar */
+		if (isEndState_[s]) {
+			// framewise length model: each (context, state) pair has a single hypothesis, expand it right away
+			if (HypothesisKey::disregardLength) {
+				expandGrammar(i, frame, newHyp);
+				continue;
 			}
+			// otherwise all segment ends with the same context and state only differ in their length and lead to
+			// the same new hypotheses, so only the best one needs to be expanded
+			HypothesisKey key(batch_.context[i], s, 0);
+			Core::FlatHashMap< HypothesisKey, u32, HypothesisKey::Hash >::Entry* best = bestExits_.find(key);
+			if (best == 0)
+				bestExits_.insert(key, i);
+			else if (exitScore[i] > exitScore[best->value])
+				best->value = i;
 		}
-		/* no hmm end state: forward transition (loop already treated above) */
+		/* no hmm end state: transition to next state */
 		else {
-			// transition to next state
-			HypothesisKey key(h->key.context, hmm_->successor(h->key.state), 1);
-			score = h->value.score + lengthModelScale_ * lengthModel_->segmentScore(h->key.length, h->key.state)
-					+ scorer_->segmentScore(t-1, h->key.length, h->key.state) + hmm_->transitionScore(h->key.state, key.state)
-					+ scorer_->frameScore(t, key.state) + lengthModelScale_ * lengthModel_->frameScore(key.length, key.state);
-			newHyp.update(key, score, h->value.traceback);
+			u32 successor = s + 1;
+			Float score = exitScore[i] + forwardScores_[s] + frame[successor] + startLengthScores_[successor];
+			newHyp.update(HypothesisKey(batch_.context[i], successor, 1), score, batch_.traceback[i]);
+		}
+	}
+
+	/* expand the best segment ends */
+	for (Core::FlatHashMap< HypothesisKey, u32, HypothesisKey::Hash >::iterator it = bestExits_.begin(); it != bestExits_.end(); ++it)
+		expandGrammar(it->value, frame, newHyp);
+}
+
+void ViterbiDecoding::expandGrammar(u32 i, const Float* frame, HypothesisList& newHyp) {
+	// start a new class hypothesis for each transition allowed by the grammar
+	u32 s = batch_.state[i];
+	const std::vector<GrammarTransition>& transitions = grammarTransitions_[batch_.context[i]];
+	for (u32 j = 0; j < transitions.size(); j++) {
+		const GrammarTransition& g = transitions[j];
+		// transition from an end state to the start state of the same class is a loop in single state hmms
+		Float score = batch_.exitScore[i] + g.score + (g.state == s ? loopScores_[s] : forwardScores_[s])
+				+ frame[g.state] + startLengthScores_[g.state];
+		newHyp.update(HypothesisKey(g.context, g.state, 1), score, batch_.traceback[i], true);
+	}
+}
+
+void ViterbiDecoding::appendFrame(const TracebackNode& node) {
+	if (outputType_ == hmmStates) {
+		if ((framewiseRecognition_.size() > 0) && (framewiseRecognition_.back() == node.state))
+			segmentation_.back().length++;
+		else
+			segmentation_.push_back(ActionSegment(node.state, 1));
+		framewiseRecognition_.push_back(node.state);
+	}
+	else { // outputType_ == labels
+		u32 c = hmm_->getClass(node.state);
+		if ((node.isActionBoundary) || (segmentation_.size() == 0))
+			segmentation_.push_back(ActionSegment(c, 1));
+		else
+			segmentation_.back().length++;
+		framewiseRecognition_.push_back(c);
+	}
+}
+
+void ViterbiDecoding::appendTraceback(u32 index, u32 stop) {
+	// collect the nodes from index back to stop (exclusive) and append them in temporal order
+	tracebackBuffer_.clear();
+	for (; (index != TracebackArena::none) && (index != stop); index = tracebackArena_.node(index).predecessor)
+		tracebackBuffer_.push_back(index);
+	for (u32 i = tracebackBuffer_.size(); i > 0; i--)
+		appendFrame(tracebackArena_.node(tracebackBuffer_[i-1]));
+}
+
+void ViterbiDecoding::notifySegmentListener(u32 nFixedSegments) {
+	if (segmentListener_) {
+		for (u32 i = nFixedSegments_; i < nFixedSegments; i++)
+			segmentListener_->fixedSegment(segmentation_[i]);
+	}
+	nFixedSegments_ = std::max(nFixedSegments_, nFixedSegments);
+}
+
+void ViterbiDecoding::collectGarbage(HypothesisList& hyp) {
+	if (partialTraceback_) {
+		std::vector<u32> nodes;
+		for (HypothesisIterator h = hyp.begin(); h != hyp.end(); ++h)
+			nodes.push_back(h->value.traceback);
+		u32 ancestor = tracebackArena_.markCommonAncestor(nodes);
+		// the traceback up to the common ancestor is fixed, output it and cut it off the lattice
+		if (ancestor != TracebackArena::none) {
+			appendTraceback(ancestor, fixedNode_);
+			tracebackArena_.node(ancestor).predecessor = TracebackArena::none;
+			fixedNode_ = ancestor;
+			// the last segment may still be continued by the following frames
+			if (segmentation_.size() > 0)
+				notifySegmentListener(segmentation_.size() - 1);
 		}
 	}
+	else {
+		hyp.markTracebacks();
+	}
+	tracebackArena_.sweep();
 }
 
 void ViterbiDecoding::traceback(HypothesisList& hyp, u32 sequenceLength) {
 	// check if some valid path could be found
-	segmentation_.clear();
-	framewiseRecognition_.clear();
 	if (hyp.nHypotheses() == 0) {
+		// decoding may run in parallel threads
+#pragma omp critical
 		Core::Log::os("No valid hypothesis found. Either sequence is too short or pruning is too strong.");
-		segmentation_.push_back(ActionSegment(0, sequenceLength));
-		framewiseRecognition_.resize(sequenceLength, 0);
+		// label the remaining frames with class 0 (the fixed part of a partial traceback has already been output)
+		u32 nFixedFrames = framewiseRecognition_.size();
+		if (nFixedFrames < sequenceLength) {
+			if ((segmentation_.size() > nFixedSegments_) && (segmentation_.back().label == 0))
+				segmentation_.back().length += sequenceLength - nFixedFrames;
+			else
+				segmentation_.push_back(ActionSegment(0, sequenceLength - nFixedFrames));
+			framewiseRecognition_.resize(sequenceLength, 0);
+		}
 	}
-	// reconstruct decoded state- and label sequence
+	// reconstruct decoded state- and label sequence (the part after the already fixed traceback)
 	else {
-		// trace back best sequence
-		u32 length = 0;
-		for (TracebackNode* traceback = hyp.begin()->value.traceback->predecessor; traceback != 0; traceback = traceback->predecessor) {
-			length++;
-			if (outputType_ == hmmStates) {
-				framewiseRecognition_.insert(framewiseRecognition_.begin(), traceback->state);
-				if ((framewiseRecognition_.size() > 1) && (framewiseRecognition_[0] == framewiseRecognition_[1]))
-					segmentation_[0].length++;
-				else
-					segmentation_.insert(segmentation_.begin(), ActionSegment(traceback->state, 1));
-			}
-			else { // outputType_ == labels
-				framewiseRecognition_.insert(framewiseRecognition_.begin(), hmm_->getClass(traceback->state));
-				if (traceback->isActionBoundary) {
-					segmentation_.insert(segmentation_.begin(), ActionSegment(hmm_->getClass(traceback->state), length));
-					length = 0;
-				}
-			}
-		}
+		appendTraceback(tracebackArena_.node(hyp.begin()->value.traceback).predecessor, fixedNode_);
 	}
+	notifySegmentListener(segmentation_.size());
 }
 
 Float ViterbiDecoding::decode(const Math::Matrix<Float>& sequence) {
@@ -314,31 +649,41 @@ Float ViterbiDecoding::decode(const Math::Matrix<Float>& sequence) {
 	u32 T = sequence.nColumns();
 	scorer_->setSequence(sequence);
 
-	HypothesisList oldHyp;
-	HypothesisList newHyp;
+	HypothesisList& oldHyp = oldHyp_;
+	HypothesisList& newHyp = newHyp_;
+	tracebackArena_.reset();
+	fixedNode_ = TracebackArena::none;
+	nFixedSegments_ = 0;
+	segmentation_.clear();
+	framewiseRecognition_.clear();
+	initializeGrammarTransitions();
+	oldHyp.initialize(grammar_->nNonterminals(), hmm_->nStates());
+	newHyp.initialize(grammar_->nNonterminals(), hmm_->nStates());
 
 	// create initial hypotheses
 	const std::vector<Grammar::Rule>& rules = grammar_->rules(grammar_->startSymbol());
 	for (u32 rule = 0; rule < rules.size(); rule++) {
 		HypothesisKey key(rules.at(rule).context, hmm_->startState(rules.at(rule).label), 1);
-		Float score = grammarScale_ * rules.at(rule).logProbability + scorer_->frameScore(0, key.state) + lengthModelScale_ * lengthModel_->frameScore(key.length, key.state);
-		oldHyp.update(key, score, 0, true);
+		Float score = grammarScale_ * rules.at(rule).logProbability + scorer_->frameScore(0, key.state) + lengthModel_->scaledFrameScore(key.length, key.state);
+		oldHyp.update(key, score, TracebackArena::none, true);
 	}
 
 	// decode all remaining frames
 	for (u32 t = 1; t < T; t++) {
 		// viterbi decoding of frame t
 		decodeFrame(t, oldHyp, newHyp);
-		// oldHyp must be cleared before nodes in newHyp are deleted due to traceback pointers!
 		oldHyp.clear();
 		// prune
-		newHyp.prune(maxLength_);
+		newHyp.prune();
 		// swap old and new hypotheses for processing of next frame
-		std::swap(oldHyp, newHyp);
+		oldHyp.swap(newHyp);
+		// release traceback nodes that are not reachable from the remaining hypotheses
+		if (tracebackArena_.needsCollection())
+			collectGarbage(oldHyp);
 	}
 
 	// find best hypothesis (among all hypotheses that allow a transition to the sequence end symbol)
-	for (Hypothesis* h = oldHyp.begin(); h != oldHyp.end(); h = h->next) {
+	for (HypothesisIterator h = oldHyp.begin(); h != oldHyp.end(); ++h) {
 		if (hmm_->isEndState(h->key.state)) {
 			const std::vector<Grammar::Rule>& rules = grammar_->rules(h->key.context);
 			for (u32 rule = 0; rule < rules.size(); rule++) {
@@ -346,7 +691,7 @@ Float ViterbiDecoding::decode(const Math::Matrix<Float>& sequence) {
 					// hmm transition probability: h->key.state+1 may not exist but does not matter since h->key.state is an end-state
 					HypothesisKey key(grammar_->endSymbol(), Types::max<u32>(), 1);
 					Float score = h->value.score + grammarScale_ * rules.at(rule).logProbability + hmm_->transitionScore(h->key.state, h->key.state+1)
-								  + lengthModelScale_ * lengthModel_->segmentScore(h->key.length, h->key.state)
+								  + lengthModel_->scaledSegmentScore(h->key.length, h->key.state)
 								  + scorer_->segmentScore(T-1, h->key.length, h->key.state);
 					newHyp.update(key, score, h->value.traceback);
 				}
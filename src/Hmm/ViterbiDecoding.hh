@@ -24,7 +24,7 @@
 #define HMM_VITERBIDECODING_HH_
 
 #include <Core/CommonHeaders.hh>
-#include <Core/HashMap.hh>
+#include <Core/FlatHashMap.hh>
 #include <Math/Vector.hh>
 #include <Math/Matrix.hh>
 #include <algorithm>
@@ -44,18 +44,58 @@ public:
 		ActionSegment(u32 _label, u32 _length) : label(_label), length(_length) {}
 	};
 
+	/*
+	 * receives the segments of the decoded sequence in temporal order as soon as they are fixed,
+	 * i.e. with partial traceback already during decoding, otherwise at the end of the sequence
+	 */
+	class SegmentListener {
+	public:
+		virtual ~SegmentListener() {}
+		virtual void fixedSegment(const ActionSegment& segment) = 0;
+	};
+
 private:
 	/* construct linked list as bookkeeping for hypotheses */
 
 	/* traceback node */
 	class TracebackNode {
 	public:
-		TracebackNode* predecessor;
+		u32 predecessor; // index of the predecessor in the traceback arena
 		u32 state;
-		u32 nSuccessors;
 		bool isActionBoundary;
-		TracebackNode(u32 _state, TracebackNode* _predecessor);
-		~TracebackNode();
+		bool isMarked; // used by garbage collection
+		TracebackNode(u32 _state, u32 _predecessor);
+	};
+
+	/*
+	 * storage for all traceback nodes of a sequence, nodes are referenced by their index
+	 * nodes of dead traceback branches are reclaimed by a garbage collection that is run whenever
+	 * the arena doubled its size since the last collection
+	 */
+	class TracebackArena {
+	private:
+		std::vector<TracebackNode> nodes_;
+		std::vector<u32> freeNodes_;
+		u32 collectionSize_; // run garbage collection if number of used nodes exceeds this size
+	public:
+		static const u32 none; // index of non-existing node
+		TracebackArena();
+		u32 newNode(u32 state, u32 predecessor = none);
+		TracebackNode& node(u32 index) { return nodes_[index]; }
+		u32 nUsedNodes() const { return nodes_.size() - freeNodes_.size(); }
+		bool needsCollection() const { return nUsedNodes() > collectionSize_; }
+		/* mark the traceback of a live node (and all of its predecessors) */
+		void mark(u32 index);
+		/*
+		 * mark the tracebacks of the given live nodes up to their deepest common ancestor
+		 * @param nodes distinct nodes of the same depth, used as buffer
+		 * @return the common ancestor (its predecessors are not marked) or none if the tracebacks do not merge
+		 */
+		u32 markCommonAncestor(std::vector<u32>& nodes);
+		/* release all unmarked nodes and reset the marks */
+		void sweep();
+		/* release all nodes (memory is kept for the next sequence) */
+		void reset();
 	};
 
 	/* a key for the hash map */
@@ -65,42 +105,89 @@ private:
 		u32 context;
 		u32 state;
 		u32 length;
+		HypothesisKey() : context(0), state(0), length(0) {}
 		HypothesisKey(u32 _context, u32 _state, u32 _length);
 		bool operator==(const HypothesisKey& k) const;
 		static u32 hash(const HypothesisKey& k);
+		/* hash function for the hash map, direct addressing of (context, state) pairs if nStates > 0 */
+		class Hash {
+		public:
+			u32 nStates;
+			Hash(u32 _nStates = 0) : nStates(_nStates) {}
+			u32 operator()(const HypothesisKey& k) const;
+		};
 	};
 
 	/* a node in the list */
 	class HypothesisNode {
 	public:
 		Float score;
-		TracebackNode* traceback;
-		HypothesisNode(u32 state);
-		~HypothesisNode();
-		void update(Float score, TracebackNode* predecessorTraceback, bool isActionBoundary = false);
+		u32 traceback;
+		HypothesisNode();
+		HypothesisNode(u32 _traceback);
 	};
 
-	/* the list */
+	/*
+	 * the list
+	 * if the length is disregarded and the number of (context, state) pairs is small enough, the hash map directly
+	 * addresses the hypotheses by context and state, i.e. it acts as a dense table
+	 */
 	class HypothesisList {
 	private:
 		static const Core::ParameterFloat paramPruningThreshold_;
 		static const Core::ParameterInt paramMaxHypotheses_;
+		static const Core::ParameterInt paramMaxDenseTableSize_;
+		static const Core::ParameterBool paramHistogramPruning_;
+		static const Core::ParameterInt paramNumberOfHistogramBins_;
+		typedef Core::FlatHashMap< HypothesisKey, HypothesisNode, HypothesisKey::Hash > HashMap;
 	public:
-		typedef Core::HashMap< HypothesisKey, HypothesisNode >::Entry Hypothesis;
+		typedef HashMap::Entry Hypothesis;
+		typedef HashMap::iterator iterator;
 	private:
-		Core::HashMap< HypothesisKey, HypothesisNode > hashmap_;
+		HashMap hashmap_;
+		TracebackArena& arena_;
 		Float pruningThreshold_;
 		u32 maxHypotheses_;
+		u32 maxDenseTableSize_;
+		bool histogramPruning_;
+		u32 nHistogramBins_;
+		bool isDense_;
+		// buffers for pruning, one entry per hypothesis length
+		std::vector<Float> bestScores_;
+		std::vector<Float> worstScores_;
+		std::vector<u32> nHypothesesPerLength_;
+		std::vector<u32> histogramOffsets_;
+		std::vector< std::vector<Hypothesis*> > bins_;
+		std::vector<u32> histogram_;
+		std::vector<u32> cutoffs_;
 		static bool compare(Hypothesis* a, Hypothesis* b);
 		void remove(const HypothesisKey& key);
+		u32 lengthIndex(const Hypothesis& h) const { return (HypothesisKey::disregardLength ? 0 : h.key.length - 1); }
+		u32 histogramBin(const Hypothesis& h, Float bestScore) const;
+		void selectionPruning(Float bestScore);
+		void histogramPruning(Float bestScore);
 	public:
-		HypothesisList();
+		HypothesisList(TracebackArena& arena);
+		/*
+		 * select the addressing of the hypotheses of the next sequence, list must be empty
+		 * @param nContexts number of grammar contexts
+		 * @param nStates number of hmm states
+		 */
+		void initialize(u32 nContexts, u32 nStates);
+		bool isDense() const { return isDense_; }
 		u32 nHypotheses() const { return hashmap_.size(); }
-		void update(const HypothesisKey& key, Float score, TracebackNode* predecessorTraceback, bool isActionBoundary = false);
+		void update(const HypothesisKey& key, Float score, u32 predecessorTraceback, bool isActionBoundary = false);
 		void clear();
-		Hypothesis* begin() { return hashmap_.begin(); }
-		Hypothesis* end() { return hashmap_.end(); }
-		void prune(u32 maxLength);
+		void swap(HypothesisList& hyp);
+		/* mark the tracebacks of all hypotheses in the arena */
+		void markTracebacks();
+		iterator begin() { return hashmap_.begin(); }
+		iterator end() { return hashmap_.end(); }
+		/*
+		 * remove all hypotheses whose score is worse than the best score minus the pruning threshold and
+		 * keep at most max-hypotheses hypotheses per length (exact selection or, if histogram pruning is used, approximately)
+		 */
+		void prune();
 	};
 
 	/* the class for the actual Viterbi decoding */
@@ -109,33 +196,98 @@ private:
 	static const Core::ParameterFloat paramGrammarScale_;
 	static const Core::ParameterFloat paramLengthModelScale_;
 	static const Core::ParameterInt paramMaximalLength_;
+	static const Core::ParameterBool paramPartialTraceback_;
 	enum ViterbiOutput { hmmStates, labels };
 	typedef HypothesisList::Hypothesis Hypothesis;
+	typedef HypothesisList::iterator HypothesisIterator;
+
+	/* a grammar rule leading to a new class, resolved to its hmm start state */
+	struct GrammarTransition {
+		u32 context;
+		u32 state;
+		Float score; // scaled grammar score
+		GrammarTransition(u32 _context, u32 _state, Float _score) : context(_context), state(_state), score(_score) {}
+	};
+
+	/* the hypotheses of a frame in structure-of-arrays layout */
+	struct HypothesisBatch {
+		std::vector<u32> context;
+		std::vector<u32> state;
+		std::vector<u32> length;
+		std::vector<u32> traceback;
+		std::vector<Float> score;
+		std::vector<Float> loopScore; // score after the loop transition
+		std::vector<Float> exitScore; // score after ending the segment in the current state
+		u32 size() const { return score.size(); }
+		void resize(u32 size);
+	};
 protected:
 	ViterbiOutput outputType_;
 	Float grammarScale_;
 	Float lengthModelScale_;
 	u32 maxLength_;
+	bool partialTraceback_;
 	Grammar* grammar_;
 	Scorer* scorer_;
-	LengthModel* lengthModel_;
+	const LengthModel* lengthModel_;
+	bool ownsLengthModel_;
 	HiddenMarkovModel* hmm_;
 	std::vector<ActionSegment> segmentation_;
 	std::vector<u32> framewiseRecognition_;
 	bool isInitialized_;
+	// memory of traceback and hypotheses is kept over all sequences
+	TracebackArena tracebackArena_;
+	HypothesisList oldHyp_;
+	HypothesisList newHyp_;
+	// last traceback node that has already been written to the output (partial traceback)
+	u32 fixedNode_;
+	std::vector<u32> tracebackBuffer_;
+	SegmentListener* segmentListener_;
+	u32 nFixedSegments_; // number of segments that have already been passed to the listener
+	// precomputed hmm, length model, and grammar tables for the frame expansion
+	std::vector<Float> loopScores_;
+	std::vector<Float> forwardScores_;
+	std::vector<u8> isEndState_;
+	std::vector<Float> startLengthScores_; // scaled length model frame score of length one for each state
+	std::vector< std::vector<GrammarTransition> > grammarTransitions_;
+	bool useLengthModel_;
+	bool useSegmentScores_;
+	std::vector<Float> frameScoreBuffer_;
+	HypothesisBatch batch_;
+	// index of the best segment end for each (context, end state) pair
+	Core::FlatHashMap< HypothesisKey, u32, HypothesisKey::Hash > bestExits_;
 private:
+	void initializeTables();
+	void initializeGrammarTransitions();
+	const Float* frameScores(u32 t);
+	void gather(HypothesisList& hyp);
+	void expandGrammar(u32 i, const Float* frame, HypothesisList& newHyp);
 	void decodeFrame(u32 t, HypothesisList& oldHyp, HypothesisList& newHyp);
+	void appendFrame(const TracebackNode& node);
+	void appendTraceback(u32 index, u32 stop);
+	void notifySegmentListener(u32 nFixedSegments);
+	void collectGarbage(HypothesisList& hyp);
 	void traceback(HypothesisList& hyp, u32 sequenceLength);
 public:
 	ViterbiDecoding();
 	virtual ~ViterbiDecoding();
-	void initialize();
+	/*
+	 * @param usePrecomputedScores if true, decode/realign expect the frame scores of the sequence instead of the sequence itself
+	 * @param sharedLengthModel if given, the (already initialized) length model of another decoder is used read-only
+	 */
+	void initialize(bool usePrecomputedScores = false, const LengthModel* sharedLengthModel = 0);
 	void sanityCheck();
 	Float decode(const Math::Matrix<Float>& sequence);
 	Float realign(const Math::Matrix<Float>& sequence, const std::vector<u32>& labelSequence);
 	const std::vector<ActionSegment>& segmentation() const { return segmentation_; }
 	const std::vector<u32>& framewiseRecognition() const { return framewiseRecognition_; }
+	/* the listener is not owned by the decoder, 0 disables it */
+	void setSegmentListener(SegmentListener* listener) { segmentListener_ = listener; }
 	u32 nOutputClasses() const;
+	Scorer& scorer() { require(isInitialized_); return *scorer_; }
+	/* replace the loop probabilities of the hmm states (see HiddenMarkovModel::setLoopProbabilities) */
+	void setLoopProbabilities(const Math::Vector<Float>& loopProbabilities);
+	const LengthModel& lengthModel() const { require(isInitialized_); return *lengthModel_; }
 };
 
 } // namespace
@@ -83,6 +83,7 @@ protected:
 	using Precursor::nColumns_;
 	using Precursor::nRows_;
 	using Precursor::nAllocatedCells_;
+	using Precursor::ownsMemory_;
 	using Precursor::elem_;
 	using CudaDataStructure::cublasHandle;
 	using CudaDataStructure::gpuMode_;
@@ -128,6 +129,19 @@ public:
 	// -> no new memory allocation, old content remains valid
 	void safeResize(u32 nRows, u32 nColumns);
 
+	// let the matrix be a view on nRows * nColumns elements of buffer, starting at offset (host and device memory)
+	// any subsequent reallocation (e.g. resize) makes the matrix own its memory again
+	void useExternalMemory(CudaVector<T> &buffer, u32 offset, u32 nRows, u32 nColumns);
+
+	// CPU only: let the matrix be a view on nRows * nColumns elements of host memory
+	void useExternalMemory(T* data, u32 nRows, u32 nColumns);
+
+	// copy the (host) content of the matrix to buffer, starting at offset, and let the matrix be a view on it
+	void moveToExternalMemory(CudaVector<T> &buffer, u32 offset);
+
+	// returns false if the matrix is a view on external memory
+	bool ownsMemory() const { return Precursor::ownsMemory(); }
+
 	virtual void reshape(u32 nRows, u32 nColumns);
 
 	void setVisibleColumns(u32 nColumns) { safeResize(nRows_, nColumns); }
@@ -359,6 +373,14 @@ public:
 	// this = this .* (1 - X .^ 2)
 	void elementwiseMultiplicationWithTanhDerivative(const CudaMatrix<T> &X);
 
+	// fused gated recurrent unit forward/backward steps (see Math::Matrix), only available in CPU mode
+	void gruForward(CudaMatrix<T> &updateGate, CudaMatrix<T> &resetGate, CudaMatrix<T> &candidate,
+			const CudaMatrix<T> &recurrentCandidate, const CudaMatrix<T> *previousOutput = 0);
+	void gruBackward(const CudaMatrix<T> &z, const CudaMatrix<T> &r, const CudaMatrix<T> &c,
+			const CudaMatrix<T> &recurrentCandidate, const CudaMatrix<T> *previousOutput,
+			CudaMatrix<T> &updateGateError, CudaMatrix<T> &resetGateError, CudaMatrix<T> &candidateError,
+			CudaMatrix<T> &recurrentCandidateError) const;
+
 	// for each column i: this(_,i) = (diag(softmax(_,i)) - softmax(_,i)*softmax(_,i)^T) * this(_,i)
 	void multiplicationWithSoftmaxDerivative(const CudaMatrix<T> &softmax);
 
@@ -384,6 +406,13 @@ public:
 	// return the value of the cross entropy objective function; each column of *this is interpreted as a probability distribution
 	T crossEntropyObjectiveFunction(const CudaMatrix<T>& targets) const;
 
+	// same as above, but the targets are given as class indices (one label per column)
+	u32 nClassificationErrors(const CudaVector<u32>& labels) const;
+	T crossEntropyObjectiveFunction(const CudaVector<u32>& labels) const;
+
+	// this(labels(i), i) += alpha for each column i (e.g. subtract the one-hot targets from the softmax output)
+	void addKroneckerDelta(const CudaVector<u32>& labels, T alpha);
+
 	// return the value of the weighted cross entropy objective function; each column of *this is interpreted as a probability distribution
 	T weightedCrossEntropyObjectiveFunction(const CudaMatrix<T>& targets, const CudaVector<T>& weights) const;
 
@@ -547,32 +576,27 @@ CudaMatrix<T>::CudaMatrix(const CudaMatrix<T> &X) :
 
 template<typename T>
 bool CudaMatrix<T>::allocateGpuMemory(){
-	int result = 0;
 	if (gpuMode_) {
 		if (d_elem_) {
-			result = Cuda::free(d_elem_);
-			require_eq(result, 0);
+			MemoryPool::devicePool().release(d_elem_);
 			d_elem_ = 0;
 		}
-		if (nRows_ * nColumns_ > 0) {
-			result = Cuda::alloc(d_elem_, nRows_ * nColumns_);
-			require_eq(result, 0);
-		}
+		// the device block has the same number of cells as the host block
+		if (nRows_ * nColumns_ > 0)
+			d_elem_ = MemoryPool::devicePool().allocate<T>(nAllocatedCells_);
 		if ((d_elem_ == 0) && (nRows_ * nColumns_ > 0)) {
 			std::cerr << "GPU: Failed to allocate memory." << std::endl;
 			exit(1);
 		}
 	}
-	return result == 0;
+	return true;
 }
 
 
 template<typename T>
 CudaMatrix<T>::~CudaMatrix(){
-	int result = 0;
-	if (gpuMode_){
-		result = Cuda::free(d_elem_);
-		require_eq(result, 0);
+	if (gpuMode_ && ownsMemory_){
+		MemoryPool::devicePool().release(d_elem_);
 	}
 }
 
@@ -612,6 +636,11 @@ void CudaMatrix<T>::resize(u32 nRows, u32 nCols, bool reallocate) {
 	// only reallocate memory if the size increased
 	// (memory allocations slow down GPU computations if done too often... for whatever reason...)
 	reallocate |= nRows * nCols > nAllocatedCells_;
+	// a view on external memory is detached, its device memory must not be freed
+	if (!ownsMemory_) {
+		reallocate = true;
+		d_elem_ = 0;
+	}
 	Precursor::resize(nRows, nCols);
 	if (reallocate){
 		allocateGpuMemory();
@@ -621,7 +650,38 @@ void CudaMatrix<T>::resize(u32 nRows, u32 nCols, bool reallocate) {
 template<typename T>
 void CudaMatrix<T>::safeResize(u32 nRows, u32 nColumns) {
 	require_le(nRows * nColumns, nAllocatedCells_);
-	resize(nRows, nColumns, false);
+	if (ownsMemory_)
+		resize(nRows, nColumns, false);
+	else // keep pointing to the external memory
+		Precursor::safeResize(nRows, nColumns);
+}
+
+template<typename T>
+void CudaMatrix<T>::useExternalMemory(CudaVector<T> &buffer, u32 offset, u32 nRows, u32 nColumns) {
+	require(!isComputing_);
+	require_eq(buffer.gpuMode_, gpuMode_);
+	require_le((u64)offset + (u64)nRows * nColumns, (u64)buffer.nRows_);
+	if (gpuMode_ && d_elem_ && ownsMemory_)
+		MemoryPool::devicePool().release(d_elem_);
+	d_elem_ = (gpuMode_ ? buffer.d_elem_ + offset : 0);
+	Precursor::useExternalMemory(buffer.elem_ + offset, nRows, nColumns);
+}
+
+template<typename T>
+void CudaMatrix<T>::useExternalMemory(T* data, u32 nRows, u32 nColumns) {
+	require(!isComputing_);
+	require(!gpuMode_);
+	Precursor::useExternalMemory(data, nRows, nColumns);
+}
+
+template<typename T>
+void CudaMatrix<T>::moveToExternalMemory(CudaVector<T> &buffer, u32 offset) {
+	require(!isComputing_);
+	require(!buffer.isComputing_);
+	require_le((u64)offset + (u64)nRows_ * nColumns_, (u64)buffer.nRows_);
+	if (nRows_ * nColumns_ > 0)
+		std::copy(elem_, elem_ + nRows_ * nColumns_, buffer.elem_ + offset);
+	useExternalMemory(buffer, offset, nRows_, nColumns_);
 }
 template<typename T>
 void CudaMatrix<T>::reshape(u32 nRows, u32 nColumns) {
@@ -1116,10 +1176,10 @@ T CudaMatrix<T>::sum() const {
 	if (gpuMode_) {
 		T result = 0;
 		T *resultDev;
-		Cuda::alloc(resultDev, 1);
+		resultDev = MemoryPool::devicePool().allocate<T>(1);
 		Cuda::sum(d_elem_, nRows_, nColumns_, resultDev);
 		Cuda::copyFromGpu(&result, resultDev, 1);
-		Cuda::free(resultDev);
+		MemoryPool::devicePool().release(resultDev);
 		return result;
 	} else {
 		return Precursor::sum();
@@ -1418,6 +1478,41 @@ void CudaMatrix<T>::elementwiseMultiplicationWithTanhDerivative(const CudaMatrix
 		Precursor::elementwiseMultiplicationWithTanhDerivative(X);
 }
 
+template<typename T>
+void CudaMatrix<T>::gruForward(CudaMatrix<T> &updateGate, CudaMatrix<T> &resetGate, CudaMatrix<T> &candidate,
+		const CudaMatrix<T> &recurrentCandidate, const CudaMatrix<T> *previousOutput) {
+	require(isComputing_);
+	require(updateGate.isComputing_);
+	require(resetGate.isComputing_);
+	require(candidate.isComputing_);
+	require(recurrentCandidate.isComputing_);
+	require(!previousOutput || previousOutput->isComputing_);
+	// no fused kernel on the GPU, use the composition of the single operations instead
+	require(!gpuMode_);
+	Precursor::gruForward(updateGate, resetGate, candidate, recurrentCandidate, previousOutput);
+}
+
+template<typename T>
+void CudaMatrix<T>::gruBackward(const CudaMatrix<T> &z, const CudaMatrix<T> &r, const CudaMatrix<T> &c,
+		const CudaMatrix<T> &recurrentCandidate, const CudaMatrix<T> *previousOutput,
+		CudaMatrix<T> &updateGateError, CudaMatrix<T> &resetGateError, CudaMatrix<T> &candidateError,
+		CudaMatrix<T> &recurrentCandidateError) const {
+	require(isComputing_);
+	require(z.isComputing_);
+	require(r.isComputing_);
+	require(c.isComputing_);
+	require(recurrentCandidate.isComputing_);
+	require(!previousOutput || previousOutput->isComputing_);
+	require(updateGateError.isComputing_);
+	require(resetGateError.isComputing_);
+	require(candidateError.isComputing_);
+	require(recurrentCandidateError.isComputing_);
+	// no fused kernel on the GPU, use the composition of the single operations instead
+	require(!gpuMode_);
+	Precursor::gruBackward(z, r, c, recurrentCandidate, previousOutput,
+			updateGateError, resetGateError, candidateError, recurrentCandidateError);
+}
+
 template<typename T>
 void CudaMatrix<T>::multiplicationWithSoftmaxDerivative(const Math::CudaMatrix<T>& softmax) {
 	require(isComputing_);
@@ -1511,10 +1606,10 @@ u32 CudaMatrix<T>::nClassificationErrors(const CudaMatrix<T>& targets) const {
 	if (gpuMode_) {
 		unsigned int result = 0u;
 		unsigned int *resultDev;
-		Cuda::alloc(resultDev, 1);
+		resultDev = MemoryPool::devicePool().allocate<unsigned int>(1);
 		Cuda::nClassificationErrors(d_elem_, nRows_, nColumns_, targets.d_elem_, resultDev);
 		Cuda::copyFromGpu(&result, resultDev, 1);
-		Cuda::free(resultDev);
+		MemoryPool::devicePool().release(resultDev);
 		return result;
 	} else {
 		return Precursor::nClassificationErrors(targets);
@@ -1530,16 +1625,64 @@ T CudaMatrix<T>::crossEntropyObjectiveFunction(const CudaMatrix<T>& targets) con
 	if (gpuMode_) {
 		T result = 0;
 		T *resultDev;
-		Cuda::alloc(resultDev, nColumns_);
+		resultDev = MemoryPool::devicePool().allocate<T>(nColumns_);
 		Cuda::crossEntropyObjectiveFunction(d_elem_, nRows_, nColumns_, targets.d_elem_, resultDev);
 		Cuda::asum(cublasHandle, nColumns_, resultDev, 1, &result);
-		Cuda::free(resultDev);
+		MemoryPool::devicePool().release(resultDev);
 		return result;
 	} else {
 		return Precursor::crossEntropyObjectiveFunction(targets);
 	}
 }
 
+template<typename T>
+u32 CudaMatrix<T>::nClassificationErrors(const CudaVector<u32>& labels) const {
+	require(isComputing_);
+	require(labels.isComputing());
+	require_eq(nColumns_, labels.nRows());
+	if (gpuMode_) {
+		unsigned int result = 0u;
+		unsigned int *resultDev;
+		resultDev = MemoryPool::devicePool().allocate<unsigned int>(1);
+		Cuda::nClassificationErrors(d_elem_, nRows_, nColumns_, labels.d_elem_, resultDev);
+		Cuda::copyFromGpu(&result, resultDev, 1);
+		MemoryPool::devicePool().release(resultDev);
+		return result;
+	} else {
+		return Precursor::nClassificationErrors(labels);
+	}
+}
+
+template<typename T>
+T CudaMatrix<T>::crossEntropyObjectiveFunction(const CudaVector<u32>& labels) const {
+	require(isComputing_);
+	require(labels.isComputing());
+	require_eq(nColumns_, labels.nRows());
+	if (gpuMode_) {
+		T result = 0;
+		T *resultDev;
+		resultDev = MemoryPool::devicePool().allocate<T>(nColumns_);
+		Cuda::crossEntropyObjectiveFunction(d_elem_, nRows_, nColumns_, labels.d_elem_, resultDev);
+		Cuda::asum(cublasHandle, nColumns_, resultDev, 1, &result);
+		MemoryPool::devicePool().release(resultDev);
+		return result;
+	} else {
+		return Precursor::crossEntropyObjectiveFunction(labels);
+	}
+}
+
+template<typename T>
+void CudaMatrix<T>::addKroneckerDelta(const CudaVector<u32>& labels, T alpha) {
+	require(isComputing_);
+	require(labels.isComputing());
+	require_eq(nColumns_, labels.nRows());
+	if (gpuMode_) {
+		Cuda::addKroneckerDelta(d_elem_, nRows_, nColumns_, labels.d_elem_, alpha);
+	} else {
+		Precursor::addKroneckerDelta(labels, alpha);
+	}
+}
+
 template<typename T>
 T CudaMatrix<T>::weightedCrossEntropyObjectiveFunction(const CudaMatrix<T>& targets, const CudaVector<T>& weights) const {
 	require(isComputing_);
@@ -1551,10 +1694,10 @@ T CudaMatrix<T>::weightedCrossEntropyObjectiveFunction(const CudaMatrix<T>& targ
 	if (gpuMode_) {
 		T result = 0;
 		T *resultDev;
-		Cuda::alloc(resultDev, nColumns_);
+		resultDev = MemoryPool::devicePool().allocate<T>(nColumns_);
 		Cuda::weightedCrossEntropyObjectiveFunction(d_elem_, nRows_, nColumns_, targets.d_elem_, resultDev, weights.d_elem_);
 		Cuda::asum(cublasHandle, nColumns_, resultDev, 1, &result);
-		Cuda::free(resultDev);
+		MemoryPool::devicePool().release(resultDev);
 		return result;
 	} else {
 		return Precursor::weightedCrossEntropyObjectiveFunction(targets, weights);
@@ -1570,10 +1713,10 @@ T CudaMatrix<T>::squaredErrorObjectiveFunction(const CudaMatrix<T>& targets) con
 	if (gpuMode_) {
 		T result = 0;
 		T *resultDev;
-		Cuda::alloc(resultDev, nColumns_);
+		resultDev = MemoryPool::devicePool().allocate<T>(nColumns_);
 		Cuda::squaredErrorObjectiveFunction(d_elem_, nRows_, nColumns_, targets.d_elem_, resultDev);
 		Cuda::asum(cublasHandle, nColumns_, resultDev, 1, &result);
-		Cuda::free(resultDev);
+		MemoryPool::devicePool().release(resultDev);
 		return result;
 	} else {
 		return Precursor::squaredErrorObjectiveFunction(targets);
@@ -1591,10 +1734,10 @@ T CudaMatrix<T>::weightedSquaredErrorObjectiveFunction(const CudaMatrix<T>& targ
 	if (gpuMode_) {
 		T result = 0;
 		T *resultDev;
-		Cuda::alloc(resultDev, nColumns_);
+		resultDev = MemoryPool::devicePool().allocate<T>(nColumns_);
 		Cuda::weightedSquaredErrorObjectiveFunction(d_elem_, nRows_, nColumns_, targets.d_elem_, resultDev, weights.d_elem_);
 		Cuda::asum(cublasHandle, nColumns_, resultDev, 1, &result);
-		Cuda::free(resultDev);
+		MemoryPool::devicePool().release(resultDev);
 		return result;
 	} else {
 		return Precursor::weightedSquaredErrorObjectiveFunction(targets, weights);
@@ -1610,10 +1753,10 @@ T CudaMatrix<T>::smoothedL1ObjectiveFunction(const CudaMatrix<T>& targets) const
 	if (gpuMode_) {
 		T result = 0;
 		T *resultDev;
-		Cuda::alloc(resultDev, nColumns_);
+		resultDev = MemoryPool::devicePool().allocate<T>(nColumns_);
 		Cuda::smoothedL1ObjectiveFunction(d_elem_, nRows_, nColumns_, targets.d_elem_, resultDev);
 		Cuda::asum(cublasHandle, nColumns_, resultDev, 1, &result);
-		Cuda::free(resultDev);
+		MemoryPool::devicePool().release(resultDev);
 		return result;
 	} else {
 		return Precursor::smoothedL1ObjectiveFunction(targets);
@@ -1631,10 +1774,10 @@ T CudaMatrix<T>::weightedSmoothedL1ObjectiveFunction(const CudaMatrix<T>& target
 	if (gpuMode_) {
 		T result = 0;
 		T *resultDev;
-		Cuda::alloc(resultDev, nColumns_);
+		resultDev = MemoryPool::devicePool().allocate<T>(nColumns_);
 		Cuda::weightedSmoothedL1ObjectiveFunction(d_elem_, nRows_, nColumns_, targets.d_elem_, weights.d_elem_, resultDev);
 		Cuda::asum(cublasHandle, nColumns_, resultDev, 1, &result);
-		Cuda::free(resultDev);
+		MemoryPool::devicePool().release(resultDev);
 		return result;
 	} else {
 		return Precursor::weightedSmoothedL1ObjectiveFunction(targets, weights);
@@ -1772,12 +1915,11 @@ void CudaMatrix<T>::dropout(const T dropoutProbability) {
 	if (gpuMode_) {
 		int result;
 		T* mask;
-		result = Cuda::alloc(mask, nColumns_ * nRows_);
-		require_eq(result, 0);
+		mask = MemoryPool::devicePool().allocate<T>(nColumns_ * nRows_);
 		result = Cuda::generateUniform(randomNumberGenerator, mask, nColumns_ * nRows_);
 		require_eq(result, 0);
 		Cuda::dropout(d_elem_, mask, nRows_, nColumns_, dropoutProbability);
-		Cuda::free(mask);
+		MemoryPool::devicePool().release(mask);
 	}
 	else {
 		Precursor::dropout(dropoutProbability);
@@ -1790,13 +1932,12 @@ void CudaMatrix<T>::addGaussianNoise(const T standardDeviation) {
 	if (gpuMode_) {
 		int result;
 		T* mask;
-		result = Cuda::alloc(mask, nColumns_ * nRows_);
-		require_eq(result, 0);
+		mask = MemoryPool::devicePool().allocate<T>(nColumns_ * nRows_);
 		result = Cuda::generateNormal(randomNumberGenerator, mask, nColumns_ * nRows_, (T) 0.0, standardDeviation);
 		require_eq(result, 0);
 		result = Cuda::axpy(cublasHandle, nColumns_ * nRows_, (T) 1.0, mask, 1, d_elem_, 1);
 		require_eq(result, 0);
-		Cuda::free(mask);
+		MemoryPool::devicePool().release(mask);
 	}
 	else {
 		std::cerr << "Gaussian noise not yet implemented for CPU." << std::endl;
@@ -2241,7 +2382,8 @@ std::string CudaMatrix<T>::toString(bool transpose) {
 template<typename T>
 void CudaMatrix<T>::clear() {
 	if (gpuMode_ && d_elem_) {
-		Cuda::free(d_elem_);
+		if (ownsMemory_)
+			MemoryPool::devicePool().release(d_elem_);
 		d_elem_ = 0;
 	}
 	Precursor::clear();
@@ -989,6 +989,114 @@ template void _cuda_rpropUpdate<double>(double *currentValues, double *newGradie
 template void _cuda_rpropUpdate<float>(float *currentValues, float *newGradients, float *oldGradients, float *updateValues, float increasingFactor, float decreasingFactor, float maxUpdateValue, float minUpdateValue, unsigned int nRows, unsigned int nColumns);
 
 
+/*
+ *
+ * fused optimizer updates
+ *
+ */
+template<typename T>
+__device__ T _cuda_optimizerGradient(T gradient, T parameter, T weightDecay, T clipping){
+	T g = gradient + weightDecay * parameter;
+	if (clipping > 0)
+		g = fmin(fmax(g, -clipping), clipping);
+	return g;
+}
+
+template<typename T>
+__global__ void __cuda_momentumUpdate(T *parameters, const T *gradient, T *momentum, T learningRate, T momentumFactor,
+		T weightDecay, T clipping, unsigned int nElements){
+    unsigned  int index = threadIdx.x + blockIdx.x * blockDim.x;
+    if (index < nElements) {
+	T g = _cuda_optimizerGradient(gradient[index], parameters[index], weightDecay, clipping);
+	T m = momentumFactor * momentum[index] - learningRate * g;
+	momentum[index] = m;
+	parameters[index] += m;
+    }
+}
+
+template<typename T>
+void _cuda_momentumUpdate(T *parameters, const T *gradient, T *momentum, T learningRate, T momentumFactor,
+		T weightDecay, T clipping, unsigned int nElements)
+{
+    int gridSize = (int)ceil( (float) nElements/THREADS_PER_BLOCK);
+    __cuda_momentumUpdate <<< gridSize , THREADS_PER_BLOCK >>> (parameters, gradient, momentum, learningRate, momentumFactor, weightDecay, clipping, nElements);
+}
+
+template void _cuda_momentumUpdate<double>(double *parameters, const double *gradient, double *momentum, double learningRate, double momentumFactor, double weightDecay, double clipping, unsigned int nElements);
+template void _cuda_momentumUpdate<float>(float *parameters, const float *gradient, float *momentum, float learningRate, float momentumFactor, float weightDecay, float clipping, unsigned int nElements);
+
+template<typename T>
+__global__ void __cuda_adamUpdate(T *parameters, const T *gradient, T *firstMoment, T *secondMoment, T learningRate,
+		T beta1, T beta2, T epsilon, T biasCorrection1, T biasCorrection2, T weightDecay, T clipping, unsigned int nElements){
+    unsigned  int index = threadIdx.x + blockIdx.x * blockDim.x;
+    if (index < nElements) {
+	T g = _cuda_optimizerGradient(gradient[index], parameters[index], weightDecay, clipping);
+	T m = beta1 * firstMoment[index] + (1 - beta1) * g;
+	T v = beta2 * secondMoment[index] + (1 - beta2) * g * g;
+	firstMoment[index] = m;
+	secondMoment[index] = v;
+	parameters[index] -= learningRate * (m / biasCorrection1) / (sqrt(v / biasCorrection2) + epsilon);
+    }
+}
+
+template<typename T>
+void _cuda_adamUpdate(T *parameters, const T *gradient, T *firstMoment, T *secondMoment, T learningRate,
+		T beta1, T beta2, T epsilon, T biasCorrection1, T biasCorrection2, T weightDecay, T clipping, unsigned int nElements)
+{
+    int gridSize = (int)ceil( (float) nElements/THREADS_PER_BLOCK);
+    __cuda_adamUpdate <<< gridSize , THREADS_PER_BLOCK >>> (parameters, gradient, firstMoment, secondMoment, learningRate,
+		beta1, beta2, epsilon, biasCorrection1, biasCorrection2, weightDecay, clipping, nElements);
+}
+
+template void _cuda_adamUpdate<double>(double *parameters, const double *gradient, double *firstMoment, double *secondMoment, double learningRate, double beta1, double beta2, double epsilon, double biasCorrection1, double biasCorrection2, double weightDecay, double clipping, unsigned int nElements);
+template void _cuda_adamUpdate<float>(float *parameters, const float *gradient, float *firstMoment, float *secondMoment, float learningRate, float beta1, float beta2, float epsilon, float biasCorrection1, float biasCorrection2, float weightDecay, float clipping, unsigned int nElements);
+
+template<typename T>
+__global__ void __cuda_rmspropUpdate(T *parameters, const T *gradient, T *meanSquare, T learningRate, T decay, T epsilon,
+		T weightDecay, T clipping, unsigned int nElements){
+    unsigned  int index = threadIdx.x + blockIdx.x * blockDim.x;
+    if (index < nElements) {
+	T g = _cuda_optimizerGradient(gradient[index], parameters[index], weightDecay, clipping);
+	T v = decay * meanSquare[index] + (1 - decay) * g * g;
+	meanSquare[index] = v;
+	parameters[index] -= learningRate * g / (sqrt(v) + epsilon);
+    }
+}
+
+template<typename T>
+void _cuda_rmspropUpdate(T *parameters, const T *gradient, T *meanSquare, T learningRate, T decay, T epsilon,
+		T weightDecay, T clipping, unsigned int nElements)
+{
+    int gridSize = (int)ceil( (float) nElements/THREADS_PER_BLOCK);
+    __cuda_rmspropUpdate <<< gridSize , THREADS_PER_BLOCK >>> (parameters, gradient, meanSquare, learningRate, decay, epsilon, weightDecay, clipping, nElements);
+}
+
+template void _cuda_rmspropUpdate<double>(double *parameters, const double *gradient, double *meanSquare, double learningRate, double decay, double epsilon, double weightDecay, double clipping, unsigned int nElements);
+template void _cuda_rmspropUpdate<float>(float *parameters, const float *gradient, float *meanSquare, float learningRate, float decay, float epsilon, float weightDecay, float clipping, unsigned int nElements);
+
+template<typename T>
+__global__ void __cuda_adagradUpdate(T *parameters, const T *gradient, T *sumSquare, T learningRate, T epsilon,
+		T weightDecay, T clipping, unsigned int nElements){
+    unsigned  int index = threadIdx.x + blockIdx.x * blockDim.x;
+    if (index < nElements) {
+	T g = _cuda_optimizerGradient(gradient[index], parameters[index], weightDecay, clipping);
+	T v = sumSquare[index] + g * g;
+	sumSquare[index] = v;
+	parameters[index] -= learningRate * g / (sqrt(v) + epsilon);
+    }
+}
+
+template<typename T>
+void _cuda_adagradUpdate(T *parameters, const T *gradient, T *sumSquare, T learningRate, T epsilon,
+		T weightDecay, T clipping, unsigned int nElements)
+{
+    int gridSize = (int)ceil( (float) nElements/THREADS_PER_BLOCK);
+    __cuda_adagradUpdate <<< gridSize , THREADS_PER_BLOCK >>> (parameters, gradient, sumSquare, learningRate, epsilon, weightDecay, clipping, nElements);
+}
+
+template void _cuda_adagradUpdate<double>(double *parameters, const double *gradient, double *sumSquare, double learningRate, double epsilon, double weightDecay, double clipping, unsigned int nElements);
+template void _cuda_adagradUpdate<float>(float *parameters, const float *gradient, float *sumSquare, float learningRate, float epsilon, float weightDecay, float clipping, unsigned int nElements);
+
 /*
  *
  * add constant elementwise
@@ -2461,6 +2569,88 @@ template void _cuda_crossEntropyObjectiveFunction<double>(double *matrixPtr, uns
 template __global__ void __cuda_crossEntropyObjectiveFunction<float>(float *matrixPtr, unsigned int nRows, unsigned int nColumns, float *targets, float *objFctn);
 template void _cuda_crossEntropyObjectiveFunction<float>(float *matrixPtr, unsigned int nRows, unsigned int nColumns, float *targets, float *objFctn);
 
+/*
+ *
+ * nClassificationErrors, crossEntropyObjectiveFunction, addKroneckerDelta with class indices as targets
+ *
+ */
+template<typename T>
+__global__ void __cuda_nClassificationErrors(T *matrixPtr, unsigned int nRows, unsigned int nColumns, unsigned int *labels, unsigned int *resultDevPtr){
+    unsigned  int column= threadIdx.x + blockIdx.x * blockDim.x;
+    if (column < nColumns){
+	int beginCol = column * nRows;
+	T maxVal = matrixPtr[beginCol];
+	uint argmax = 0;
+	for (int i = 1; i < nRows; i++){
+	    T val = matrixPtr[beginCol + i];
+	    if (val > maxVal){
+		maxVal =  val;
+		argmax = i;
+	    }
+	}
+	if (argmax != labels[column]){
+	    atomicAdd(resultDevPtr, 1);
+	}
+    }
+}
+
+template<typename T>
+void _cuda_nClassificationErrors(T *matrixPtr, unsigned int nRows, unsigned int nColumns, unsigned int *labels, unsigned int *resultDevPtr)
+{
+    // parallelization over columns only
+    int gridSize = (int)ceil( (float) nColumns/THREADS_PER_BLOCK);
+    unsigned int result = 0;
+    cudaMemcpy(resultDevPtr, &result, sizeof(unsigned int), cudaMemcpyHostToDevice);
+    __cuda_nClassificationErrors <<< gridSize, THREADS_PER_BLOCK>>> (matrixPtr, nRows, nColumns, labels, resultDevPtr);
+}
+
+template __global__ void __cuda_nClassificationErrors<double>(double *matrixPtr, unsigned int nRows, unsigned int nColumns, unsigned int *labels, unsigned int *resultDevPtr);
+template void _cuda_nClassificationErrors<double>(double *matrixPtr, unsigned int nRows, unsigned int nColumns, unsigned int *labels, unsigned int *resultDevPtr);
+template __global__ void __cuda_nClassificationErrors<float>(float *matrixPtr, unsigned int nRows, unsigned int nColumns, unsigned int *labels, unsigned int *resultDevPtr);
+template void _cuda_nClassificationErrors<float>(float *matrixPtr, unsigned int nRows, unsigned int nColumns, unsigned int *labels, unsigned int *resultDevPtr);
+
+template<typename T>
+__global__ void __cuda_crossEntropyObjectiveFunction(T *matrixPtr, unsigned int nRows, unsigned int nColumns, unsigned int *labels, T *objFctn){
+    unsigned  int column= threadIdx.x + blockIdx.x * blockDim.x;
+    if (column < nColumns){
+	objFctn[column] = -log(matrixPtr[nRows * column + labels[column]]);
+    }
+}
+
+template<typename T>
+void _cuda_crossEntropyObjectiveFunction(T *matrixPtr, unsigned int nRows, unsigned int nColumns, unsigned int *labels, T *objFctn)
+{
+    // parallelization over columns only
+    int gridSize = (int)ceil( (float) nColumns/THREADS_PER_BLOCK);
+    __cuda_crossEntropyObjectiveFunction <<< gridSize , THREADS_PER_BLOCK >>> (matrixPtr, nRows, nColumns, labels, objFctn);
+}
+
+template __global__ void __cuda_crossEntropyObjectiveFunction<double>(double *matrixPtr, unsigned int nRows, unsigned int nColumns, unsigned int *labels, double *objFctn);
+template void _cuda_crossEntropyObjectiveFunction<double>(double *matrixPtr, unsigned int nRows, unsigned int nColumns, unsigned int *labels, double *objFctn);
+template __global__ void __cuda_crossEntropyObjectiveFunction<float>(float *matrixPtr, unsigned int nRows, unsigned int nColumns, unsigned int *labels, float *objFctn);
+template void _cuda_crossEntropyObjectiveFunction<float>(float *matrixPtr, unsigned int nRows, unsigned int nColumns, unsigned int *labels, float *objFctn);
+
+template<typename T>
+__global__ void __cuda_addKroneckerDelta(T *matrixPtr, unsigned int nRows, unsigned int nColumns, unsigned int *labels, T alpha){
+    unsigned  int column= threadIdx.x + blockIdx.x * blockDim.x;
+    if (column < nColumns){
+	matrixPtr[nRows * column + labels[column]] += alpha;
+    }
+}
+
+template<typename T>
+void _cuda_addKroneckerDelta(T *matrixPtr, unsigned int nRows, unsigned int nColumns, unsigned int *labels, T alpha)
+{
+    // parallelization over columns only
+    int gridSize = (int)ceil( (float) nColumns/THREADS_PER_BLOCK);
+    __cuda_addKroneckerDelta <<< gridSize , THREADS_PER_BLOCK >>> (matrixPtr, nRows, nColumns, labels, alpha);
+}
+
+template __global__ void __cuda_addKroneckerDelta<double>(double *matrixPtr, unsigned int nRows, unsigned int nColumns, unsigned int *labels, double alpha);
+template void _cuda_addKroneckerDelta<double>(double *matrixPtr, unsigned int nRows, unsigned int nColumns, unsigned int *labels, double alpha);
+template __global__ void __cuda_addKroneckerDelta<float>(float *matrixPtr, unsigned int nRows, unsigned int nColumns, unsigned int *labels, float alpha);
+template void _cuda_addKroneckerDelta<float>(float *matrixPtr, unsigned int nRows, unsigned int nColumns, unsigned int *labels, float alpha);
+
 // weightedCrossEntropyObjectiveFunction
 template<typename T>
 __global__ void __cuda_weightedCrossEntropyObjectiveFunction(T *matrixPtr, unsigned int nRows, unsigned int nColumns, T *targets, T *objFctn, T *weights){
@@ -119,6 +119,22 @@ template<typename T>
 void _cuda_rpropUpdate(T *currentValues, T *newGradients, T *oldGradients, T *updateValues, T increasingFactor, T decreasingFactor,
 		T maxUpdateValue, T minUpdateValue, unsigned int nRows, unsigned int nColumns);
 
+template<typename T>
+void _cuda_momentumUpdate(T *parameters, const T *gradient, T *momentum, T learningRate, T momentumFactor,
+		T weightDecay, T clipping, unsigned int nElements);
+
+template<typename T>
+void _cuda_adamUpdate(T *parameters, const T *gradient, T *firstMoment, T *secondMoment, T learningRate,
+		T beta1, T beta2, T epsilon, T biasCorrection1, T biasCorrection2, T weightDecay, T clipping, unsigned int nElements);
+
+template<typename T>
+void _cuda_rmspropUpdate(T *parameters, const T *gradient, T *meanSquare, T learningRate, T decay, T epsilon,
+		T weightDecay, T clipping, unsigned int nElements);
+
+template<typename T>
+void _cuda_adagradUpdate(T *parameters, const T *gradient, T *sumSquare, T learningRate, T epsilon,
+		T weightDecay, T clipping, unsigned int nElements);
+
 template<typename T>
 void _cuda_addConstantElementwise(T constant, T *data, unsigned int nRows, unsigned int nColumns);
 
@@ -240,6 +256,15 @@ void _cuda_nClassificationErrors(T *devPtr, unsigned int nRows, unsigned int nCo
 template<typename T>
 void _cuda_crossEntropyObjectiveFunction(T *matrixPtr, unsigned int nRows, unsigned int nColumns, T *targets, T *resultDev);
 
+template<typename T>
+void _cuda_nClassificationErrors(T *devPtr, unsigned int nRows, unsigned int nColumns, unsigned int *labels, unsigned int *resultDev);
+
+template<typename T>
+void _cuda_crossEntropyObjectiveFunction(T *matrixPtr, unsigned int nRows, unsigned int nColumns, unsigned int *labels, T *resultDev);
+
+template<typename T>
+void _cuda_addKroneckerDelta(T *devPtr, unsigned int nRows, unsigned int nColumns, unsigned int *labels, T alpha);
+
 template<typename T>
 void _cuda_weightedCrossEntropyObjectiveFunction(T *matrixPtr, unsigned int nRows, unsigned int nColumns, T *targets, T *resultDev, T *weights);
 
@@ -257,6 +257,36 @@ inline void rpropUpdate(T *currentValues, T *newGradients, T *oldGradients, T *u
 			maxUpdateValue, minUpdateValue, nRows, nColumns)), "rpropUpdate");
 }
 
+// fused optimizer updates
+
+template<typename T>
+inline void momentumUpdate(T *parameters, const T *gradient, T *momentum, T learningRate, T momentumFactor,
+		T weightDecay, T clipping, unsigned int nElements){
+	CUDACALL((_cuda_momentumUpdate<T>(parameters, gradient, momentum, learningRate, momentumFactor,
+			weightDecay, clipping, nElements)), "momentumUpdate");
+}
+
+template<typename T>
+inline void adamUpdate(T *parameters, const T *gradient, T *firstMoment, T *secondMoment, T learningRate,
+		T beta1, T beta2, T epsilon, T biasCorrection1, T biasCorrection2, T weightDecay, T clipping, unsigned int nElements){
+	CUDACALL((_cuda_adamUpdate<T>(parameters, gradient, firstMoment, secondMoment, learningRate,
+			beta1, beta2, epsilon, biasCorrection1, biasCorrection2, weightDecay, clipping, nElements)), "adamUpdate");
+}
+
+template<typename T>
+inline void rmspropUpdate(T *parameters, const T *gradient, T *meanSquare, T learningRate, T decay, T epsilon,
+		T weightDecay, T clipping, unsigned int nElements){
+	CUDACALL((_cuda_rmspropUpdate<T>(parameters, gradient, meanSquare, learningRate, decay, epsilon,
+			weightDecay, clipping, nElements)), "rmspropUpdate");
+}
+
+template<typename T>
+inline void adagradUpdate(T *parameters, const T *gradient, T *sumSquare, T learningRate, T epsilon,
+		T weightDecay, T clipping, unsigned int nElements){
+	CUDACALL((_cuda_adagradUpdate<T>(parameters, gradient, sumSquare, learningRate, epsilon,
+			weightDecay, clipping, nElements)), "adagradUpdate");
+}
+
 // add constant elementwise
 
 template<typename T>
@@ -535,6 +565,26 @@ inline void crossEntropyObjectiveFunction(T *matrixPtr, unsigned int nRows, unsi
 			"crossEntropyObjectiveFunction");
 }
 
+// number of classification errors and cross-entropy objective function with class indices as targets
+template<typename T>
+inline void nClassificationErrors(T *devPtr, unsigned int nRows, unsigned int nColumns, unsigned int *labels, unsigned int *resultDev) {
+	CUDACALL((_cuda_nClassificationErrors<T>(devPtr, nRows, nColumns, labels, resultDev)),
+			"nClassificationErrors");
+}
+
+template<typename T>
+inline void crossEntropyObjectiveFunction(T *matrixPtr, unsigned int nRows, unsigned int nColumns, unsigned int *labels, T *resultDev){
+	CUDACALL((_cuda_crossEntropyObjectiveFunction<T>(matrixPtr, nRows, nColumns, labels, resultDev)),
+			"crossEntropyObjectiveFunction");
+}
+
+// add alpha to the entry of each column that is given by the class index
+template<typename T>
+inline void addKroneckerDelta(T *devPtr, unsigned int nRows, unsigned int nColumns, unsigned int *labels, T alpha){
+	CUDACALL((_cuda_addKroneckerDelta<T>(devPtr, nRows, nColumns, labels, alpha)),
+			"addKroneckerDelta");
+}
+
 // weighted cross-entropy objective function
 template<typename T>
 inline void weightedCrossEntropyObjectiveFunction(T *matrixPtr, unsigned int nRows, unsigned int nColumns, T *targets, T *resultDev, T *weights){
@@ -63,6 +63,7 @@ class CudaVector : protected Vector<T>, public CudaDataStructure {
 protected:
 	using Precursor::nRows_;
 	using Precursor::nAllocatedCells_;
+	using Precursor::ownsMemory_;
 	using Precursor::elem_;
 	using CudaDataStructure::cublasHandle;
 	using CudaDataStructure::gpuMode_;
@@ -95,6 +96,16 @@ public:
 	// -> no new memory allocation, old content remains valid
 	virtual void safeResize(u32 nRows);
 
+	// let the vector be a view on nRows elements of buffer, starting at offset (host and device memory)
+	// any subsequent reallocation (e.g. resize) makes the vector own its memory again
+	void useExternalMemory(CudaVector<T> &buffer, u32 offset, u32 nRows);
+
+	// copy the (host) content of the vector to buffer, starting at offset, and let the vector be a view on it
+	void moveToExternalMemory(CudaVector<T> &buffer, u32 offset);
+
+	// returns false if the vector is a view on external memory
+	bool ownsMemory() const { return Precursor::ownsMemory(); }
+
 	void clear();
 	u32 nRows() const { return Precursor::nRows(); }
 	u32 nColumns() const { return 1; }
@@ -182,6 +193,20 @@ void ensureMinimalValue(const T threshold);
 void rpropUpdate(const CudaVector<T> &newGradients, CudaVector<T> &oldGradients, CudaVector<T> &updateValues,
 		const T increasingFactor, const T decreasingFactor, const T maxUpdateValue, const T minUpdateValue);
 
+// fused optimizer updates (see Vector.hh)
+void momentumUpdate(const CudaVector<T> &gradient, CudaVector<T> &momentum, const T learningRate, const T momentumFactor,
+		const T weightDecay = 0, const T clipping = 0);
+
+void adamUpdate(const CudaVector<T> &gradient, CudaVector<T> &firstMoment, CudaVector<T> &secondMoment, const T learningRate,
+		const T beta1, const T beta2, const T epsilon, const T biasCorrection1, const T biasCorrection2,
+		const T weightDecay = 0, const T clipping = 0);
+
+void rmspropUpdate(const CudaVector<T> &gradient, CudaVector<T> &meanSquare, const T learningRate, const T decay, const T epsilon,
+		const T weightDecay = 0, const T clipping = 0);
+
+void adagradUpdate(const CudaVector<T> &gradient, CudaVector<T> &sumSquare, const T learningRate, const T epsilon,
+		const T weightDecay = 0, const T clipping = 0);
+
 // index of minimal absolute value
 u32 argAbsMin() const;
 
@@ -280,17 +305,14 @@ CudaVector<T>::CudaVector(const CudaVector<T> &vector)
 
 template<typename T>
 bool CudaVector<T>::allocateGpuMemory(){
-	int result = 0;
 	if (gpuMode_) {
 		if (d_elem_) {
-			result = Cuda::free(d_elem_);
-			require_eq(result, 0);
+			MemoryPool::devicePool().release(d_elem_);
 			d_elem_ = 0;
 		}
-		if (nRows_ > 0) {
-			result = Cuda::alloc(d_elem_, nRows_);
-			require_eq(result, 0);
-		}
+		// the device block has the same number of cells as the host block
+		if (nRows_ > 0)
+			d_elem_ = MemoryPool::devicePool().allocate<T>(nAllocatedCells_);
 		if ((d_elem_ == 0) && (nRows_ > 0)) {
 			std::cerr << "GPU: Failed to allocate memory." << std::endl;
 			exit(1);
@@ -302,8 +324,8 @@ bool CudaVector<T>::allocateGpuMemory(){
 template<typename T>
 CudaVector<T>::~CudaVector(){
 	if (gpuMode_){
-		if (d_elem_)
-			Cuda::free(d_elem_);
+		if (d_elem_ && ownsMemory_)
+			MemoryPool::devicePool().release(d_elem_);
 	}
 }
 
@@ -312,6 +334,11 @@ void CudaVector<T>::resize(u32 newSize, bool reallocate) {
 	// only reallocate memory if the size increased
 	// (memory allocations slow down GPU computations if done too often... for whatever reason...)
 	reallocate |= newSize > nAllocatedCells_;
+	// a view on external memory is detached, its device memory must not be freed
+	if (!ownsMemory_) {
+		reallocate = true;
+		d_elem_ = 0;
+	}
 	Precursor::resize(newSize);
 	if (reallocate){
 		allocateGpuMemory();
@@ -321,13 +348,38 @@ void CudaVector<T>::resize(u32 newSize, bool reallocate) {
 template<typename T>
 void CudaVector<T>::safeResize(u32 nRows) {
 	require_le(nRows, nAllocatedCells_);
-	resize(nRows, false);
+	if (ownsMemory_)
+		resize(nRows, false);
+	else // keep pointing to the external memory
+		Precursor::safeResize(nRows);
+}
+
+template<typename T>
+void CudaVector<T>::useExternalMemory(CudaVector<T> &buffer, u32 offset, u32 nRows) {
+	require(!isComputing_);
+	require_eq(buffer.gpuMode_, gpuMode_);
+	require_le((u64)offset + nRows, (u64)buffer.nRows_);
+	if (gpuMode_ && d_elem_ && ownsMemory_)
+		MemoryPool::devicePool().release(d_elem_);
+	d_elem_ = (gpuMode_ ? buffer.d_elem_ + offset : 0);
+	Precursor::useExternalMemory(buffer.elem_ + offset, nRows);
+}
+
+template<typename T>
+void CudaVector<T>::moveToExternalMemory(CudaVector<T> &buffer, u32 offset) {
+	require(!isComputing_);
+	require(!buffer.isComputing_);
+	require_le((u64)offset + nRows_, (u64)buffer.nRows_);
+	if (nRows_ > 0)
+		std::copy(elem_, elem_ + nRows_, buffer.elem_ + offset);
+	useExternalMemory(buffer, offset, nRows_);
 }
 
 template<typename T>
 void CudaVector<T>::clear() {
 	if (gpuMode_ && d_elem_){
-		Cuda::free(d_elem_);
+		if (ownsMemory_)
+			MemoryPool::devicePool().release(d_elem_);
 		d_elem_ = 0;
 	}
 	Precursor::clear();
@@ -618,6 +670,67 @@ void CudaVector<T>::rpropUpdate(const CudaVector<T> &newGradients, CudaVector<T>
 				increasingFactor, decreasingFactor, maxUpdateValue, minUpdateValue);
 }
 
+template<typename T>
+void CudaVector<T>::momentumUpdate(const CudaVector<T> &gradient, CudaVector<T> &momentum, const T learningRate, const T momentumFactor,
+		const T weightDecay, const T clipping) {
+	require(isComputing_);
+	require(gradient.isComputing_);
+	require(momentum.isComputing_);
+	require_eq(gradient.nRows(), nRows_);
+	require_eq(momentum.nRows(), nRows_);
+	if (gpuMode_)
+		Cuda::momentumUpdate(d_elem_, gradient.d_elem_, momentum.d_elem_, learningRate, momentumFactor, weightDecay, clipping, nRows_);
+	else
+		Precursor::momentumUpdate(gradient, momentum, learningRate, momentumFactor, weightDecay, clipping);
+}
+
+template<typename T>
+void CudaVector<T>::adamUpdate(const CudaVector<T> &gradient, CudaVector<T> &firstMoment, CudaVector<T> &secondMoment, const T learningRate,
+		const T beta1, const T beta2, const T epsilon, const T biasCorrection1, const T biasCorrection2,
+		const T weightDecay, const T clipping) {
+	require(isComputing_);
+	require(gradient.isComputing_);
+	require(firstMoment.isComputing_);
+	require(secondMoment.isComputing_);
+	require_eq(gradient.nRows(), nRows_);
+	require_eq(firstMoment.nRows(), nRows_);
+	require_eq(secondMoment.nRows(), nRows_);
+	if (gpuMode_)
+		Cuda::adamUpdate(d_elem_, gradient.d_elem_, firstMoment.d_elem_, secondMoment.d_elem_, learningRate,
+				beta1, beta2, epsilon, biasCorrection1, biasCorrection2, weightDecay, clipping, nRows_);
+	else
+		Precursor::adamUpdate(gradient, firstMoment, secondMoment, learningRate,
+				beta1, beta2, epsilon, biasCorrection1, biasCorrection2, weightDecay, clipping);
+}
+
+template<typename T>
+void CudaVector<T>::rmspropUpdate(const CudaVector<T> &gradient, CudaVector<T> &meanSquare, const T learningRate, const T decay, const T epsilon,
+		const T weightDecay, const T clipping) {
+	require(isComputing_);
+	require(gradient.isComputing_);
+	require(meanSquare.isComputing_);
+	require_eq(gradient.nRows(), nRows_);
+	require_eq(meanSquare.nRows(), nRows_);
+	if (gpuMode_)
+		Cuda::rmspropUpdate(d_elem_, gradient.d_elem_, meanSquare.d_elem_, learningRate, decay, epsilon, weightDecay, clipping, nRows_);
+	else
+		Precursor::rmspropUpdate(gradient, meanSquare, learningRate, decay, epsilon, weightDecay, clipping);
+}
+
+template<typename T>
+void CudaVector<T>::adagradUpdate(const CudaVector<T> &gradient, CudaVector<T> &sumSquare, const T learningRate, const T epsilon,
+		const T weightDecay, const T clipping) {
+	require(isComputing_);
+	require(gradient.isComputing_);
+	require(sumSquare.isComputing_);
+	require_eq(gradient.nRows(), nRows_);
+	require_eq(sumSquare.nRows(), nRows_);
+	if (gpuMode_)
+		Cuda::adagradUpdate(d_elem_, gradient.d_elem_, sumSquare.d_elem_, learningRate, epsilon, weightDecay, clipping, nRows_);
+	else
+		Precursor::adagradUpdate(gradient, sumSquare, learningRate, epsilon, weightDecay, clipping);
+}
+
 template<typename T>
 u32 CudaVector<T>::argAbsMin() const {
 	require(isComputing_);
@@ -648,10 +761,10 @@ u32 CudaVector<T>::argMax() const {
 	if (gpuMode_) {
 		u32 result = 0;
 		u32 *resultDev;
-		Cuda::alloc(resultDev, 1);
+		resultDev = MemoryPool::devicePool().allocate<u32>(1);
 		Cuda::argMax(d_elem_, nRows_, 1, resultDev);
 		Cuda::copyFromGpu(&result, resultDev, 1);
-		Cuda::free(resultDev);
+		MemoryPool::devicePool().release(resultDev);
 		return result;
 	} else {
 		return Precursor::argMax();
@@ -664,10 +777,10 @@ T CudaVector<T>::max() const {
 	if (gpuMode_) {
 		u32 index = 0;
 		u32 *resultDev;
-		Cuda::alloc(resultDev, 1);
+		resultDev = MemoryPool::devicePool().allocate<u32>(1);
 		Cuda::argMax(d_elem_, nRows_, 1, resultDev);
 		Cuda::copyFromGpu(&index, resultDev, 1);
-		Cuda::free(resultDev);
+		MemoryPool::devicePool().release(resultDev);
 		return get(index);
 	} else {
 		return Precursor::max();
@@ -775,10 +888,10 @@ T CudaVector<T>::sum() const {
 	if (gpuMode_) {
 		T result = 0;
 		T *resultDev;
-		Cuda::alloc(resultDev, 1);
+		resultDev = MemoryPool::devicePool().allocate<T>(1);
 		Cuda::sum(d_elem_, nRows_, 1, resultDev);
 		Cuda::copyFromGpu(&result, resultDev, 1);
-		Cuda::free(resultDev);
+		MemoryPool::devicePool().release(resultDev);
 		return result;
 	} else {
 		return Precursor::sum();
@@ -20,6 +20,7 @@
 #include <Core/OpenMPWrapper.hh>
 
 #include <Math/Blas.hh>
+#include <Math/MemoryPool.hh>
 #include <Math/Vector.hh>   		// for matrix-vector operations (Blas 2)
 #include <Math/FastVectorOperations.hh>
 #include <Math/Random.hh>
@@ -59,6 +60,7 @@ protected:
 	u32 nRows_;
 	u32 nColumns_;
 	bool needsU64Space_;
+	bool ownsMemory_; // false if elem_ points to external memory (see useExternalMemory)
 	T *elem_;
 protected:
 	static bool initialized;
@@ -137,6 +139,13 @@ public:
 
 	void setVisibleColumns(u32 nColumns) { safeResize(nRows_, nColumns); }
 
+	// let the matrix point to external memory of size nRows * nColumns (no copy, memory is not freed by the matrix)
+	// any subsequent reallocation (e.g. resize) makes the matrix own its memory again
+	void useExternalMemory(T* data, u32 nRows, u32 nColumns);
+
+	// returns false if the matrix is a view on external memory
+	bool ownsMemory() const { return ownsMemory_; }
+
 	// set dimensions to those of X and allocate
 	template <typename S>
 	void copyStructure(const Matrix<S> &X);
@@ -362,6 +371,22 @@ public:
 	// this = this .* (1 - X .^ 2)
 	void elementwiseMultiplicationWithTanhDerivative(const Matrix<T> &X);
 
+	// fused gated recurrent unit forward step, one pass over all gate matrices (same shape as this):
+	// z = sigmoid(updateGate), r = sigmoid(resetGate), c = tanh(candidate + r .* recurrentCandidate),
+	// this = z .* (c - previousOutput) + previousOutput
+	// updateGate, resetGate, and candidate are overwritten with z, r, and c
+	// previousOutput may be 0 or have less columns than this, missing columns are treated as zero
+	void gruForward(Matrix<T> &updateGate, Matrix<T> &resetGate, Matrix<T> &candidate,
+			const Matrix<T> &recurrentCandidate, const Matrix<T> *previousOutput = 0);
+
+	// fused gated recurrent unit backward step, this is the error signal of the output
+	// z, r, c are the gate activations as computed by gruForward, previousOutput as in gruForward
+	// computes the error signals of the four gate inputs in one pass
+	void gruBackward(const Matrix<T> &z, const Matrix<T> &r, const Matrix<T> &c,
+			const Matrix<T> &recurrentCandidate, const Matrix<T> *previousOutput,
+			Matrix<T> &updateGateError, Matrix<T> &resetGateError, Matrix<T> &candidateError,
+			Matrix<T> &recurrentCandidateError) const;
+
 	// for each column i: this(_,i) = (diag(softmax(_,i)) - softmax(_,i)*softmax(_,i)^T) * this(_,i)
 	void multiplicationWithSoftmaxDerivative(const Matrix<T> &softmax);
 
@@ -387,6 +412,16 @@ public:
 	// return the value of the cross entropy objective function; each column of *this is interpreted as a probability distribution
 	T crossEntropyObjectiveFunction(const Matrix<T>& targets) const;
 
+	// same as above, but the targets are given as class indices (one label per column)
+	template<typename S>
+	u32 nClassificationErrors(const Vector<S>& labels) const;
+	template<typename S>
+	T crossEntropyObjectiveFunction(const Vector<S>& labels) const;
+
+	// this(labels(i), i) += alpha for each column i (e.g. subtract the one-hot targets from the softmax output)
+	template<typename S>
+	void addKroneckerDelta(const Vector<S>& labels, T alpha);
+
 	// return the value of the weighted cross entropy objective function; each column of *this is interpreted as a probability distribution
 	T weightedCrossEntropyObjectiveFunction(const Matrix<T>& targets, const Vector<T>& weights) const;
 
@@ -580,10 +615,15 @@ s32 Matrix<T>::initialize(){
  */
 template<typename T>
 bool Matrix<T>::allocate() {
-	if (elem_)
-		delete [] elem_;
-	elem_ = (u64)nRows_ * (u64)nColumns_ > 0 ? new T[(u64)nRows_*(u64)nColumns_] : 0;
-	nAllocatedCells_ = (u64)nRows_ * (u64)nColumns_ > 0 ? (u64)nRows_*(u64)nColumns_ : 0;
+	if (elem_ && ownsMemory_)
+		MemoryPool::hostPool().release(elem_);
+	// the pool may return a larger block, later resizes within the allocated cells do not reallocate
+	u64 nCells = (u64)nRows_ * (u64)nColumns_;
+	elem_ = nCells > 0 ? MemoryPool::hostPool().allocate<T>(nCells, &nCells) : 0;
+	if (!needsU64Space_)
+		nCells = std::min(nCells, (u64)Types::max<u32>());
+	nAllocatedCells_ = nCells;
+	ownsMemory_ = true;
 	return true;
 }
 
@@ -594,6 +634,7 @@ nAllocatedCells_(0),
 nRows_(nRows),
 nColumns_(nColumns),
 needsU64Space_((u64)nRows * (u64)nColumns > (u64)Types::max<u32>()),
+ownsMemory_(true),
 elem_(0),
 nThreads_(1)
 {
@@ -610,6 +651,7 @@ nAllocatedCells_(0),
 nRows_(X.nRows_),
 nColumns_(X.nColumns_),
 needsU64Space_(X.needsU64Space_),
+ownsMemory_(true),
 elem_(0),
 nThreads_(1)
 {
@@ -638,6 +680,7 @@ Matrix<T>::Matrix(const Matrix<T> &X, u32 rowIndexX, u32 colIndexX,
 		nRows_(nRows),
 		nColumns_(nColumns),
 		needsU64Space_((u64)nRows * (u64)nColumns > (u64)Types::max<u32>()),
+		ownsMemory_(true),
 		elem_(0),
 		nThreads_(initialized ? maxThreads : initialize())
 {
@@ -649,16 +692,17 @@ Matrix<T>::Matrix(const Matrix<T> &X, u32 rowIndexX, u32 colIndexX,
 
 template<typename T>
 Matrix<T>::~Matrix() {
-	if (elem_)
-		delete [] elem_;
+	if (elem_ && ownsMemory_)
+		MemoryPool::hostPool().release(elem_);
 	elem_ = 0;
 }
 
 template<typename T>
 void Matrix<T>::clear() {
-	if (elem_)
-		delete [] elem_;
+	if (elem_ && ownsMemory_)
+		MemoryPool::hostPool().release(elem_);
 	elem_ = 0;
+	ownsMemory_ = true;
 	nRows_ = 0;
 	nColumns_ = 0;
 	nAllocatedCells_ = 0;
@@ -672,6 +716,7 @@ void Matrix<T>::swap(Matrix<T> &X){
 	std::swap(nColumns_, X.nColumns_);
 	std::swap(nAllocatedCells_, X.nAllocatedCells_);
 	std::swap(needsU64Space_, X.needsU64Space_);
+	std::swap(ownsMemory_, X.ownsMemory_);
 	std::swap(elem_, X.elem_);
 }
 
@@ -685,6 +730,7 @@ void Matrix<T>::swap(Vector<T> &X){
 	u32 tmpAllocatedCells = X.nAllocatedCells_;
 	X.nAllocatedCells_ = (u32)nAllocatedCells_;
 	nAllocatedCells_ = (u64)tmpAllocatedCells;
+	std::swap(ownsMemory_, X.ownsMemory_);
 	std::swap(elem_, X.elem_);
 }
 
@@ -698,6 +744,7 @@ Matrix<T> &Matrix<T>::operator=(Matrix<T> rhs) {
 template<typename T>
 void Matrix<T>::resize(u32 nRows, u32 nColumns, bool reallocate) {
 	reallocate |= (u64)nRows * (u64)nColumns > nAllocatedCells_;
+	reallocate |= !ownsMemory_;
 	nRows_ = nRows;
 	nColumns_ = nColumns;
 	if (reallocate) {
@@ -709,7 +756,25 @@ void Matrix<T>::resize(u32 nRows, u32 nColumns, bool reallocate) {
 template<typename T>
 void Matrix<T>::safeResize(u32 nRows, u32 nColumns) {
 	require_le((u64)nRows * (u64)nColumns, nAllocatedCells_);
-	resize(nRows, nColumns, false);
+	if (ownsMemory_) {
+		resize(nRows, nColumns, false);
+	}
+	else { // keep pointing to the external memory
+		nRows_ = nRows;
+		nColumns_ = nColumns;
+	}
+}
+
+template<typename T>
+void Matrix<T>::useExternalMemory(T* data, u32 nRows, u32 nColumns) {
+	if (elem_ && ownsMemory_)
+		MemoryPool::hostPool().release(elem_);
+	elem_ = data;
+	ownsMemory_ = false;
+	nRows_ = nRows;
+	nColumns_ = nColumns;
+	nAllocatedCells_ = (u64)nRows * (u64)nColumns;
+	needsU64Space_ = (u64)nRows * (u64)nColumns > (u64)Types::max<u32>();
 }
 
 template<typename T>
@@ -1679,6 +1744,104 @@ void Matrix<T>::elementwiseMultiplicationWithTanhDerivative(const Matrix<T> &X)
 		elem_[i] *= 1.0 - X.elem_[i] * X.elem_[i];
 }
 
+template<typename T>
+void Matrix<T>::gruForward(Matrix<T> &updateGate, Matrix<T> &resetGate, Matrix<T> &candidate,
+		const Matrix<T> &recurrentCandidate, const Matrix<T> *previousOutput) {
+	require(!needsU64Space_);
+	require_eq(updateGate.nRows(), nRows_);
+	require_eq(updateGate.nColumns(), nColumns_);
+	require_eq(resetGate.nRows(), nRows_);
+	require_eq(resetGate.nColumns(), nColumns_);
+	require_eq(candidate.nRows(), nRows_);
+	require_eq(candidate.nColumns(), nColumns_);
+	require_eq(recurrentCandidate.nRows(), nRows_);
+	require_eq(recurrentCandidate.nColumns(), nColumns_);
+	u32 nPreviousColumns = 0;
+	if (previousOutput) {
+		require_eq(previousOutput->nRows(), nRows_);
+		require_le(previousOutput->nColumns(), nColumns_);
+		nPreviousColumns = previousOutput->nColumns();
+	}
+	T* z = updateGate.elem_;
+	T* r = resetGate.elem_;
+	T* c = candidate.elem_;
+	const T* u = recurrentCandidate.elem_;
+	// columns are independent, the inner loops are branch-free so that the arithmetic can be vectorized
+#pragma omp parallel for
+	for (u32 j = 0; j < nColumns_; j++) {
+		u32 begin = j * nRows_;
+		u32 end = begin + nRows_;
+		for (u32 i = begin; i < end; i++) {
+			z[i] = 1.0 / (1.0 + std::exp(-z[i]));
+			r[i] = 1.0 / (1.0 + std::exp(-r[i]));
+			c[i] = std::tanh(c[i] + r[i] * u[i]);
+		}
+		if (j < nPreviousColumns) {
+			const T* h = previousOutput->elem_;
+			for (u32 i = begin; i < end; i++)
+				elem_[i] = (c[i] - h[i]) * z[i] + h[i];
+		}
+		else {
+			for (u32 i = begin; i < end; i++)
+				elem_[i] = c[i] * z[i];
+		}
+	}
+}
+
+template<typename T>
+void Matrix<T>::gruBackward(const Matrix<T> &z, const Matrix<T> &r, const Matrix<T> &c,
+		const Matrix<T> &recurrentCandidate, const Matrix<T> *previousOutput,
+		Matrix<T> &updateGateError, Matrix<T> &resetGateError, Matrix<T> &candidateError,
+		Matrix<T> &recurrentCandidateError) const {
+	require(!needsU64Space_);
+	require_eq(z.nRows(), nRows_);
+	require_eq(z.nColumns(), nColumns_);
+	require_eq(r.nRows(), nRows_);
+	require_eq(r.nColumns(), nColumns_);
+	require_eq(c.nRows(), nRows_);
+	require_eq(c.nColumns(), nColumns_);
+	require_eq(recurrentCandidate.nRows(), nRows_);
+	require_eq(recurrentCandidate.nColumns(), nColumns_);
+	require_eq(updateGateError.nRows(), nRows_);
+	require_eq(updateGateError.nColumns(), nColumns_);
+	require_eq(resetGateError.nRows(), nRows_);
+	require_eq(resetGateError.nColumns(), nColumns_);
+	require_eq(candidateError.nRows(), nRows_);
+	require_eq(candidateError.nColumns(), nColumns_);
+	require_eq(recurrentCandidateError.nRows(), nRows_);
+	require_eq(recurrentCandidateError.nColumns(), nColumns_);
+	u32 nPreviousColumns = 0;
+	if (previousOutput) {
+		require_eq(previousOutput->nRows(), nRows_);
+		require_le(previousOutput->nColumns(), nColumns_);
+		nPreviousColumns = previousOutput->nColumns();
+	}
+	const T* u = recurrentCandidate.elem_;
+	T* ez = updateGateError.elem_;
+	T* er = resetGateError.elem_;
+	T* ec = candidateError.elem_;
+	T* eu = recurrentCandidateError.elem_;
+#pragma omp parallel for
+	for (u32 j = 0; j < nColumns_; j++) {
+		u32 begin = j * nRows_;
+		u32 end = begin + nRows_;
+		if (j < nPreviousColumns) {
+			const T* h = previousOutput->elem_;
+			for (u32 i = begin; i < end; i++)
+				ez[i] = (c.elem_[i] - h[i]) * (z.elem_[i] * (1.0 - z.elem_[i])) * elem_[i];
+		}
+		else {
+			for (u32 i = begin; i < end; i++)
+				ez[i] = c.elem_[i] * (z.elem_[i] * (1.0 - z.elem_[i])) * elem_[i];
+		}
+		for (u32 i = begin; i < end; i++) {
+			ec[i] = elem_[i] * (1.0 - c.elem_[i] * c.elem_[i]) * z.elem_[i];
+			er[i] = ec[i] * (r.elem_[i] * (1.0 - r.elem_[i])) * u[i];
+			eu[i] = ec[i] * r.elem_[i];
+		}
+	}
+}
+
 template<typename T>
 void Matrix<T>::multiplicationWithSoftmaxDerivative(const Math::Matrix<T>& softmax) {
 	require(!needsU64Space_);
@@ -1792,6 +1955,42 @@ T Matrix<T>::crossEntropyObjectiveFunction(const Matrix<T>& targets) const {
 	return objFctn;
 }
 
+template<typename T>
+template<typename S>
+u32 Matrix<T>::nClassificationErrors(const Vector<S>& labels) const {
+	require(!needsU64Space_);
+	require_eq(nColumns_, labels.nRows());
+	u32 nErrors = 0;
+#pragma omp parallel for reduction(+:nErrors)
+	for (u32 column = 0; column < nColumns_; column++) {
+		const T* c = elem_ + (u64)column * nRows_;
+		if ((u32)(std::max_element(c, c + nRows_) - c) != labels.at(column))
+			nErrors++;
+	}
+	return nErrors;
+}
+
+template<typename T>
+template<typename S>
+T Matrix<T>::crossEntropyObjectiveFunction(const Vector<S>& labels) const {
+	require(!needsU64Space_);
+	require_eq(nColumns_, labels.nRows());
+	T objFctn = 0;
+#pragma omp parallel for reduction(+:objFctn)
+	for (u32 column = 0; column < nColumns_; column++)
+		objFctn += -std::log(at(labels.at(column), column));
+	return objFctn;
+}
+
+template<typename T>
+template<typename S>
+void Matrix<T>::addKroneckerDelta(const Vector<S>& labels, T alpha) {
+	require(!needsU64Space_);
+	require_eq(nColumns_, labels.nRows());
+	for (u32 column = 0; column < nColumns_; column++)
+		at(labels.at(column), column) += alpha;
+}
+
 template<typename T>
 T Matrix<T>::weightedCrossEntropyObjectiveFunction(const Matrix<T>& targets, const Vector<T>& weights) const {
 	require(!needsU64Space_);
@@ -2319,14 +2518,18 @@ void Matrix<T>::writeBinary(Core::IOStream& stream, bool transpose) {
 		I = nRows_;
 		J = nColumns_;
 	}
+	// write the values in file order with a single block write
+	std::vector<f32> values((u64)I * (u64)J);
 	for (u32 i = 0; i < I; i++) {
 		for (u32 j = 0; j < J; j++) {
 			if (transpose)
-				stream << (f32)at(j, i);
+				values[(u64)i * J + j] = (f32)at(j, i);
 			else
-				stream << (f32)at(i, j);
+				values[(u64)i * J + j] = (f32)at(i, j);
 		}
 	}
+	if (values.size() > 0)
+		stream.write(&(values[0]), values.size());
 }
 
 template<typename T>
@@ -2396,20 +2599,21 @@ void Matrix<T>::readHeader(Core::IOStream& stream, bool transpose) {
 
 template<typename T>
 void Matrix<T>::read(Core::IOStream& stream, bool transpose) {
-	f32 x;
+	// read all values with a single block read and rearrange them in memory
+	std::vector<f32> values((u64)nRows_ * (u64)nColumns_);
+	if (values.size() > 0)
+		stream.read(&(values[0]), values.size());
 	if (transpose) {
 		for (u32 col = 0; col < nColumns_; col++) {
 			for (u32 row = 0; row < nRows_; row++) {
-				stream >> x;
-				at(row, col) = (T)x;
+				at(row, col) = (T)values[(u64)col * nRows_ + row];
 			}
 		}
 	}
 	else {
 		for (u32 row = 0; row < nRows_; row++) {
 			for (u32 col = 0; col < nColumns_; col++) {
-				stream >> x;
-				at(row, col) = (T)x;
+				at(row, col) = (T)values[(u64)row * nColumns_ + col];
 			}
 		}
 	}
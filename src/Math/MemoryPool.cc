@@ -0,0 +1,199 @@
+/*
+ * Copyright 2016 Alexander Richard
+ *
+ * This file is part of Squirrel.
+ *
+ * Licensed under the Academic Free License 3.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * You should have received a copy of the License along with Squirrel.
+ * If not, see <https://opensource.org/licenses/AFL-3.0>.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ */
+
+#include "MemoryPool.hh"
+#include "CudaWrapper.hh"
+#include "CudaDataStructure.hh"
+#include <stdlib.h>
+#include <string>
+
+using namespace Math;
+
+// if false, all requests are directly passed to malloc/cudaMalloc (read once, at the first allocation)
+const Core::ParameterBool MemoryPool::paramUseMemoryPool_("use-memory-pool", true, "math");
+
+MemoryPool::MemoryPool(Location location) :
+		location_(location),
+		isEnabled_(Core::Configuration::config(paramUseMemoryPool_)),
+		nRequests_(0),
+		nHits_(0),
+		nRawAllocations_(0),
+		nBytesInUse_(0),
+		maxBytesInUse_(0),
+		nBytesCached_(0)
+{
+	pthread_mutex_init(&mutex_, 0);
+}
+
+MemoryPool& MemoryPool::hostPool() {
+	// never deleted: matrices with static storage duration may release their memory at program exit
+	static MemoryPool* pool = new MemoryPool(host);
+	return *pool;
+}
+
+MemoryPool& MemoryPool::devicePool() {
+	static MemoryPool* pool = new MemoryPool(device);
+	return *pool;
+}
+
+u32 MemoryPool::sizeClass(u64 nBytes) {
+	if (nBytes <= minBlockSize_)
+		return 0;
+	// find e with 2^e < nBytes <= 2^(e+1), then round up to a multiple of 2^e / 4
+	u32 e = log2MinBlockSize_;
+	while (((u64)1 << (e + 1)) < nBytes)
+		e++;
+	u64 step = ((u64)1 << e) / 4;
+	u64 m = (nBytes - ((u64)1 << e) + step - 1) / step;
+	return (e - log2MinBlockSize_) * 4 + (u32)m;
+}
+
+u64 MemoryPool::classSize(u32 sizeClass) {
+	if (sizeClass == 0)
+		return minBlockSize_;
+	u32 e = log2MinBlockSize_ + (sizeClass - 1) / 4;
+	u64 m = (sizeClass - 1) % 4 + 1;
+	return ((u64)1 << e) + m * (((u64)1 << e) / 4);
+}
+
+void* MemoryPool::rawAllocate(u64 nBytes) {
+	void* ptr = 0;
+	if (location_ == host) {
+		if (posix_memalign(&ptr, alignment_, nBytes) != 0)
+			ptr = 0;
+	}
+	else {
+		char* devicePtr = 0;
+		if (Cuda::alloc(devicePtr, nBytes) != 0)
+			devicePtr = 0;
+		ptr = devicePtr;
+	}
+	return ptr;
+}
+
+void MemoryPool::rawFree(void* ptr) {
+	if (location_ == host) {
+		::free(ptr);
+	}
+	else {
+		int result = Cuda::free((char*)ptr);
+		require_eq(result, 0);
+	}
+}
+
+void* MemoryPool::allocate(u64 nBytes, u64* nAllocatedBytes) {
+	require_gt(nBytes, 0);
+	void* ptr = 0;
+	pthread_mutex_lock(&mutex_);
+	nRequests_++;
+	if (isEnabled_) {
+		u32 c = sizeClass(nBytes);
+		nBytes = classSize(c);
+		if (freeBlocks_.size() <= c)
+			freeBlocks_.resize(c + 1);
+		if (!freeBlocks_.at(c).empty()) {
+			ptr = freeBlocks_.at(c).back();
+			freeBlocks_.at(c).pop_back();
+			nBytesCached_ -= nBytes;
+			nHits_++;
+		}
+		else {
+			ptr = rawAllocate(nBytes);
+			// the memory may be exhausted by cached blocks of other size classes
+			if ((ptr == 0) && (nBytesCached_ > 0)) {
+				_releaseCachedBlocks();
+				ptr = rawAllocate(nBytes);
+			}
+			if (ptr) {
+				sizeClasses_[ptr] = c;
+				nRawAllocations_++;
+			}
+		}
+		if (ptr) {
+			nBytesInUse_ += nBytes;
+			maxBytesInUse_ = std::max(maxBytesInUse_, nBytesInUse_);
+		}
+	}
+	else {
+		ptr = rawAllocate(nBytes);
+		nRawAllocations_++;
+	}
+	pthread_mutex_unlock(&mutex_);
+	if (nAllocatedBytes)
+		*nAllocatedBytes = nBytes;
+	if (ptr == 0) {
+		Core::Error::msg("MemoryPool: failed to allocate ") << nBytes << " bytes of "
+				<< (location_ == host ? "host" : "device") << " memory." << Core::Error::abort;
+	}
+	return ptr;
+}
+
+void MemoryPool::release(void* ptr) {
+	if (ptr == 0)
+		return;
+	pthread_mutex_lock(&mutex_);
+	if (isEnabled_) {
+		std::map<void*, u32>::iterator it = sizeClasses_.find(ptr);
+		require(it != sizeClasses_.end());
+		u64 nBytes = classSize(it->second);
+		freeBlocks_.at(it->second).push_back(ptr);
+		nBytesInUse_ -= nBytes;
+		nBytesCached_ += nBytes;
+	}
+	else {
+		rawFree(ptr);
+	}
+	pthread_mutex_unlock(&mutex_);
+}
+
+void MemoryPool::_releaseCachedBlocks() {
+	for (u32 c = 0; c < freeBlocks_.size(); c++) {
+		for (u32 i = 0; i < freeBlocks_.at(c).size(); i++) {
+			rawFree(freeBlocks_.at(c).at(i));
+			sizeClasses_.erase(freeBlocks_.at(c).at(i));
+		}
+		freeBlocks_.at(c).clear();
+	}
+	nBytesCached_ = 0;
+}
+
+void MemoryPool::releaseCachedBlocks() {
+	pthread_mutex_lock(&mutex_);
+	_releaseCachedBlocks();
+	pthread_mutex_unlock(&mutex_);
+}
+
+void MemoryPool::_logStatistics(const char* name) {
+	pthread_mutex_lock(&mutex_);
+	std::string tag = std::string("memory-pool.") + name;
+	Core::Log::openTag(tag.c_str());
+	if (isEnabled_) {
+		Core::Log::os("Requests: ") << nRequests_ << ", served from the cache: " << nHits_
+				<< " (hit rate " << (nRequests_ > 0 ? (Float)nHits_ / nRequests_ : 0) << ").";
+		Core::Log::os("Raw allocations: ") << nRawAllocations_ << ", peak bytes in use: " << maxBytesInUse_
+				<< ", cached bytes: " << nBytesCached_ << ".";
+	}
+	else {
+		Core::Log::os("Memory pool is disabled. Raw allocations: ") << nRawAllocations_ << ".";
+	}
+	Core::Log::closeTag();
+	pthread_mutex_unlock(&mutex_);
+}
+
+void MemoryPool::logStatistics() {
+	hostPool()._logStatistics("host");
+	if (CudaDataStructure::hasGpu())
+		devicePool()._logStatistics("device");
+}
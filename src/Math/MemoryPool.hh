@@ -0,0 +1,108 @@
+/*
+ * Copyright 2016 Alexander Richard
+ *
+ * This file is part of Squirrel.
+ *
+ * Licensed under the Academic Free License 3.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * You should have received a copy of the License along with Squirrel.
+ * If not, see <https://opensource.org/licenses/AFL-3.0>.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ */
+
+#ifndef MATH_MEMORYPOOL_HH_
+#define MATH_MEMORYPOOL_HH_
+
+#include <Core/CommonHeaders.hh>
+#include <pthread.h>
+#include <vector>
+#include <map>
+
+namespace Math {
+
+/*
+ * MemoryPool
+ * caching allocator for the (host or device) memory of matrices and vectors
+ * requests are rounded up to a size class (four classes per power of two, so at most 25% of a block are unused),
+ * released blocks are kept in a free list per size class and reused by later requests of the same class
+ * once the pool is warmed up, changing matrix sizes (e.g. variable length sequence batches) do not allocate memory
+ */
+class MemoryPool
+{
+public:
+	enum Location { host, device };
+private:
+	static const Core::ParameterBool paramUseMemoryPool_;
+	static const u64 minBlockSize_ = 256;	// bytes, size of the smallest size class
+	static const u32 log2MinBlockSize_ = 8;
+	static const u64 alignment_ = 64;		// bytes, alignment of host memory
+
+	Location location_;
+	bool isEnabled_;
+	pthread_mutex_t mutex_;
+	std::vector< std::vector<void*> > freeBlocks_;	// released blocks of each size class
+	std::map<void*, u32> sizeClasses_;				// size class of each block that has been allocated by the pool
+	// statistics
+	u64 nRequests_;
+	u64 nHits_;					// requests served with a cached block
+	u64 nRawAllocations_;		// requests that needed a new block
+	u64 nBytesInUse_;
+	u64 maxBytesInUse_;
+	u64 nBytesCached_;
+
+	MemoryPool(Location location);
+	static u32 sizeClass(u64 nBytes);
+	static u64 classSize(u32 sizeClass);
+	void* rawAllocate(u64 nBytes);
+	void rawFree(void* ptr);
+	void _releaseCachedBlocks();
+	void _logStatistics(const char* name);
+public:
+	/*
+	 * @return the pool for host memory (Matrix, Vector) and the pool for device memory (CudaMatrix, CudaVector)
+	 * the pools live until the end of the program
+	 */
+	static MemoryPool& hostPool();
+	static MemoryPool& devicePool();
+	/*
+	 * @return a block for at least nBytes bytes (if given, nAllocatedBytes is set to the usable size of the block)
+	 */
+	void* allocate(u64 nBytes, u64* nAllocatedBytes = 0);
+	/*
+	 * @return a block for at least nElements elements of type T (if given, nAllocatedElements is set to the number of elements that fit into the block)
+	 */
+	template<typename T>
+	T* allocate(u64 nElements, u64* nAllocatedElements = 0);
+	/*
+	 * return a block to the pool (the block is cached, not freed)
+	 */
+	void release(void* ptr);
+	/*
+	 * free all cached blocks
+	 */
+	void releaseCachedBlocks();
+	bool isEnabled() const { return isEnabled_; }
+	u64 nRequests() const { return nRequests_; }
+	u64 nRawAllocations() const { return nRawAllocations_; }
+	u64 nBytesCached() const { return nBytesCached_; }
+	/*
+	 * log hit rate, number of raw allocations and peak memory of the host (and device) pool
+	 */
+	static void logStatistics();
+};
+
+template<typename T>
+T* MemoryPool::allocate(u64 nElements, u64* nAllocatedElements) {
+	u64 nBytes = 0;
+	T* ptr = static_cast<T*>(allocate(nElements * sizeof(T), &nBytes));
+	if (nAllocatedElements)
+		*nAllocatedElements = nBytes / sizeof(T);
+	return ptr;
+}
+
+} // namespace
+
+#endif /* MATH_MEMORYPOOL_HH_ */
@@ -0,0 +1,283 @@
+/*
+ * Copyright 2016 Alexander Richard
+ *
+ * This file is part of Squirrel.
+ *
+ * Licensed under the Academic Free License 3.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * You should have received a copy of the License along with Squirrel.
+ * If not, see <https://opensource.org/licenses/AFL-3.0>.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ */
+
+#ifndef MATH_REDUCEDPRECISION_HH_
+#define MATH_REDUCEDPRECISION_HH_
+
+#include <Core/CommonHeaders.hh>
+#include <Math/Blas.hh>
+#include <vector>
+#include <string.h>
+#include <cmath>
+#include <algorithm>
+
+namespace Math {
+
+/*
+ * conversion between f32 and the 16 bit floating point formats bfloat16 (8 exponent bits, 7 mantissa bits)
+ * and IEEE half precision float16 (5 exponent bits, 10 mantissa bits), both with round to nearest even
+ */
+inline u16 floatToBfloat16(f32 x) {
+	u32 bits;
+	memcpy(&bits, &x, sizeof(u32));
+	if ((bits & 0x7fffffff) > 0x7f800000) // nan
+		return (bits >> 16) | 0x40;
+	return (bits + 0x7fff + ((bits >> 16) & 1)) >> 16;
+}
+
+inline f32 bfloat16ToFloat(u16 x) {
+	u32 bits = (u32)x << 16;
+	f32 result;
+	memcpy(&result, &bits, sizeof(f32));
+	return result;
+}
+
+inline u16 floatToHalf(f32 x) {
+	u32 bits;
+	memcpy(&bits, &x, sizeof(u32));
+	u32 sign = (bits >> 16) & 0x8000;
+	u32 mantissa = bits & 0x7fffff;
+	if (((bits >> 23) & 0xff) == 0xff) // inf or nan
+		return sign | 0x7c00 | (mantissa ? 0x200 : 0);
+	s32 exponent = (s32)((bits >> 23) & 0xff) - 127 + 15;
+	if (exponent >= 31) // overflow
+		return sign | 0x7c00;
+	if (exponent <= 0) { // subnormal or zero
+		if (exponent < -10)
+			return sign;
+		mantissa |= 0x800000;
+		u32 shift = 14 - exponent;
+		u32 half = mantissa >> shift;
+		u32 remainder = mantissa & ((1u << shift) - 1);
+		u32 midpoint = 1u << (shift - 1);
+		if ((remainder > midpoint) || ((remainder == midpoint) && (half & 1)))
+			half++;
+		return sign | half;
+	}
+	u32 half = sign | (exponent << 10) | (mantissa >> 13);
+	u32 remainder = mantissa & 0x1fff;
+	// a carry into the exponent is the correct rounding result
+	if ((remainder > 0x1000) || ((remainder == 0x1000) && (half & 1)))
+		half++;
+	return half;
+}
+
+inline f32 halfToFloat(u16 x) {
+	u32 sign = (u32)(x & 0x8000) << 16;
+	s32 exponent = (x >> 10) & 0x1f;
+	u32 mantissa = x & 0x3ff;
+	u32 bits;
+	if (exponent == 0) {
+		if (mantissa == 0) {
+			bits = sign;
+		}
+		else { // subnormal: normalize
+			exponent = 1;
+			while (!(mantissa & 0x400)) {
+				mantissa <<= 1;
+				exponent--;
+			}
+			bits = sign | ((u32)(exponent + 127 - 15) << 23) | ((mantissa & 0x3ff) << 13);
+		}
+	}
+	else if (exponent == 31) {
+		bits = sign | 0x7f800000 | (mantissa << 13);
+	}
+	else {
+		bits = sign | ((u32)(exponent + 127 - 15) << 23) | (mantissa << 13);
+	}
+	f32 result;
+	memcpy(&result, &bits, sizeof(f32));
+	return result;
+}
+
+/*
+ * ReducedPrecisionMatrix
+ * reduced precision copy of a (weight) matrix W for inference, supports only the product y += W^T x
+ * the products are accumulated in f32, M can be any matrix type that provides host access via begin() (Matrix, CudaMatrix)
+ * bfloat16/float16: 16 bit storage of the matrix
+ * int8: symmetric 8 bit quantization with one scale per column of W (i.e. per output unit),
+ *       the input x is quantized to 8 bit as well, either with a fixed scale determined in a calibration pass
+ *       (see observeInput/finishCalibration) or with one scale per column of x computed on the fly
+ */
+class ReducedPrecisionMatrix
+{
+public:
+	enum Precision { float32, bfloat16, float16, int8 };
+private:
+	Precision precision_;
+	u32 nRows_;
+	u32 nColumns_;
+	std::vector<u16> halfElements_;		// bfloat16 or float16 elements (column major)
+	std::vector<s8> quantizedElements_;	// int8 elements (column major)
+	std::vector<f32> scales_;			// int8: scale of each column
+	f32 inputScale_;					// int8: fixed scale of the input (0 if the input is scaled column-wise)
+	f32 inputRange_;					// int8: maximal absolute input value observed in the calibration pass
+	// bfloat16/float16: buffer for a block of W converted to f32
+	static const u32 maxBlockElements_ = 65536;
+	std::vector<f32> decodedBlock_;
+	// int8: buffers for the quantized input
+	std::vector<s8> quantizedInput_;
+	std::vector<f32> inputScales_;
+	template<class M>
+	void addTransposedProductHalf(const M& x, M& y);
+	template<class M>
+	void addTransposedProductInt8(const M& x, M& y);
+public:
+	ReducedPrecisionMatrix() : precision_(float32), nRows_(0), nColumns_(0), inputScale_(0), inputRange_(0) {}
+	Precision precision() const { return precision_; }
+	u32 nRows() const { return nRows_; }
+	u32 nColumns() const { return nColumns_; }
+	/*
+	 * @return the number of bytes used to store the matrix elements
+	 */
+	u64 nBytes() const { return halfElements_.size() * sizeof(u16) + quantizedElements_.size() + scales_.size() * sizeof(f32); }
+	/*
+	 * store the given matrix in the given precision
+	 */
+	template<class M>
+	void set(const M& matrix, Precision precision);
+	/*
+	 * y += W^T x (W is the stored matrix)
+	 */
+	template<class M>
+	void addTransposedProduct(const M& x, M& y);
+	/*
+	 * calibration of the int8 input scale: observe all inputs of the calibration pass, then call finishCalibration
+	 */
+	template<class M>
+	void observeInput(const M& x);
+	void finishCalibration() { inputScale_ = inputRange_ / 127.0f; }
+	f32 inputScale() const { return inputScale_; }
+};
+
+template<class M>
+void ReducedPrecisionMatrix::set(const M& matrix, Precision precision) {
+	require(precision != float32);
+	precision_ = precision;
+	nRows_ = matrix.nRows();
+	nColumns_ = matrix.nColumns();
+	u64 size = (u64)nRows_ * nColumns_;
+	typename M::const_iterator elements = matrix.begin();
+	halfElements_.clear();
+	quantizedElements_.clear();
+	scales_.clear();
+	if (precision_ == int8) {
+		quantizedElements_.resize(size);
+		scales_.resize(nColumns_);
+		for (u32 j = 0; j < nColumns_; j++) {
+			typename M::const_iterator column = elements + (u64)j * nRows_;
+			f32 maxAbs = 0;
+			for (u32 i = 0; i < nRows_; i++)
+				maxAbs = std::max(maxAbs, (f32)std::abs(column[i]));
+			scales_.at(j) = (maxAbs > 0 ? maxAbs / 127.0f : 1.0f);
+			for (u32 i = 0; i < nRows_; i++)
+				quantizedElements_.at((u64)j * nRows_ + i) = (s8)std::floor(column[i] / scales_.at(j) + 0.5f);
+		}
+	}
+	else {
+		halfElements_.resize(size);
+		for (u64 i = 0; i < size; i++)
+			halfElements_.at(i) = (precision_ == bfloat16 ? floatToBfloat16(elements[i]) : floatToHalf(elements[i]));
+	}
+}
+
+template<class M>
+void ReducedPrecisionMatrix::addTransposedProduct(const M& x, M& y) {
+	require_eq(x.nRows(), nRows_);
+	require_eq(y.nRows(), nColumns_);
+	require_eq(x.nColumns(), y.nColumns());
+	if (precision_ == int8)
+		addTransposedProductInt8(x, y);
+	else
+		addTransposedProductHalf(x, y);
+}
+
+template<class M>
+void ReducedPrecisionMatrix::addTransposedProductHalf(const M& x, M& y) {
+	typename M::const_iterator input = x.begin();
+	typename M::iterator output = y.begin();
+	u32 batchSize = x.nColumns();
+	// W is converted to f32 block-wise (the block fits into the cache) and each block is multiplied with BLAS
+	u32 blockSize = std::min(nColumns_, std::max(1u, maxBlockElements_ / nRows_));
+	decodedBlock_.resize((u64)nRows_ * blockSize);
+	for (u32 j0 = 0; j0 < nColumns_; j0 += blockSize) {
+		u32 nBlockColumns = std::min(blockSize, nColumns_ - j0);
+#pragma omp parallel for
+		for (u32 j = 0; j < nBlockColumns; j++) {
+			const u16* elements = &(halfElements_[(u64)(j0 + j) * nRows_]);
+			f32* column = &(decodedBlock_[(u64)j * nRows_]);
+			if (precision_ == bfloat16) {
+				for (u32 i = 0; i < nRows_; i++)
+					column[i] = bfloat16ToFloat(elements[i]);
+			}
+			else {
+				for (u32 i = 0; i < nRows_; i++)
+					column[i] = halfToFloat(elements[i]);
+			}
+		}
+		Math::gemm<f32>(CblasColMajor, CblasTrans, CblasNoTrans, nBlockColumns, batchSize, nRows_,
+				1.0f, &(decodedBlock_[0]), nRows_, input, nRows_, 1.0f, output + j0, nColumns_);
+	}
+}
+
+template<class M>
+void ReducedPrecisionMatrix::addTransposedProductInt8(const M& x, M& y) {
+	typename M::const_iterator input = x.begin();
+	typename M::iterator output = y.begin();
+	u32 batchSize = x.nColumns();
+	// quantize the input
+	quantizedInput_.resize((u64)nRows_ * batchSize);
+	inputScales_.resize(batchSize);
+#pragma omp parallel for
+	for (u32 b = 0; b < batchSize; b++) {
+		typename M::const_iterator in = input + (u64)b * nRows_;
+		f32 scale = inputScale_;
+		if (scale == 0) {
+			f32 maxAbs = 0;
+			for (u32 i = 0; i < nRows_; i++)
+				maxAbs = std::max(maxAbs, (f32)std::abs(in[i]));
+			scale = (maxAbs > 0 ? maxAbs / 127.0f : 1.0f);
+		}
+		inputScales_[b] = scale;
+		s8* q = &(quantizedInput_[(u64)b * nRows_]);
+		for (u32 i = 0; i < nRows_; i++)
+			q[i] = (s8)std::max(-127.0f, std::min(127.0f, std::floor((f32)in[i] / scale + 0.5f)));
+	}
+	// integer dot products, rescaled with the scales of W and x
+#pragma omp parallel for
+	for (u32 j = 0; j < nColumns_; j++) {
+		const s8* w = &(quantizedElements_[(u64)j * nRows_]);
+		for (u32 b = 0; b < batchSize; b++) {
+			const s8* q = &(quantizedInput_[(u64)b * nRows_]);
+			s32 sum = 0;
+			for (u32 i = 0; i < nRows_; i++)
+				sum += (s32)w[i] * (s32)q[i];
+			output[(u64)b * nColumns_ + j] += scales_[j] * inputScales_[b] * sum;
+		}
+	}
+}
+
+template<class M>
+void ReducedPrecisionMatrix::observeInput(const M& x) {
+	typename M::const_iterator input = x.begin();
+	u64 size = (u64)x.nRows() * x.nColumns();
+	for (u64 i = 0; i < size; i++)
+		inputRange_ = std::max(inputRange_, (f32)std::abs(input[i]));
+}
+
+} // namespace
+
+#endif /* MATH_REDUCEDPRECISION_HH_ */
@@ -24,6 +24,7 @@
 
 #include <Core/CommonHeaders.hh>
 #include <Math/Blas.hh>
+#include <Math/MemoryPool.hh>
 #include <Math/FastVectorOperations.hh>
 
 #include <iostream>		/** to use std::cout */
@@ -54,6 +55,7 @@ protected:
 	// (may differ from nRows_ * nColumns_ due to lazy resize)
 	u32 nAllocatedCells_;
 	u32 nRows_;
+	bool ownsMemory_; // false if elem_ points to external memory (see useExternalMemory)
 	T *elem_;
 public:
 	Vector(u32 nRows = 0);			// constructor with memory allocation
@@ -96,6 +98,13 @@ public:
 	// -> no new memory allocation, old content remains valid
 	virtual void safeResize(u32 nRows);
 
+	// let the vector point to external memory of size nRows (no copy, memory is not freed by the vector)
+	// any subsequent reallocation (e.g. resize) makes the vector own its memory again
+	void useExternalMemory(T* data, u32 nRows);
+
+	// returns false if the vector is a view on external memory
+	bool ownsMemory() const { return ownsMemory_; }
+
 	void clear();
 public:
 	// copy
@@ -163,6 +172,24 @@ public:
 
 	void rpropUpdate(const Vector<T> &newGradients, Vector<T> &oldGradients, Vector<T> &updateValues, const T increasingFactor, const T decreasingFactor, const T maxUpdateValue, const T minUpdateValue);
 
+	/*
+	 * fused optimizer updates: this vector contains the parameters, the gradient is read only once and not modified
+	 * the effective gradient is g = clip(gradient + weightDecay * parameter, -clipping, clipping), clipping <= 0 means no clipping
+	 */
+	// momentum = momentumFactor * momentum - learningRate * g, parameter += momentum
+	void momentumUpdate(const Vector<T> &gradient, Vector<T> &momentum, const T learningRate, const T momentumFactor,
+			const T weightDecay = 0, const T clipping = 0);
+	// first/second moment are updated with beta1/beta2 and divided by the bias corrections (1 - beta^iteration)
+	void adamUpdate(const Vector<T> &gradient, Vector<T> &firstMoment, Vector<T> &secondMoment, const T learningRate,
+			const T beta1, const T beta2, const T epsilon, const T biasCorrection1, const T biasCorrection2,
+			const T weightDecay = 0, const T clipping = 0);
+	// meanSquare = decay * meanSquare + (1 - decay) * g^2, parameter -= learningRate * g / (sqrt(meanSquare) + epsilon)
+	void rmspropUpdate(const Vector<T> &gradient, Vector<T> &meanSquare, const T learningRate, const T decay, const T epsilon,
+			const T weightDecay = 0, const T clipping = 0);
+	// sumSquare += g^2, parameter -= learningRate * g / (sqrt(sumSquare) + epsilon)
+	void adagradUpdate(const Vector<T> &gradient, Vector<T> &sumSquare, const T learningRate, const T epsilon,
+			const T weightDecay = 0, const T clipping = 0);
+
 	// index of minimal absolute value
 	u32 argAbsMin() const;
 
@@ -246,10 +273,13 @@ public:
 
 template<typename T>
 bool Vector<T>::allocate() {
-	if (elem_)
-		delete [] elem_;
-	elem_ = nRows_ > 0 ? new T[nRows_] : 0;
-	nAllocatedCells_ = nRows_ > 0 ? nRows_ : 0;
+	if (elem_ && ownsMemory_)
+		MemoryPool::hostPool().release(elem_);
+	// the pool may return a larger block, later resizes within the allocated cells do not reallocate
+	u64 nCells = nRows_;
+	elem_ = nCells > 0 ? MemoryPool::hostPool().allocate<T>(nCells, &nCells) : 0;
+	nAllocatedCells_ = (u32)std::min(nCells, (u64)Types::max<u32>());
+	ownsMemory_ = true;
 	return true;
 }
 
@@ -260,6 +290,7 @@ template<typename T>
 Vector<T>::Vector(u32 size) :
 	nAllocatedCells_(0),
 	nRows_(size),
+	ownsMemory_(true),
 	elem_(0)
 {
 	allocate();
@@ -271,6 +302,7 @@ template<typename T>
 Vector<T>::Vector(const Vector<T> &vector) :
 	nAllocatedCells_(0),
 	nRows_(vector.nRows_),
+	ownsMemory_(true),
 	elem_(0)
 {
 	allocate();
@@ -284,6 +316,7 @@ Vector<T>::Vector(const Vector<T> &vector) :
 template<typename T>
 void Vector<T>::resize(u32 newSize, bool reallocate) {
 	reallocate |= newSize > nAllocatedCells_;
+	reallocate |= !ownsMemory_;
 	nRows_ = newSize;
 	if (reallocate)
 		allocate();
@@ -292,14 +325,28 @@ void Vector<T>::resize(u32 newSize, bool reallocate) {
 template<typename T>
 void Vector<T>::safeResize(u32 nRows) {
 	require_le(nRows, nAllocatedCells_);
-	resize(nRows, false);
+	if (ownsMemory_)
+		resize(nRows, false);
+	else // keep pointing to the external memory
+		nRows_ = nRows;
+}
+
+template<typename T>
+void Vector<T>::useExternalMemory(T* data, u32 nRows) {
+	if (elem_ && ownsMemory_)
+		MemoryPool::hostPool().release(elem_);
+	elem_ = data;
+	ownsMemory_ = false;
+	nRows_ = nRows;
+	nAllocatedCells_ = nRows;
 }
 
 template<typename T>
 void Vector<T>::clear() {
-	if (elem_)
-		delete [] elem_;
+	if (elem_ && ownsMemory_)
+		MemoryPool::hostPool().release(elem_);
 	elem_ = 0;
+	ownsMemory_ = true;
 	nRows_ = 0;
 	nAllocatedCells_ = 0;
 }
@@ -452,6 +499,83 @@ void Vector<T>::rpropUpdate(const Vector<T> &newGradients, Vector<T> &oldGradien
 	}
 }
 
+// effective gradient of the fused optimizer updates
+template<typename T>
+inline T optimizerGradient(T gradient, T parameter, T weightDecay, T clipping) {
+	T g = gradient + weightDecay * parameter;
+	if (clipping > 0)
+		g = std::min(std::max(g, -clipping), clipping);
+	return g;
+}
+
+template<typename T>
+void Vector<T>::momentumUpdate(const Vector<T> &gradient, Vector<T> &momentum, const T learningRate, const T momentumFactor,
+		const T weightDecay, const T clipping) {
+	require_eq(gradient.nRows(), nRows_);
+	require_eq(momentum.nRows(), nRows_);
+	T* p = elem_;
+	const T* d = gradient.begin();
+	T* m = momentum.begin();
+#pragma omp parallel for
+	for (u32 i = 0; i < nRows_; i++) {
+		T g = optimizerGradient(d[i], p[i], weightDecay, clipping);
+		m[i] = momentumFactor * m[i] - learningRate * g;
+		p[i] += m[i];
+	}
+}
+
+template<typename T>
+void Vector<T>::adamUpdate(const Vector<T> &gradient, Vector<T> &firstMoment, Vector<T> &secondMoment, const T learningRate,
+		const T beta1, const T beta2, const T epsilon, const T biasCorrection1, const T biasCorrection2,
+		const T weightDecay, const T clipping) {
+	require_eq(gradient.nRows(), nRows_);
+	require_eq(firstMoment.nRows(), nRows_);
+	require_eq(secondMoment.nRows(), nRows_);
+	T* p = elem_;
+	const T* d = gradient.begin();
+	T* m = firstMoment.begin();
+	T* v = secondMoment.begin();
+#pragma omp parallel for
+	for (u32 i = 0; i < nRows_; i++) {
+		T g = optimizerGradient(d[i], p[i], weightDecay, clipping);
+		m[i] = beta1 * m[i] + (1 - beta1) * g;
+		v[i] = beta2 * v[i] + (1 - beta2) * g * g;
+		p[i] -= learningRate * (m[i] / biasCorrection1) / (std::sqrt(v[i] / biasCorrection2) + epsilon);
+	}
+}
+
+template<typename T>
+void Vector<T>::rmspropUpdate(const Vector<T> &gradient, Vector<T> &meanSquare, const T learningRate, const T decay, const T epsilon,
+		const T weightDecay, const T clipping) {
+	require_eq(gradient.nRows(), nRows_);
+	require_eq(meanSquare.nRows(), nRows_);
+	T* p = elem_;
+	const T* d = gradient.begin();
+	T* v = meanSquare.begin();
+#pragma omp parallel for
+	for (u32 i = 0; i < nRows_; i++) {
+		T g = optimizerGradient(d[i], p[i], weightDecay, clipping);
+		v[i] = decay * v[i] + (1 - decay) * g * g;
+		p[i] -= learningRate * g / (std::sqrt(v[i]) + epsilon);
+	}
+}
+
+template<typename T>
+void Vector<T>::adagradUpdate(const Vector<T> &gradient, Vector<T> &sumSquare, const T learningRate, const T epsilon,
+		const T weightDecay, const T clipping) {
+	require_eq(gradient.nRows(), nRows_);
+	require_eq(sumSquare.nRows(), nRows_);
+	T* p = elem_;
+	const T* d = gradient.begin();
+	T* v = sumSquare.begin();
+#pragma omp parallel for
+	for (u32 i = 0; i < nRows_; i++) {
+		T g = optimizerGradient(d[i], p[i], weightDecay, clipping);
+		v[i] += g * g;
+		p[i] -= learningRate * g / (std::sqrt(v[i]) + epsilon);
+	}
+}
+
 template<typename T>
 u32 Vector<T>::argAbsMin() const {
 	return Math::iamin(nRows_, elem_, 1);
@@ -673,6 +797,7 @@ template<typename T>
 void Vector<T>::swap(Vector<T> &vector){
 	std::swap(nRows_, vector.nRows_);
 	std::swap(nAllocatedCells_, vector.nAllocatedCells_);
+	std::swap(ownsMemory_, vector.ownsMemory_);
 	std::swap(elem_, vector.elem_);
 }
 
@@ -686,6 +811,7 @@ void Vector<T>::swap(Matrix<T> &X){
 	u32 tmpAllocatedCells = (u32)X.nAllocatedCells_;
 	X.nAllocatedCells_ = nAllocatedCells_;
 	nAllocatedCells_ = tmpAllocatedCells;
+	std::swap(ownsMemory_, X.ownsMemory_);
 	std::swap(elem_, X.elem_);
 }
 
@@ -721,9 +847,12 @@ void Vector<T>::writeAsciiHeader(Core::IOStream& stream) {
 template<typename T>
 void Vector<T>::writeBinary(Core::IOStream& stream) {
 	require(stream.is_open());
+	std::vector<f32> values(nRows_);
 	for (u32 row = 0; row < nRows_; row++) {
-		stream << (f32)at(row);
+		values[row] = (f32)at(row);
 	}
+	if (nRows_ > 0)
+		stream.write(&(values[0]), nRows_);
 }
 
 template<typename T>
@@ -769,10 +898,11 @@ void Vector<T>::readHeader(Core::IOStream& stream) {
 
 template<typename T>
 void Vector<T>::read(Core::IOStream& stream) {
-	f32 x;
+	std::vector<f32> values(this->nRows_);
+	if (this->nRows_ > 0)
+		stream.read(&(values[0]), this->nRows_);
 	for (u32 row = 0; row < this->nRows_; row++) {
-		stream >> x;
-		at(row) = (T)x;
+		at(row) = (T)values[row];
 	}
 }
 
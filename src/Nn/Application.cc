@@ -24,6 +24,9 @@
 #include "Application.hh"
 #include "Trainer.hh"
 #include "Forwarder.hh"
+#include "DataParallel.hh"
+#include "ReplicatedTrainer.hh"
+#include <Math/MemoryPool.hh>
 
 using namespace Nn;
 
@@ -49,10 +52,21 @@ void NeuralNetworkApplication::run() {
 	switch ((Action)Core::Configuration::config(paramAction_)) {
 	case training:
 	{
-		Trainer* trainer = Trainer::createTrainer();
-		trainer->initialize();
-		trainer->processAllEpochs(batchSize_);
-		trainer->finalize();
+		DataParallel::launchWorkers();
+		// multi-threaded training with several replicas of the trainer
+		if (ReplicatedTrainer::isReplicatedTrainingRequested()) {
+			ReplicatedTrainer trainer;
+			trainer.initialize();
+			trainer.processAllEpochs(batchSize_);
+			trainer.finalize();
+		}
+		else {
+			Trainer* trainer = Trainer::createTrainer();
+			trainer->initialize();
+			trainer->processAllEpochs(batchSize_);
+			trainer->finalize();
+		}
+		DataParallel::finalize();
 	}
 	break;
 	case forwarding:
@@ -68,4 +82,5 @@ void NeuralNetworkApplication::run() {
 		Core::Error::msg("No action given.") << Core::Error::abort;
 		break;
 	}
+	Math::MemoryPool::logStatistics();
 }
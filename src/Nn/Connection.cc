@@ -104,10 +104,37 @@ void Connection::_backpropagateWeights(const Matrix& source, Matrix& dest) {
 	_forwardWeightMultiplication(source, dest);
 }
 
+void Connection::collectTimeBatchedErrorSignal(Matrix& errorSignal) {
+	require(source_->hasMergedTimeframes());
+	require(!isRecurrent());
+	const std::vector<u32>& timeBatchColumns = source_->timeBatchColumns();
+	require_eq(timeBatchColumns.size(), dest_->nTimeframes());
+	errorSignal.resize(dest_->nInputUnits(destPort_), source_->activationsOut(0, sourcePort_).nColumns());
+	errorSignal.setToZero();
+	u32 column = 0;
+	for (u32 t = 0; t < dest_->nTimeframes(); t++) {
+		// error signal might not exists if dest_ is beyond the last recurrent layer
+		if (dest_->errorSignalIn(t, destPort_).nRows() > 0) {
+			require_eq(dest_->errorSignalIn(t, destPort_).nColumns(), timeBatchColumns.at(t));
+			errorSignal.copyBlockFromMatrix(dest_->errorSignalIn(t, destPort_), 0, 0, 0, column, errorSignal.nRows(), timeBatchColumns.at(t));
+		}
+		column += timeBatchColumns.at(t);
+	}
+	require_eq(column, errorSignal.nColumns());
+}
+
 void Connection::backpropagateWeights(u32 timeframe) {
 	require(isComputing_);
 	require(source_);
 	require(dest_);
+	// source_ holds all timeframes in a single one (time-batched backpropagation, see NeuralNetwork::mergeTimeBatchedLayers)
+	if (source_->hasMergedTimeframes() && (!dest_->hasMergedTimeframes())) {
+		Matrix errorSignal;
+		errorSignal.initComputation();
+		collectTimeBatchedErrorSignal(errorSignal);
+		_backpropagateWeights(errorSignal, source_->errorSignalOut(0, sourcePort_));
+		return;
+	}
 	require_eq(source_->nTimeframes(), dest_->nTimeframes());
 	// default behavior: just backpropagate the old error signal (equivalent to weight-matrix = identity)
 	if (isRecurrent() && (timeframe + 1 < dest_->nTimeframes())) {
@@ -187,7 +214,8 @@ const Core::ParameterFloat WeightConnection::paramRandomWeightMax_("random-weigh
 
 WeightConnection::WeightConnection(const char* name, BaseLayer* source, BaseLayer* dest, u32 sourcePort, u32 destPort, bool isRecurrent, ConnectionType type) :
 		Precursor(name, source, dest, sourcePort, destPort, isRecurrent, type),
-		isTrainable_(Core::Configuration::config(paramIsTrainable_, prefix_))
+		isTrainable_(Core::Configuration::config(paramIsTrainable_, prefix_)),
+		isCalibrating_(false)
 {}
 
 void WeightConnection::initialize() {
@@ -289,7 +317,39 @@ void WeightConnection::_forwardWeightMultiplication(const Matrix& source, Matrix
 	require_eq(weights_.nRows(), source.nRows());
 	require_eq(weights_.nColumns(), dest.nRows());
 	require_eq(source.nColumns(), dest.nColumns());
-	dest.addMatrixProduct(weights_, source, 1, 1, true, false);
+	if ((reducedWeights_.precision() != Math::ReducedPrecisionMatrix::float32) && (!isCalibrating_)) {
+		// the reduced precision product operates on the host memory
+		source.finishComputation();
+		dest.finishComputation();
+		reducedWeights_.addTransposedProduct(source, dest);
+		source.initComputation(false);
+		dest.initComputation();
+	}
+	else {
+		if (isCalibrating_) {
+			source.finishComputation();
+			reducedWeights_.observeInput(source);
+			source.initComputation(false);
+		}
+		dest.addMatrixProduct(weights_, source, 1, 1, true, false);
+	}
+}
+
+void WeightConnection::setWeightPrecision(Math::ReducedPrecisionMatrix::Precision precision) {
+	require(!isComputing_);
+	if (precision != Math::ReducedPrecisionMatrix::float32)
+		reducedWeights_.set(weights_, precision);
+}
+
+void WeightConnection::startCalibration() {
+	require_eq(reducedWeights_.precision(), Math::ReducedPrecisionMatrix::int8);
+	isCalibrating_ = true;
+}
+
+void WeightConnection::finishCalibration() {
+	require(isCalibrating_);
+	reducedWeights_.finishCalibration();
+	isCalibrating_ = false;
 }
 
 void WeightConnection::_backpropagateWeights(const Matrix& source, Matrix& dest) {
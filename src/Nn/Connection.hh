@@ -24,6 +24,7 @@
 #define NN_CONNECTION_HH_
 
 #include <Core/CommonHeaders.hh>
+#include <Math/ReducedPrecision.hh>
 #include "Types.hh"
 
 namespace Nn {
@@ -82,6 +83,8 @@ public:
 
 	virtual void forwardWeightMultiplication();
 	virtual void backpropagateWeights(u32 timeframe = 0);
+	// concatenate the error signals of all timeframes of the destination layer if the source layer has merged timeframes
+	void collectTimeBatchedErrorSignal(Matrix& errorSignal);
 
 	virtual void saveWeights(const std::string& basePath, const std::string& suffix) {};
 	virtual void setWeightsFileSuffix();
@@ -126,6 +129,9 @@ protected:
 protected:
 	Matrix weights_;
 	bool isTrainable_;
+	// reduced precision copy of the weights used for forwarding (inference only)
+	Math::ReducedPrecisionMatrix reducedWeights_;
+	bool isCalibrating_;
 
 	virtual void _initializeWeights(u32 nRows, u32 nColumns);
 	virtual void _initializeWeights(const std::string& basePath, const std::string& suffix, u32 nRows, u32 nColumns);
@@ -140,6 +146,17 @@ public:
 	virtual bool hasWeights() const { return true; }
 	virtual bool isTrainable() const;
 	virtual Matrix& weights();
+	/*
+	 * forward with a reduced precision copy of the weights (CPU only, the weights must not change afterwards)
+	 */
+	void setWeightPrecision(Math::ReducedPrecisionMatrix::Precision precision);
+	Math::ReducedPrecisionMatrix::Precision weightPrecision() const { return reducedWeights_.precision(); }
+	u64 nReducedPrecisionBytes() const { return reducedWeights_.nBytes(); }
+	/*
+	 * int8 calibration pass: forward in full precision and observe the input range until finishCalibration is called
+	 */
+	void startCalibration();
+	void finishCalibration();
 public:
 	virtual void saveWeights(const std::string& basePath, const std::string& suffix);
 
@@ -0,0 +1,254 @@
+/*
+ * Copyright 2016 Alexander Richard
+ *
+ * This file is part of Squirrel.
+ *
+ * Licensed under the Academic Free License 3.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * You should have received a copy of the License along with Squirrel.
+ * If not, see <https://opensource.org/licenses/AFL-3.0>.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ */
+
+#include "DataParallel.hh"
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <sched.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sstream>
+
+using namespace Nn;
+
+/*
+ * DataParallel
+ */
+const Core::ParameterInt DataParallel::paramNumberOfWorkers_("number-of-workers", 1, "data-parallel");
+
+const Core::ParameterString DataParallel::paramLogFile_("log-file", "stdout", "");
+
+u32 DataParallel::nWorkers_ = 1;
+
+u32 DataParallel::rank_ = 0;
+
+pid_t DataParallel::parent_ = 0;
+
+std::vector<pid_t> DataParallel::workers_;
+
+DataParallel::ControlBlock* DataParallel::control_ = 0;
+
+int DataParallel::sharedMemoryFile_ = -1;
+
+void DataParallel::launchWorkers() {
+	require(control_ == 0);
+	nWorkers_ = Core::Configuration::config(paramNumberOfWorkers_);
+	require_ge(nWorkers_, 1);
+	if (nWorkers_ == 1)
+		return;
+	Core::Log::openTag("data-parallel");
+	// shared memory for the synchronization and the statistics, inherited by all forked workers
+	void* control = mmap(0, sizeof(ControlBlock), PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+	if (control == MAP_FAILED)
+		Core::Error::msg("DataParallel::launchWorkers: failed to allocate shared memory.") << Core::Error::abort;
+	control_ = (ControlBlock*)control;
+	control_->nArrived = 0;
+	control_->generation = 0;
+	char filename[] = "/dev/shm/squirrel-data-parallel-XXXXXX";
+	sharedMemoryFile_ = mkstemp(filename);
+	if (sharedMemoryFile_ < 0)
+		Core::Error::msg("DataParallel::launchWorkers: failed to create ") << filename << "." << Core::Error::abort;
+	// the file is removed as soon as all workers closed it
+	unlink(filename);
+	Core::Log::os("Fork ") << nWorkers_ - 1 << " additional worker processes.";
+	Core::Log::closeTag();
+	// flush buffered output, otherwise it is duplicated in the workers
+	Core::Log::os().flush();
+	parent_ = getpid();
+	for (u32 r = 1; r < nWorkers_; r++) {
+		pid_t pid = fork();
+		if (pid < 0)
+			Core::Error::msg("DataParallel::launchWorkers: fork failed.") << Core::Error::abort;
+		if (pid == 0) {
+			rank_ = r;
+			workers_.clear();
+			std::string logFile = Core::Configuration::config(paramLogFile_);
+			std::stringstream s;
+			s << (logFile.compare("stdout") == 0 ? std::string("data-parallel") : logFile) << ".worker-" << r;
+			Core::Log::redirect(s.str().c_str());
+			break;
+		}
+		workers_.push_back(pid);
+	}
+	// each worker reads its own shard of the data
+	std::stringstream nShards, shardIndex;
+	nShards << nWorkers_;
+	shardIndex << rank_;
+	Core::Configuration::setParameter("*.number-of-shards", nShards.str().c_str());
+	Core::Configuration::setParameter("*.shard-index", shardIndex.str().c_str());
+	Core::Log::openTag("data-parallel");
+	Core::Log::os("Worker ") << rank_ << " of " << nWorkers_ << " (process " << getpid() << ").";
+	Core::Log::closeTag();
+}
+
+void DataParallel::finalize() {
+	if (nWorkers_ == 1)
+		return;
+	barrier();
+	for (u32 i = 0; i < workers_.size(); i++) {
+		int status;
+		waitpid(workers_.at(i), &status, 0);
+		if (!WIFEXITED(status) || (WEXITSTATUS(status) != 0))
+			Core::Error::msg("DataParallel::finalize: worker ") << i + 1 << " terminated abnormally." << Core::Error::abort;
+	}
+	workers_.clear();
+}
+
+void DataParallel::checkWorkers() {
+	// the other workers wait forever if one of them died, so terminate in this case
+	if (rank_ == 0) {
+		for (u32 i = 0; i < workers_.size(); i++) {
+			int status;
+			if (waitpid(workers_.at(i), &status, WNOHANG) != 0)
+				Core::Error::msg("DataParallel::barrier: worker ") << i + 1 << " terminated unexpectedly." << Core::Error::abort;
+		}
+	}
+	else if (getppid() != parent_) {
+		Core::Error::msg("DataParallel::barrier: worker 0 terminated unexpectedly.") << Core::Error::abort;
+	}
+}
+
+void DataParallel::barrier() {
+	if (nWorkers_ == 1)
+		return;
+	require(control_);
+	u32 generation = control_->generation;
+	if (__sync_add_and_fetch(&(control_->nArrived), 1) == nWorkers_) {
+		control_->nArrived = 0;
+		__sync_add_and_fetch(&(control_->generation), 1);
+	}
+	else {
+		for (u32 n = 1; control_->generation == generation; n++) {
+			sched_yield();
+			if (n % 100000 == 0)
+				checkWorkers();
+		}
+	}
+	__sync_synchronize();
+}
+
+/*
+ * GradientAllReduce
+ */
+GradientAllReduce::GradientAllReduce() :
+		size_(0),
+		slotSize_(0),
+		buffer_(0)
+{}
+
+GradientAllReduce::~GradientAllReduce() {
+	if (buffer_)
+		munmap(buffer_, slotSize_ * DataParallel::nWorkers());
+}
+
+void GradientAllReduce::initialize(u32 size) {
+	require(buffer_ == 0);
+	require_gt(DataParallel::nWorkers(), 1);
+	size_ = size;
+	// slots are aligned to cache lines
+	slotSize_ = nScalars * sizeof(f64) + (u64)size_ * sizeof(Float);
+	slotSize_ = ((slotSize_ + 63) / 64) * 64;
+	u64 totalSize = slotSize_ * DataParallel::nWorkers();
+	// all workers resize the file to the same size before it is mapped
+	if (ftruncate(DataParallel::sharedMemoryFile(), totalSize) != 0)
+		Core::Error::msg("GradientAllReduce::initialize: failed to allocate ") << totalSize << " bytes of shared memory." << Core::Error::abort;
+	void* buffer = mmap(0, totalSize, PROT_READ | PROT_WRITE, MAP_SHARED, DataParallel::sharedMemoryFile(), 0);
+	if (buffer == MAP_FAILED)
+		Core::Error::msg("GradientAllReduce::initialize: failed to map shared memory.") << Core::Error::abort;
+	buffer_ = (char*)buffer;
+	DataParallel::barrier();
+}
+
+void GradientAllReduce::chunk(u32 worker, u32& begin, u32& end) const {
+	begin = (u64)size_ * worker / DataParallel::nWorkers();
+	end = (u64)size_ * (worker + 1) / DataParallel::nWorkers();
+}
+
+void GradientAllReduce::reduce(Statistics& statistics) {
+	require(buffer_);
+	require(!statistics.isNormalized());
+	u32 rank = DataParallel::rank();
+	u32 nWorkers = DataParallel::nWorkers();
+	bool isComputing = statistics.isComputing();
+	statistics.finishComputation();
+	// write the local statistics into the own slot
+	f64* s = scalars(rank);
+	s[0] = statistics.nObservations();
+	s[1] = (statistics.needsSequenceCount() ? statistics.nSequences() : 0);
+	s[2] = (statistics.needsClassificationStatistics() ? statistics.nClassificationErrors() : 0);
+	s[3] = (statistics.needsObjectiveFunction() ? statistics.objectiveFunction() : 0);
+	if (statistics.needsGradient()) {
+		require_eq(statistics.gradient().nRows(), size_);
+		memcpy(gradient(rank), statistics.gradient().begin(), (u64)size_ * sizeof(Float));
+	}
+	DataParallel::barrier();
+	u32 begin, end;
+	if (statistics.needsGradient()) {
+		// reduce-scatter: sum up the own chunk over all slots
+		chunk(rank, begin, end);
+		Float* g = gradient(rank);
+		for (u32 w = 0; w < nWorkers; w++) {
+			if (w == rank)
+				continue;
+			const Float* h = gradient(w);
+#pragma omp parallel for
+			for (u32 i = begin; i < end; i++)
+				g[i] += h[i];
+		}
+	}
+	DataParallel::barrier();
+	if (statistics.needsGradient()) {
+		// all-gather: collect the summed chunks of all workers
+		Float* g = statistics.gradient().begin();
+		for (u32 w = 0; w < nWorkers; w++) {
+			chunk(w, begin, end);
+			memcpy(g + begin, gradient(w) + begin, (u64)(end - begin) * sizeof(Float));
+		}
+	}
+	f64 sum[nScalars] = { 0, 0, 0, 0 };
+	for (u32 w = 0; w < nWorkers; w++) {
+		for (u32 i = 0; i < nScalars; i++)
+			sum[i] += scalars(w)[i];
+	}
+	// the slots may be overwritten by the next reduce when all workers passed this barrier
+	DataParallel::barrier();
+	// add the statistics of the other workers
+	statistics.increaseNumberOfObservations((u32)sum[0] - (u32)s[0]);
+	if (statistics.needsSequenceCount())
+		statistics.increaseNumberOfSequences((u32)sum[1] - (u32)s[1]);
+	if (statistics.needsClassificationStatistics())
+		statistics.increaseNumberOfClassificationErrors((u32)sum[2] - (u32)s[2]);
+	if (statistics.needsObjectiveFunction())
+		statistics.addToObjectiveFunction((Float)(sum[3] - s[3]));
+	if (isComputing)
+		statistics.initComputation();
+}
+
+void GradientAllReduce::broadcast(Vector& parameters) {
+	require(buffer_);
+	require_eq(parameters.nRows(), size_);
+	bool isComputing = parameters.isComputing();
+	parameters.finishComputation();
+	if (DataParallel::isMaster())
+		memcpy(gradient(0), parameters.begin(), (u64)size_ * sizeof(Float));
+	DataParallel::barrier();
+	if (!DataParallel::isMaster())
+		memcpy(parameters.begin(), gradient(0), (u64)size_ * sizeof(Float));
+	DataParallel::barrier();
+	if (isComputing)
+		parameters.initComputation();
+}
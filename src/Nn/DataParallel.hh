@@ -0,0 +1,108 @@
+/*
+ * Copyright 2016 Alexander Richard
+ *
+ * This file is part of Squirrel.
+ *
+ * Licensed under the Academic Free License 3.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * You should have received a copy of the License along with Squirrel.
+ * If not, see <https://opensource.org/licenses/AFL-3.0>.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ */
+
+#ifndef NN_DATAPARALLEL_HH_
+#define NN_DATAPARALLEL_HH_
+
+#include <Core/CommonHeaders.hh>
+#include <sys/types.h>
+#include "Types.hh"
+#include "Statistics.hh"
+
+namespace Nn {
+
+/*
+ * data parallel training with several worker processes on one machine
+ * the worker processes are forked at startup, each worker reads its own shard of the feature caches
+ * (the parameters *.number-of-shards and *.shard-index of the feature readers are set accordingly)
+ * the statistics of all workers are summed before each model update (see GradientAllReduce)
+ * only the first worker (rank 0) saves the network parameters, the other workers log to <log-file>.worker-<rank>
+ */
+class DataParallel
+{
+private:
+	static const Core::ParameterInt paramNumberOfWorkers_;
+	static const Core::ParameterString paramLogFile_;
+	// synchronization variables, located in memory that is shared by all workers
+	struct ControlBlock {
+		volatile u32 nArrived;
+		volatile u32 generation;
+	};
+	static u32 nWorkers_;
+	static u32 rank_;
+	static pid_t parent_;
+	static std::vector<pid_t> workers_;
+	static ControlBlock* control_;
+	static int sharedMemoryFile_;
+	static void checkWorkers();
+public:
+	/*
+	 * fork the worker processes (call once before the trainer is created), returns in each worker
+	 */
+	static void launchWorkers();
+	/*
+	 * wait for all workers to finish (rank 0), the other workers just return
+	 */
+	static void finalize();
+	static u32 nWorkers() { return nWorkers_; }
+	static u32 rank() { return rank_; }
+	static bool isMaster() { return rank_ == 0; }
+	/*
+	 * blocks until all workers called the barrier
+	 */
+	static void barrier();
+	/*
+	 * @return file descriptor of a file in shared memory that is accessible by all workers
+	 */
+	static int sharedMemoryFile() { return sharedMemoryFile_; }
+};
+
+/*
+ * all-reduce of the statistics of all workers in shared memory
+ * each worker writes its statistics into its own slot, then each worker sums up one chunk of the gradient over all slots
+ * (reduce-scatter) and finally copies all summed chunks back into its statistics (all-gather), i.e. like a ring all-reduce
+ * each worker reads and writes the gradient only once
+ */
+class GradientAllReduce
+{
+private:
+	enum { nScalars = 4 };
+	u32 size_;			// number of gradient components
+	u64 slotSize_;		// size of the slot of a worker in bytes
+	char* buffer_;
+	f64* scalars(u32 worker) { return (f64*)(buffer_ + worker * slotSize_); }
+	Float* gradient(u32 worker) { return (Float*)(buffer_ + worker * slotSize_ + nScalars * sizeof(f64)); }
+	void chunk(u32 worker, u32& begin, u32& end) const;
+public:
+	GradientAllReduce();
+	virtual ~GradientAllReduce();
+	/*
+	 * @param size number of gradient components (same for all workers)
+	 */
+	void initialize(u32 size);
+	/*
+	 * replace the statistics (observation count, classification errors, objective function, gradient)
+	 * by their sum over all workers, the statistics must not be normalized yet
+	 */
+	void reduce(Statistics& statistics);
+	/*
+	 * copy the parameters of worker 0 to all other workers
+	 */
+	void broadcast(Vector& parameters);
+};
+
+} // namespace
+
+#endif /* NN_DATAPARALLEL_HH_ */
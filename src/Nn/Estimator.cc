@@ -28,7 +28,7 @@ using namespace std;
 /*
  * Estimator
  */
-const Core::ParameterEnum Estimator::paramEstimatorType_("method", "none, steepest-descent, rprop, adam", "none", "estimator");
+const Core::ParameterEnum Estimator::paramEstimatorType_("method", "none, steepest-descent, rprop, adam, rmsprop, adagrad", "none", "estimator");
 
 const Core::ParameterBool Estimator::paramLogParameterNorm_("log-parameter-norm", true, "estimator");
 
@@ -36,17 +36,42 @@ const Core::ParameterBool Estimator::paramLogGradientNorm_("log-gradient-norm",
 
 const Core::ParameterBool Estimator::paramLogStepSize_("log-step-size", true, "estimator");
 
+const Core::ParameterFloat Estimator::paramGradientClipping_("gradient-clipping", 0.0, "estimator");
+
+const Core::ParameterFloat Estimator::paramWeightDecay_("weight-decay", 0.0, "estimator");
+
 Estimator::Estimator() :
 		epoch_(1),
 		learningRateSchedule_(0),
 		logParameterNorm_(Core::Configuration::config(paramLogParameterNorm_)),
 		logGradientNorm_(Core::Configuration::config(paramLogGradientNorm_)),
-		logStepSize_(Core::Configuration::config(paramLogStepSize_))
+		logStepSize_(Core::Configuration::config(paramLogStepSize_)),
+		gradientClipping_(Core::Configuration::config(paramGradientClipping_)),
+		weightDecay_(Core::Configuration::config(paramWeightDecay_))
 {}
 
 void Estimator::initialize(NeuralNetwork& network, TrainingTask task) {
 	learningRateSchedule_ = LearningRateSchedule::createLearningRateSchedule();
 	learningRateSchedule_->initialize(task);
+	initializeSegments(network);
+}
+
+void Estimator::initializeSegments(NeuralNetwork& network, Float biasWeight) {
+	segments_.clear();
+	for (u32 h = 0; h < network.nParameterBlocks(); h++) {
+		const ParameterBlock& b = network.parameterBlock(h);
+		Float factor = network.learningRateFactor(h) * (b.isBias ? biasWeight : 1.0);
+		if ((segments_.size() > 0) && (segments_.back().learningRateFactor == factor))
+			segments_.back().size += b.size();
+		else
+			segments_.push_back(Segment(b.offset, b.size(), factor));
+	}
+}
+
+void Estimator::segmentView(Vector& buffer, const Segment& segment, Vector& view) {
+	view.finishComputation(false);
+	view.useExternalMemory(buffer, segment.offset, segment.size);
+	view.initComputation(false);
 }
 
 void Estimator::setEpoch(u32 epoch) {
@@ -61,18 +86,7 @@ void Estimator::estimate(NeuralNetwork& network, Statistics& statistics) {
 
 	// log the parameter norm
 	if (logParameterNorm_ && statistics.needsGradient()) {
-		Float parameterNorm = 0.0;
-		for (u32 c = 0; c < network.nConnections(); c++) {
-			if (network.connection(c).hasWeights() && network.connection(c).isTrainable())
-				parameterNorm += network.connection(c).weights().l1norm();
-		}
-		for (u32 l = 0; l < network.nLayer(); l++) {
-			if (network.layer(l).isBiasTrainable()) {
-				for (u32 port = 0; port < network.layer(l).nInputPorts(); port++)
-					parameterNorm += network.layer(l).bias(port).l1norm();
-			}
-		}
-		Core::Log::os("parameter-norm (l1-norm of all trainable weights and biases): ") << parameterNorm;
+		Core::Log::os("parameter-norm (l1-norm of all trainable weights and biases): ") << network.parameters().l1norm();
 	}
 
 	// log the gradient norm
@@ -100,6 +114,14 @@ Estimator* Estimator::createEstimator() {
 		Core::Log::os("Create Adam estimator.");
 		estimator = new AdamEstimator();
 		break;
+	case rmsprop:
+		Core::Log::os("Create RMSprop estimator.");
+		estimator = new RmspropEstimator();
+		break;
+	case adagrad:
+		Core::Log::os("Create Adagrad estimator.");
+		estimator = new AdagradEstimator();
+		break;
 	case none:
 		estimator = new Estimator();
 		break;
@@ -129,54 +151,36 @@ SteepestDescentEstimator::SteepestDescentEstimator() :
 
 void SteepestDescentEstimator::initialize(NeuralNetwork& network, TrainingTask task) {
 	Precursor::initialize(network, task);
+	initializeSegments(network, biasWeight_);
 	momentumStats_.initialize(network);
 	momentumStats_.initComputation();
+	momentumStats_.gradient().setToZero();
 }
 
 void SteepestDescentEstimator::estimate(NeuralNetwork& network, Statistics& statistics) {
 	Precursor::estimate(network, statistics);
 	Float learningRate = learningRateSchedule_->learningRate();
 	Float stepSize = 0;
-	// update bias
-	for (u32 l = 0; l < network.nLayer(); l++) {
-		if (network.layer(l).isBiasTrainable()) {
-			for (u32 port = 0; port < network.layer(l).nInputPorts(); port++) {
-				if (useMomentum_) {
-					momentumStats_.biasGradient(network.layer(l).name(), port).scale(momentum_);
-					momentumStats_.biasGradient(network.layer(l).name(), port).add(statistics.biasGradient(network.layer(l).name(), port),
-							-learningRate * biasWeight_ * network.layer(l).learningRateFactor());
-					network.layer(l).bias(port).add(momentumStats_.biasGradient(network.layer(l).name(), port));
-					if (logStepSize_) {
-						stepSize += momentumStats_.biasGradient(network.layer(l).name(), port).l1norm();
-					}
-				}
-				else {
-					network.layer(l).bias(port).add(statistics.biasGradient(network.layer(l).name(), port), -learningRate * biasWeight_ * network.layer(l).learningRateFactor());
-					if (logStepSize_)
-						stepSize += statistics.biasGradient(network.layer(l).name(), port).l1norm() * learningRate * biasWeight_ * network.layer(l).learningRateFactor();
-				}
-			}
+	// the fused kernel is needed for momentum, gradient clipping and weight decay, plain sgd only needs an axpy
+	bool fused = useMomentum_ || (gradientClipping_ > 0) || (weightDecay_ != 0);
+	Vector parameters, gradient, momentum;
+	for (u32 i = 0; i < segments_.size(); i++) {
+		Float alpha = learningRate * segments_.at(i).learningRateFactor;
+		segmentView(network.parameters(), segments_.at(i), parameters);
+		segmentView(statistics.gradient(), segments_.at(i), gradient);
+		if (fused) {
+			// without momentum, the momentum buffer just holds the last step
+			segmentView(momentumStats_.gradient(), segments_.at(i), momentum);
+			parameters.momentumUpdate(gradient, momentum, alpha, (useMomentum_ ? momentum_ : (Float)0.0), weightDecay_, gradientClipping_);
 		}
-	}
-	// update weights
-	for (u32 c = 0; c < network.nConnections(); c++) {
-		if (network.connection(c).hasWeights() && network.connection(c).isTrainable()) {
-			if (useMomentum_) {
-				momentumStats_.weightsGradient(network.connection(c).name()).scale(momentum_);
-				momentumStats_.weightsGradient(network.connection(c).name()).add(statistics.weightsGradient(network.connection(c).name()),
-						-learningRate * network.connection(c).learningRateFactor());
-				network.connection(c).weights().add(momentumStats_.weightsGradient(network.connection(c).name()));
-				if (logStepSize_) {
-					stepSize += momentumStats_.weightsGradient(network.connection(c).name()).l1norm();
-				}
-			}
-			else {
-				network.connection(c).weights().add(statistics.weightsGradient(network.connection(c).name()), -learningRate * network.connection(c).learningRateFactor());
-				if (logStepSize_)
-					stepSize += statistics.weightsGradient(network.connection(c).name()).l1norm() * learningRate * network.connection(c).learningRateFactor();
-			}
+		else {
+			parameters.add(gradient, -alpha);
+			if (logStepSize_)
+				stepSize += gradient.l1norm() * alpha;
 		}
 	}
+	if (logStepSize_ && fused)
+		stepSize = momentumStats_.gradient().l1norm();
 	// log step size
 	if (logStepSize_)
 		Core::Log::os("step size: ") << stepSize;
@@ -220,21 +224,8 @@ void RpropEstimator::initialize(NeuralNetwork& network, TrainingTask task) {
 	oldGradients_.initComputation();
 	updateValues_.initComputation();
 
-	for (u32 l = 0; l < network.nLayer(); l++) {
-		if (network.layer(l).isBiasTrainable()) {
-			for (u32 port = 0; port < network.layer(l).nInputPorts(); port++) {
-				updateValues_.biasGradient(network.layer(l).name(), port).fill(initialStepSize_);
-				oldGradients_.biasGradient(network.layer(l).name(), port).setToZero();
-			}
-		}
-	}
-
-	for (u32 c = 0; c < network.nConnections(); c++) {
-		if (network.connection(c).hasWeights() && network.connection(c).isTrainable()) {
-			updateValues_.weightsGradient(network.connection(c).name()).fill(initialStepSize_);
-			oldGradients_.weightsGradient(network.connection(c).name()).setToZero();
-		}
-	}
+	updateValues_.gradient().fill(initialStepSize_);
+	oldGradients_.gradient().setToZero();
 
 	std::string filename = Core::Configuration::config(paramLoadStepSizesFrom_);
 	if (!filename.empty()) {
@@ -248,36 +239,12 @@ void RpropEstimator::initialize(NeuralNetwork& network, TrainingTask task) {
 
 void RpropEstimator::estimate(NeuralNetwork& network, Statistics& statistics) {
 	Precursor::estimate(network, statistics);
-	Float stepSize = 0;
-
-	for (u32 l = 0; l < network.nLayer(); l++) {
-		if (network.layer(l).isBiasTrainable()) {
-			for (u32 port = 0; port < network.layer(l).nInputPorts(); port++) {
-				network.layer(l).bias(port).rpropUpdate(
-						statistics.biasGradient(network.layer(l).name(), port),
-						oldGradients_.biasGradient(network.layer(l).name(), port),
-						updateValues_.biasGradient(network.layer(l).name(), port),
-						increasingFactor_, decreasingFactor_, maxUpdateValue_, minUpdateValue_);
-				if (logStepSize_)
-					stepSize += updateValues_.biasGradient(network.layer(l).name(), port).l1norm();
-			}
-		}
-	}
-
-	for (u32 c = 0; c < network.nConnections(); c++) {
-		if (network.connection(c).hasWeights() && network.connection(c).isTrainable()) {
-			network.connection(c).weights().rpropUpdate(
-					statistics.weightsGradient(network.connection(c).name()),
-					oldGradients_.weightsGradient(network.connection(c).name()),
-					updateValues_.weightsGradient(network.connection(c).name()),
-					increasingFactor_, decreasingFactor_, maxUpdateValue_, minUpdateValue_);
-			if (logStepSize_)
-				stepSize += updateValues_.weightsGradient(network.connection(c).name()).l1norm();
-		}
-	}
+	// rprop does not depend on the learning rate, so the complete arena is updated at once
+	network.parameters().rpropUpdate(statistics.gradient(), oldGradients_.gradient(), updateValues_.gradient(),
+			increasingFactor_, decreasingFactor_, maxUpdateValue_, minUpdateValue_);
 	// log step size
 	if (logStepSize_)
-		Core::Log::os("step size: ") << stepSize;
+		Core::Log::os("step size: ") << updateValues_.gradient().l1norm();
 }
 /*
  * ADAM Estimator
@@ -305,105 +272,86 @@ void AdamEstimator::initialize(NeuralNetwork& network, TrainingTask task) {
 	firstMoment_.initComputation();
 	secondMoment_.initComputation();
 
-	for (u32 l = 0; l < network.nLayer(); l++) {
-		if (network.layer(l).isBiasTrainable()) {
-			for (u32 port = 0; port < network.layer(l).nInputPorts(); port++) {
-				firstMoment_.biasGradient(network.layer(l).name(), port).setToZero();
-				secondMoment_.biasGradient(network.layer(l).name(), port).setToZero();
-			}
-		}
-	}
-	for (u32 c = 0; c < network.nConnections(); c++) {
-		if (network.connection(c).hasWeights() && network.connection(c).isTrainable()) {
-			firstMoment_.weightsGradient(network.connection(c).name()).setToZero();
-			secondMoment_.weightsGradient(network.connection(c).name()).setToZero();
-		}
-	}
+	firstMoment_.gradient().setToZero();
+	secondMoment_.gradient().setToZero();
 }
 
-void AdamEstimator::update(Matrix &weights, const Matrix &firstMoment, const Matrix &secondMoment, Float learningRateFactor) {
-	Matrix biasCorrectedFirstMoment;
-	Matrix biasCorrectedSecondMoment;
-
-	biasCorrectedFirstMoment.resize(firstMoment.nRows(), firstMoment.nColumns());
-	biasCorrectedSecondMoment.resize(secondMoment.nRows(), secondMoment.nColumns());
-
-	biasCorrectedFirstMoment.initComputation(false);
-	biasCorrectedSecondMoment.initComputation(false);
-
-	biasCorrectedFirstMoment.copy(firstMoment);
-	biasCorrectedSecondMoment.copy(secondMoment);
-	biasCorrectedFirstMoment.scale( (Float)  ( 1.0 / ( 1.0 - std::pow(beta1_, iteration_))));
-	biasCorrectedSecondMoment.scale( (Float) ( 1.0 / ( 1.0 - std::pow(beta2_, iteration_))));
-
-	biasCorrectedSecondMoment.signedPow((Float) 0.5);
-	biasCorrectedSecondMoment.addConstantElementwise(epsilon_);
-	biasCorrectedFirstMoment.elementwiseDivision(biasCorrectedSecondMoment);
-
-	weights.add(biasCorrectedFirstMoment, (Float)(-1.0 * learningRate() * learningRateFactor));
+void AdamEstimator::estimate(NeuralNetwork& network, Statistics& statistics) {
+	Precursor::estimate(network, statistics);
 
-	biasCorrectedFirstMoment.finishComputation(false);
-	biasCorrectedSecondMoment.finishComputation(false);
+	iteration_++;
+	Float biasCorrection1 = 1.0 - std::pow(beta1_, iteration_);
+	Float biasCorrection2 = 1.0 - std::pow(beta2_, iteration_);
+	// moments and parameters are updated in a single pass over each segment, the gradient is left unchanged
+	Vector parameters, gradient, firstMoment, secondMoment;
+	for (u32 i = 0; i < segments_.size(); i++) {
+		segmentView(network.parameters(), segments_.at(i), parameters);
+		segmentView(statistics.gradient(), segments_.at(i), gradient);
+		segmentView(firstMoment_.gradient(), segments_.at(i), firstMoment);
+		segmentView(secondMoment_.gradient(), segments_.at(i), secondMoment);
+		parameters.adamUpdate(gradient, firstMoment, secondMoment, learningRate() * segments_.at(i).learningRateFactor,
+				beta1_, beta2_, epsilon_, biasCorrection1, biasCorrection2, weightDecay_, gradientClipping_);
+	}
 }
 
-void AdamEstimator::update(Vector &bias, const Vector &firstMoment, const Vector &secondMoment, Float learningRateFactor) {
-
-	Vector biasCorrectedFirstMoment;
-	Vector biasCorrectedSecondMoment;
-
-	biasCorrectedFirstMoment.resize(firstMoment.nRows());
-	biasCorrectedSecondMoment.resize(secondMoment.nRows());
-
-	biasCorrectedFirstMoment.initComputation(false);
-	biasCorrectedSecondMoment.initComputation(false);
-
-	biasCorrectedFirstMoment.copy(firstMoment);
-	biasCorrectedSecondMoment.copy(secondMoment);
-	biasCorrectedFirstMoment.scale( (Float)  ( 1.0 / ( 1.0 - std::pow(beta1_, iteration_))));
-	biasCorrectedSecondMoment.scale( (Float) ( 1.0 / ( 1.0 - std::pow(beta2_, iteration_))));
-
-	biasCorrectedSecondMoment.signedPow((Float) 0.5);
-	biasCorrectedSecondMoment.addConstantElementwise(epsilon_);
-	biasCorrectedFirstMoment.elementwiseDivision(biasCorrectedSecondMoment);
+/*
+ * RMSprop Estimator
+ */
+const Core::ParameterFloat RmspropEstimator::paramDecay_("decay", 0.9, "estimator");
+const Core::ParameterFloat RmspropEstimator::paramEpsilon_("epsilon", 0.00000001, "estimator");
 
-	bias.add(biasCorrectedFirstMoment, (Float)(-1.0 * learningRate() * learningRateFactor));
+RmspropEstimator::RmspropEstimator() :
+		Precursor(),
+		decay_(Core::Configuration::config(paramDecay_)),
+		epsilon_(Core::Configuration::config(paramEpsilon_)),
+		meanSquare_((Statistics::StatisticTypes)(Statistics::gradientStatistics))
+{}
 
-	biasCorrectedFirstMoment.finishComputation(false);
-	biasCorrectedSecondMoment.finishComputation(false);
+void RmspropEstimator::initialize(NeuralNetwork& network, TrainingTask task) {
+	Precursor::initialize(network, task);
+	meanSquare_.initialize(network);
+	meanSquare_.initComputation();
+	meanSquare_.gradient().setToZero();
 }
 
-void AdamEstimator::estimate(NeuralNetwork& network, Statistics& statistics) {
+void RmspropEstimator::estimate(NeuralNetwork& network, Statistics& statistics) {
 	Precursor::estimate(network, statistics);
-
-	iteration_++;
-	for (u32 l = 0; l < network.nLayer(); l++) {
-		if (network.layer(l).isBiasTrainable()) {
-			for (u32 port = 0; port < network.layer(l).nInputPorts(); port++) {
-				firstMoment_.biasGradient(network.layer(l).name(), port).scale(beta1_);
-				firstMoment_.biasGradient(network.layer(l).name(), port).add(statistics.biasGradient(network.layer(l).name(), port), (Float)(1.0 - beta1_));
-
-				secondMoment_.biasGradient(network.layer(l).name(), port).scale(beta2_);
-				statistics.biasGradient(network.layer(l).name(), port).elementwiseMultiplication(statistics.biasGradient(network.layer(l).name(), port));
-				secondMoment_.biasGradient(network.layer(l).name(), port).add(statistics.biasGradient(network.layer(l).name(), port), (Float)(1.0 - beta2_));
-
-				//if(network.layer(l).getLearningRate() != -1)
-				update(network.layer(l).bias(port), firstMoment_.biasGradient(network.layer(l).name(), port),
-						secondMoment_.biasGradient(network.layer(l).name(), port), network.layer(l).learningRateFactor());
-			}
-		}
+	Vector parameters, gradient, meanSquare;
+	for (u32 i = 0; i < segments_.size(); i++) {
+		segmentView(network.parameters(), segments_.at(i), parameters);
+		segmentView(statistics.gradient(), segments_.at(i), gradient);
+		segmentView(meanSquare_.gradient(), segments_.at(i), meanSquare);
+		parameters.rmspropUpdate(gradient, meanSquare, learningRate() * segments_.at(i).learningRateFactor,
+				decay_, epsilon_, weightDecay_, gradientClipping_);
 	}
+}
+
+/*
+ * Adagrad Estimator
+ */
+const Core::ParameterFloat AdagradEstimator::paramEpsilon_("epsilon", 0.00000001, "estimator");
 
-	for (u32 c = 0; c < network.nConnections(); c++) {
-		if (network.connection(c).hasWeights() && network.connection(c).isTrainable()) {
-			firstMoment_.weightsGradient(network.connection(c).name()).scale(beta1_);
-			firstMoment_.weightsGradient(network.connection(c).name()).add(statistics.weightsGradient(network.connection(c).name()), (Float)(1.0 - beta1_));
+AdagradEstimator::AdagradEstimator() :
+		Precursor(),
+		epsilon_(Core::Configuration::config(paramEpsilon_)),
+		sumSquare_((Statistics::StatisticTypes)(Statistics::gradientStatistics))
+{}
 
-			secondMoment_.weightsGradient(network.connection(c).name()).scale(beta2_);
-			statistics.weightsGradient(network.connection(c).name()).elementwiseMultiplication(statistics.weightsGradient(network.connection(c).name()));
-			secondMoment_.weightsGradient(network.connection(c).name()).add(statistics.weightsGradient(network.connection(c).name()), (Float)(1.0 - beta2_));
+void AdagradEstimator::initialize(NeuralNetwork& network, TrainingTask task) {
+	Precursor::initialize(network, task);
+	sumSquare_.initialize(network);
+	sumSquare_.initComputation();
+	sumSquare_.gradient().setToZero();
+}
 
-			update(network.connection(c).weights(), firstMoment_.weightsGradient(network.connection(c).name()),
-					secondMoment_.weightsGradient(network.connection(c).name()), network.connection(c).learningRateFactor());
-		}
+void AdagradEstimator::estimate(NeuralNetwork& network, Statistics& statistics) {
+	Precursor::estimate(network, statistics);
+	Vector parameters, gradient, sumSquare;
+	for (u32 i = 0; i < segments_.size(); i++) {
+		segmentView(network.parameters(), segments_.at(i), parameters);
+		segmentView(statistics.gradient(), segments_.at(i), gradient);
+		segmentView(sumSquare_.gradient(), segments_.at(i), sumSquare);
+		parameters.adagradUpdate(gradient, sumSquare, learningRate() * segments_.at(i).learningRateFactor,
+				epsilon_, weightDecay_, gradientClipping_);
 	}
 }
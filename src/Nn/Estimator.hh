@@ -41,13 +41,33 @@ private:
 	static const Core::ParameterBool paramLogParameterNorm_;
 	static const Core::ParameterBool paramLogGradientNorm_;
 	static const Core::ParameterBool paramLogStepSize_;
-	enum EstimatorType { none, steepestDescent, rprop, adam };
+	static const Core::ParameterFloat paramGradientClipping_;
+	static const Core::ParameterFloat paramWeightDecay_;
+	enum EstimatorType { none, steepestDescent, rprop, adam, rmsprop, adagrad };
+protected:
+	/*
+	 * maximal contiguous range of the flat parameter arena in which all blocks have the same learning rate factor
+	 */
+	class Segment {
+	public:
+		u32 offset;
+		u32 size;
+		Float learningRateFactor;
+		Segment(u32 _offset, u32 _size, Float _learningRateFactor) : offset(_offset), size(_size), learningRateFactor(_learningRateFactor) {}
+	};
 protected:
 	u32 epoch_;				// the current epoch number
 	LearningRateSchedule* learningRateSchedule_;
 	bool logParameterNorm_;
 	bool logGradientNorm_;
 	bool logStepSize_;
+	Float gradientClipping_;	// used by the fused update kernels, clip each gradient component to [-c, c] if c > 0
+	Float weightDecay_;		// used by the fused update kernels, add weightDecay * parameter to the gradient
+	std::vector<Segment> segments_;
+	// the learning rate factors of the biases are multiplied with biasWeight
+	void initializeSegments(NeuralNetwork& network, Float biasWeight = 1.0);
+	// let view point to the given segment of a buffer in the layout of the parameter arena
+	static void segmentView(Vector& buffer, const Segment& segment, Vector& view);
 public:
 	Estimator();
 	virtual ~Estimator() {}
@@ -134,9 +154,6 @@ private:
 
 	Statistics firstMoment_;
 	Statistics secondMoment_;
-private:
-	void update(Matrix &weights, const Matrix &firstMoment, const Matrix &secondMoment, Float learningRateFactor);
-	void update(Vector &bias, const Vector &firstMoment, const Vector &secondMoment, Float learningRateFactor);
 
 public:
 	AdamEstimator();
@@ -146,6 +163,52 @@ public:
 	virtual void estimate(NeuralNetwork& network, Statistics& statistics);
 };
 
+/*
+ * RMSprop Estimator
+ */
+class RmspropEstimator : public Estimator
+{
+private:
+	typedef Estimator Precursor;
+private:
+	static const Core::ParameterFloat paramDecay_;
+	static const Core::ParameterFloat paramEpsilon_;
+
+	Float decay_;
+	Float epsilon_;
+
+	Statistics meanSquare_;
+
+public:
+	RmspropEstimator();
+	virtual ~RmspropEstimator() { }
+	virtual void initialize(NeuralNetwork& network, TrainingTask task);
+	virtual u32 requiredStatistics() const { return Statistics::gradientStatistics; }
+	virtual void estimate(NeuralNetwork& network, Statistics& statistics);
+};
+
+/*
+ * Adagrad Estimator
+ */
+class AdagradEstimator : public Estimator
+{
+private:
+	typedef Estimator Precursor;
+private:
+	static const Core::ParameterFloat paramEpsilon_;
+
+	Float epsilon_;
+
+	Statistics sumSquare_;
+
+public:
+	AdagradEstimator();
+	virtual ~AdagradEstimator() { }
+	virtual void initialize(NeuralNetwork& network, TrainingTask task);
+	virtual u32 requiredStatistics() const { return Statistics::gradientStatistics; }
+	virtual void estimate(NeuralNetwork& network, Statistics& statistics);
+};
+
 } // namespace
 
 #endif /* NN_ESTIMATOR_HH_ */
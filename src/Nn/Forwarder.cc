@@ -31,6 +31,10 @@ const Core::ParameterEnum Forwarder::paramTask_("task", "evaluate, dump-output",
 
 const Core::ParameterEnum Forwarder::paramEvaluate_("evaluate", "none, classification-error, cross-entropy, squared-error", "none", "forwarder");
 
+// int8 weights: the first mini-batches are forwarded in full precision to determine the input range of each connection
+// (0: no calibration, the inputs are quantized with a scale per observation)
+const Core::ParameterInt Forwarder::paramCalibrationBatches_("calibration-batches", 0, "forwarder");
+
 Forwarder::Forwarder() :
 		task_((Task)Core::Configuration::config(paramTask_)),
 		evaluation_((Evaluation)Core::Configuration::config(paramEvaluate_)),
@@ -38,6 +42,7 @@ Forwarder::Forwarder() :
 		writer_(0),
 		evalResult_(0),
 		evalNormalization_(0),
+		nCalibrationBatches_(Core::Configuration::config(paramCalibrationBatches_)),
 		isInitialized_(false)
 {}
 
@@ -234,6 +239,10 @@ void Forwarder::eval() {
 void Forwarder::initialize() {
 	minibatchGenerator_.initialize();
 	network_.initialize();
+	if (network_.weightPrecision() != Math::ReducedPrecisionMatrix::int8)
+		nCalibrationBatches_ = 0;
+	if (nCalibrationBatches_ > 0)
+		network_.startQuantizationCalibration();
 	network_.initComputation();
 	/* initialize feature writer for feature dumping */
 	if (task_ == dumpFeatures) {
@@ -253,14 +262,21 @@ void Forwarder::initialize() {
 void Forwarder::forward(u32 batchSize) {
 	require(isInitialized_);
 	u32 nProcessedObservations = 0;
+	u32 nProcessedBatches = 0;
 	while (nProcessedObservations < minibatchGenerator_.totalNumberOfObservations()) {
+		if ((nCalibrationBatches_ > 0) && (nProcessedBatches == nCalibrationBatches_)) {
+			network_.finishQuantizationCalibration();
+			Core::Log::os("Finished int8 calibration after ") << nProcessedBatches << " mini-batches.";
+		}
 		u32 bsize = std::min(batchSize, minibatchGenerator_.totalNumberOfObservations() - nProcessedObservations);
 		minibatchGenerator_.generateBatch(bsize);
 		if (task_ == evaluate)
 			eval();
 		else
 			dump();
-		nProcessedObservations += bsize;
+		// the batch may be smaller than requested (see MinibatchGenerator::max-batch-frames)
+		nProcessedObservations += minibatchGenerator_.batchSize();
+		nProcessedBatches++;
 	}
 }
 
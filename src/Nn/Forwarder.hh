@@ -41,6 +41,7 @@ class Forwarder
 private:
 	static const Core::ParameterEnum paramTask_;
 	static const Core::ParameterEnum paramEvaluate_;
+	static const Core::ParameterInt paramCalibrationBatches_;
 	enum Task { evaluate, dumpFeatures };
 	enum Evaluation { none, classificationError, crossEntropy, squaredError };
 protected:
@@ -51,6 +52,7 @@ protected:
 	Features::FeatureWriter* writer_;
 	Float evalResult_;
 	u32 evalNormalization_;
+	u32 nCalibrationBatches_;
 	bool isInitialized_;
 
 	// dump features
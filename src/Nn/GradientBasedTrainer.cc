@@ -36,6 +36,7 @@ GradientBasedTrainer::GradientBasedTrainer() :
 		statistics_(0),
 		regularizer_(0),
 		criterion_(0),
+		allReduce_(0),
 		modelUpdateStrategy_((ModelUpdateStrategy) Core::Configuration::config(paramModelUpdateStrategy_)),
 		epochAtLastUpdate_(0),
 		firstTrainableLayerIndex_(0),
@@ -45,6 +46,8 @@ GradientBasedTrainer::GradientBasedTrainer() :
 GradientBasedTrainer::~GradientBasedTrainer() {
 	if (regularizer_)
 		delete regularizer_;
+	if (allReduce_)
+		delete allReduce_;
 }
 
 u32 GradientBasedTrainer::requiredStatistics() {
@@ -78,6 +81,12 @@ void GradientBasedTrainer::initialize() {
 	criterion_ = TrainingCriterion::createCriterion();
 	criterion_->initialize(network());
 	lastRecurrentLayerIndex_ = std::min(network().lastRecurrentLayerIndex(), network().nLayer() - 1);
+	// data parallel training: all workers start with the parameters of the first worker
+	if (DataParallel::nWorkers() > 1) {
+		allReduce_ = new GradientAllReduce();
+		allReduce_->initialize(network().parameters().nRows());
+		allReduce_->broadcast(network().parameters());
+	}
 }
 
 void GradientBasedTrainer::backpropTimeframe(u32 t, u32 layerIndexFrom, u32 layerIndexTo, bool greedyBackprop) {
@@ -119,6 +128,12 @@ void GradientBasedTrainer::errorBackpropagation(u32 historyLength, bool greedyBa
 	/* backpropagation through time */
 	u32 T = network().outputLayer().nTimeframes() - 1;
 
+	// layers that have been forwarded time-batched can be backpropagated for all timeframes at once
+	// if the complete sequence is memorized
+	u32 nTimeBatchedLayers = 0;
+	if ((historyLength > T) && (network().nTimeBatchedLayers() > firstTrainableLayerIndex_))
+		nTimeBatchedLayers = network().nTimeBatchedLayers();
+
 	// backprop from the next layer that requires a full forward pass over all timeframes until the first layer is reached
 	s32 layerIndexTo = network().nLayer() - 1;
 	while (layerIndexTo >= 0) {
@@ -126,13 +141,20 @@ void GradientBasedTrainer::errorBackpropagation(u32 historyLength, bool greedyBa
 		// get layer up to which the forwarding can be done
 		while ((layerIndexFrom > 0) && (!network().layer(layerIndexFrom).requiresFullPass()))
 			layerIndexFrom--;
-		// backprop all timeframes for the block [layerIndexFrom, layerIndexTo]
+		// backprop all timeframes for the block [layerIndexFrom, layerIndexTo] (time-batched layers are skipped)
 		for (s32 t = T; t > (s32)T - (s32)historyLength; t--) {
-			backpropTimeframe((u32)t, (u32)layerIndexFrom, (u32)layerIndexTo, greedyBackprop);
+			backpropTimeframe((u32)t, std::max((u32)layerIndexFrom, nTimeBatchedLayers), (u32)layerIndexTo, greedyBackprop);
 		}
 		// set the values for the next block
 		layerIndexTo = layerIndexFrom - 1;
 	}
+
+	// backprop the time-batched layers with all timeframes merged into a single one
+	if (nTimeBatchedLayers > 0) {
+		network().mergeTimeBatchedLayers();
+		for (s32 l = nTimeBatchedLayers - 1; l >= (s32)firstTrainableLayerIndex_; l--)
+			network().layer(l).backpropagate(0);
+	}
 }
 
 void GradientBasedTrainer::updateGradient(u32 historyLength) {
@@ -143,6 +165,23 @@ void GradientBasedTrainer::updateGradient(u32 historyLength) {
 		if (network().connection(c).hasWeights() && network().connection(c).isTrainable()) {
 			u32 sourcePort = network().connection(c).sourcePort();
 			u32 destPort = network().connection(c).destinationPort();
+			// time-batched layers have all timeframes merged into a single one
+			if (network().connection(c).to().hasMergedTimeframes()) {
+				statistics().weightsGradient(network().weightsHandle(c)).addMatrixProduct(
+						network().timeBatchedActivations(network().connection(c)),
+						network().connection(c).to().errorSignal(0, destPort),
+						1.0, 1.0, false, true);
+				continue;
+			}
+			// connection from a time-batched layer: concatenate the error signals of all timeframes of the target layer
+			if (network().connection(c).from().hasMergedTimeframes()) {
+				Matrix errorSignal;
+				errorSignal.initComputation();
+				network().connection(c).collectTimeBatchedErrorSignal(errorSignal);
+				statistics().weightsGradient(network().weightsHandle(c)).addMatrixProduct(
+						network().connection(c).from().activations(0, sourcePort), errorSignal, 1.0, 1.0, false, true);
+				continue;
+			}
 			// sum over the complete stored history of time frames
 			for (s32 t = T; t > (s32)T - (s32)historyLength; t--) {
 				// if error signal exists (might not be the case if t < T and connection is beyond last recurrent layer)
@@ -150,7 +189,7 @@ void GradientBasedTrainer::updateGradient(u32 historyLength) {
 					if(network().connection(c).type() == Connection::convolutionalConnection
 							|| network().connection(c).type() == Connection::validConvolutionalConnection) {
 #ifdef MODULE_CUDNN
-						((ConvolutionalConnection&)network().connection(c)).backwardWRTKernel(statistics().weightsGradient(network().connection(c).name()),
+						((ConvolutionalConnection&)network().connection(c)).backwardWRTKernel(statistics().weightsGradient(network().weightsHandle(c)),
 								network().connection(c).from().activations(t, sourcePort), network().connection(c).to().errorSignal(t, destPort));
 #else
 						Matrix &activation = network().connection(c).from().activations(t, sourcePort);
@@ -162,7 +201,7 @@ void GradientBasedTrainer::updateGradient(u32 historyLength) {
 						Matrix temp1;
 						((ConvolutionalConnection&)network().connection(c)).forwardPreprocess(activation, temp1);
 
-						statistics().weightsGradient(network().connection(c).name()).
+						statistics().weightsGradient(network().weightsHandle(c)).
 								addMatrixProduct(temp1, temp, 1.0, 1.0, false, true);
 
 						temp.finishComputation(false);
@@ -171,7 +210,7 @@ void GradientBasedTrainer::updateGradient(u32 historyLength) {
 					}
 					// in case of full weight matrices
 					else {
-						statistics().weightsGradient(network().connection(c).name()).addMatrixProduct(
+						statistics().weightsGradient(network().weightsHandle(c)).addMatrixProduct(
 								network().connection(c).from().activations(t, sourcePort),
 								network().connection(c).to().errorSignal(t, destPort),
 								1.0, 1.0, false, true);
@@ -184,16 +223,22 @@ void GradientBasedTrainer::updateGradient(u32 historyLength) {
 	for (u32 l = 0; l < network().nLayer(); l++) {
 		if (network().layer(l).useBias() && network().layer(l).isBiasTrainable()) {
 			for (u32 port = 0; port < network().layer(l).nInputPorts(); port++) {
+				// time-batched layers have all timeframes merged into a single one
+				if (network().layer(l).hasMergedTimeframes()) {
+					statistics().biasGradient(network().biasHandle(l, port)).addSummedColumnsChannelWise(
+							network().layer(l).errorSignal(0, port), network().layer(l).nChannels(port));
+					continue;
+				}
 				// sum over the complete stored history of time frames
 				for (s32 t = T; t > (s32)T - (s32)historyLength; t--) {
 					// if error signal exists (might not be the case if t < T and layer is beyond last recurrent layer)
 					if (network().layer(l).layerType() == Layer::batchNormalizationLayer) {
 						Vector biasGradient;
 						((BatchNormalizationLayer&)network().layer(l)).getBiasGradient(biasGradient);
-						statistics().biasGradient(network().layer(l).name(), 0).add(biasGradient);
+						statistics().biasGradient(network().biasHandle(l, 0)).add(biasGradient);
 					}
 					else if (network().layer(l).errorSignal(t, port).nRows() > 0) {
-						statistics().biasGradient(network().layer(l).name(), port).addSummedColumnsChannelWise(
+						statistics().biasGradient(network().biasHandle(l, port)).addSummedColumnsChannelWise(
 								network().layer(l).errorSignal(t, port), network().layer(l).nChannels(port));
 					}
 				}
@@ -203,6 +248,9 @@ void GradientBasedTrainer::updateGradient(u32 historyLength) {
 }
 
 void GradientBasedTrainer::estimateModelParameters() {
+	// sum up the statistics of all workers
+	if (allReduce_)
+		allReduce_->reduce(statistics());
 	statistics().normalize();
 	// add the regularizer gradient and objective function
 	regularizer_->addToGradient(network(), statistics());
@@ -235,9 +283,30 @@ void FeedForwardTrainer::initialize() {
 		network().setMaximalMemory(1); // set the history length (number of time frames that are memorized) to 1
 }
 
+bool FeedForwardTrainer::supportsLabelTargets() {
+	return criterion_->supportsLabelTargets();
+}
+
 void FeedForwardTrainer::processBatch(Matrix& source, Matrix& targets) {
+	_processBatch(source, targets);
+}
+
+void FeedForwardTrainer::processBatch(Matrix& source, LabelVector& targets) {
+	_processBatch(source, targets);
+}
+
+void FeedForwardTrainer::processSequenceBatch(MatrixContainer& source, MatrixContainer& targets) {
+	_processSequenceBatch(source, targets);
+}
+
+void FeedForwardTrainer::processSequenceBatch(MatrixContainer& source, LabelContainer& targets) {
+	_processSequenceBatch(source, targets);
+}
+
+template<typename Targets>
+void FeedForwardTrainer::_processBatch(Matrix& source, Targets& targets) {
 	require_gt(epochLength_, 0);
-	require_eq(source.nColumns(), targets.nColumns());
+	require_eq(source.nColumns(), nObservations(targets));
 	/* initial steps for the batch */
 	// ensure everything is in computing state
 	targets.initComputation();
@@ -267,10 +336,11 @@ void FeedForwardTrainer::processBatch(Matrix& source, Matrix& targets) {
 	}
 }
 
-void FeedForwardTrainer::processSequenceBatch(MatrixContainer& source, MatrixContainer& targets) {
+template<typename Targets>
+void FeedForwardTrainer::_processSequenceBatch(MatrixContainer& source, Targets& targets) {
 	require_gt(epochLength_, 0);
 	for (u32 t = 0; t < source.nTimeframes(); t++) {
-		require_eq(source.at(t).nColumns(), targets.at(t).nColumns());
+		require_eq(source.at(t).nColumns(), nObservations(targets.at(t)));
 	}
 	/* initial steps for the batch */
 	// ensure everything is in computing state
@@ -322,9 +392,30 @@ void RnnTrainer::initialize() {
 	Precursor::initialize();
 }
 
+bool RnnTrainer::supportsLabelTargets() {
+	return criterion_->supportsLabelTargets();
+}
+
 void RnnTrainer::processSequenceBatch(MatrixContainer& source, Matrix& targets) {
+	_processSequenceBatch(source, targets);
+}
+
+void RnnTrainer::processSequenceBatch(MatrixContainer& source, LabelVector& targets) {
+	_processSequenceBatch(source, targets);
+}
+
+void RnnTrainer::processSequenceBatch(MatrixContainer& source, MatrixContainer& targets) {
+	_processSequenceBatchWithSequenceTargets(source, targets);
+}
+
+void RnnTrainer::processSequenceBatch(MatrixContainer& source, LabelContainer& targets) {
+	_processSequenceBatchWithSequenceTargets(source, targets);
+}
+
+template<typename Targets>
+void RnnTrainer::_processSequenceBatch(MatrixContainer& source, Targets& targets) {
 	require_gt(epochLength_, 0);
-	require_eq(source.getLast().nColumns(), targets.nColumns());
+	require_eq(source.getLast().nColumns(), nObservations(targets));
 
 	/* initial steps for the sequence batch */
 	// set the history length (number of time frames that are memorized)
@@ -358,10 +449,11 @@ void RnnTrainer::processSequenceBatch(MatrixContainer& source, Matrix& targets)
 	}
 }
 
-void RnnTrainer::processSequenceBatch(MatrixContainer& source, MatrixContainer& targets) {
+template<typename Targets>
+void RnnTrainer::_processSequenceBatchWithSequenceTargets(MatrixContainer& source, Targets& targets) {
 	require_gt(epochLength_, 0);
 	for (u32 t = 0; t < source.nTimeframes(); t++) {
-		require_eq(source.at(t).nColumns(), targets.at(t).nColumns());
+		require_eq(source.at(t).nColumns(), nObservations(targets.at(t)));
 	}
 
 	/* initial steps for the sequence batch */
@@ -388,8 +480,8 @@ void RnnTrainer::processSequenceBatch(MatrixContainer& source, MatrixContainer&
 	if (task_ == classification)
 		statistics().increaseNumberOfClassificationErrors(nClassificationErrors(targets));
 	for (u32 t = 0; t < targets.nTimeframes(); t++)
-		statistics().increaseNumberOfObservations(targets.at(t).nColumns());
-	statistics().increaseNumberOfSequences(targets.getLast().nColumns());
+		statistics().increaseNumberOfObservations(nObservations(targets.at(t)));
+	statistics().increaseNumberOfSequences(nObservations(targets.getLast()));
 	updateGradient(historyLength);
 
 	/* estimate the model parameters */
@@ -430,7 +522,7 @@ void BagOfWordsNetworkTrainer::_updateGradient() {
 		for (u32 port = 0; port < network().layer(l).nInputPorts(); port++) {
 			// update the bias gradients
 			if (network().layer(l).useBias() && network().layer(l).isBiasTrainable()) {
-				statistics().biasGradient(network().layer(l).name(), port).addSummedColumns(
+				statistics().biasGradient(network().biasHandle(l, port)).addSummedColumns(
 						network().layer(l).latestErrorSignal(port));
 			}
 			// update the weights gradients
@@ -441,7 +533,7 @@ void BagOfWordsNetworkTrainer::_updateGradient() {
 					if(network().connection(c).type() == Connection::convolutionalConnection
 							|| network().connection(c).type() == Connection::validConvolutionalConnection) {
 #ifdef MODULE_CUDNN
-						((ConvolutionalConnection&)network().connection(c)).backwardWRTKernel(statistics().weightsGradient(network().connection(c).name()),
+						((ConvolutionalConnection&)network().connection(c)).backwardWRTKernel(statistics().weightsGradient(network().weightsHandle(c)),
 								network().connection(c).from().latestActivations(sourcePort), network().connection(c).to().latestErrorSignal(destPort));
 #else
 						Matrix &activation = network().connection(c).from().activations(t, sourcePort);
@@ -453,7 +545,7 @@ void BagOfWordsNetworkTrainer::_updateGradient() {
 						Matrix temp1;
 						((ConvolutionalConnection&)network().connection(c)).forwardPreprocess(activation, temp1);
 
-						statistics().weightsGradient(network().connection(c).name()).
+						statistics().weightsGradient(network().weightsHandle(c)).
 								addMatrixProduct(temp1, temp, 1.0, 1.0, false, true);
 
 						temp.finishComputation(false);
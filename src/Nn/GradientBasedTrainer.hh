@@ -28,6 +28,7 @@
 #include "Statistics.hh"
 #include "Regularizer.hh"
 #include "TrainingCriteria.hh"
+#include "DataParallel.hh"
 
 namespace Nn {
 
@@ -45,6 +46,7 @@ protected:
 	Statistics* statistics_;
 	Regularizer* regularizer_;
 	TrainingCriterion* criterion_;
+	GradientAllReduce* allReduce_;	// only used for data parallel training
 	ModelUpdateStrategy modelUpdateStrategy_;
 	u32 epochAtLastUpdate_;
 	u32 firstTrainableLayerIndex_;
@@ -60,6 +62,16 @@ protected:
 	virtual Float computeObjectiveFunction(MatrixContainer& targets) { return criterion_->computeObjectiveFunction(network(), targets); }
 	virtual u32 nClassificationErrors(Matrix& targets) { return criterion_->nClassificationErrors(network(), targets); }
 	virtual u32 nClassificationErrors(MatrixContainer& targets) { return criterion_->nClassificationErrors(network(), targets); }
+	// same with class indices as targets
+	virtual void computeInitialErrorSignal(LabelVector& labels) { criterion_->computeInitialErrorSignal(network(), labels); }
+	virtual void computeInitialErrorSignals(LabelContainer& labels) { criterion_->computeInitialErrorSignals(network(), labels); }
+	virtual Float computeObjectiveFunction(LabelVector& labels) { return criterion_->computeObjectiveFunction(network(), labels); }
+	virtual Float computeObjectiveFunction(LabelContainer& labels) { return criterion_->computeObjectiveFunction(network(), labels); }
+	virtual u32 nClassificationErrors(LabelVector& labels) { return criterion_->nClassificationErrors(network(), labels); }
+	virtual u32 nClassificationErrors(LabelContainer& labels) { return criterion_->nClassificationErrors(network(), labels); }
+	// number of observations the targets are given for
+	static u32 nObservations(const Matrix& targets) { return targets.nColumns(); }
+	static u32 nObservations(const LabelVector& labels) { return labels.size(); }
 
 	/*
 	 * @param t the timeframe for which to do compute the error signals
@@ -90,14 +102,20 @@ class FeedForwardTrainer : public GradientBasedTrainer
 {
 private:
 	typedef GradientBasedTrainer Precursor;
+	// Targets: one-hot/real valued target matrices or class indices
+	template<typename Targets> void _processBatch(Matrix& source, Targets& targets);
+	template<typename Targets> void _processSequenceBatch(MatrixContainer& source, Targets& targets);
 public:
 	FeedForwardTrainer();
 	virtual ~FeedForwardTrainer() {}
 	virtual void initialize();
+	virtual bool supportsLabelTargets();
 	virtual void processBatch(Matrix& source, Matrix& targets);
+	virtual void processBatch(Matrix& source, LabelVector& targets);
 	// process each element of the sequence one by one but recurrency in forwarding is possible
 	// (training with truncated gradient, only current frame regarded for gradient)
-	virtual void processSequenceBatch(MatrixContainer& source, MatrixContainer& target);
+	virtual void processSequenceBatch(MatrixContainer& source, MatrixContainer& targets);
+	virtual void processSequenceBatch(MatrixContainer& source, LabelContainer& targets);
 };
 
 /*
@@ -113,12 +131,18 @@ protected:
 	u32 maxTimeHistory_;
 	bool greedyForwarding_;
 	virtual u32 requiredStatistics();
+private:
+	template<typename Targets> void _processSequenceBatch(MatrixContainer& source, Targets& targets);
+	template<typename Targets> void _processSequenceBatchWithSequenceTargets(MatrixContainer& source, Targets& targets);
 public:
 	RnnTrainer();
 	virtual ~RnnTrainer() {}
 	virtual void initialize();
+	virtual bool supportsLabelTargets();
 	virtual void processSequenceBatch(MatrixContainer& source, Matrix& targets);
 	virtual void processSequenceBatch(MatrixContainer& source, MatrixContainer& targets);
+	virtual void processSequenceBatch(MatrixContainer& source, LabelVector& targets);
+	virtual void processSequenceBatch(MatrixContainer& source, LabelContainer& targets);
 };
 
 /*
@@ -156,6 +180,8 @@ private:
 public:
 	SpecialRnnTrainer();
 	virtual ~SpecialRnnTrainer() {}
+	// the batches are rearranged as one-hot target matrices
+	virtual bool supportsLabelTargets() { return false; }
 	virtual void processSequenceBatch(MatrixContainer& source, Matrix& targets);
 	void processSequenceBatch(MatrixContainer& source, MatrixContainer& targets);
 };
@@ -49,6 +49,7 @@ BaseLayer::BaseLayer(const char* name) :
 		dropoutProbability_(Core::Configuration::config(paramDropoutProbability_, prefix_)),
 		useDropout_(dropoutProbability_ > 0),
 		nTimeframes_(0),
+		hasMergedTimeframes_(false),
 		trainingMode_(false),
 		isInitialized_(false),
 		isComputing_(false)
@@ -61,8 +62,11 @@ void BaseLayer::initialize(const std::string &basePath, const std::string& suffi
 	}
 	activations_.resize(nPorts_);
 	errorSignals_.resize(nPorts_);
-	if (useDropout_)
+	batchedActivations_.resize(nPorts_);
+	if (useDropout_) {
 		dropoutMasks_.resize(nPorts_);
+		batchedDropoutMasks_.resize(nPorts_);
+	}
 	for (u32 port = 0; port < nPorts_; port++) {
 		activations_.at(port).setMaximalMemory(maxMemory);
 		if (trainingMode_)
@@ -181,6 +185,8 @@ void BaseLayer::reset() {
 			dropoutMasks_.at(port).reset();
 	}
 	nTimeframes_ = 0;
+	timeBatchColumns_.clear();
+	hasMergedTimeframes_ = false;
 }
 
 void BaseLayer::setActivationVisibility(u32 timeframe, u32 nVisibleColumns) {
@@ -200,6 +206,52 @@ void BaseLayer::setErrorSignalVisibility(u32 timeframe, u32 nVisibleColumns) {
 	}
 }
 
+void BaseLayer::storeTimeBatch() {
+	require_eq(nTimeframes_, 1);
+	for (u32 port = 0; port < nPorts_; port++) {
+		batchedActivations_.at(port).swap(activations_.at(port).getLast());
+		if (useDropout_)
+			batchedDropoutMasks_.at(port).swap(dropoutMasks_.at(port).getLast());
+	}
+	reset();
+}
+
+void BaseLayer::addTimeframeFromBatch(u32 column, u32 nColumns) {
+	addTimeframe(nColumns);
+	for (u32 port = 0; port < nPorts_; port++) {
+		require_le(column + nColumns, batchedActivations_.at(port).nColumns());
+		activations_.at(port).getLast().copyBlockFromMatrix(batchedActivations_.at(port), 0, column, 0, 0, nInputUnits(port), nColumns);
+		if (useDropout_)
+			dropoutMasks_.at(port).getLast().copyBlockFromMatrix(batchedDropoutMasks_.at(port), 0, column, 0, 0, nInputUnits(port), nColumns);
+	}
+	timeBatchColumns_.push_back(nColumns);
+}
+
+void BaseLayer::mergeTimeframes() {
+	require_gt(nTimeframes_, 0);
+	require_eq(nTimeframes_, timeBatchColumns_.size());
+	// all timeframes need to be memorized, otherwise the batch is not complete
+	require_le(nTimeframes_, activations_.at(0).maxMemory());
+	std::vector<u32> timeBatchColumns(timeBatchColumns_);
+	reset();
+	for (u32 port = 0; port < nPorts_; port++) {
+		u32 nColumns = batchedActivations_.at(port).nColumns();
+		activations_.at(port).addTimeframe(nInputUnits(port), 0);
+		activations_.at(port).getLast().swap(batchedActivations_.at(port));
+		if (trainingMode_) {
+			errorSignals_.at(port).addTimeframe(nInputUnits(port), nColumns);
+			errorSignals_.at(port).getLast().setToZero();
+		}
+		if (useDropout_) {
+			dropoutMasks_.at(port).addTimeframe(nInputUnits(port), 0);
+			dropoutMasks_.at(port).getLast().swap(batchedDropoutMasks_.at(port));
+		}
+	}
+	nTimeframes_ = 1;
+	timeBatchColumns_.swap(timeBatchColumns);
+	hasMergedTimeframes_ = true;
+}
+
 void BaseLayer::dropout() {
 	u32 t = nTimeframes() - 1;
 	if (useDropout_) {
@@ -222,6 +274,11 @@ void BaseLayer::initComputation(bool sync) {
 		if (useDropout_)
 			dropoutMasks_.at(port).initComputation(sync);
 	}
+	for (u32 port = 0; port < batchedActivations_.size(); port++) {
+		batchedActivations_.at(port).initComputation(sync);
+		if (useDropout_)
+			batchedDropoutMasks_.at(port).initComputation(sync);
+	}
 	isComputing_ = true;
 }
 
@@ -235,6 +292,11 @@ void BaseLayer::finishComputation(bool sync) {
 		if (useDropout_)
 			dropoutMasks_.at(port).finishComputation(sync);
 	}
+	for (u32 port = 0; port < batchedActivations_.size(); port++) {
+		batchedActivations_.at(port).finishComputation(sync);
+		if (useDropout_)
+			batchedDropoutMasks_.at(port).finishComputation(sync);
+	}
 	isComputing_ = false;
 }
 
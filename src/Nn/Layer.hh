@@ -63,6 +63,12 @@ protected:
 	std::vector<MatrixContainer> errorSignals_;	// the error signals of the layer (only used in training), one container for each port
 	std::vector<MatrixContainer> dropoutMasks_;  // store binary masks if dropout is used
 
+	// time-batched forwarding (see NeuralNetwork::forwardSequence)
+	std::vector<Matrix> batchedActivations_;	// activations of all timeframes in a single matrix, one for each port
+	std::vector<Matrix> batchedDropoutMasks_;
+	std::vector<u32> timeBatchColumns_;			// number of columns of each timeframe in the batch
+	bool hasMergedTimeframes_;
+
 	bool trainingMode_;
 	bool isInitialized_;
 	bool isComputing_;			// are the layer matrices/vectors in computing state?
@@ -138,6 +144,16 @@ public:
 	virtual void setActivationVisibility(u32 timeframe, u32 nVisibleColumns);
 	virtual void setErrorSignalVisibility(u32 timeframe, u32 nVisibleColumns);
 
+	/* time-batched forwarding: all timeframes are forwarded at once in a single (wide) timeframe */
+	// move the activations of the single timeframe to the batch and reset the layer
+	virtual void storeTimeBatch();
+	// add a timeframe that contains nColumns columns of the batch, starting at column
+	virtual void addTimeframeFromBatch(u32 column, u32 nColumns);
+	// replace all timeframes by the single timeframe of the batch (error signals are reset to zero)
+	virtual void mergeTimeframes();
+	virtual bool hasMergedTimeframes() const { return hasMergedTimeframes_; }
+	virtual const std::vector<u32>& timeBatchColumns() const { return timeBatchColumns_; }
+
 	virtual bool isInitialized() const { return isInitialized_; }
 
 	virtual bool useDropout() const { return useDropout_; }
@@ -21,6 +21,7 @@
  *      Author: richard
  */
 
+#include <algorithm>
 #include "MatrixContainer.hh"
 
 using namespace Nn;
@@ -116,7 +117,7 @@ void MatrixContainer::reset() {
 	nTimeframes_ = 0;
 }
 
-void MatrixContainer::addTimeframe(u32 nRows, u32 nColumns) {
+void MatrixContainer::_appendTimeframe() {
 	require(maxMemory_ > 0);
 	nTimeframes_++;
 	if (nTimeframes_ > maxMemory_) {
@@ -125,9 +126,18 @@ void MatrixContainer::addTimeframe(u32 nRows, u32 nColumns) {
 			container_.at(i)->swap(*(container_.at(i-1)));
 		}
 	}
+}
+
+void MatrixContainer::addTimeframe(u32 nRows, u32 nColumns) {
+	_appendTimeframe();
 	getLast().resize(nRows, nColumns);
 }
 
+void MatrixContainer::addTimeframe(Float* data, u32 nRows, u32 nColumns) {
+	_appendTimeframe();
+	getLast().useExternalMemory(data, nRows, nColumns);
+}
+
 void MatrixContainer::_revert(std::vector<Matrix*>& mat, u32 startColumn, u32 endColumn) {
 	Matrix tmp;
 	tmp.initComputation();
@@ -175,3 +185,62 @@ void MatrixContainer::finishComputation(bool sync) {
 	}
 	isComputing_ = false;
 }
+
+/*
+ * LabelContainer
+ */
+LabelContainer::LabelContainer() :
+		nTimeframes_(0),
+		isComputing_(false)
+{}
+
+LabelContainer::~LabelContainer() {
+	for (u32 i = 0; i < container_.size(); i++)
+		delete container_.at(i);
+}
+
+LabelVector& LabelContainer::at(u32 timeframe) {
+	require_lt(timeframe, nTimeframes_);
+	return *(container_.at(timeframe));
+}
+
+const LabelVector& LabelContainer::at(u32 timeframe) const {
+	require_lt(timeframe, nTimeframes_);
+	return *(container_.at(timeframe));
+}
+
+LabelVector& LabelContainer::getLast() {
+	require_gt(nTimeframes_, 0);
+	return at(nTimeframes_ - 1);
+}
+
+const LabelVector& LabelContainer::getLast() const {
+	require_gt(nTimeframes_, 0);
+	return at(nTimeframes_ - 1);
+}
+
+void LabelContainer::reset() {
+	nTimeframes_ = 0;
+}
+
+void LabelContainer::addTimeframe(const u32* labels, u32 nLabels) {
+	require(!isComputing_);
+	if (nTimeframes_ == container_.size())
+		container_.push_back(new LabelVector);
+	LabelVector& v = *(container_.at(nTimeframes_));
+	v.resize(nLabels);
+	std::copy(labels, labels + nLabels, v.begin());
+	nTimeframes_++;
+}
+
+void LabelContainer::initComputation(bool sync) {
+	for (u32 t = 0; t < container_.size(); t++)
+		container_.at(t)->initComputation(sync);
+	isComputing_ = true;
+}
+
+void LabelContainer::finishComputation(bool sync) {
+	for (u32 t = 0; t < container_.size(); t++)
+		container_.at(t)->finishComputation(sync);
+	isComputing_ = false;
+}
@@ -42,6 +42,7 @@ private:
 	bool isComputing_;
 private:
 	void _revert(std::vector<Matrix*>& mat, u32 startColumn, u32 endColumn);
+	void _appendTimeframe();
 public:
 	MatrixContainer();
 	virtual ~MatrixContainer();
@@ -65,6 +66,8 @@ public:
 	void reset();
 
 	void addTimeframe(u32 nRows = 0, u32 nColumns = 0);
+	// CPU only: add a time frame that is a view on the given host memory (see CudaMatrix::useExternalMemory)
+	void addTimeframe(Float* data, u32 nRows, u32 nColumns);
 
 	// revert temporal order in matrices
 	// requires all rows to be of same size and nColumns(t) <= nColumns(t+1)
@@ -75,6 +78,34 @@ public:
 	void finishComputation(bool sync = true);
 };
 
+/*
+ * container for the label targets of a sequence mini-batch (one label vector per time frame)
+ */
+class LabelContainer
+{
+private:
+	std::vector<LabelVector*> container_;	// label vectors are kept and reused for subsequent batches
+	u32 nTimeframes_;
+	bool isComputing_;
+public:
+	LabelContainer();
+	virtual ~LabelContainer();
+
+	u32 nTimeframes() const { return nTimeframes_; }
+	LabelVector& at(u32 timeframe);
+	const LabelVector& at(u32 timeframe) const;
+	LabelVector& getLast();
+	const LabelVector& getLast() const;
+	void reset();
+
+	// append a time frame with a copy of the given labels
+	void addTimeframe(const u32* labels, u32 nLabels);
+
+	bool isComputing() const { return isComputing_; }
+	void initComputation(bool sync = true);
+	void finishComputation(bool sync = true);
+};
+
 } // namespace
 
 #endif /* NN_MATRIXCONTAINER_HH_ */
@@ -25,6 +25,7 @@
 #include "Types.hh"
 #include "MatrixContainer.hh"
 #include "MinibatchGenerator.hh"
+#include "DataParallel.hh"
 
 using namespace Nn;
 
@@ -32,19 +33,50 @@ const Core::ParameterEnum MinibatchGenerator::paramSourceType_("source-type", "s
 
 const Core::ParameterEnum MinibatchGenerator::paramTargetType_("target-type", "single, sequence", "single", "");
 
+// number of mini-batches that are generated in a background thread in advance (0: no prefetching)
+const Core::ParameterInt MinibatchGenerator::paramPrefetchQueueDepth_("prefetch-queue-depth", 0, "");
+
+// maximal number of frames (maximal sequence length times number of sequences) of a sequence mini-batch
+// if > 0, the batch size is an upper bound and each mini-batch contains as many sequences as fit into the budget
+const Core::ParameterInt MinibatchGenerator::paramMaxBatchFrames_("max-batch-frames", 0, "");
+
 MinibatchGenerator::MinibatchGenerator(TrainingMode trainingMode) :
 		sourceType_((FeatureType) Core::Configuration::config(paramSourceType_)),
 		targetType_((FeatureType) Core::Configuration::config(paramTargetType_)),
 		trainingMode_(trainingMode),
 		featureReader_(0),
+		hasLabelTargets_(false),
+		areTargetsExpanded_(false),
+		publishedBatch_(0),
 		sourceDimension_(0),
 		targetDimension_(0),
 		featureTransformation_(sourceType_),
 		isInitialized_(false),
-		generatedBatch_(false)
+		generatedBatch_(false),
+		batchSize_(0),
+		maxBatchFrames_(Core::Configuration::config(paramMaxBatchFrames_)),
+		nFrames_(0),
+		nPaddedFrames_(0),
+		isStagingInPlace_(false),
+		prefetchQueueDepth_(Core::Configuration::config(paramPrefetchQueueDepth_)),
+		nRequestedBatches_(0),
+		nPrefetchedBatches_(0),
+		nConsumedBatches_(0),
+		terminatePrefetching_(false),
+		isPrefetching_(false)
 {}
 
 MinibatchGenerator::~MinibatchGenerator() {
+	if (isPrefetching_) {
+		pthread_mutex_lock(&mutex_);
+		terminatePrefetching_ = true;
+		pthread_cond_signal(&batchRequested_);
+		pthread_mutex_unlock(&mutex_);
+		pthread_join(prefetchThread_, 0);
+		pthread_cond_destroy(&batchRequested_);
+		pthread_cond_destroy(&batchPrefetched_);
+		pthread_mutex_destroy(&mutex_);
+	}
 	if (featureReader_)
 		delete featureReader_;
 }
@@ -67,124 +99,333 @@ void MinibatchGenerator::initialize() {
 
 		featureReader_->initialize();
 		sourceDimension_ = featureReader_->featureDimension();
-		if ((trainingMode_ == supervised) && (sourceType_ == single) && (targetType_ == single))
+		if ((trainingMode_ == supervised) && (sourceType_ == single) && (targetType_ == single)) {
 			targetDimension_ = dynamic_cast< Features::AlignedFeatureReader* >(featureReader_)->targetDimension();
-		else if ((trainingMode_ == supervised) && (sourceType_ == sequence) && (targetType_ == single))
+			hasLabelTargets_ = dynamic_cast< Features::AlignedFeatureReader* >(featureReader_)->hasLabelTargets();
+		}
+		else if ((trainingMode_ == supervised) && (sourceType_ == sequence) && (targetType_ == single)) {
 			targetDimension_ = dynamic_cast< Features::AlignedSequenceFeatureReader* >(featureReader_)->targetDimension();
-		else if ((trainingMode_ == supervised) && (sourceType_ == sequence) && (targetType_ == sequence))
+			hasLabelTargets_ = dynamic_cast< Features::AlignedSequenceFeatureReader* >(featureReader_)->hasLabelTargets();
+		}
+		else if ((trainingMode_ == supervised) && (sourceType_ == sequence) && (targetType_ == sequence)) {
 			targetDimension_ = dynamic_cast< Features::TemporallyAlignedSequenceFeatureReader* >(featureReader_)->targetDimension();
+			hasLabelTargets_ = dynamic_cast< Features::TemporallyAlignedSequenceFeatureReader* >(featureReader_)->hasLabelTargets();
+		}
+
+		// with a frame budget, the workers would process different numbers of mini-batches
+		if ((maxBatchFrames_ > 0) && (DataParallel::nWorkers() > 1))
+			Core::Error::msg("MinibatchGenerator: max-batch-frames can not be used for data parallel training.") << Core::Error::abort;
+
+		// on the CPU, the network directly processes the staged batches, so no batch is copied
+		isStagingInPlace_ = !Math::CudaDataStructure::hasGpu();
+
+		// start the prefetching thread (from now on only this thread accesses the feature reader)
+		batches_.resize(prefetchQueueDepth_ > 0 ? prefetchQueueDepth_ + 1 : 1);
+		if (prefetchQueueDepth_ > 0) {
+			Core::Log::openTag("minibatch-generator");
+			Core::Log::os("Prefetch up to ") << prefetchQueueDepth_ << " mini-batches in a background thread.";
+			Core::Log::closeTag();
+			pthread_mutex_init(&mutex_, 0);
+			pthread_cond_init(&batchRequested_, 0);
+			pthread_cond_init(&batchPrefetched_, 0);
+			if (pthread_create(&prefetchThread_, 0, prefetchThread, this) != 0)
+				Core::Error::msg("MinibatchGenerator::initialize: failed to start prefetching thread.") << Core::Error::abort;
+			isPrefetching_ = true;
+		}
 		isInitialized_ = true;
 	}
 }
 
-void MinibatchGenerator::read(std::vector< Math::Matrix<Float> >& source, std::vector< Math::Matrix<Float> >& target) {
+void MinibatchGenerator::read(Batch& batch, u32 index, u32 offset) {
+	bool hasSingleTargets = (trainingMode_ == supervised) && (targetType_ == single);
+	bool hasSequenceTargets = (trainingMode_ == supervised) && (targetType_ == sequence);
 
-	/* read source */
+	/* single source: write source and target directly into column index of the batch */
 	if (sourceType_ == single) {
-		source.push_back(Math::Matrix<Float>(sourceDimension_, 1));
-		source.back().copy(dynamic_cast< Features::FeatureReader* >(featureReader_)->next().begin());
+		const Math::Vector<Float>& source = dynamic_cast< Features::FeatureReader* >(featureReader_)->next();
+		std::copy(source.begin(), source.end(), batch.source.begin() + (u64)index * sourceDimension_);
+		if (hasSingleTargets && hasLabelTargets_) {
+			batch.labels.at(index) = dynamic_cast< Features::AlignedFeatureReader* >(featureReader_)->label();
+		}
+		else if (hasSingleTargets) {
+			const Math::Vector<Float>& target = dynamic_cast< Features::AlignedFeatureReader* >(featureReader_)->target();
+			std::copy(target.begin(), target.end(), batch.target.begin() + (u64)index * targetDimension_);
+		}
 	}
+	/* sequence source: append the sequence to the staged sequences (starting at frame offset) */
 	else {
-		const Math::Matrix<Float>& tmp = dynamic_cast< Features::SequenceFeatureReader* >(featureReader_)->next();
-		source.push_back(Math::Matrix<Float>(sourceDimension_, tmp.nColumns()));
-		source.back().copy(tmp.begin());
+		const Math::Matrix<Float>& source = dynamic_cast< Features::SequenceFeatureReader* >(featureReader_)->next();
+		batch.sequenceLengths.at(index) = source.nColumns();
+		batch.sequenceOffsets.at(index) = offset;
+		batch.sourceSequences.resize((u64)(offset + source.nColumns()) * sourceDimension_);
+		std::copy(source.begin(), source.end(), batch.sourceSequences.begin() + (u64)offset * sourceDimension_);
+		if (hasSingleTargets && hasLabelTargets_) {
+			batch.labelSequences.at(index) = dynamic_cast< Features::AlignedSequenceFeatureReader* >(featureReader_)->label();
+		}
+		else if (hasSingleTargets) {
+			const Math::Vector<Float>& target = dynamic_cast< Features::AlignedSequenceFeatureReader* >(featureReader_)->target();
+			std::copy(target.begin(), target.end(), batch.targetSequences.begin() + (u64)index * targetDimension_);
+		}
+		else if (hasSequenceTargets && hasLabelTargets_) {
+			const std::vector<u32>& labels = dynamic_cast< Features::TemporallyAlignedSequenceFeatureReader* >(featureReader_)->labelSequence();
+			require_eq(labels.size(), source.nColumns());
+			batch.labelSequences.resize(offset + labels.size());
+			std::copy(labels.begin(), labels.end(), batch.labelSequences.begin() + offset);
+		}
+		else if (hasSequenceTargets) {
+			// source and target sequence have same length
+			const Math::Matrix<Float>& target = dynamic_cast< Features::TemporallyAlignedSequenceFeatureReader* >(featureReader_)->target();
+			require_eq(target.nColumns(), source.nColumns());
+			batch.targetSequences.resize((u64)(offset + target.nColumns()) * targetDimension_);
+			std::copy(target.begin(), target.end(), batch.targetSequences.begin() + (u64)offset * targetDimension_);
+		}
 	}
+}
+
+void MinibatchGenerator::fillBatch(Batch& batch) {
+	// throw error message if no features were requested
+	if (batch.requestedBatchSize == 0)
+		Core::Error::msg("MinibatchGenerator::generateBatch: feature reader has no observations left to fill a minibatch.") << Core::Error::abort;
 
-	/* read target */
-	// (a) single targets
-	if ((trainingMode_ == supervised) && (targetType_ == single)) {
-		target.push_back(Math::Matrix<Float>(targetDimension_, 1));
-		target.back().setToZero();
-		if (sourceType_ == single)
-			target.back().copy(dynamic_cast< Features::AlignedFeatureReader* >(featureReader_)->target().begin());
-		else if (sourceType_ == sequence)
-			target.back().copy(dynamic_cast< Features::AlignedSequenceFeatureReader* >(featureReader_)->target().begin());
+	bool hasSingleTargets = (trainingMode_ == supervised) && (targetType_ == single);
+	if (sourceType_ == single) {
+		batch.source.resize((u64)sourceDimension_ * batch.requestedBatchSize);
+		if (hasSingleTargets && hasLabelTargets_)
+			batch.labels.resize(batch.requestedBatchSize);
+		else if (hasSingleTargets)
+			batch.target.resize((u64)targetDimension_ * batch.requestedBatchSize);
 	}
-	// (b) sequence targets
-	else if ((trainingMode_ == supervised) && (targetType_ == sequence)) {
-		target.push_back(Math::Matrix<Float>(targetDimension_, source.back().nColumns())); // source and target sequence have same length
-		target.back().copy(dynamic_cast< Features::TemporallyAlignedSequenceFeatureReader* >(featureReader_)->target());
+	else {
+		batch.sequenceLengths.resize(batch.requestedBatchSize);
+		batch.sequenceOffsets.resize(batch.requestedBatchSize);
+		batch.sourceSequences.clear();
+		batch.targetSequences.clear();
+		batch.labelSequences.clear();
+		if (hasSingleTargets && hasLabelTargets_)
+			batch.labelSequences.resize(batch.requestedBatchSize);
+		else if (hasSingleTargets)
+			batch.targetSequences.resize((u64)targetDimension_ * batch.requestedBatchSize);
 	}
-}
-
-void MinibatchGenerator::generateSingleBatch(const std::vector< Math::Matrix<Float> >& source, const std::vector< Math::Matrix<Float> >& target) {
-	// copy source features
-	sourceBatch_.resize(sourceDimension_, source.size());
-	for (u32 i = 0; i < source.size(); i++) {
-		for (u32 d = 0; d < sourceDimension_; d++) {
-			sourceBatch_.at(d, i) = source.at(i).at(d, 0);
+	batch.batchSize = batch.requestedBatchSize;
+	u32 maxSequenceLength = 0;
+	u32 nStagedFrames = 0;
+	for (u32 i = 0; i < batch.requestedBatchSize; i++) {
+		if ((sourceType_ == single) && (!dynamic_cast< Features::FeatureReader* >(featureReader_)->hasFeatures()))
+			featureReader_->newEpoch();
+		else if ((sourceType_ == sequence) && (!dynamic_cast< Features::SequenceFeatureReader* >(featureReader_)->hasSequences()))
+			featureReader_->newEpoch();
+		// stop if the next sequence exceeds the frame budget (the first sequence is always added)
+		if ((sourceType_ == sequence) && (maxBatchFrames_ > 0) && (i > 0)) {
+			u32 length = std::max(maxSequenceLength, dynamic_cast< Features::SequenceFeatureReader* >(featureReader_)->nextSequenceLength());
+			if (length * (i + 1) > maxBatchFrames_) {
+				batch.batchSize = i;
+				break;
+			}
 		}
-	}
-	// copy target features
-	targetBatch_.resize(targetDimension_, target.size());
-	for (u32 i = 0; i < target.size(); i++) {
-		for (u32 d = 0; d < targetDimension_; d++) {
-			targetBatch_.at(d, i) = target.at(i).at(d, 0);
+		read(batch, i, nStagedFrames);
+		if (sourceType_ == sequence) {
+			nStagedFrames += batch.sequenceLengths.at(i);
+			maxSequenceLength = std::max(maxSequenceLength, batch.sequenceLengths.at(i));
 		}
 	}
+
+	if (sourceType_ == sequence)
+		generateSequenceBatch(batch);
 }
 
-void MinibatchGenerator::generateSequenceBatch(const std::vector< Math::Matrix<Float> >& source, const std::vector< Math::Matrix<Float> >& target) {
+void MinibatchGenerator::generateSequenceBatch(Batch& batch) {
 	// sort source and target sequences from long to short
 	std::vector< std::pair<u32, u32> > lengthsAndIndices;
-	for (u32 i = 0; i < source.size(); i++)
-		lengthsAndIndices.push_back(std::make_pair(source.at(i).nColumns(), i));
+	for (u32 i = 0; i < batch.batchSize; i++)
+		lengthsAndIndices.push_back(std::make_pair(batch.sequenceLengths.at(i), i));
 	std::stable_sort(lengthsAndIndices.begin(), lengthsAndIndices.end(), compare);
-	order_.clear();
+	batch.order.clear();
 	for (u32 i = 0; i < lengthsAndIndices.size(); i++)
-		order_.push_back(lengthsAndIndices.at(i).second);
+		batch.order.push_back(lengthsAndIndices.at(i).second);
 
 	// how many sequences are active (started) at time frame t?
-	u32 maxSequenceLength = source.at(order_.at(0)).nColumns();
-	std::vector<u32> nStartedSequences(maxSequenceLength, 0);
+	u32 maxSequenceLength = batch.sequenceLengths.at(batch.order.at(0));
+	batch.nFrames = 0;
+	for (u32 i = 0; i < batch.batchSize; i++)
+		batch.nFrames += batch.sequenceLengths.at(i);
+	batch.nPaddedFrames = maxSequenceLength * batch.batchSize;
+	batch.nStartedSequences.assign(maxSequenceLength, 0);
 	u32 i = 0;
 	for (u32 t = 0; t < maxSequenceLength; t++) {
 		if (t > 0)
-			nStartedSequences.at(t) = nStartedSequences.at(t - 1);
-		while ( (i < source.size()) && (maxSequenceLength - source.at(order_.at(i)).nColumns() == t) ) {
-			nStartedSequences.at(t)++;
+			batch.nStartedSequences.at(t) = batch.nStartedSequences.at(t - 1);
+		while ( (i < batch.batchSize) && (maxSequenceLength - batch.sequenceLengths.at(batch.order.at(i)) == t) ) {
+			batch.nStartedSequences.at(t)++;
 			i++;
 		}
 	}
 
-	// add all time frames to the actual sequence source/target batch (note that the sequences are ordered!)
-	sourceSequenceBatch_.reset();
-	sourceSequenceBatch_.setMaximalMemory(maxSequenceLength);
-	if ((trainingMode_ == supervised) && (targetType_ == sequence)) {
-		targetSequenceBatch_.reset();
-		targetSequenceBatch_.setMaximalMemory(maxSequenceLength);
-	}
+	// write all time frames one after another into the batch (note that the sequences are ordered!)
+	bool hasSequenceTargets = (trainingMode_ == supervised) && (targetType_ == sequence);
+	batch.source.resize((u64)batch.nFrames * sourceDimension_);
+	if (hasSequenceTargets && hasLabelTargets_)
+		batch.labels.resize(batch.nFrames);
+	else if (hasSequenceTargets)
+		batch.target.resize((u64)batch.nFrames * targetDimension_);
+	u32 column = 0;
 	for (u32 t = 0; t < maxSequenceLength; t++) {
-		sourceSequenceBatch_.addTimeframe(sourceDimension_, nStartedSequences.at(t));
-		if ((trainingMode_ == supervised) && (targetType_ == sequence))
-			targetSequenceBatch_.addTimeframe(targetDimension_, nStartedSequences.at(t));
-		for (u32 i = 0; i < nStartedSequences.at(t); i++) {
-#pragma omp parallel for
-			for (u32 d = 0; d < sourceDimension_; d++) {
-				u32 offset = maxSequenceLength - source.at(order_.at(i)).nColumns();
-				sourceSequenceBatch_.getLast().at(d, i) = source.at(order_.at(i)).at(d, t - offset);
+		for (u32 i = 0; i < batch.nStartedSequences.at(t); i++) {
+			u32 index = batch.order.at(i);
+			u32 frame = batch.sequenceOffsets.at(index) + t - (maxSequenceLength - batch.sequenceLengths.at(index));
+			std::vector<Float>::const_iterator s = batch.sourceSequences.begin() + (u64)frame * sourceDimension_;
+			std::copy(s, s + sourceDimension_, batch.source.begin() + (u64)column * sourceDimension_);
+			if (hasSequenceTargets && hasLabelTargets_) {
+				batch.labels.at(column) = batch.labelSequences.at(frame);
 			}
-			if ((trainingMode_ == supervised) && (targetType_ == sequence)) {
-#pragma omp parallel for
-				for (u32 d = 0; d < targetDimension_; d++) {
-					u32 offset = maxSequenceLength - target.at(order_.at(i)).nColumns();
-					targetSequenceBatch_.getLast().at(d, i) = target.at(order_.at(i)).at(d, t - offset);
-				}
+			else if (hasSequenceTargets) {
+				std::vector<Float>::const_iterator g = batch.targetSequences.begin() + (u64)frame * targetDimension_;
+				std::copy(g, g + targetDimension_, batch.target.begin() + (u64)column * targetDimension_);
 			}
+			column++;
 		}
 	}
 
-	// if targets are not sequences, add them to targetBatch_
-	if ((trainingMode_ == supervised) && (targetType_ == single)) {
-		targetBatch_.resize(targetDimension_, target.size());
-		for (u32 i = 0; i < target.size(); i++) {
-			for (u32 d = 0; d < targetDimension_; d++) {
-				targetBatch_.at(d, i) = target.at(order_.at(i)).at(d, 0);
-			}
+	// if targets are not sequences, add them to the single target batch
+	if ((trainingMode_ == supervised) && (targetType_ == single) && hasLabelTargets_) {
+		batch.labels.resize(batch.batchSize);
+		for (u32 i = 0; i < batch.batchSize; i++)
+			batch.labels.at(i) = batch.labelSequences.at(batch.order.at(i));
+	}
+	else if ((trainingMode_ == supervised) && (targetType_ == single)) {
+		batch.target.resize((u64)targetDimension_ * batch.batchSize);
+		for (u32 i = 0; i < batch.batchSize; i++) {
+			std::vector<Float>::const_iterator g = batch.targetSequences.begin() + (u64)batch.order.at(i) * targetDimension_;
+			std::copy(g, g + targetDimension_, batch.target.begin() + (u64)i * targetDimension_);
 		}
 	}
 }
 
+void MinibatchGenerator::publishMatrix(Float* data, u32 nRows, u32 nColumns, Matrix& matrix) {
+	if (isStagingInPlace_) {
+		matrix.useExternalMemory(data, nRows, nColumns);
+	}
+	else {
+		matrix.resize(nRows, nColumns);
+		matrix.copy(data);
+	}
+}
+
+void MinibatchGenerator::publishTimeframe(Float* data, u32 nRows, u32 nColumns, MatrixContainer& container) {
+	if (isStagingInPlace_) {
+		container.addTimeframe(data, nRows, nColumns);
+	}
+	else {
+		container.addTimeframe(nRows, nColumns);
+		container.getLast().copy(data);
+	}
+}
+
+void MinibatchGenerator::publishBatch(Batch& batch) {
+	if (sourceType_ == single) {
+		publishMatrix(&(batch.source[0]), sourceDimension_, batch.batchSize, sourceBatch_);
+	}
+	else {
+		u32 nTimeframes = batch.nStartedSequences.size();
+		bool hasSequenceTargets = (trainingMode_ == supervised) && (targetType_ == sequence);
+		sourceSequenceBatch_.reset();
+		sourceSequenceBatch_.setMaximalMemory(nTimeframes);
+		if (hasSequenceTargets && hasLabelTargets_) {
+			targetLabelSequence_.reset();
+		}
+		else if (hasSequenceTargets) {
+			targetSequenceBatch_.reset();
+			targetSequenceBatch_.setMaximalMemory(nTimeframes);
+		}
+		u32 column = 0;
+		for (u32 t = 0; t < nTimeframes; t++) {
+			publishTimeframe(&(batch.source[(u64)column * sourceDimension_]), sourceDimension_, batch.nStartedSequences.at(t), sourceSequenceBatch_);
+			if (hasSequenceTargets && hasLabelTargets_)
+				targetLabelSequence_.addTimeframe(&(batch.labels[column]), batch.nStartedSequences.at(t));
+			else if (hasSequenceTargets)
+				publishTimeframe(&(batch.target[(u64)column * targetDimension_]), targetDimension_, batch.nStartedSequences.at(t), targetSequenceBatch_);
+			column += batch.nStartedSequences.at(t);
+		}
+		order_ = batch.order;
+		nFrames_ += batch.nFrames;
+		nPaddedFrames_ += batch.nPaddedFrames;
+	}
+	batchSize_ = batch.batchSize;
+	if ((trainingMode_ == supervised) && (targetType_ == single) && hasLabelTargets_) {
+		targetLabels_.resize(batch.batchSize);
+		std::copy(batch.labels.begin(), batch.labels.begin() + batch.batchSize, targetLabels_.begin());
+	}
+	else if ((trainingMode_ == supervised) && (targetType_ == single)) {
+		publishMatrix(&(batch.target[0]), targetDimension_, batch.batchSize, targetBatch_);
+	}
+	publishedBatch_ = &batch;
+	areTargetsExpanded_ = false;
+}
+
+void MinibatchGenerator::expandLabels(const u32* labels, u32 nColumns, Matrix& targets) {
+	targets.resize(targetDimension_, nColumns);
+	targets.setToZero();
+	for (u32 i = 0; i < nColumns; i++)
+		targets.at(labels[i], i) = 1.0;
+}
+
+void MinibatchGenerator::expandTargets() {
+	// the published batch is not refilled before the next batch is generated
+	require(publishedBatch_);
+	const Batch& batch = *publishedBatch_;
+	if (targetType_ == single) {
+		targetBatch_.finishComputation(false);
+		expandLabels(&(batch.labels[0]), batch.batchSize, targetBatch_);
+	}
+	else {
+		u32 nTimeframes = batch.nStartedSequences.size();
+		targetSequenceBatch_.finishComputation(false);
+		targetSequenceBatch_.reset();
+		targetSequenceBatch_.setMaximalMemory(nTimeframes);
+		u32 column = 0;
+		for (u32 t = 0; t < nTimeframes; t++) {
+			targetSequenceBatch_.addTimeframe();
+			expandLabels(&(batch.labels[column]), batch.nStartedSequences.at(t), targetSequenceBatch_.getLast());
+			column += batch.nStartedSequences.at(t);
+		}
+	}
+	areTargetsExpanded_ = true;
+}
+
+void* MinibatchGenerator::prefetchThread(void* generator) {
+	static_cast<MinibatchGenerator*>(generator)->prefetch();
+	return 0;
+}
+
+void MinibatchGenerator::prefetch() {
+	// the feature reader may log (e.g. on a new epoch), but Core::Log must only be used by the main thread
+	Core::Log::mute(true);
+	pthread_mutex_lock(&mutex_);
+	while (true) {
+		while ((nPrefetchedBatches_ == nRequestedBatches_) && (!terminatePrefetching_))
+			pthread_cond_wait(&batchRequested_, &mutex_);
+		if (terminatePrefetching_)
+			break;
+		// the requested batch is not accessed by the main thread until it is marked as prefetched
+		Batch& batch = batches_.at(nPrefetchedBatches_ % batches_.size());
+		pthread_mutex_unlock(&mutex_);
+		fillBatch(batch);
+		pthread_mutex_lock(&mutex_);
+		nPrefetchedBatches_++;
+		pthread_cond_signal(&batchPrefetched_);
+	}
+	pthread_mutex_unlock(&mutex_);
+}
+
+void MinibatchGenerator::requestBatch(u32 batchSize) {
+	require(isPrefetching_);
+	require_lt(nRequestedBatches(), prefetchQueueDepth_);
+	pthread_mutex_lock(&mutex_);
+	batches_.at(nRequestedBatches_ % batches_.size()).requestedBatchSize = batchSize;
+	nRequestedBatches_++;
+	pthread_cond_signal(&batchRequested_);
+	pthread_mutex_unlock(&mutex_);
+}
+
 void MinibatchGenerator::generateBatch(u32 batchSize) {
 	require(isInitialized_);
 	// make sure none of the containers is in computing state
@@ -192,34 +433,34 @@ void MinibatchGenerator::generateBatch(u32 batchSize) {
 	targetBatch_.finishComputation(false);
 	sourceSequenceBatch_.finishComputation(false);
 	targetSequenceBatch_.finishComputation(false);
+	targetLabels_.finishComputation(false);
+	targetLabelSequence_.finishComputation(false);
 
-	std::vector< Math::Matrix<Float> > source, target;
-	if (sourceType_ == single) {
-		Features::FeatureReader* fr = dynamic_cast< Features::FeatureReader* >(featureReader_);
-		for (u32 i = 0; i < batchSize; i++) {
-			if (!fr->hasFeatures())
-				fr->newEpoch();
-			read(source, target);
-		}
+	if (isPrefetching_) {
+		if (nRequestedBatches() == 0)
+			requestBatch(batchSize);
+		// wait for the oldest requested batch
+		pthread_mutex_lock(&mutex_);
+		while (nPrefetchedBatches_ == nConsumedBatches_)
+			pthread_cond_wait(&batchPrefetched_, &mutex_);
+		pthread_mutex_unlock(&mutex_);
+		// the batch stays published (and is not refilled) until the next batch is generated
+		Batch& batch = batches_.at(nConsumedBatches_ % batches_.size());
+		// with a frame budget, the prefetched batch may be smaller than the requested one, but never larger
+		if ((batch.requestedBatchSize > batchSize) || ((maxBatchFrames_ == 0) && (batch.requestedBatchSize != batchSize)))
+			Core::Error::msg("MinibatchGenerator::generateBatch: requested batch size ") << batchSize
+				<< " does not match size of prefetched batch (" << batch.requestedBatchSize << ")." << Core::Error::abort;
+		publishBatch(batch);
+		pthread_mutex_lock(&mutex_);
+		nConsumedBatches_++;
+		pthread_mutex_unlock(&mutex_);
 	}
 	else {
-		Features::SequenceFeatureReader* fr = dynamic_cast< Features::SequenceFeatureReader* >(featureReader_);
-		for (u32 i = 0; i < batchSize; i++) {
-			if (!fr->hasSequences())
-				fr->newEpoch();
-			read(source, target);
-		}
+		batches_.at(0).requestedBatchSize = batchSize;
+		fillBatch(batches_.at(0));
+		publishBatch(batches_.at(0));
 	}
 
-	// throw error message if no features were available
-	if (source.size() == 0)
-		Core::Error::msg("MinibatchGenerator::generateBatch: feature reader has no observations left to fill a minibatch.") << Core::Error::abort;
-
-	if (sourceType_ == single)
-		generateSingleBatch(source, target);
-	else
-		generateSequenceBatch(source, target);
-
 	// apply feature transformation depending on the type
 	if ((sourceType_ == single) && (featureTransformation_.outputFormat() == sequence))
 		featureTransformation_.transform(sourceBatch_, sourceSequenceBatch_);
@@ -229,6 +470,24 @@ void MinibatchGenerator::generateBatch(u32 batchSize) {
 	generatedBatch_ = true;
 }
 
+void MinibatchGenerator::logPaddingEfficiency() {
+	if (nPaddedFrames_ > 0) {
+		Core::Log::os("Padding efficiency (fraction of non-padded frames in the sequence mini-batches): ")
+				<< (Float)nFrames_ / nPaddedFrames_ << " (" << nFrames_ << " of " << nPaddedFrames_ << " frames).";
+	}
+	nFrames_ = 0;
+	nPaddedFrames_ = 0;
+}
+
+void MinibatchGenerator::setTargetLabels(const std::vector<u32>& labels) {
+	require(isInitialized_);
+	if (!hasLabelTargets_ || (sourceType_ != single) || (targetType_ != single))
+		Core::Error::msg("MinibatchGenerator::setTargetLabels: only possible for single source and target type with a label target cache.") << Core::Error::abort;
+	// all requested batches have been consumed, so the prefetching thread does not access the feature reader
+	require_eq(nRequestedBatches(), 0);
+	dynamic_cast< Features::AlignedFeatureReader* >(featureReader_)->setTargetLabels(labels);
+}
+
 u32 MinibatchGenerator::totalNumberOfFeatures() const {
 	require(isInitialized_);
 	return featureReader_->totalNumberOfFeatures();
@@ -255,9 +514,20 @@ Matrix& MinibatchGenerator::targetBatch() {
 		Core::Error::msg("Method MinibatchGenerator::targetBatch is only available for supervised training.") << Core::Error::abort;
 	if (targetType_ == sequence)
 		Core::Error::msg("Method MinibatchGenerator::targetBatch is not available if target type is sequence.") << Core::Error::abort;
+	if (hasLabelTargets_ && !areTargetsExpanded_)
+		expandTargets();
 	return targetBatch_;
 }
 
+LabelVector& MinibatchGenerator::targetLabels() {
+	require(generatedBatch_);
+	if (!hasLabelTargets_)
+		Core::Error::msg("Method MinibatchGenerator::targetLabels is only available if the target cache is a label cache.") << Core::Error::abort;
+	if (targetType_ == sequence)
+		Core::Error::msg("Method MinibatchGenerator::targetLabels is not available if target type is sequence.") << Core::Error::abort;
+	return targetLabels_;
+}
+
 MatrixContainer& MinibatchGenerator::sourceSequenceBatch() {
 	require(generatedBatch_);
 	if (featureTransformation_.outputFormat() == single)
@@ -271,5 +541,16 @@ MatrixContainer& MinibatchGenerator::targetSequenceBatch() {
 		Core::Error::msg("Method MinibatchGenerator::targetSequenceBatch is only available for supervised training.") << Core::Error::abort;
 	if (targetType_ == single)
 		Core::Error::msg("Method MinibatchGenerator::targetSequenceBatch is not available if target type is single.") << Core::Error::abort;
+	if (hasLabelTargets_ && !areTargetsExpanded_)
+		expandTargets();
 	return targetSequenceBatch_;
 }
+
+LabelContainer& MinibatchGenerator::targetLabelSequence() {
+	require(generatedBatch_);
+	if (!hasLabelTargets_)
+		Core::Error::msg("Method MinibatchGenerator::targetLabelSequence is only available if the target cache is a label cache.") << Core::Error::abort;
+	if (targetType_ == single)
+		Core::Error::msg("Method MinibatchGenerator::targetLabelSequence is not available if target type is single.") << Core::Error::abort;
+	return targetLabelSequence_;
+}
@@ -23,6 +23,7 @@
 #ifndef NN_MINIBATCHGENERATOR_HH_
 #define NN_MINIBATCHGENERATOR_HH_
 
+#include <pthread.h>
 #include <Core/CommonHeaders.hh>
 #include <Nn/Types.hh>
 #include <Nn/MatrixContainer.hh>
@@ -39,6 +40,31 @@ private:
 
 	static const Core::ParameterEnum paramSourceType_;
 	static const Core::ParameterEnum paramTargetType_;
+	static const Core::ParameterInt paramPrefetchQueueDepth_;
+	static const Core::ParameterInt paramMaxBatchFrames_;
+
+	/*
+	 * host side staging area of a mini-batch (filled by the prefetching thread or directly in synchronous mode)
+	 * the features are written column-contiguous into the batch buffers, on the CPU the published matrices are views on them
+	 * all buffers are reused, so no memory is allocated once the buffers reached their maximal size
+	 */
+	struct Batch {
+		u32 requestedBatchSize;
+		u32 batchSize;								// actual batch size (may be smaller than requested if maxBatchFrames_ > 0)
+		std::vector<Float> source;					// single: sourceDimension x batchSize, sequence: all time frames one after another
+		std::vector<Float> target;					// single targets: targetDimension x batchSize, sequence targets: as source
+		std::vector<Float> sourceSequences;			// sequence batch: the sequences as read from the feature reader
+		std::vector<Float> targetSequences;			// (sequence targets or single targets of a sequence batch)
+		std::vector<u32> labels;					// label targets: class indices instead of target (same column order)
+		std::vector<u32> labelSequences;			// label targets: class indices instead of targetSequences
+		std::vector<u32> sequenceLengths;
+		std::vector<u32> sequenceOffsets;			// first frame of each sequence in sourceSequences
+		std::vector<u32> nStartedSequences;			// number of active sequences at each time frame
+		std::vector<u32> order;						// original sequence order
+		u32 nFrames;								// number of sequence frames in the batch
+		u32 nPaddedFrames;							// maximal sequence length times number of sequences
+		Batch() : requestedBatchSize(0), batchSize(0), nFrames(0), nPaddedFrames(0) {}
+	};
 
 private:
 	FeatureType sourceType_;
@@ -51,23 +77,77 @@ private:
 	Matrix targetBatch_;
 	MatrixContainer sourceSequenceBatch_;
 	MatrixContainer targetSequenceBatch_;
+	// label targets: the targets are staged and published as class indices,
+	// the one-hot target batches are only generated if they are requested
+	bool hasLabelTargets_;
+	LabelVector targetLabels_;
+	LabelContainer targetLabelSequence_;
+	bool areTargetsExpanded_;
+	const Batch* publishedBatch_;
 	std::vector<u32> order_; // keep track of original sequence order
 	u32 sourceDimension_;
 	u32 targetDimension_;
 	FeatureTransformation featureTransformation_;
 	bool isInitialized_;
 	bool generatedBatch_;
-
-	void read(std::vector< Math::Matrix<Float> >& source, std::vector< Math::Matrix<Float> >& target);
-	void generateSingleBatch(const std::vector< Math::Matrix<Float> >& source, const std::vector< Math::Matrix<Float> >& target);
-	void generateSequenceBatch(const std::vector< Math::Matrix<Float> >& source, const std::vector< Math::Matrix<Float> >& target);
+	u32 batchSize_;
+	u32 maxBatchFrames_;
+	u64 nFrames_;
+	u64 nPaddedFrames_;
+	bool isStagingInPlace_;	// CPU only: the published batches use the memory of the staging area instead of a copy
+
+	// prefetching: ring buffer of prefetchQueueDepth_ + 1 batches, the additional batch is the published one that is currently
+	// processed by the network while the others are filled (a single batch in synchronous mode)
+	u32 prefetchQueueDepth_;
+	std::vector<Batch> batches_;
+	u64 nRequestedBatches_;
+	u64 nPrefetchedBatches_;
+	u64 nConsumedBatches_;
+	bool terminatePrefetching_;
+	bool isPrefetching_;
+	pthread_t prefetchThread_;
+	pthread_mutex_t mutex_;
+	pthread_cond_t batchRequested_;
+	pthread_cond_t batchPrefetched_;
+
+	void read(Batch& batch, u32 index, u32 offset);
+	void fillBatch(Batch& batch);
+	void generateSequenceBatch(Batch& batch);
+	void publishMatrix(Float* data, u32 nRows, u32 nColumns, Matrix& matrix);
+	void publishTimeframe(Float* data, u32 nRows, u32 nColumns, MatrixContainer& container);
+	void publishBatch(Batch& batch);
+	void expandLabels(const u32* labels, u32 nColumns, Matrix& targets);
+	void expandTargets();
+	static void* prefetchThread(void* generator);
+	void prefetch();
 
 public:
 	MinibatchGenerator(TrainingMode trainingMode);
 	~MinibatchGenerator();
 
 	void initialize();
+	/*
+	 * generate the next mini-batch (in prefetching mode: wait for the oldest requested batch)
+	 */
 	void generateBatch(u32 batchSize);
+	/*
+	 * @return the number of observations in the generated mini-batch
+	 * (at most the requested batch size, smaller if the frame budget of a sequence batch is exceeded)
+	 */
+	u32 batchSize() const { return batchSize_; }
+	/*
+	 * prefetching mode only: request the background generation of a mini-batch of the given size
+	 * at most prefetchQueueDepth() batches may be requested but not yet generated via generateBatch
+	 */
+	void requestBatch(u32 batchSize);
+	/*
+	 * @return the number of batches that can be prefetched (0 if prefetching is disabled)
+	 */
+	u32 prefetchQueueDepth() const { return prefetchQueueDepth_; }
+	/*
+	 * @return the number of requested batches that have not yet been generated via generateBatch
+	 */
+	u32 nRequestedBatches() const { return nRequestedBatches_ - nConsumedBatches_; }
 	/*
 	 * @return the total number of feature vectors in the feature cache
 	 */
@@ -78,12 +158,29 @@ public:
 	u32 totalNumberOfObservations() const;
 	FeatureType sourceType() const { return featureTransformation_.outputFormat(); }
 	FeatureType targetType() const { return targetType_; }
+	/*
+	 * @return true if the targets are class indices (target cache is a label cache)
+	 * in this case, targetLabels()/targetLabelSequence() avoid the one-hot target matrices
+	 */
+	bool hasLabelTargets() const { return hasLabelTargets_; }
+	/*
+	 * frame-wise label targets only: replace the targets by the given labels (one per feature vector, in cache order)
+	 * must not be called while requested batches are prefetched, the read position in the current epoch is kept
+	 */
+	void setTargetLabels(const std::vector<u32>& labels);
+	/*
+	 * log the fraction of sequence frames in the mini-batches generated since the last call that are not padding
+	 */
+	void logPaddingEfficiency();
 
 	Matrix& sourceBatch();
 	Matrix& targetBatch();
 
 	MatrixContainer& sourceSequenceBatch();
 	MatrixContainer& targetSequenceBatch();
+
+	LabelVector& targetLabels();
+	LabelContainer& targetLabelSequence();
 	const std::vector<u32>& sequenceOrder() const { return order_; }
 };
 
@@ -523,6 +523,12 @@ void GatedRecurrentUnitLayer::addInternalConnections(NeuralNetwork& network) {
 void GatedRecurrentUnitLayer::forward() {
 	Precursor::forward();
 	u32 t = nTimeframes() - 1;
+	// fused computation of gates, candidate activation, and output in a single pass (CPU only)
+	if (!activationsOut(t, 0).isInGpuMode()) {
+		activationsOut(t, 0).gruForward(activationsIn(t, 0), activationsIn(t, 1), activationsIn(t, 2), activationsIn(t, 3),
+				(t > 0 ? &(activationsOut(t-1, 0)) : 0));
+		return;
+	}
 	// sigmoid on update gate (port 0)
 	activationsIn(t, 0).sigmoid();
 	// sigmoid on reset gate (port 1)
@@ -544,6 +550,13 @@ void GatedRecurrentUnitLayer::forward() {
 void GatedRecurrentUnitLayer::backpropagate(u32 timeframe) {
 	Precursor::backpropagate(timeframe);
 	u32 t = timeframe;
+	// fused computation of all error signals in a single pass (CPU only)
+	if (!errorSignalOut(t, 0).isInGpuMode()) {
+		errorSignalOut(t, 0).gruBackward(activationsIn(t, 0), activationsIn(t, 1), activationsIn(t, 2), activationsIn(t, 3),
+				(t > 0 ? &(activationsOut(t-1, 0)) : 0),
+				errorSignalIn(t, 0), errorSignalIn(t, 1), errorSignalIn(t, 2), errorSignalIn(t, 3));
+		return;
+	}
 	// error signal for update gate (port 0)
 	errorSignalIn(t, 0).copy(activationsIn(t, 2));
 	if (t > 0) {
@@ -44,6 +44,11 @@ const Core::ParameterString NeuralNetwork::paramLoadParamsFrom_("load-model-from
 
 const Core::ParameterInt NeuralNetwork::paramLoadParamsEpoch_("load-epoch", Types::max<s32>(), "neural-network");
 
+const Core::ParameterBool NeuralNetwork::paramTimeBatchedForwarding_("time-batched-forwarding", false, "neural-network");
+
+// storage precision of the weights of all weight connections for forwarding, reduced precisions are only supported for inference on the CPU
+const Core::ParameterEnum NeuralNetwork::paramWeightPrecision_("weight-precision", "float32, bfloat16, float16, int8", "float32", "neural-network");
+
 NeuralNetwork::NeuralNetwork() :
 		inputDimension_(Core::Configuration::config(paramInputDimension_)),
 		sourceWidth_(Core::Configuration::config(paramSourceWidth_)),
@@ -53,9 +58,15 @@ NeuralNetwork::NeuralNetwork() :
 		isRecurrent_(false),
 		isInitialized_(false),
 		isComputing_(false),
+		useDropout_(true),
 		writeParamsTo_(Core::Configuration::config(paramWriteParamsTo_)),
 		loadParamsFrom_(Core::Configuration::config(paramLoadParamsFrom_)),
-		loadParamsEpoch_(Core::Configuration::config(paramLoadParamsEpoch_))
+		loadParamsEpoch_(Core::Configuration::config(paramLoadParamsEpoch_)),
+		timeBatchedForwarding_(Core::Configuration::config(paramTimeBatchedForwarding_)),
+		maxTimeBatchedLayers_(0),
+		nTimeBatchedLayers_(0),
+		weightPrecision_((Math::ReducedPrecisionMatrix::Precision)Core::Configuration::config(paramWeightPrecision_)),
+		nBiasBlocks_(0)
 {
 	if (!writeParamsTo_.empty())
 		writeParamsTo_.append("/");
@@ -298,12 +309,153 @@ void NeuralNetwork::initialize(u32 maxMemory) {
 	for (u32 c = 0; c < connections_.size(); c++) {
 		connections_.at(c)->initializeWeights(loadParamsFrom_, s.str());
 	}
+	initializeParameterArena();
+	if (weightPrecision_ != Math::ReducedPrecisionMatrix::float32)
+		initializeWeightPrecision();
 	Core::Log::closeTag();
 	// by default, set the last layer as output layer
 	layer_.back()->setAsOutputLayer();
+	// determine the leading layers that can be forwarded time-batched
+	if (timeBatchedForwarding_) {
+		while ((maxTimeBatchedLayers_ < nLayer_) && isTimeBatchable(maxTimeBatchedLayers_))
+			maxTimeBatchedLayers_++;
+		Core::Log::os("Forward the first ") << maxTimeBatchedLayers_ << " layers time-batched.";
+	}
 	isInitialized_ = true;
 }
 
+void NeuralNetwork::initializeParameterArena() {
+	parameterBlocks_.clear();
+	connectionToParameterBlock_.assign(connections_.size(), Types::max<u32>());
+	layerToParameterBlock_.assign(nLayer_, std::vector<u32>());
+	u32 offset = 0;
+	for (u32 l = 0; l < nLayer_; l++) {
+		if (layer_.at(l)->isBiasTrainable()) {
+			for (u32 port = 0; port < layer_.at(l)->nInputPorts(); port++) {
+				layerToParameterBlock_.at(l).push_back(parameterBlocks_.size());
+				parameterBlocks_.push_back(ParameterBlock(offset, layer_.at(l)->bias(port).nRows(), 1, true, l, port));
+				offset += layer_.at(l)->bias(port).nRows();
+			}
+		}
+	}
+	nBiasBlocks_ = parameterBlocks_.size();
+	for (u32 c = 0; c < connections_.size(); c++) {
+		if (connections_.at(c)->hasWeights() && connections_.at(c)->isTrainable()) {
+			connectionToParameterBlock_.at(c) = parameterBlocks_.size();
+			parameterBlocks_.push_back(ParameterBlock(offset, connections_.at(c)->weights().nRows(), connections_.at(c)->weights().nColumns(), false, c, 0));
+			offset += connections_.at(c)->weights().nRows() * connections_.at(c)->weights().nColumns();
+		}
+	}
+	// move the parameters to the arena
+	parameters_.resize(offset);
+	for (u32 i = 0; i < parameterBlocks_.size(); i++) {
+		const ParameterBlock& b = parameterBlocks_.at(i);
+		if (b.isBias)
+			layer_.at(b.index)->bias(b.port).moveToExternalMemory(parameters_, b.offset);
+		else
+			connections_.at(b.index)->weights().moveToExternalMemory(parameters_, b.offset);
+	}
+	Core::Log::os("Flat parameter arena with ") << parameterBlocks_.size() << " blocks and " << offset << " parameters.";
+}
+
+void NeuralNetwork::initializeWeightPrecision() {
+	if (Math::CudaDataStructure::hasGpu())
+		Core::Error::msg("NeuralNetwork: reduced weight precision is only supported on the CPU.") << Core::Error::abort;
+	for (u32 c = 0; c < connections_.size(); c++) {
+		// convolutional connections keep their full precision weights
+		if (connections_.at(c)->type() != Connection::weightConnection)
+			continue;
+		WeightConnection* connection = dynamic_cast<WeightConnection*>(connections_.at(c));
+		connection->setWeightPrecision(weightPrecision_);
+		Core::Log::os("Connection ") << connection->name() << ": " << connection->nReducedPrecisionBytes()
+				<< " bytes of reduced precision weights (" << (u64)connection->weights().size() * sizeof(Float) << " bytes in full precision).";
+	}
+}
+
+void NeuralNetwork::startQuantizationCalibration() {
+	require_eq(weightPrecision_, Math::ReducedPrecisionMatrix::int8);
+	for (u32 c = 0; c < connections_.size(); c++) {
+		if (connections_.at(c)->type() == Connection::weightConnection)
+			dynamic_cast<WeightConnection*>(connections_.at(c))->startCalibration();
+	}
+}
+
+void NeuralNetwork::finishQuantizationCalibration() {
+	require_eq(weightPrecision_, Math::ReducedPrecisionMatrix::int8);
+	for (u32 c = 0; c < connections_.size(); c++) {
+		if (connections_.at(c)->type() == Connection::weightConnection)
+			dynamic_cast<WeightConnection*>(connections_.at(c))->finishCalibration();
+	}
+}
+
+u32 NeuralNetwork::biasHandle(u32 layerIndex, u32 port) const {
+	require_lt(port, layerToParameterBlock_.at(layerIndex).size());
+	return layerToParameterBlock_.at(layerIndex).at(port);
+}
+
+u32 NeuralNetwork::weightsHandle(u32 connectionIndex) const {
+	require_lt(connectionToParameterBlock_.at(connectionIndex), parameterBlocks_.size());
+	return connectionToParameterBlock_.at(connectionIndex);
+}
+
+void NeuralNetwork::shareParameters(NeuralNetwork& network) {
+	require(isInitialized_);
+	require(!isComputing_);
+	require_eq(parameterBlocks_.size(), network.nParameterBlocks());
+	require_eq(parameters_.nRows(), network.parameters().nRows());
+	for (u32 i = 0; i < parameterBlocks_.size(); i++) {
+		const ParameterBlock& b = parameterBlocks_.at(i);
+		require_eq(b.offset, network.parameterBlock(i).offset);
+		require_eq(b.size(), network.parameterBlock(i).size());
+		if (b.isBias)
+			layer_.at(b.index)->bias(b.port).useExternalMemory(network.parameters(), b.offset, b.nRows);
+		else
+			connections_.at(b.index)->weights().useExternalMemory(network.parameters(), b.offset, b.nRows, b.nColumns);
+	}
+	parameters_.useExternalMemory(network.parameters(), 0, network.parameters().nRows());
+}
+
+Float NeuralNetwork::learningRateFactor(u32 handle) const {
+	const ParameterBlock& b = parameterBlocks_.at(handle);
+	return (b.isBias ? layer(b.index).learningRateFactor() : connection(b.index).learningRateFactor());
+}
+
+bool NeuralNetwork::isTimeBatchable(u32 layerIndex) {
+	Layer& l = layer(layerIndex);
+	// the error signals of the output layer are set per timeframe by the trainer, so it is not time-batched
+	if (l.isRecurrent() || l.requiresFullPass() || l.isOutputLayer())
+		return false;
+	// only layers that process each column independently and store no further timeframe dependent data
+	switch (l.layerType()) {
+	case Layer::identity:
+	case Layer::sigmoid:
+	case Layer::tanh:
+	case Layer::softmax:
+	case Layer::max:
+	case Layer::exponential:
+	case Layer::logarithmic:
+	case Layer::rectified:
+	case Layer::clipped:
+		break;
+	default:
+		return false;
+	}
+	// input must come from the network input or from preceding time-batched layers
+	for (u32 port = 0; port < l.nInputPorts(); port++) {
+		for (u32 i = 0; i < l.nIncomingConnections(port); i++) {
+			Connection& c = l.incomingConnection(i, port);
+			if ((c.type() != Connection::plainConnection) && (c.type() != Connection::weightConnection))
+				return false;
+			bool isBatchedSource = (&(c.from()) == &inputLayer_);
+			for (u32 k = 0; k < layerIndex; k++)
+				isBatchedSource = isBatchedSource || (&(c.from()) == layer_.at(k));
+			if (!isBatchedSource)
+				return false;
+		}
+	}
+	return true;
+}
+
 bool NeuralNetwork::requiresFullMemorization() const {
 	for (u32 l = 0; l < nLayer(); l++) {
 		if (layer(l).requiresFullPass())
@@ -366,7 +518,7 @@ void NeuralNetwork::forward(Matrix& batch, u32 layerIndexFrom, u32 layerIndexTo)
 		// ... and forward the input
 		layer(l).forward();
 		// apply dropout if desired
-		if (layer(l).useDropout())
+		if (useDropout_ && layer(l).useDropout())
 			layer(l).dropout();
 		// finalize the forwarding for this layer (only implemented for special layer types)
 		layer(l).finalizeForwarding();
@@ -408,7 +560,7 @@ void NeuralNetwork::forwardTimeframe(MatrixContainer& batchedSequence, u32 t, u3
 		/* forward the input */
 		layer(l).forward();
 		// apply dropout if desired
-		if (layer(l).useDropout())
+		if (useDropout_ && layer(l).useDropout())
 			layer(l).dropout();
 	}
 	for (u32 l = layerIndexFrom; l <= forwardTo; l++) {
@@ -427,9 +579,46 @@ void NeuralNetwork::forwardTimeframe(MatrixContainer& batchedSequence, u32 t, u3
 	}
 }
 
+void NeuralNetwork::forwardTimeBatched(MatrixContainer& batchedSequence, u32 nLayers) {
+	// concatenate all timeframes of the input sequence...
+	u32 nColumns = 0;
+	for (u32 t = 0; t < batchedSequence.nTimeframes(); t++)
+		nColumns += batchedSequence.at(t).nColumns();
+	batchedSequence.initComputation();
+	timeBatchedInput_.initComputation();
+	timeBatchedInput_.resize(batchedSequence.getLast().nRows(), nColumns);
+	u32 column = 0;
+	for (u32 t = 0; t < batchedSequence.nTimeframes(); t++) {
+		timeBatchedInput_.copyBlockFromMatrix(batchedSequence.at(t), 0, 0, 0, column,
+				batchedSequence.at(t).nRows(), batchedSequence.at(t).nColumns());
+		column += batchedSequence.at(t).nColumns();
+	}
+	// ... forward them as a single mini-batch...
+	forward(timeBatchedInput_, 0, nLayers - 1);
+	// ... and keep the activations to split them into timeframes during sequence forwarding
+	for (u32 l = 0; l < nLayers; l++)
+		layer(l).storeTimeBatch();
+	inputLayer_.reset();
+	nTimeBatchedLayers_ = nLayers;
+}
+
+void NeuralNetwork::addTimeBatchedTimeframe(MatrixContainer& batchedSequence, u32 t, u32 column) {
+	inputLayer_.addInput(batchedSequence.at(t));
+	initComputation();
+	for (u32 l = 0; l < nTimeBatchedLayers_; l++)
+		layer(l).addTimeframeFromBatch(column, batchedSequence.at(t).nColumns());
+}
+
 void NeuralNetwork::forwardSequence(MatrixContainer& batchedSequence, bool greedyForwarding) {
 	require(isInitialized_);
 	reset();
+	// forward the leading non-recurrent layers for all timeframes at once
+	// (with greedy forwarding only up to the last recurrent layer, the layers above are not forwarded for each timeframe)
+	u32 nTimeBatchedLayers = maxTimeBatchedLayers_;
+	if (greedyForwarding)
+		nTimeBatchedLayers = std::min(nTimeBatchedLayers, lastRecurrentLayerIndex() + 1);
+	if (nTimeBatchedLayers > 0)
+		forwardTimeBatched(batchedSequence, nTimeBatchedLayers);
 	// forward up to the next layer that requires a full forward pass over all timeframes until the last layer is reached
 	u32 layerIndexFrom = 0;
 	while (layerIndexFrom < nLayer()) {
@@ -438,13 +627,38 @@ void NeuralNetwork::forwardSequence(MatrixContainer& batchedSequence, bool greed
 		while ((layerIndexTo < nLayer()-1) && (!layer_.at(layerIndexTo)->requiresFullPass()))
 			layerIndexTo++;
 		// forward all timeframes for the block [layerIndexFrom, layerIndexTo]
-		for (u32 t = 0; t < batchedSequence.nTimeframes(); t++)
-			forwardTimeframe(batchedSequence, t, layerIndexFrom, layerIndexTo, greedyForwarding);
+		u32 column = 0;
+		for (u32 t = 0; t < batchedSequence.nTimeframes(); t++) {
+			if ((layerIndexFrom == 0) && (nTimeBatchedLayers_ > 0)) {
+				// split the time-batched layers into timeframes and forward the remaining layers of the block
+				addTimeBatchedTimeframe(batchedSequence, t, column);
+				column += batchedSequence.at(t).nColumns();
+				forwardTimeframe(batchedSequence, t, nTimeBatchedLayers_, layerIndexTo, greedyForwarding);
+			}
+			else {
+				forwardTimeframe(batchedSequence, t, layerIndexFrom, layerIndexTo, greedyForwarding);
+			}
+		}
 		// set the values for the next block
 		layerIndexFrom = layerIndexTo + 1;
 	}
 }
 
+void NeuralNetwork::mergeTimeBatchedLayers() {
+	require_gt(nTimeBatchedLayers_, 0);
+	for (u32 l = 0; l < nTimeBatchedLayers_; l++)
+		layer(l).mergeTimeframes();
+}
+
+Matrix& NeuralNetwork::timeBatchedActivations(Connection& connection) {
+	require(connection.to().hasMergedTimeframes());
+	if (connection.from().hasMergedTimeframes())
+		return connection.from().activationsOut(0, connection.sourcePort());
+	// the only other possible source of a time-batched layer is the network input
+	require(&(connection.from()) == &inputLayer_);
+	return timeBatchedInput_;
+}
+
 void NeuralNetwork::reset() {
 	// reset all activations (and error signals if network is in training mode)
 	for (u32 l = 0; l < layer_.size(); l++) {
@@ -452,6 +666,7 @@ void NeuralNetwork::reset() {
 	}
 	// reset the input
 	inputLayer_.reset();
+	nTimeBatchedLayers_ = 0;
 }
 
 void NeuralNetwork::setTrainingMode(bool trainingMode, u32 firstTrainableLayerIndex) {
@@ -481,12 +696,15 @@ void NeuralNetwork::initComputation(bool sync) {
 	require(isInitialized_);
 	inputLayer_.initComputation(sync);
 	if (!isComputing_) {
+		timeBatchedInput_.initComputation(sync);
 		for (u32 l = 0; l < nLayer_; l++) {
 			layer_.at(l)->initComputation(sync);
 		}
 		for (u32 c = 0; c < connections_.size(); c++) {
 			connections_.at(c)->initComputation(sync);
 		}
+		// the arena itself is not synchronized, its content is synchronized via the views in the layers and connections
+		parameters_.initComputation(false);
 	}
 	isComputing_ = true;
 }
@@ -494,11 +712,13 @@ void NeuralNetwork::initComputation(bool sync) {
 void NeuralNetwork::finishComputation(bool sync) {
 	require(isInitialized_);
 	inputLayer_.finishComputation(sync);
+	timeBatchedInput_.finishComputation(sync);
 	for (u32 l = 0; l < nLayer_; l++) {
 		layer_.at(l)->finishComputation(sync);
 	}
 	for (u32 c = 0; c < connections_.size(); c++) {
 		connections_.at(c)->finishComputation(sync);
 	}
+	parameters_.finishComputation(false);
 	isComputing_ = false;
 }
@@ -31,6 +31,24 @@
 #include "MultiPortLayer.hh"
 namespace Nn {
 
+/*
+ * ParameterBlock
+ * a contiguous block of the flat parameter arena, either the bias of a layer port or the weight matrix of a connection
+ */
+class ParameterBlock
+{
+public:
+	u32 offset;
+	u32 nRows;
+	u32 nColumns;
+	bool isBias;
+	u32 index;		// layer index for biases, connection index for weights
+	u32 port;		// input port of the layer for biases
+	ParameterBlock(u32 _offset, u32 _nRows, u32 _nColumns, bool _isBias, u32 _index, u32 _port) :
+		offset(_offset), nRows(_nRows), nColumns(_nColumns), isBias(_isBias), index(_index), port(_port) {}
+	u32 size() const { return nRows * nColumns; }
+};
+
 class NeuralNetwork
 {
 private:
@@ -44,6 +62,8 @@ private:
 	static const Core::ParameterString paramWriteParamsTo_;
 	static const Core::ParameterString paramLoadParamsFrom_;
 	static const Core::ParameterInt paramLoadParamsEpoch_;
+	static const Core::ParameterBool paramTimeBatchedForwarding_;
+	static const Core::ParameterEnum paramWeightPrecision_;
 private:
 	u32 inputDimension_;
 
@@ -61,11 +81,29 @@ private:
 	bool isRecurrent_;
 	bool isInitialized_;
 	bool isComputing_;
+	bool useDropout_;		// if false, the dropout of the layers is not applied in the forwarding
 
 	std::string writeParamsTo_;
 	std::string loadParamsFrom_;
 	u32 loadParamsEpoch_;
 
+	/* time-batched forwarding of the non-recurrent layers at the bottom of the network */
+	bool timeBatchedForwarding_;
+	u32 maxTimeBatchedLayers_;			// number of leading layers that can be forwarded time-batched
+	u32 nTimeBatchedLayers_;			// number of leading layers that have been forwarded time-batched by forwardSequence
+	Matrix timeBatchedInput_;			// all timeframes of the input sequence concatenated
+
+	/* reduced precision weights of the weight connections for inference */
+	Math::ReducedPrecisionMatrix::Precision weightPrecision_;
+	void initializeWeightPrecision();
+
+	/* flat parameter arena */
+	Vector parameters_;
+	std::vector<ParameterBlock> parameterBlocks_;
+	u32 nBiasBlocks_;
+	std::vector<u32> connectionToParameterBlock_;
+	std::vector< std::vector<u32> > layerToParameterBlock_;
+
 	bool layerExists(std::string& layerName);
 	void addLayer(std::string& layerName);
 	void addConnection(Connection* connection, bool needsWeightsFileSuffix);
@@ -73,6 +111,10 @@ private:
 	bool containsLayer(BaseLayer* layer, std::vector<BaseLayer*> v);
 	void checkTopology();
 	void logTopology();
+	bool isTimeBatchable(u32 layerIndex);
+	void forwardTimeBatched(MatrixContainer& batchedSequence, u32 nLayers);
+	void addTimeBatchedTimeframe(MatrixContainer& batchedSequence, u32 t, u32 column);
+	void initializeParameterArena();
 public:
 	NeuralNetwork();
 	virtual ~NeuralNetwork();
@@ -107,9 +149,56 @@ public:
 	void forwardTimeframe(MatrixContainer& batchedSequence, u32 t, u32 layerIndexFrom = 0, u32 layerIndexTo = Types::max<u32>(), bool greedyForwarding = true);
 	void forwardSequence(MatrixContainer& batchedSequence, bool greedyForwarding = true);
 
+	/*
+	 * time-batched forwarding: the leading non-recurrent layers are forwarded for all timeframes at once
+	 * by concatenating the timeframes of the sequence to one wide matrix, the activations are afterwards split into timeframes
+	 * @return number of leading layers that have been forwarded time-batched in the last call of forwardSequence
+	 */
+	u32 nTimeBatchedLayers() const { return nTimeBatchedLayers_; }
+	// concatenate all timeframes of the time-batched layers to a single timeframe (for time-batched error backpropagation)
+	void mergeTimeBatchedLayers();
+	// all timeframes of the source activations of a connection to a merged time-batched layer
+	Matrix& timeBatchedActivations(Connection& connection);
+
+	/*
+	 * flat parameter arena: all trainable biases (in layer order) followed by all trainable weight matrices (in connection order)
+	 * are stored contiguously in parameters(), the biases of the layers and the weights of the connections are views on it
+	 * the blocks are addressed by integer handles, the bias blocks have the handles 0,...,nBiasBlocks()-1
+	 */
+	Vector& parameters() { return parameters_; }
+	u32 nParameterBlocks() const { return parameterBlocks_.size(); }
+	u32 nBiasBlocks() const { return nBiasBlocks_; }
+	const ParameterBlock& parameterBlock(u32 handle) const { return parameterBlocks_.at(handle); }
+	// handle of the bias of the given layer port (bias needs to be trainable)
+	u32 biasHandle(u32 layerIndex, u32 port) const;
+	// handle of the weights of the given connection (weights need to be trainable)
+	u32 weightsHandle(u32 connectionIndex) const;
+	/*
+	 * let the parameter arena and all biases and weights be views on the parameter arena of network
+	 * (both networks must have the same structure), e.g. for lock-free training of several network replicas
+	 */
+	void shareParameters(NeuralNetwork& network);
+	// learning rate factor of the layer or connection the block belongs to
+	Float learningRateFactor(u32 handle) const;
+
+	/*
+	 * precision of the weights used for forwarding (anything but float32 is for inference on the CPU only)
+	 */
+	Math::ReducedPrecisionMatrix::Precision weightPrecision() const { return weightPrecision_; }
+	/*
+	 * int8 weights: forward the following batches in full precision to determine the range of the inputs of each connection
+	 */
+	void startQuantizationCalibration();
+	void finishQuantizationCalibration();
+
 	void reset();
 
 	void setTrainingMode(bool trainingMode, u32 firstTrainableLayerIndex = 0);
+	/*
+	 * enable/disable the dropout of all layers for the following forwardings (enabled by default),
+	 * e.g. to score data with the network of a running training
+	 */
+	void setDropout(bool useDropout) { useDropout_ = useDropout; }
 
 	void saveNeuralNetworkParameters();
 	void saveNeuralNetworkParameters(const std::string& suffix);
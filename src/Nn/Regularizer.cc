@@ -74,15 +74,6 @@ void L2Regularizer::addToObjectiveFunction(NeuralNetwork& network, Statistics& s
 
 void L2Regularizer::addToGradient(NeuralNetwork& network, Statistics& statistics) {
 	require(statistics.needsGradient());
-	for (u32 l = 0; l < network.nLayer(); l++) {
-		if (network.layer(l).useBias() && network.layer(l).isBiasTrainable()) {
-			for (u32 port = 0; port < network.layer(l).nInputPorts(); port++)
-				statistics.biasGradient(network.layer(l).name(), port).add(network.layer(l).bias(port), regularizationConstant_);
-		}
-	}
-	for (u32 c = 0; c < network.nConnections(); c++) {
-		if (network.connection(c).hasWeights() && network.connection(c).isTrainable()) {
-			statistics.weightsGradient(network.connection(c).name()).add(network.connection(c).weights(), regularizationConstant_);
-		}
-	}
+	// gradient and parameter arena share the same layout
+	statistics.gradient().add(network.parameters(), regularizationConstant_);
 }
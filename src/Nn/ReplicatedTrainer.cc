@@ -0,0 +1,196 @@
+/*
+ * Copyright 2016 Alexander Richard
+ *
+ * This file is part of Squirrel.
+ *
+ * Licensed under the Academic Free License 3.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * You should have received a copy of the License along with Squirrel.
+ * If not, see <https://opensource.org/licenses/AFL-3.0>.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ */
+
+#include "ReplicatedTrainer.hh"
+#include "DataParallel.hh"
+#include <Core/OpenMPWrapper.hh>
+#include <Math/CudaDataStructure.hh>
+#include <sstream>
+#include <algorithm>
+
+using namespace Nn;
+
+const Core::ParameterInt ReplicatedTrainer::paramNumberOfReplicas_("number-of-replicas", 1, "trainer");
+
+const Core::ParameterEnum ReplicatedTrainer::paramReplicaUpdate_("replica-update", "averaging, hogwild", "averaging", "trainer");
+
+// number of mini-batches each replica processes between two parameter averagings
+const Core::ParameterInt ReplicatedTrainer::paramAveragingInterval_("averaging-interval", 1, "trainer");
+
+ReplicatedTrainer::ReplicatedTrainer() :
+		nReplicas_(Core::Configuration::config(paramNumberOfReplicas_)),
+		updateType_((UpdateType)Core::Configuration::config(paramReplicaUpdate_)),
+		averagingInterval_(Core::Configuration::config(paramAveragingInterval_)),
+		isInitialized_(false)
+{
+	require_ge(nReplicas_, 1);
+	require_ge(averagingInterval_, 1);
+}
+
+ReplicatedTrainer::~ReplicatedTrainer() {
+	for (u32 r = 0; r < replicas_.size(); r++)
+		delete replicas_.at(r);
+}
+
+bool ReplicatedTrainer::isReplicatedTrainingRequested() {
+	return (Core::Configuration::config(paramNumberOfReplicas_) > 1);
+}
+
+void ReplicatedTrainer::initialize() {
+	if (isInitialized_)
+		return;
+	if (DataParallel::nWorkers() > 1)
+		Core::Error::msg("ReplicatedTrainer::initialize: replicated training can not be combined with data-parallel.number-of-workers > 1.") << Core::Error::abort;
+	Core::Log::openTag("replicated-trainer");
+	Core::Log::os("Train with ") << nReplicas_ << " replicas in parallel threads, replica update: "
+			<< (updateType_ == averaging ? "averaging" : "hogwild") << ".";
+	Core::Log::closeTag();
+	// each replica reads its own shard of the data, so an explicitly given epoch length is split over the replicas
+	std::stringstream epochLength;
+	epochLength << Core::Configuration::config(Trainer::paramEpochLength_) / nReplicas_;
+	Core::Configuration::setParameter("trainer.epoch-length", epochLength.str().c_str());
+	for (u32 r = 0; r < nReplicas_; r++) {
+		std::stringstream nShards, shardIndex;
+		nShards << nReplicas_;
+		shardIndex << r;
+		Core::Configuration::setParameter("*.number-of-shards", nShards.str().c_str());
+		Core::Configuration::setParameter("*.shard-index", shardIndex.str().c_str());
+		Core::Log::mute(r > 0);
+		replicas_.push_back(Trainer::createTrainer());
+		replicas_.back()->initialize();
+		Core::Log::mute(false);
+	}
+	// the cuda data structures are initialized with the first network
+	if (Math::CudaDataStructure::hasGpu())
+		Core::Error::msg("ReplicatedTrainer::initialize: replicated training is only supported on the CPU.") << Core::Error::abort;
+	// all replicas start from the parameters of the first replica
+	Vector& parameters = replicas_.at(0)->network().parameters();
+	for (u32 r = 1; r < nReplicas_; r++) {
+		if (updateType_ == hogwild) {
+			replicas_.at(r)->network().shareParameters(replicas_.at(0)->network());
+		}
+		else {
+			// on the CPU the arenas can be accessed directly, no synchronization needed
+			parameters.initComputation(false);
+			replicas_.at(r)->network().parameters().initComputation(false);
+			replicas_.at(r)->network().parameters().copy(parameters);
+			replicas_.at(r)->network().parameters().finishComputation(false);
+			parameters.finishComputation(false);
+		}
+	}
+	isInitialized_ = true;
+}
+
+void ReplicatedTrainer::finalize() {
+	for (u32 r = 0; r < nReplicas_; r++) {
+		Core::Log::mute(r > 0);
+		replicas_.at(r)->finalize();
+		Core::Log::mute(false);
+	}
+}
+
+void ReplicatedTrainer::averageParameters(u32 replica) {
+	u32 size = replicas_.at(0)->network().parameters().nRows();
+	u32 chunkSize = (size + nReplicas_ - 1) / nReplicas_;
+	u32 offset = std::min(size, replica * chunkSize);
+	chunkSize = std::min(chunkSize, size - offset);
+	if (chunkSize == 0)
+		return;
+	Vector sum, view;
+	sum.useExternalMemory(replicas_.at(0)->network().parameters(), offset, chunkSize);
+	sum.initComputation(false);
+	for (u32 r = 1; r < nReplicas_; r++) {
+		view.finishComputation(false);
+		view.useExternalMemory(replicas_.at(r)->network().parameters(), offset, chunkSize);
+		view.initComputation(false);
+		sum.add(view);
+	}
+	sum.scale(1.0 / nReplicas_);
+	for (u32 r = 1; r < nReplicas_; r++) {
+		view.finishComputation(false);
+		view.useExternalMemory(replicas_.at(r)->network().parameters(), offset, chunkSize);
+		view.initComputation(false);
+		view.copy(sum);
+	}
+}
+
+void ReplicatedTrainer::processEpoch(u32 batchSize) {
+	Core::Log::openTag("neural-network.process-epoch");
+	Core::Utils::Timer timer;
+	timer.run();
+	bool isEpochFinished = false;
+#pragma omp parallel num_threads(nReplicas_)
+	{
+		u32 r = Core::omp::get_thread_num();
+		Trainer* trainer = replicas_.at(r);
+		Core::Log::mute(r > 0);
+		if (updateType_ == hogwild) {
+			while (!trainer->isEpochFinished())
+				trainer->processBatch(batchSize);
+		}
+		else {
+			// all replicas take part in each averaging, even if they already finished their epoch
+			while (!isEpochFinished) {
+				for (u32 i = 0; (i < averagingInterval_) && (!trainer->isEpochFinished()); i++)
+					trainer->processBatch(batchSize);
+#pragma omp barrier
+				averageParameters(r);
+#pragma omp barrier
+#pragma omp single
+				{
+					isEpochFinished = true;
+					for (u32 i = 0; i < nReplicas_; i++)
+						isEpochFinished = isEpochFinished && replicas_.at(i)->isEpochFinished();
+				}
+			}
+		}
+		Core::Log::mute(false);
+	}
+	timer.stop();
+	u32 nObservations = 0;
+	for (u32 r = 0; r < nReplicas_; r++)
+		nObservations += replicas_.at(r)->nProcessedObservations();
+	Core::Log::os("Processed ") << nObservations << " observations with " << nReplicas_ << " replicas.";
+	Core::Log::os("Throughput of all ") << nReplicas_ << " replicas: " << nObservations / timer.time() << " observations per second.";
+	for (u32 r = 0; r < nReplicas_; r++) {
+		Core::Log::mute(r > 0);
+		replicas_.at(r)->minibatchGenerator_.logPaddingEfficiency();
+		Core::Log::mute(false);
+	}
+	Trainer* master = replicas_.at(0);
+	if ((master->saveFrequency() > 0) && ((master->nProcessedEpochs() + 1) % master->saveFrequency() == 0)) {
+		std::stringstream s;
+		s << ".epoch-" << master->nProcessedEpochs() + 1;
+		master->network().saveNeuralNetworkParameters(s.str());
+	}
+	Core::Log::closeTag();
+}
+
+void ReplicatedTrainer::processAllEpochs(u32 batchSize) {
+	require(isInitialized_);
+	Core::Log::openTag("neural-network.process-all-epochs");
+	Trainer* master = replicas_.at(0);
+	while (master->nProcessedEpochs() < master->numberOfEpochs()) {
+		Core::Log::os("Start epoch ") << master->nProcessedEpochs() + 1;
+		for (u32 r = 0; r < nReplicas_; r++)
+			replicas_.at(r)->estimator().setEpoch(master->nProcessedEpochs() + 1);
+		processEpoch(batchSize);
+		for (u32 r = 0; r < nReplicas_; r++)
+			replicas_.at(r)->finishEpoch();
+	}
+	if (master->saveFrequency() == 0) // save at least at the end of the training
+		master->network().saveNeuralNetworkParameters();
+	Core::Log::closeTag();
+}
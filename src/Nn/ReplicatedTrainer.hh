@@ -0,0 +1,63 @@
+/*
+ * Copyright 2016 Alexander Richard
+ *
+ * This file is part of Squirrel.
+ *
+ * Licensed under the Academic Free License 3.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * You should have received a copy of the License along with Squirrel.
+ * If not, see <https://opensource.org/licenses/AFL-3.0>.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ */
+
+#ifndef NN_REPLICATEDTRAINER_HH_
+#define NN_REPLICATEDTRAINER_HH_
+
+#include <Core/CommonHeaders.hh>
+#include "Types.hh"
+#include "Trainer.hh"
+
+namespace Nn {
+
+/*
+ * multi-threaded training on the CPU with several trainer replicas
+ * each replica runs in its own thread, has its own network, statistics and estimator
+ * and reads its own shard of the feature caches (*.number-of-shards and *.shard-index are set accordingly)
+ * replica-update:
+ *   averaging: the parameters of all replicas are averaged after every averaging-interval mini-batches
+ *   hogwild: all replicas share the parameters of the first replica and update them without any locking
+ * only the first replica logs and saves the network parameters
+ */
+class ReplicatedTrainer
+{
+private:
+	static const Core::ParameterInt paramNumberOfReplicas_;
+	static const Core::ParameterEnum paramReplicaUpdate_;
+	static const Core::ParameterInt paramAveragingInterval_;
+	enum UpdateType { averaging, hogwild };
+	u32 nReplicas_;
+	UpdateType updateType_;
+	u32 averagingInterval_;
+	std::vector<Trainer*> replicas_;
+	bool isInitialized_;
+	// average the chunk of the parameter arena that is assigned to the given replica
+	void averageParameters(u32 replica);
+	void processEpoch(u32 batchSize);
+public:
+	ReplicatedTrainer();
+	virtual ~ReplicatedTrainer();
+	void initialize();
+	void finalize();
+	void processAllEpochs(u32 batchSize);
+	u32 nReplicas() const { return nReplicas_; }
+	Trainer& replica(u32 index) { return *(replicas_.at(index)); }
+
+	static bool isReplicatedTrainingRequested();
+};
+
+} // namespace
+
+#endif /* NN_REPLICATEDTRAINER_HH_ */
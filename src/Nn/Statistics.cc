@@ -42,27 +42,25 @@ Statistics::Statistics(StatisticTypes types) :
 
 void Statistics::initialize(const NeuralNetwork& network) {
 	if (needsGradient_) {
-		// initialize bias gradient
-		u32 i = 0;
-		for (u32 l = 0; l < network.nLayer(); l++) {
-			if (network.layer(l).isBiasTrainable()) {
-				for (u32 port = 0; port < network.layer(l).nInputPorts(); port++) {
-					std::stringstream s;
-					s << network.layer(l).name() << ".port-" << port;
-					layerNameToIndex_[s.str()] = i;
-					biasGradient_.push_back(Vector(network.layer(l).bias(port).nRows()));
-					i++;
-				}
+		u32 size = 0;
+		for (u32 h = 0; h < network.nParameterBlocks(); h++)
+			size += network.parameterBlock(h).size();
+		gradient_.resize(size);
+		biasGradient_.resize(network.nBiasBlocks());
+		weightsGradient_.resize(network.nParameterBlocks() - network.nBiasBlocks());
+		for (u32 h = 0; h < network.nParameterBlocks(); h++) {
+			const ParameterBlock& b = network.parameterBlock(h);
+			// initialize bias gradient
+			if (b.isBias) {
+				std::stringstream s;
+				s << network.layer(b.index).name() << ".port-" << b.port;
+				layerNameToIndex_[s.str()] = h;
+				biasGradient_.at(h).useExternalMemory(gradient_, b.offset, b.nRows);
 			}
-		}
-		// initialize weights gradient
-		i = 0;
-		for (u32 c = 0; c < network.nConnections(); c++) {
-			if (network.connection(c).hasWeights() && network.connection(c).isTrainable()) {
-				connectionNameToIndex_[network.connection(c).name()] = i;
-				WeightConnection* conn = dynamic_cast<WeightConnection*>(&(network.connection(c)));
-				weightsGradient_.push_back(Matrix(conn->weights().nRows(), conn->weights().nColumns()));
-				i++;
+			// initialize weights gradient
+			else {
+				connectionNameToIndex_[network.connection(b.index).name()] = h - network.nBiasBlocks();
+				weightsGradient_.at(h - network.nBiasBlocks()).useExternalMemory(gradient_, b.offset, b.nRows, b.nColumns);
 			}
 		}
 	}
@@ -85,14 +83,7 @@ void Statistics::reset() {
 		objectiveFunctionValue_ = 0;
 	}
 	if (needsGradient_) {
-		// reset bias gradient
-		for (u32 i = 0; i < biasGradient_.size(); i++) {
-			biasGradient_.at(i).setToZero();
-		}
-		// reset weights gradient
-		for (u32 i = 0; i < weightsGradient_.size(); i++) {
-			weightsGradient_.at(i).setToZero();
-		}
+		gradient_.setToZero();
 	}
 }
 
@@ -118,17 +109,20 @@ void Statistics::saveStatistics(const std::string& filename) {
 	/* actual statistics */
 	// the actual bias gradient values
 	for (u32 i = 0; i < biasGradient_.size(); i++) {
-		for (u32 j = 0; j < biasGradient_.at(i).nRows(); j++) {
-			o << biasGradient_.at(i).at(j);
-		}
+		o.write(biasGradient_.at(i).begin(), biasGradient_.at(i).nRows());
 	}
-	// the actual weight gradient values
+	// the actual weight gradient values (stored row by row)
+	std::vector<Float> values;
 	for (u32 i = 0; i < weightsGradient_.size(); i++) {
-		for (u32 row = 0; row < weightsGradient_.at(i).nRows(); row++) {
-			for (u32 column = 0; column < weightsGradient_.at(i).nColumns(); column++) {
-				o << weightsGradient_.at(i).at(row, column);
+		const Matrix& w = weightsGradient_.at(i);
+		values.resize((u64)w.nRows() * w.nColumns());
+		for (u32 row = 0; row < w.nRows(); row++) {
+			for (u32 column = 0; column < w.nColumns(); column++) {
+				values[(u64)row * w.nColumns() + column] = w.at(row, column);
 			}
 		}
+		if (values.size() > 0)
+			o.write(&(values[0]), values.size());
 	}
 	// base statistics
 	o << needsClassificationStatistics_;
@@ -174,15 +168,18 @@ void Statistics::loadStatistics(const std::string& filename) {
 	}
 	// read bias gradient
 	for (u32 i = 0; i < biasGradient_.size(); i++) {
-		for (u32 j = 0; j < biasGradient_.at(i).nRows(); j++) {
-			s >> biasGradient_.at(i).at(j);
-		}
+		s.read(biasGradient_.at(i).begin(), biasGradient_.at(i).nRows());
 	}
-	// read weights gradient
+	// read weights gradient (stored row by row)
+	std::vector<Float> values;
 	for (u32 i = 0; i < weightsGradient_.size(); i++) {
-		for (u32 row = 0; row < weightsGradient_.at(i).nRows(); row++) {
-			for (u32 column = 0; column < weightsGradient_.at(i).nColumns(); column++) {
-				s >> weightsGradient_.at(i).at(row, column);
+		Matrix& w = weightsGradient_.at(i);
+		values.resize((u64)w.nRows() * w.nColumns());
+		if (values.size() > 0)
+			s.read(&(values[0]), values.size());
+		for (u32 row = 0; row < w.nRows(); row++) {
+			for (u32 column = 0; column < w.nColumns(); column++) {
+				w.at(row, column) = values[(u64)row * w.nColumns() + column];
 			}
 		}
 	}
@@ -203,10 +200,7 @@ void Statistics::normalize() {
 		objectiveFunctionValue_ /= nObservations_;
 	}
 	if (needsGradient_) {
-		for (u32 i = 0; i < biasGradient_.size(); i++)
-			biasGradient_.at(i).scale(1.0 / nObservations_);
-		for (u32 i = 0; i < weightsGradient_.size(); i++)
-			weightsGradient_.at(i).scale(1.0 / nObservations_);
+		gradient_.scale(1.0 / nObservations_);
 	}
 	isNormalized_ = true;
 }
@@ -246,14 +240,7 @@ Matrix& Statistics::weightsGradient(const std::string& connectionName) {
 
 Float Statistics::gradientNorm() {
 	require(needsGradient_);
-	Float nrm = 0.0;
-	for (u32 i = 0; i < biasGradient_.size(); i++) {
-		nrm += biasGradient_.at(i).asum();
-	}
-	for (u32 i = 0; i < weightsGradient_.size(); i++) {
-		nrm += weightsGradient_.at(i).l1norm();
-	}
-	return nrm;
+	return gradient_.asum();
 }
 
 void Statistics::addToObjectiveFunction(Float value) {
@@ -274,22 +261,25 @@ void Statistics::increaseNumberOfClassificationErrors(u32 nErrors) {
 	nClassificationErrors_ += nErrors;
 }
 
+// the gradient buffer is synchronized at once, the views only change their state
 void Statistics::initComputation(bool sync) {
+	gradient_.initComputation(sync);
 	for (u32 i = 0; i < biasGradient_.size(); i++) {
-		biasGradient_.at(i).initComputation(sync);
+		biasGradient_.at(i).initComputation(false);
 	}
 	for (u32 i = 0; i < weightsGradient_.size(); i++) {
-		weightsGradient_.at(i).initComputation(sync);
+		weightsGradient_.at(i).initComputation(false);
 	}
 	isComputing_ = true;
 }
 
 void Statistics::finishComputation(bool sync) {
+	gradient_.finishComputation(sync);
 	for (u32 i = 0; i < biasGradient_.size(); i++) {
-		biasGradient_.at(i).finishComputation(sync);
+		biasGradient_.at(i).finishComputation(false);
 	}
 	for (u32 i = 0; i < weightsGradient_.size(); i++) {
-		weightsGradient_.at(i).finishComputation(sync);
+		weightsGradient_.at(i).finishComputation(false);
 	}
 	isComputing_ = false;
 }
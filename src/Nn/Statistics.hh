@@ -55,7 +55,8 @@ private:
 	u32 nClassificationErrors_;
 	// objective function statistics
 	Float objectiveFunctionValue_;
-	// gradient statistics
+	// gradient statistics, all gradients are views on the flat buffer gradient_ (same layout as the parameter arena of the network)
+	Vector gradient_;
 	std::vector<Vector> biasGradient_;
 	std::vector<Matrix> weightsGradient_;
 
@@ -76,6 +77,7 @@ public:
 	bool needsClassificationStatistics() const { return needsClassificationStatistics_; }
 	bool needsObjectiveFunction() const { return needsObjectiveFunction_; }
 	bool needsGradient() const { return needsGradient_; }
+	bool needsSequenceCount() const { return needsSequenceCount_; }
 
 	bool isNormalized() const { return isNormalized_; }
 
@@ -87,6 +89,11 @@ public:
 	Float objectiveFunction();
 	Vector& biasGradient(const std::string& layerName, u32 port);
 	Matrix& weightsGradient(const std::string& connectionName);
+	// access via the parameter block handles of the network (see NeuralNetwork::biasHandle/weightsHandle)
+	Vector& biasGradient(u32 handle) { return biasGradient_.at(handle); }
+	Matrix& weightsGradient(u32 handle) { return weightsGradient_.at(handle - biasGradient_.size()); }
+	// all gradients in a single vector
+	Vector& gradient() { require(needsGradient_); return gradient_; }
 
 	Float gradientNorm();
 
@@ -23,8 +23,10 @@
 #include "Trainer.hh"
 #include "Forwarder.hh"
 #include "GradientBasedTrainer.hh"
+#include "DataParallel.hh"
 #include <sstream>
 #include <iomanip>
+#include <algorithm>
 
 using namespace Nn;
 
@@ -58,6 +60,7 @@ Trainer::Trainer() :
 		saveFrequency_(Core::Configuration::config(paramSaveFrequency_)),
 		nProcessedMinibatches_(0),
 		nProcessedObservations_(0),
+		nRequestedObservations_(0),
 		minibatchGenerator_(supervised),
 		estimator_(0),
 		isInitialized_(false)
@@ -76,11 +79,16 @@ void Trainer::initialize() {
 		// initialize the network with a maximal memory = 1 for activations/error signals over time
 		// (only activations/error signals of most recent time frame are stored)
 		network_.initialize();
+		if (network_.weightPrecision() != Math::ReducedPrecisionMatrix::float32)
+			Core::Error::msg("Trainer: neural-network.weight-precision must be float32 for training.") << Core::Error::abort;
 		minibatchGenerator_.initialize();
 		estimator_ = Estimator::createEstimator();
 		estimator_->initialize(network_, task_);
 		if (epochLength_ == 0)
 			epochLength_ = minibatchGenerator_.totalNumberOfObservations();
+		// with data parallel training, the epoch is split over all workers (each worker reads its own shard)
+		else
+			epochLength_ /= DataParallel::nWorkers();
 		isInitialized_ = true;
 	}
 }
@@ -96,11 +104,9 @@ void Trainer::processAllEpochs(u32 batchSize) {
 		Core::Log::os("Start epoch ") << nProcessedEpochs_ + 1;
 		estimator_->setEpoch(nProcessedEpochs_ + 1);
 		processEpoch(batchSize);
-		nProcessedEpochs_++;
-		nProcessedObservations_ = 0;
-		nProcessedMinibatches_ = 0;
+		finishEpoch();
 	}
-	if (saveFrequency_ == 0) { // save at least at the end of the training
+	if ((saveFrequency_ == 0) && DataParallel::isMaster()) { // save at least at the end of the training
 		network().saveNeuralNetworkParameters();
 	}
 	Core::Log::closeTag();
@@ -108,10 +114,22 @@ void Trainer::processAllEpochs(u32 batchSize) {
 
 void Trainer::processEpoch(u32 batchSize) {
 	Core::Log::openTag("neural-network.process-epoch");
+	Core::Utils::Timer timer;
+	timer.run();
 	while (nProcessedObservations_ < epochLength_)
 		processBatch(batchSize);
+	timer.stop();
 	Core::Log::os("Processed ") << nProcessedObservations_ << " observations in " << nProcessedMinibatches_ << " mini-batches.";
-	if ( (saveFrequency_ > 0) && ((nProcessedEpochs_ + 1) % saveFrequency_ == 0) ) {
+	if (DataParallel::nWorkers() > 1) {
+		Core::Log::os("Throughput of all ") << DataParallel::nWorkers() << " workers: "
+				<< nProcessedObservations_ * DataParallel::nWorkers() / timer.time() << " observations per second ("
+				<< nProcessedObservations_ / timer.time() << " per worker).";
+	}
+	else {
+		Core::Log::os("Throughput: ") << nProcessedObservations_ / timer.time() << " observations per second.";
+	}
+	minibatchGenerator_.logPaddingEfficiency();
+	if ( (saveFrequency_ > 0) && ((nProcessedEpochs_ + 1) % saveFrequency_ == 0) && DataParallel::isMaster()) {
 		std::stringstream s;
 		s << ".epoch-" << nProcessedEpochs_ + 1;
 		network().saveNeuralNetworkParameters(s.str());
@@ -119,16 +137,44 @@ void Trainer::processEpoch(u32 batchSize) {
 	Core::Log::closeTag();
 }
 
+void Trainer::finishEpoch() {
+	nProcessedEpochs_++;
+	nProcessedObservations_ = 0;
+	nRequestedObservations_ = 0;
+	nProcessedMinibatches_ = 0;
+}
+
+void Trainer::requestBatches(u32 batchSize) {
+	// keep the prefetching queue of the minibatch generator filled with the upcoming batches of this epoch
+	while ((minibatchGenerator_.nRequestedBatches() < minibatchGenerator_.prefetchQueueDepth()) && (nRequestedObservations_ < epochLength_)) {
+		u32 size = std::min(batchSize, epochLength_ - nRequestedObservations_);
+		minibatchGenerator_.requestBatch(size);
+		nRequestedObservations_ += size;
+	}
+}
+
 void Trainer::processBatch(u32 batchSize) {
 	Core::Log::openTag("neural-network.process-batch");
+	if (minibatchGenerator_.prefetchQueueDepth() > 0)
+		requestBatches(batchSize);
 	// ensure that last batch in epoch processes only the remaining observations
 	if (nProcessedObservations_ + batchSize > epochLength_)
 		batchSize = epochLength_ - nProcessedObservations_;
 	minibatchGenerator_.generateBatch(batchSize);
+	// the generated batch may contain less observations than requested (see MinibatchGenerator::max-batch-frames)
+	batchSize = minibatchGenerator_.batchSize();
 	Core::Log::os() << "Process mini-batch " << nProcessedMinibatches_ + 1 << " with " << batchSize << " observations.";
 
 	/* call the trainer */
-	if (minibatchGenerator_.sourceType() == single)
+	if (minibatchGenerator_.hasLabelTargets() && supportsLabelTargets()) {
+		if (minibatchGenerator_.sourceType() == single)
+			processBatch(minibatchGenerator_.sourceBatch(), minibatchGenerator_.targetLabels());
+		else if ((minibatchGenerator_.sourceType() == sequence) && (minibatchGenerator_.targetType() == single))
+			processSequenceBatch(minibatchGenerator_.sourceSequenceBatch(), minibatchGenerator_.targetLabels());
+		else if ((minibatchGenerator_.sourceType() == sequence) && (minibatchGenerator_.targetType() == sequence))
+			processSequenceBatch(minibatchGenerator_.sourceSequenceBatch(), minibatchGenerator_.targetLabelSequence());
+	}
+	else if (minibatchGenerator_.sourceType() == single)
 		processBatch(minibatchGenerator_.sourceBatch(), minibatchGenerator_.targetBatch());
 	else if ((minibatchGenerator_.sourceType() == sequence) && (minibatchGenerator_.targetType() == single))
 		processSequenceBatch(minibatchGenerator_.sourceSequenceBatch(), minibatchGenerator_.targetBatch());
@@ -150,6 +196,11 @@ Estimator& Trainer::estimator() {
 	return *estimator_;
 }
 
+MinibatchGenerator& Trainer::minibatchGenerator() {
+	require(isInitialized_);
+	return minibatchGenerator_;
+}
+
 void Trainer::processBatch(Matrix& source, Matrix& target) {
 	Core::Error::msg("Trainer::processBatch(source, target): Supervised frame-wise training not supported by this trainer.") << Core::Error::abort;
 }
@@ -164,6 +215,18 @@ void Trainer::processSequenceBatch(MatrixContainer& source, MatrixContainer& tar
 			"is not supported by this trainer.") << Core::Error::abort;
 }
 
+void Trainer::processBatch(Matrix& source, LabelVector& target) {
+	Core::Error::msg("Trainer::processBatch(source, target): Training with label targets is not supported by this trainer.") << Core::Error::abort;
+}
+
+void Trainer::processSequenceBatch(MatrixContainer& source, LabelVector& target) {
+	Core::Error::msg("Trainer::processSequenceBatch(source, target): Training with label targets is not supported by this trainer.") << Core::Error::abort;
+}
+
+void Trainer::processSequenceBatch(MatrixContainer& source, LabelContainer& target) {
+	Core::Error::msg("Trainer::processSequenceBatch(source, target): Training with label targets is not supported by this trainer.") << Core::Error::abort;
+}
+
 /* factory */
 Trainer* Trainer::createTrainer() {
 	Trainer* trainer = 0;
@@ -36,6 +36,7 @@ namespace Nn {
  */
 class Trainer
 {
+	friend class ReplicatedTrainer;
 private:
 	static const Core::ParameterEnum paramTrainer_;
 	static const Core::ParameterEnum paramTask_;
@@ -54,6 +55,7 @@ protected:
 
 	u32 nProcessedMinibatches_;
 	u32 nProcessedObservations_;
+	u32 nRequestedObservations_; // observations requested from the prefetching minibatch generator
 
 	NeuralNetwork network_;
 	MinibatchGenerator minibatchGenerator_;
@@ -61,6 +63,7 @@ protected:
 
 	bool isInitialized_;
 
+	void requestBatches(u32 batchSize);
 public:
 	Trainer();
 	virtual ~Trainer();
@@ -69,14 +72,30 @@ public:
 	void processBatch(u32 batchSize);
 	void processEpoch(u32 batchSize);
 	void processAllEpochs(u32 batchSize);
+	/* epoch bookkeeping for external epoch loops (see ReplicatedTrainer) */
+	u32 nProcessedEpochs() const { return nProcessedEpochs_; }
+	u32 numberOfEpochs() const { return numberOfEpochs_; }
+	u32 saveFrequency() const { return saveFrequency_; }
+	bool isEpochFinished() const { return nProcessedObservations_ >= epochLength_; }
+	u32 nProcessedObservations() const { return nProcessedObservations_; }
+	void finishEpoch();
 	NeuralNetwork& network();
 	Estimator& estimator();
+	MinibatchGenerator& minibatchGenerator();
 	/* override this method for supervised frame-wise training */
 	virtual void processBatch(Matrix& source, Matrix& target);
 	/* override this method for supervised sequence training with one target per sequence */
 	virtual void processSequenceBatch(MatrixContainer& source, Matrix& target);
 	/* override this method for supervised sequence training where the targets are also sequences */
 	virtual void processSequenceBatch(MatrixContainer& source, MatrixContainer& target);
+	/*
+	 * override these methods (and supportsLabelTargets) to train directly on class indices if the targets are labels
+	 * (see MinibatchGenerator::hasLabelTargets), otherwise the targets are passed as one-hot matrices
+	 */
+	virtual bool supportsLabelTargets() { return false; }
+	virtual void processBatch(Matrix& source, LabelVector& target);
+	virtual void processSequenceBatch(MatrixContainer& source, LabelVector& target);
+	virtual void processSequenceBatch(MatrixContainer& source, LabelContainer& target);
 
 	/* factory */
 	static Trainer* createTrainer();
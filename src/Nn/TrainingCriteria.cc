@@ -78,6 +78,58 @@ u32 TrainingCriterion::nClassificationErrors(NeuralNetwork& network, const Matri
 	return errors;
 }
 
+void TrainingCriterion::initialErrorSignal(const Matrix& activations, const LabelVector& labels, Matrix& errorSignal) {
+	Core::Error::msg("TrainingCriterion: Error signal computation with label targets is not supported by this criterion.") << Core::Error::abort;
+}
+
+Float TrainingCriterion::objectiveFunction(const Matrix& activations, const LabelVector& labels) {
+	Core::Error::msg("TrainingCriterion: Objective function computation with label targets is not supported by this criterion.") << Core::Error::abort;
+	return 0;
+}
+
+void TrainingCriterion::computeInitialErrorSignal(NeuralNetwork& network, const LabelVector& labels) {
+	sanityCheck(network);
+	initialErrorSignal(network.outputLayer().latestActivations(0), labels, network.outputLayer().latestErrorSignal(0));
+}
+
+void TrainingCriterion::computeInitialErrorSignals(NeuralNetwork& network, const LabelContainer& labels) {
+	sanityCheck(network);
+	require_eq(network.outputLayer().nTimeframes(), labels.nTimeframes());
+	for (u32 t = 0; t < labels.nTimeframes(); t++) {
+		initialErrorSignal(network.outputLayer().activations(t, 0), labels.at(t), network.outputLayer().errorSignal(t, 0));
+	}
+}
+
+Float TrainingCriterion::computeObjectiveFunction(NeuralNetwork& network, const LabelVector& labels) {
+	sanityCheck(network);
+	return objectiveFunction(network.outputLayer().latestActivations(0), labels);
+}
+
+Float TrainingCriterion::computeObjectiveFunction(NeuralNetwork& network, const LabelContainer& labels) {
+	sanityCheck(network);
+	require_eq(network.outputLayer().nTimeframes(), labels.nTimeframes());
+	Float objFctn = 0;
+	for (u32 t = 0; t < labels.nTimeframes(); t++) {
+		objFctn += objectiveFunction(network.outputLayer().activations(t, 0), labels.at(t));
+	}
+	return objFctn;
+}
+
+u32 TrainingCriterion::nClassificationErrors(NeuralNetwork& network, const LabelVector& labels) {
+	sanityCheck(network);
+	return network.outputLayer().latestActivations(0).nClassificationErrors(labels);
+}
+
+u32 TrainingCriterion::nClassificationErrors(NeuralNetwork& network, const LabelContainer& labels) {
+	sanityCheck(network);
+	require_eq(network.outputLayer().nTimeframes(), labels.nTimeframes());
+	u32 errors = 0;
+	for (u32 t = 0; t < labels.nTimeframes(); t++) {
+		errors += network.outputLayer().activations(t, 0).nClassificationErrors(labels.at(t));
+	}
+	return errors;
+}
+
 TrainingCriterion* TrainingCriterion::createCriterion() {
 	TrainingCriterion* res = 0;
 	switch ((CriterionType) Core::Configuration::config(paramTrainingCriterion_)) {
@@ -130,6 +182,10 @@ Float DummyCriterion::objectiveFunction(const Matrix& activations, const Matrix&
 	return 0.0;
 }
 
+Float DummyCriterion::objectiveFunction(const Matrix& activations, const LabelVector& labels) {
+	return 0.0;
+}
+
 /*
  * CrossEntropyCriterion
  */
@@ -158,6 +214,19 @@ Float CrossEntropyCriterion::objectiveFunction(const Matrix& activations, const
 	return activations.crossEntropyObjectiveFunction(targets);
 }
 
+void CrossEntropyCriterion::initialErrorSignal(const Matrix& activations, const LabelVector& labels, Matrix& errorSignal) {
+	require_eq(activations.nColumns(), errorSignal.nColumns());
+	require_eq(activations.nRows(), errorSignal.nRows());
+	require_eq(activations.nColumns(), labels.size());
+	errorSignal.copy(activations);
+	errorSignal.addKroneckerDelta(labels, (Float)-1.0);
+}
+
+Float CrossEntropyCriterion::objectiveFunction(const Matrix& activations, const LabelVector& labels) {
+	require_eq(activations.nColumns(), labels.size());
+	return activations.crossEntropyObjectiveFunction(labels);
+}
+
 /*
  * WeightedCrossEntropyCriterion
  */
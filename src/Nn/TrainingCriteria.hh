@@ -42,6 +42,9 @@ protected:
 	virtual void sanityCheck(NeuralNetwork& network) {}
 	virtual void initialErrorSignal(const Matrix& activations, const Matrix& targets, Matrix& errorSignal) = 0;
 	virtual Float objectiveFunction(const Matrix& activations, const Matrix& targets) = 0;
+	// same with class indices as targets (only if supportsLabelTargets())
+	virtual void initialErrorSignal(const Matrix& activations, const LabelVector& labels, Matrix& errorSignal);
+	virtual Float objectiveFunction(const Matrix& activations, const LabelVector& labels);
 public:
 	TrainingCriterion() {}
 	virtual ~TrainingCriterion() {}
@@ -59,6 +62,16 @@ public:
 	// number of classification errors for sequence targets
 	virtual u32 nClassificationErrors(NeuralNetwork& network, const MatrixContainer& targets);
 
+	// true if the criterion can be computed from class indices instead of one-hot target vectors
+	virtual bool supportsLabelTargets() const { return false; }
+	// same as above with class indices as targets
+	virtual void computeInitialErrorSignal(NeuralNetwork& network, const LabelVector& labels);
+	virtual void computeInitialErrorSignals(NeuralNetwork& network, const LabelContainer& labels);
+	virtual Float computeObjectiveFunction(NeuralNetwork& network, const LabelVector& labels);
+	virtual Float computeObjectiveFunction(NeuralNetwork& network, const LabelContainer& labels);
+	virtual u32 nClassificationErrors(NeuralNetwork& network, const LabelVector& labels);
+	virtual u32 nClassificationErrors(NeuralNetwork& network, const LabelContainer& labels);
+
 	static TrainingCriterion* createCriterion();
 };
 
@@ -72,9 +85,11 @@ private:	virtual void sanityCheck(NeuralNetwork& network) {}
 protected:
 	virtual void initialErrorSignal(const Matrix& activations, const Matrix& targets, Matrix& errorSignal);
 	virtual Float objectiveFunction(const Matrix& activations, const Matrix& targets);
+	virtual Float objectiveFunction(const Matrix& activations, const LabelVector& labels);
 public:
 	DummyCriterion();
 	virtual ~DummyCriterion() {}
+	virtual bool supportsLabelTargets() const { return true; }
 };
 
 /*
@@ -88,9 +103,12 @@ protected:
 	virtual void sanityCheck(NeuralNetwork& network);
 	virtual void initialErrorSignal(const Matrix& activations, const Matrix& targets, Matrix& errorSignal);
 	virtual Float objectiveFunction(const Matrix& activations, const Matrix& targets);
+	virtual void initialErrorSignal(const Matrix& activations, const LabelVector& labels, Matrix& errorSignal);
+	virtual Float objectiveFunction(const Matrix& activations, const LabelVector& labels);
 public:
 	CrossEntropyCriterion();
 	virtual ~CrossEntropyCriterion() {}
+	virtual bool supportsLabelTargets() const { return true; }
 };
 
 /*
@@ -112,6 +130,7 @@ public:
 	WeightedCrossEntropyCriterion();
 	virtual ~WeightedCrossEntropyCriterion() {}
 	virtual void initialize(NeuralNetwork& network);
+	virtual bool supportsLabelTargets() const { return false; }
 };
 
 /*
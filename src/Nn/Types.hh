@@ -40,6 +40,8 @@ enum TrainingMode { supervised, unsupervised };
 // neural network matrix/vector types
 typedef Math::CudaMatrix<Float> Matrix;
 typedef Math::CudaVector<Float> Vector;
+// class indices as targets (one label per column of the corresponding activations)
+typedef Math::CudaVector<u32> LabelVector;
 #ifdef MODULE_CUDNN
 typedef Math::cuDNN::CudnnConvolution<Float> CudnnConvolution;
 typedef Math::cuDNN::CudnnPooling<Float> CudnnPooling;
@@ -0,0 +1,159 @@
+/*
+ * Copyright 2016 Alexander Richard
+ *
+ * This file is part of Squirrel.
+ *
+ * Licensed under the Academic Free License 3.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * You should have received a copy of the License along with Squirrel.
+ * If not, see <https://opensource.org/licenses/AFL-3.0>.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ */
+
+#include <Test/UnitTest.hh>
+#include <Core/FlatHashMap.hh>
+
+using namespace std;
+
+class TestFlatHashMap : public Test::Fixture
+{
+public:
+	class Hash {
+	public:
+		u32 operator()(const u32& n) const { return n; }
+	};
+	typedef Core::FlatHashMap<u32, Float, Hash> Map;
+	void setUp();
+	void tearDown();
+};
+
+void TestFlatHashMap::setUp() {
+}
+
+void TestFlatHashMap::tearDown() {
+}
+
+TEST_F(Test, TestFlatHashMap, insert) {
+	Map map;
+	Map::Entry *entry = map.insert(10, 0.1f);
+	EXPECT_EQ(entry->key, 10u);
+	EXPECT_EQ(entry->value, 0.1f);
+	entry = map.insert(26, 0.2f); // collides with 10
+	EXPECT_EQ(entry->key, 26u);
+	EXPECT_EQ(entry->value, 0.2f);
+	entry = map.insert(10, 0.3f);
+	EXPECT_EQ(entry->value, 0.3f);
+	EXPECT_EQ(map.size(), 2u);
+}
+
+TEST_F(Test, TestFlatHashMap, find) {
+	Map map;
+	map.insert(10, 0.1f);
+	map.insert(26, 0.2f);
+	EXPECT_EQ(map.find(10)->value, 0.1f);
+	EXPECT_EQ(map.find(26)->value, 0.2f);
+	EXPECT_EQ(map.find(42), (Map::Entry*)0);
+}
+
+TEST_F(Test, TestFlatHashMap, remove) {
+	Map map;
+	map.insert(10, 0.1f);
+	map.insert(26, 0.2f);
+	map.remove(10);
+	EXPECT_EQ(map.size(), 1u);
+	EXPECT_EQ(map.find(10), (Map::Entry*)0);
+	// entry behind the removed one in the probing sequence must still be found
+	EXPECT_EQ(map.find(26)->value, 0.2f);
+	// removed slot is reused
+	map.insert(42, 0.3f);
+	EXPECT_EQ(map.size(), 2u);
+	EXPECT_EQ(map.find(42)->value, 0.3f);
+	EXPECT_EQ(map.find(26)->value, 0.2f);
+}
+
+TEST_F(Test, TestFlatHashMap, iterate) {
+	Map map;
+	map.insert(10, 0.1f);
+	map.insert(20, 0.2f);
+	map.insert(5, 0.05f);
+	map.remove(20);
+	// entries are iterated in order of their insertion
+	Map::iterator it = map.begin();
+	EXPECT_EQ(it->key, 10u);
+	++it;
+	EXPECT_EQ(it->key, 5u);
+	++it;
+	EXPECT_TRUE(it == map.end());
+}
+
+TEST_F(Test, TestFlatHashMap, removeWhileIterating) {
+	Map map;
+	for (u32 i = 0; i < 10; i++)
+		map.insert(i, (Float)i);
+	for (Map::iterator it = map.begin(); it != map.end(); ++it) {
+		if (it->key % 2 == 0)
+			map.remove(it->key);
+	}
+	EXPECT_EQ(map.size(), 5u);
+	u32 n = 0;
+	for (Map::iterator it = map.begin(); it != map.end(); ++it, n++)
+		EXPECT_EQ(it->key % 2, 1u);
+	EXPECT_EQ(n, 5u);
+}
+
+TEST_F(Test, TestFlatHashMap, clear) {
+	Map map;
+	map.insert(10, 0.1f);
+	map.insert(20, 0.2f);
+	u32 capacity = map.capacity();
+	map.clear();
+	EXPECT_EQ(map.size(), 0u);
+	EXPECT_EQ(map.capacity(), capacity);
+	EXPECT_EQ(map.find(10), (Map::Entry*)0);
+	EXPECT_TRUE(map.begin() == map.end());
+	map.insert(20, 0.3f);
+	EXPECT_EQ(map.find(20)->value, 0.3f);
+}
+
+TEST_F(Test, TestFlatHashMap, rehash) {
+	Map map(Hash(), 4);
+	for (u32 i = 0; i < 1000; i++)
+		map.insert(7 * i, (Float)i);
+	EXPECT_EQ(map.size(), 1000u);
+	EXPECT_GE(map.capacity(), 2000u);
+	for (u32 i = 0; i < 1000; i++)
+		EXPECT_EQ(map.find(7 * i)->value, (Float)i);
+	// removed entries are cleaned up on rehashing, so repeated insertion and removal does not grow the map unboundedly
+	for (u32 i = 0; i < 100000; i++) {
+		map.insert(100000 + i, 0.0f);
+		map.remove(100000 + i);
+	}
+	EXPECT_LE(map.capacity(), 4096u);
+	EXPECT_EQ(map.size(), 1000u);
+}
+
+TEST_F(Test, TestFlatHashMap, reserve) {
+	Map map;
+	map.reserve(100);
+	u32 capacity = map.capacity();
+	EXPECT_GE(capacity, 200u);
+	for (u32 i = 0; i < 100; i++)
+		map.insert(i, (Float)i);
+	EXPECT_EQ(map.capacity(), capacity);
+}
+
+TEST_F(Test, TestFlatHashMap, swap) {
+	Map a, b;
+	a.insert(10, 0.1f);
+	a.insert(20, 0.2f);
+	b.insert(5, 0.05f);
+	a.swap(b);
+	EXPECT_EQ(a.size(), 1u);
+	EXPECT_EQ(b.size(), 2u);
+	EXPECT_EQ(a.find(5)->value, 0.05f);
+	EXPECT_EQ(b.find(20)->value, 0.2f);
+	EXPECT_EQ(a.find(10), (Map::Entry*)0);
+}
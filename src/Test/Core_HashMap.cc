@@ -164,3 +164,34 @@ TEST_F(Test, TestHashMap, clear) {
 	EXPECT_EQ(map.size(), 0u);
 	EXPECT_EQ(map.begin(), (Core::HashMap<u32, Float>::Entry*)0);
 }
+
+TEST_F(Test, TestHashMap, reuseEntries) {
+	Core::HashMap<u32, Float> map(hash_fctn, 11);
+	Core::HashMap<u32, Float>::Entry* entry = map.insert(10, 0.1f);
+	map.remove(10);
+	// removed entry is reused for the next insertion
+	EXPECT_EQ(entry, map.insert(20, 0.2f));
+	EXPECT_EQ(entry->key, 20u);
+	EXPECT_EQ(entry->value, 0.2f);
+	EXPECT_EQ(map.size(), 1u);
+	map.clear();
+	EXPECT_EQ(entry, map.insert(5, 0.05f));
+	EXPECT_EQ(map.size(), 1u);
+	EXPECT_EQ(map.find(20), (Core::HashMap<u32, Float>::Entry*)0);
+}
+
+TEST_F(Test, TestHashMap, swap) {
+	Core::HashMap<u32, Float> map1(hash_fctn, 11);
+	Core::HashMap<u32, Float> map2(hash_fctn, 11);
+	map1.insert(10, 0.1f);
+	map1.insert(20, 0.2f);
+	map2.insert(5, 0.05f);
+
+	map1.swap(map2);
+	EXPECT_EQ(map1.size(), 1u);
+	EXPECT_EQ(map2.size(), 2u);
+	EXPECT_EQ(map1.find(5)->value, 0.05f);
+	EXPECT_EQ(map2.find(10)->value, 0.1f);
+	EXPECT_EQ(map2.find(20)->value, 0.2f);
+	EXPECT_EQ(map1.find(10), (Core::HashMap<u32, Float>::Entry*)0);
+}
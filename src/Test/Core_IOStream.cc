@@ -0,0 +1,78 @@
+/*
+ * Copyright 2016 Alexander Richard
+ *
+ * This file is part of Squirrel.
+ *
+ * Licensed under the Academic Free License 3.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * You should have received a copy of the License along with Squirrel.
+ * If not, see <https://opensource.org/licenses/AFL-3.0>.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ */
+
+#include <Test/UnitTest.hh>
+#include <Core/IOStream.hh>
+#include <stdio.h>
+#include <vector>
+
+class TestIOStream : public Test::Fixture
+{
+public:
+	void setUp() {}
+	void tearDown() {}
+	void writeAndRead(Core::IOStream& out, Core::IOStream& in, const std::string& filename, u32 nValues, bool isBinary);
+};
+
+void TestIOStream::writeAndRead(Core::IOStream& out, Core::IOStream& in, const std::string& filename, u32 nValues, bool isBinary) {
+	std::vector<f32> values(nValues);
+	for (u32 i = 0; i < nValues; i++)
+		values.at(i) = i * 0.5f;
+	// small header, large block, small trailer
+	out.open(filename, std::ios::out);
+	out << (u32)nValues;
+	if (!isBinary)
+		out << ' ';
+	out.write(&(values[0]), nValues);
+	if (!isBinary)
+		out << ' ';
+	out << (u32)7;
+	out.close();
+
+	std::vector<f32> result(nValues, -1.0f);
+	u32 size, trailer;
+	in.open(filename, std::ios::in);
+	in >> size;
+	EXPECT_EQ(nValues, size);
+	// read first value element-wise to have a partially consumed buffer, the rest as a block
+	in >> result.at(0);
+	in.read(&(result[1]), nValues - 1);
+	in >> trailer;
+	in.close();
+	for (u32 i = 0; i < nValues; i++)
+		EXPECT_EQ(values.at(i), result.at(i));
+	EXPECT_EQ(7u, trailer);
+	remove(filename.c_str());
+}
+
+TEST_F(Test, TestIOStream, binaryBlockIO) {
+	Core::BinaryStream out, in;
+	writeAndRead(out, in, "iostream-test.bin", 10000, true);
+}
+
+TEST_F(Test, TestIOStream, binarySmallBlockIO) {
+	Core::BinaryStream out, in;
+	writeAndRead(out, in, "iostream-test.bin", 10, true);
+}
+
+TEST_F(Test, TestIOStream, asciiBlockIO) {
+	Core::AsciiStream out, in;
+	writeAndRead(out, in, "iostream-test.txt", 100, false);
+}
+
+TEST_F(Test, TestIOStream, compressedBlockIO) {
+	Core::CompressedStream out, in;
+	writeAndRead(out, in, "iostream-test.gz", 100, false);
+}
@@ -254,6 +254,31 @@ TEST_F(Test, TestAlignedFeatureReader, labeledFeatureReaderSmallBufferShuffled)
 	Core::Configuration::reset();
 }
 
+TEST_F(Test, TestAlignedFeatureReader, labeledFeatureReaderSetTargetLabels) {
+	Core::Configuration::setParameter("feature-reader.feature-cache", "input.vectors");
+	Core::Configuration::setParameter("feature-reader.target-cache", "labels-1.vectors");
+	Core::Configuration::setParameter("feature-reader.shuffle-buffer", "true");
+	Features::LabeledFeatureReader featureReader("feature-reader");
+	featureReader.initialize();
+	u32 nFeatures = featureReader.totalNumberOfFeatures();
+	std::vector<u32> labels(nFeatures);
+	// replace the labels before anything is read and between two epochs
+	for (u32 epoch = 0; epoch < 2; epoch++) {
+		for (u32 j = 0; j < nFeatures; j++)
+			labels.at(j) = (epoch == 0 ? nFeatures - 1 - j : (j + 1) % nFeatures);
+		featureReader.setTargetLabels(labels);
+		for (u32 i = 0; i < nFeatures; i++) {
+			const Math::Vector<Float>& f = featureReader.next();
+			// the label must belong to the feature vector (index j in the cache)
+			u32 j = (u32)f.at(0) / 3;
+			EXPECT_EQ(labels.at(j), featureReader.label());
+		}
+		EXPECT_FALSE(featureReader.hasFeatures());
+		featureReader.newEpoch();
+	}
+	Core::Configuration::reset();
+}
+
 /* tests for aligned sequence feature reader */
 TEST_F(Test, TestAlignedFeatureReader, aligendSequenceFeatureReader) {
 	Core::Configuration::setParameter("feature-reader.feature-cache", "input.sequences");
@@ -477,3 +502,48 @@ TEST_F(Test, TestAlignedFeatureReader, temporallyLabeledSequenceFeatureReaderSor
 	testTemporallyAlignedSequenceFeatureReader(&featureReader);
 	Core::Configuration::reset();
 }
+
+TEST_F(Test, TestAlignedFeatureReader, shardedAlignedFeatureReader) {
+	Core::Configuration::setParameter("feature-reader.feature-cache", "input.vectors");
+	Core::Configuration::setParameter("feature-reader.target-cache", "targets-1.vectors");
+	Core::Configuration::setParameter("feature-reader.buffer-size", "1");
+	// shard 2 of 5 contains the observations 2 and 7 (observations 10 and 11 are not used by any shard)
+	Core::Configuration::setParameter("*.number-of-shards", "5");
+	Core::Configuration::setParameter("*.shard-index", "2");
+	Features::AlignedFeatureReader featureReader("feature-reader");
+	featureReader.initialize();
+	EXPECT_EQ(2u, featureReader.totalNumberOfFeatures());
+	for (u32 epoch = 0; epoch < 2; epoch++) {
+		for (u32 i = 0; i < 2; i++) {
+			u32 j = 2 + 5 * i;
+			const Math::Vector<Float>& f = featureReader.next();
+			for (u32 d = 0; d < featureReader.featureDimension(); d++)
+				EXPECT_EQ(j*3.0f + d, f.at(d));
+			for (u32 d = 0; d < featureReader.targetDimension(); d++)
+				EXPECT_EQ(j*2.0f + d, featureReader.target().at(d));
+		}
+		EXPECT_FALSE(featureReader.hasFeatures());
+		featureReader.newEpoch();
+	}
+	Core::Configuration::reset();
+}
+
+TEST_F(Test, TestAlignedFeatureReader, shardedAlignedSequenceFeatureReader) {
+	Core::Configuration::setParameter("feature-reader.feature-cache", "input.sequences");
+	Core::Configuration::setParameter("feature-reader.target-cache", "targets-2.vectors");
+	Core::Configuration::setParameter("*.number-of-shards", "2");
+	Core::Configuration::setParameter("*.shard-index", "1");
+	Features::AlignedSequenceFeatureReader featureReader("feature-reader");
+	featureReader.initialize();
+	EXPECT_EQ(1u, featureReader.totalNumberOfSequences());
+	for (u32 epoch = 0; epoch < 2; epoch++) {
+		// the second sequence has length 4 and starts with feature value 9
+		const Math::Matrix<Float>& f = featureReader.next();
+		EXPECT_EQ(4u, f.nColumns());
+		EXPECT_EQ(9.0f, f.at(0, 0));
+		EXPECT_EQ(2.0f, featureReader.target().at(0));
+		EXPECT_FALSE(featureReader.hasSequences());
+		featureReader.newEpoch();
+	}
+	Core::Configuration::reset();
+}
@@ -0,0 +1,114 @@
+/*
+ * Copyright 2016 Alexander Richard
+ *
+ * This file is part of Squirrel.
+ *
+ * Licensed under the Academic Free License 3.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * You should have received a copy of the License along with Squirrel.
+ * If not, see <https://opensource.org/licenses/AFL-3.0>.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ */
+
+#include <Test/UnitTest.hh>
+#include <stdio.h>
+#include <Features/FeatureCache.hh>
+#include <Features/FeatureWriter.hh>
+
+class TestFeatureCache : public Test::Fixture
+{
+public:
+	void setUp() {}
+	void tearDown() {}
+	void convertToBinary(const std::string& asciiCache, const std::string& binaryCache);
+	void compareCaches(const std::string& asciiCache, const std::string& binaryCache);
+};
+
+void TestFeatureCache::convertToBinary(const std::string& asciiCache, const std::string& binaryCache) {
+	Features::FeatureCache cache;
+	cache.setLogCacheInformation(false);
+	cache.initialize(asciiCache);
+	switch (cache.featureType()) {
+	case Features::FeatureCache::vectors:
+		{
+		Features::FeatureWriter writer("feature-writer", binaryCache);
+		writer.initialize(cache.cacheSize(), cache.featureDim());
+		for (u32 i = 0; i < cache.cacheSize(); i++)
+			writer.write(cache.next());
+		writer.finalize();
+		}
+		break;
+	case Features::FeatureCache::sequences:
+		{
+		Features::SequenceFeatureWriter writer("feature-writer", binaryCache);
+		writer.initialize(cache.cacheSize(), cache.featureDim(), cache.nSequences());
+		for (u32 i = 0; i < cache.nSequences(); i++)
+			writer.write(cache.next());
+		writer.finalize();
+		}
+		break;
+	case Features::FeatureCache::sequencelabels:
+		{
+		Features::SequenceLabelWriter writer("label-writer", binaryCache);
+		writer.initialize(cache.cacheSize(), cache.featureDim(), cache.nSequences());
+		for (u32 i = 0; i < cache.nSequences(); i++) {
+			const Math::Matrix<Float>& m = cache.next();
+			std::vector<u32> labels(m.nColumns());
+			for (u32 t = 0; t < m.nColumns(); t++)
+				labels.at(t) = m.argAbsMax(t);
+			writer.write(labels);
+		}
+		writer.finalize();
+		}
+		break;
+	default:
+		break;
+	}
+}
+
+void TestFeatureCache::compareCaches(const std::string& asciiCache, const std::string& binaryCache) {
+	convertToBinary(asciiCache, binaryCache);
+	Core::Configuration::setParameter("features.feature-cache.memory-mapping", "true");
+	Features::FeatureCache reference;
+	Features::FeatureCache mapped;
+	reference.setLogCacheInformation(false);
+	mapped.setLogCacheInformation(false);
+	reference.initialize(asciiCache);
+	mapped.initialize(binaryCache);
+	EXPECT_EQ(reference.featureType(), mapped.featureType());
+	EXPECT_EQ(reference.cacheSize(), mapped.cacheSize());
+	EXPECT_EQ(reference.featureDim(), mapped.featureDim());
+	EXPECT_EQ(reference.nSequences(), mapped.nSequences());
+	u32 nObservations = (reference.nSequences() > 0 ? reference.nSequences() : reference.cacheSize());
+	// two passes to check reset of the mapped cache
+	for (u32 epoch = 0; epoch < 2; epoch++) {
+		for (u32 i = 0; i < nObservations; i++) {
+			const Math::Matrix<Float>& r = reference.next();
+			const Math::Matrix<Float>& m = mapped.next();
+			EXPECT_EQ(r.nRows(), m.nRows());
+			EXPECT_EQ(r.nColumns(), m.nColumns());
+			for (u32 d = 0; d < r.nRows(); d++)
+				for (u32 t = 0; t < r.nColumns(); t++)
+					EXPECT_EQ(r.at(d, t), m.at(d, t));
+		}
+		reference.reset();
+		mapped.reset();
+	}
+	remove(binaryCache.c_str());
+	Core::Configuration::reset();
+}
+
+TEST_F(Test, TestFeatureCache, memoryMappedVectors) {
+	compareCaches("input.vectors", "mapped-input-vectors.bin");
+}
+
+TEST_F(Test, TestFeatureCache, memoryMappedSequences) {
+	compareCaches("input.sequences", "mapped-input-sequences.bin");
+}
+
+TEST_F(Test, TestFeatureCache, memoryMappedSequenceLabels) {
+	compareCaches("labels-1.sequences", "mapped-labels-sequences.bin");
+}
@@ -0,0 +1,81 @@
+/*
+ * Copyright 2016 Alexander Richard
+ *
+ * This file is part of Squirrel.
+ *
+ * Licensed under the Academic Free License 3.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * You should have received a copy of the License along with Squirrel.
+ * If not, see <https://opensource.org/licenses/AFL-3.0>.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ */
+
+#include <Test/UnitTest.hh>
+#include <Math/Matrix.hh>
+#include <Hmm/ViterbiDecoding.hh>
+
+class TestViterbiDecoding : public Test::Fixture
+{
+public:
+	void setUp();
+	void tearDown() {}
+};
+
+void TestViterbiDecoding::setUp() {
+	Core::Configuration::setParameter("grammar.type", "single-path");
+	Core::Configuration::setParameter("hidden-markov-model.type", "single-state-hmm");
+	Core::Configuration::setParameter("hidden-markov-model.number-of-classes", "3");
+	Core::Configuration::setParameter("viterbi-decoding.output", "labels");
+	Core::Configuration::setParameter("viterbi-decoding.pruning-threshold", "10");
+	Core::Configuration::setParameter("viterbi-decoding.partial-traceback", "true");
+}
+
+/* stores the segments and the number of already decoded frames at the time they are passed */
+class SegmentRecorder : public Hmm::ViterbiDecoding::SegmentListener
+{
+public:
+	const Hmm::ViterbiDecoding& decoder;
+	std::vector<Hmm::ViterbiDecoding::ActionSegment> segments;
+	std::vector<u32> nOutputFrames;
+	SegmentRecorder(const Hmm::ViterbiDecoding& _decoder) : decoder(_decoder) {}
+	virtual void fixedSegment(const Hmm::ViterbiDecoding::ActionSegment& segment) {
+		segments.push_back(segment);
+		nOutputFrames.push_back(decoder.framewiseRecognition().size());
+	}
+};
+
+TEST_F(Test, TestViterbiDecoding, partialTracebackListener)
+{
+	Hmm::ViterbiDecoding decoder;
+	decoder.initialize(true);
+	SegmentRecorder recorder(decoder);
+	decoder.setSegmentListener(&recorder);
+
+	// the frame scores clearly favor the transcript, so all but one hypothesis are pruned
+	u32 segmentLength = 1000;
+	std::vector<u32> transcript;
+	transcript.push_back(0);
+	transcript.push_back(1);
+	transcript.push_back(2);
+	transcript.push_back(1);
+	u32 T = transcript.size() * segmentLength;
+	Math::Matrix<Float> scores(3, T);
+	scores.fill(-100.0);
+	for (u32 t = 0; t < T; t++)
+		scores.at(transcript.at(t / segmentLength), t) = 0.0;
+
+	decoder.realign(scores, transcript);
+
+	EXPECT_EQ(transcript.size(), decoder.segmentation().size());
+	EXPECT_EQ(transcript.size(), recorder.segments.size());
+	for (u32 i = 0; i < transcript.size(); i++) {
+		EXPECT_EQ(transcript.at(i), recorder.segments.at(i).label);
+		EXPECT_EQ(segmentLength, recorder.segments.at(i).length);
+	}
+	// the first segment is passed during decoding, before the final traceback
+	EXPECT_LT(recorder.nOutputFrames.front(), T);
+	EXPECT_EQ(T, recorder.nOutputFrames.back());
+}
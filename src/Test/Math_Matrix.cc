@@ -375,3 +375,128 @@ TEST_F(Test, TestMatrix, elementwiseDivision)
 	EXPECT_EQ(A.at(1,1), (f32)-2);
 	EXPECT_EQ(A.at(1,2), (f32)-2);
 }
+
+TEST_F(Test, TestMatrix, externalMemory)
+{
+	f32 data[6] = { 0, 1, 2, 3, 4, 5 };
+	Math::Matrix<f32> A;
+	A.useExternalMemory(data, 3, 2);
+	EXPECT_FALSE(A.ownsMemory());
+	EXPECT_EQ(A.at(2,1), (f32)5);
+	// a copy owns its memory
+	Math::Matrix<f32> B(A);
+	EXPECT_TRUE(B.ownsMemory());
+	EXPECT_EQ(B.at(0,1), (f32)3);
+	// resizing detaches the matrix from the external memory
+	A.resize(3, 2);
+	EXPECT_TRUE(A.ownsMemory());
+	A.setToZero();
+	EXPECT_EQ(data[5], (f32)5);
+}
+
+TEST_F(Test, TestMatrix, gruForward)
+{
+	u32 nRows = 5, nColumns = 3;
+	Math::Matrix<f32> z(nRows, nColumns), r(nRows, nColumns), c(nRows, nColumns), u(nRows, nColumns), hPrev(nRows, nColumns);
+	for (u32 i = 0; i < nRows; i++) {
+		for (u32 j = 0; j < nColumns; j++) {
+			z.at(i,j) = 0.5 * i - 0.3 * j;
+			r.at(i,j) = 0.2 * j - 0.4 * i + 0.5;
+			c.at(i,j) = 0.7 * (i + j) - 2.0;
+			u.at(i,j) = 1.0 - 0.3 * i * j;
+			hPrev.at(i,j) = (j < 2 ? 0.1 * (i - j) : 0); // last column belongs to a sequence that starts at this timeframe
+		}
+	}
+	// composition of the single operations as in the gated recurrent unit layer
+	Math::Matrix<f32> zRef(z), rRef(r), cRef(c), hRef(nRows, nColumns);
+	zRef.sigmoid();
+	rRef.sigmoid();
+	hRef.copy(rRef);
+	hRef.elementwiseMultiplication(u);
+	cRef.add(hRef);
+	cRef.tanh();
+	hRef.copy(cRef);
+	hRef.add(hPrev, (f32)-1.0);
+	hRef.elementwiseMultiplication(zRef);
+	hRef.add(hPrev);
+	// fused kernel, with and without previous output
+	Math::Matrix<f32> h(nRows, nColumns), z0(z), r0(r), c0(c), h0(nRows, nColumns);
+	h.gruForward(z, r, c, u, &hPrev);
+	h0.gruForward(z0, r0, c0, u);
+	for (u32 i = 0; i < nRows; i++) {
+		for (u32 j = 0; j < nColumns; j++) {
+			EXPECT_DOUBLE_EQ(zRef.at(i,j), z.at(i,j), 0.000001);
+			EXPECT_DOUBLE_EQ(rRef.at(i,j), r.at(i,j), 0.000001);
+			EXPECT_DOUBLE_EQ(cRef.at(i,j), c.at(i,j), 0.000001);
+			EXPECT_DOUBLE_EQ(hRef.at(i,j), h.at(i,j), 0.000001);
+			EXPECT_DOUBLE_EQ(z0.at(i,j) * c0.at(i,j), h0.at(i,j), 0.000001);
+		}
+	}
+}
+
+TEST_F(Test, TestMatrix, gruBackward)
+{
+	u32 nRows = 5, nColumns = 3;
+	Math::Matrix<f32> z(nRows, nColumns), r(nRows, nColumns), c(nRows, nColumns), u(nRows, nColumns), dh(nRows, nColumns);
+	Math::Matrix<f32> hPrev(nRows, nColumns - 1); // previous timeframe has one sequence less
+	for (u32 i = 0; i < nRows; i++) {
+		for (u32 j = 0; j < nColumns; j++) {
+			z.at(i,j) = 0.1 + 0.15 * i;
+			r.at(i,j) = 0.9 - 0.1 * i - 0.1 * j;
+			c.at(i,j) = 0.3 * (i + j) - 0.9;
+			u.at(i,j) = 1.0 - 0.3 * i * j;
+			dh.at(i,j) = 0.2 * i - 0.5 * j + 0.1;
+			if (j < nColumns - 1)
+				hPrev.at(i,j) = 0.1 * (i - j);
+		}
+	}
+	// composition of the single operations as in the gated recurrent unit layer
+	Math::Matrix<f32> ezRef(nRows, nColumns), erRef(nRows, nColumns), ecRef(nRows, nColumns), euRef(nRows, nColumns);
+	ezRef.copy(c);
+	ezRef.safeResize(nRows, hPrev.nColumns());
+	ezRef.add(hPrev, (f32)-1.0);
+	ezRef.safeResize(nRows, nColumns);
+	ezRef.elementwiseMultiplicationWithSigmoidDerivative(z);
+	ezRef.elementwiseMultiplication(dh);
+	ecRef.copy(dh);
+	ecRef.elementwiseMultiplicationWithTanhDerivative(c);
+	ecRef.elementwiseMultiplication(z);
+	erRef.copy(ecRef);
+	erRef.elementwiseMultiplicationWithSigmoidDerivative(r);
+	erRef.elementwiseMultiplication(u);
+	euRef.copy(ecRef);
+	euRef.elementwiseMultiplication(r);
+	// fused kernel
+	Math::Matrix<f32> ez(nRows, nColumns), er(nRows, nColumns), ec(nRows, nColumns), eu(nRows, nColumns);
+	dh.gruBackward(z, r, c, u, &hPrev, ez, er, ec, eu);
+	for (u32 i = 0; i < nRows; i++) {
+		for (u32 j = 0; j < nColumns; j++) {
+			EXPECT_DOUBLE_EQ(ezRef.at(i,j), ez.at(i,j), 0.000001);
+			EXPECT_DOUBLE_EQ(erRef.at(i,j), er.at(i,j), 0.000001);
+			EXPECT_DOUBLE_EQ(ecRef.at(i,j), ec.at(i,j), 0.000001);
+			EXPECT_DOUBLE_EQ(euRef.at(i,j), eu.at(i,j), 0.000001);
+		}
+	}
+}
+
+TEST_F(Test, TestMatrix, labelTargets)
+{
+	Math::Matrix<f32> A(3,2);
+	A.at(0,0) = 0.5; A.at(1,0) = 0.25; A.at(2,0) = 0.25;
+	A.at(0,1) = 0.125; A.at(1,1) = 0.125; A.at(2,1) = 0.75;
+	Math::Vector<u32> labels(2);
+	labels.at(0) = 0; labels.at(1) = 1;
+	// same results as with the one-hot target matrix
+	Math::Matrix<f32> targets(3,2);
+	targets.setToZero();
+	targets.at(0,0) = 1; targets.at(1,1) = 1;
+	EXPECT_EQ(A.nClassificationErrors(targets), A.nClassificationErrors(labels));
+	EXPECT_EQ(1u, A.nClassificationErrors(labels));
+	EXPECT_DOUBLE_EQ(A.crossEntropyObjectiveFunction(targets), A.crossEntropyObjectiveFunction(labels), 0.00001);
+	EXPECT_DOUBLE_EQ((f32)(-std::log(0.5) - std::log(0.125)), A.crossEntropyObjectiveFunction(labels), 0.00001);
+	A.addKroneckerDelta(labels, -1.0f);
+	EXPECT_EQ((f32)-0.5, A.at(0,0));
+	EXPECT_EQ((f32)0.25, A.at(1,0));
+	EXPECT_EQ((f32)0.125, A.at(0,1));
+	EXPECT_EQ((f32)-0.875, A.at(1,1));
+}
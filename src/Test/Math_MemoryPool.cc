@@ -0,0 +1,80 @@
+/*
+ * Copyright 2016 Alexander Richard
+ *
+ * This file is part of Squirrel.
+ *
+ * Licensed under the Academic Free License 3.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * You should have received a copy of the License along with Squirrel.
+ * If not, see <https://opensource.org/licenses/AFL-3.0>.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ */
+
+#include <Test/UnitTest.hh>
+#include <Math/Matrix.hh>
+#include <Math/MemoryPool.hh>
+
+class TestMemoryPool : public Test::Fixture
+{
+public:
+	void setUp() {}
+	void tearDown() {}
+};
+
+TEST_F(Test, TestMemoryPool, sizeClasses)
+{
+	Math::MemoryPool& pool = Math::MemoryPool::hostPool();
+	EXPECT_TRUE(pool.isEnabled());
+	u64 nBytes = 0;
+	void* a = pool.allocate(100, &nBytes);
+	EXPECT_EQ(nBytes, (u64)256);
+	void* b = pool.allocate(1024, &nBytes);
+	EXPECT_EQ(nBytes, (u64)1024);
+	void* c = pool.allocate(1025, &nBytes);
+	EXPECT_EQ(nBytes, (u64)1280);
+	u64 nElements = 0;
+	f32* d = pool.allocate<f32>(1000, &nElements);
+	EXPECT_EQ(nElements, (u64)1024);
+	pool.release(a);
+	pool.release(b);
+	pool.release(c);
+	pool.release(d);
+}
+
+TEST_F(Test, TestMemoryPool, reuse)
+{
+	Math::MemoryPool& pool = Math::MemoryPool::hostPool();
+	void* a = pool.allocate(3000);
+	pool.release(a);
+	u64 nRawAllocations = pool.nRawAllocations();
+	// same size class
+	void* b = pool.allocate(2900);
+	EXPECT_EQ(a, b);
+	EXPECT_EQ(nRawAllocations, pool.nRawAllocations());
+	pool.release(b);
+}
+
+TEST_F(Test, TestMemoryPool, matrixResize)
+{
+	Math::MemoryPool& pool = Math::MemoryPool::hostPool();
+	// variable sized matrices, e.g. the time frames of sequence batches
+	u32 nColumns[] = { 7, 31, 2, 64, 17, 5 };
+	std::vector< Math::Matrix<f32> > matrices(6);
+	for (u32 i = 0; i < 6; i++)
+		matrices.at(i).resize(10, nColumns[i]);
+	for (u32 i = 0; i < 6; i++)
+		matrices.at(i).clear();
+	u64 nRawAllocations = pool.nRawAllocations();
+	// the same sizes in a different assignment to the matrices do not allocate new memory
+	for (u32 i = 0; i < 6; i++)
+		matrices.at(i).resize(10, nColumns[5 - i]);
+	EXPECT_EQ(nRawAllocations, pool.nRawAllocations());
+	// shrinking and growing within the size class does not even access the pool
+	u64 nRequests = pool.nRequests();
+	matrices.at(0).resize(10, 4);
+	matrices.at(0).resize(10, 5);
+	EXPECT_EQ(nRequests, pool.nRequests());
+}
@@ -0,0 +1,108 @@
+/*
+ * Copyright 2016 Alexander Richard
+ *
+ * This file is part of Squirrel.
+ *
+ * Licensed under the Academic Free License 3.0 (the "License").
+ * You may not use this file except in compliance with the License.
+ * You should have received a copy of the License along with Squirrel.
+ * If not, see <https://opensource.org/licenses/AFL-3.0>.
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ */
+
+#include <Test/UnitTest.hh>
+#include <Math/Matrix.hh>
+#include <Math/ReducedPrecision.hh>
+
+class TestReducedPrecision : public Test::Fixture
+{
+protected:
+	Math::Matrix<f32> weights_;
+	Math::Matrix<f32> input_;
+	Math::Matrix<f32> reference_;
+public:
+	void setUp();
+	void tearDown() {}
+};
+
+void TestReducedPrecision::setUp()
+{
+	weights_.resize(4, 3);
+	for (u32 j = 0; j < 3; j++) {
+		for (u32 i = 0; i < 4; i++)
+			weights_.at(i, j) = 0.1f * i - 0.25f * j + 0.05f;
+	}
+	input_.resize(4, 2);
+	for (u32 j = 0; j < 2; j++) {
+		for (u32 i = 0; i < 4; i++)
+			input_.at(i, j) = 0.5f * i - j;
+	}
+	reference_.resize(3, 2);
+	reference_.addMatrixProduct(weights_, input_, 0, 1, true, false);
+}
+
+TEST_F(Test, TestReducedPrecision, conversion)
+{
+	// exactly representable values
+	EXPECT_EQ(Math::bfloat16ToFloat(Math::floatToBfloat16(1.5f)), 1.5f);
+	EXPECT_EQ(Math::bfloat16ToFloat(Math::floatToBfloat16(-0.25f)), -0.25f);
+	EXPECT_EQ(Math::halfToFloat(Math::floatToHalf(1.5f)), 1.5f);
+	EXPECT_EQ(Math::halfToFloat(Math::floatToHalf(-0.25f)), -0.25f);
+	EXPECT_EQ(Math::halfToFloat(Math::floatToHalf(65504.0f)), 65504.0f);
+	EXPECT_EQ(Math::floatToHalf(1.0f), (u16)0x3c00);
+	// smallest subnormal half and overflow to infinity
+	EXPECT_EQ(Math::halfToFloat(Math::floatToHalf(5.9604645e-8f)), 5.9604645e-8f);
+	EXPECT_EQ(Math::floatToHalf(1e6f), (u16)0x7c00);
+	// round to nearest even: 1 + 2^-11 is exactly between 1 and the next half 1 + 2^-10
+	EXPECT_EQ(Math::floatToHalf(1.00048828125f), (u16)0x3c00);
+	EXPECT_EQ(Math::floatToHalf(1.001f), (u16)0x3c01);
+	EXPECT_EQ(Math::floatToBfloat16(1.00390625f), (u16)0x3f80);
+	// relative error of the conversion
+	EXPECT_DOUBLE_EQ(Math::bfloat16ToFloat(Math::floatToBfloat16(0.1f)), 0.1f, 0.1f / 256);
+	EXPECT_DOUBLE_EQ(Math::halfToFloat(Math::floatToHalf(0.1f)), 0.1f, 0.1f / 2048);
+}
+
+TEST_F(Test, TestReducedPrecision, halfPrecisionProduct)
+{
+	Math::ReducedPrecisionMatrix::Precision precisions[] = { Math::ReducedPrecisionMatrix::bfloat16, Math::ReducedPrecisionMatrix::float16 };
+	for (u32 p = 0; p < 2; p++) {
+		Math::ReducedPrecisionMatrix w;
+		w.set(weights_, precisions[p]);
+		EXPECT_EQ(w.nBytes(), (u64)24);
+		Math::Matrix<f32> y(3, 2);
+		y.fill(1.0);
+		w.addTransposedProduct(input_, y);
+		for (u32 j = 0; j < 2; j++) {
+			for (u32 i = 0; i < 3; i++)
+				EXPECT_DOUBLE_EQ(y.at(i, j), reference_.at(i, j) + 1.0f, 0.01);
+		}
+	}
+}
+
+TEST_F(Test, TestReducedPrecision, int8Product)
+{
+	Math::ReducedPrecisionMatrix w;
+	w.set(weights_, Math::ReducedPrecisionMatrix::int8);
+	EXPECT_EQ(w.nBytes(), (u64)(12 + 3 * sizeof(f32)));
+	// input scaled per column
+	Math::Matrix<f32> y(3, 2);
+	y.setToZero();
+	w.addTransposedProduct(input_, y);
+	for (u32 j = 0; j < 2; j++) {
+		for (u32 i = 0; i < 3; i++)
+			EXPECT_DOUBLE_EQ(y.at(i, j), reference_.at(i, j), 0.02);
+	}
+	// calibrated input scale
+	w.observeInput(input_);
+	w.finishCalibration();
+	EXPECT_DOUBLE_EQ(w.inputScale(), 1.5f / 127, 0.000001);
+	y.setToZero();
+	w.addTransposedProduct(input_, y);
+	for (u32 j = 0; j < 2; j++) {
+		for (u32 i = 0; i < 3; i++)
+			EXPECT_DOUBLE_EQ(y.at(i, j), reference_.at(i, j), 0.02);
+	}
+}
@@ -144,3 +144,50 @@ TEST_F(Test, TestVector, elementwiseMultiplication)
 	EXPECT_EQ(v.at(1), (f32)-8);
 	EXPECT_EQ(v.at(2), (f32)-20);
 }
+
+TEST_F(Test, TestVector, adamUpdate)
+{
+	Math::Vector<f64> p(3), g(3), m(3), v(3);
+	p.at(0) = 1.0; p.at(1) = -2.0; p.at(2) = 0.5;
+	g.at(0) = 0.5; g.at(1) = -4.0; g.at(2) = 0.0;
+	m.setToZero();
+	v.setToZero();
+	Math::Vector<f64> gradient(g);
+	// first step with bias correction reduces to p -= lr * g / (|g| + epsilon)
+	p.adamUpdate(g, m, v, 0.1, 0.9, 0.999, 0.0, 1.0 - 0.9, 1.0 - 0.999);
+	EXPECT_DOUBLE_EQ(p.at(0), 0.9, 0.0000001);
+	EXPECT_DOUBLE_EQ(p.at(1), -1.9, 0.0000001);
+	EXPECT_DOUBLE_EQ(m.at(1), -0.4, 0.0000001);
+	EXPECT_DOUBLE_EQ(v.at(1), 0.016, 0.0000001);
+	// the gradient is not modified
+	for (u32 i = 0; i < 3; i++)
+		EXPECT_EQ(g.at(i), gradient.at(i));
+	// gradient clipping and weight decay: g = clip(-4 + 0.5 * -1.9, -1, 1) = -1
+	p.adamUpdate(g, m, v, 0.1, 0.0, 0.0, 0.0, 1.0, 1.0, 0.5, 1.0);
+	EXPECT_DOUBLE_EQ(p.at(1), -1.8, 0.0000001);
+	EXPECT_DOUBLE_EQ(m.at(1), -1.0, 0.0000001);
+}
+
+TEST_F(Test, TestVector, rmspropAndAdagradUpdate)
+{
+	Math::Vector<f64> p(2), g(2), s(2);
+	p.at(0) = 1.0; p.at(1) = -1.0;
+	g.at(0) = 2.0; g.at(1) = -1.0;
+	s.setToZero();
+	p.rmspropUpdate(g, s, 0.1, 0.75, 0.0);
+	EXPECT_DOUBLE_EQ(s.at(0), 1.0, 0.0000001);
+	EXPECT_DOUBLE_EQ(s.at(1), 0.25, 0.0000001);
+	EXPECT_DOUBLE_EQ(p.at(0), 0.8, 0.0000001);
+	EXPECT_DOUBLE_EQ(p.at(1), -0.8, 0.0000001);
+	s.setToZero();
+	p.adagradUpdate(g, s, 0.1, 0.0);
+	p.adagradUpdate(g, s, 0.1, 0.0);
+	EXPECT_DOUBLE_EQ(s.at(0), 8.0, 0.0000001);
+	EXPECT_DOUBLE_EQ(p.at(0), 0.8 - 0.1 - 0.1 / std::sqrt(2.0), 0.0000001);
+	Math::Vector<f64> m(2);
+	m.setToZero();
+	p.momentumUpdate(g, m, 0.1, 0.5);
+	p.momentumUpdate(g, m, 0.1, 0.5);
+	EXPECT_DOUBLE_EQ(m.at(1), 0.15, 0.0000001);
+	EXPECT_DOUBLE_EQ(p.at(1), -0.8 + 0.1 + 0.1 / std::sqrt(2.0) + 0.25, 0.0000001);
+}
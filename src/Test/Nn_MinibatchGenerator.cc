@@ -91,6 +91,26 @@ TEST_F(Test, TestMinibatchGenerator, supervisedClassificationSingleToSingle) {
 	Core::Configuration::reset();
 }
 
+TEST_F(Test, TestMinibatchGenerator, labelTargetsSingleToSingle) {
+
+	Core::Configuration::setParameter("features.aligned-feature-reader.feature-cache", "input.vectors");
+	Core::Configuration::setParameter("features.aligned-feature-reader.label-cache", "labels-1.vectors");
+	Core::Configuration::setParameter("source-type", "single");
+	Core::Configuration::setParameter("target-type", "single");
+
+	Nn::MinibatchGenerator generator(Nn::supervised);
+	generator.initialize();
+	EXPECT_TRUE(generator.hasLabelTargets());
+	for (u32 batch = 0; batch < 3; batch++) {
+		generator.generateBatch(4);
+		EXPECT_EQ(4u, generator.targetLabels().size());
+		for (u32 col = 0; col < 4; col++)
+			EXPECT_EQ(batch * 4 + col, generator.targetLabels().at(col));
+	}
+
+	Core::Configuration::reset();
+}
+
 TEST_F(Test, TestMinibatchGenerator, supervisedRegressionSingleToSingle) {
 
 	Core::Configuration::setParameter("features.aligned-feature-reader.feature-cache", "input.vectors");
@@ -317,6 +337,37 @@ TEST_F(Test, TestMinibatchGenerator, supervisedClassificationSequenceToSequence)
 	Core::Configuration::reset();
 }
 
+TEST_F(Test, TestMinibatchGenerator, labelTargetsSequenceToSequence) {
+
+	Core::Configuration::setParameter("features.aligned-feature-reader.feature-cache", "input.sequences");
+	Core::Configuration::setParameter("features.aligned-feature-reader.label-cache", "labels-1.sequences");
+	Core::Configuration::setParameter("source-type", "sequence");
+	Core::Configuration::setParameter("target-type", "sequence");
+
+	Nn::MinibatchGenerator generator(Nn::supervised);
+	generator.initialize();
+	EXPECT_TRUE(generator.hasLabelTargets());
+
+	// the class indices are published in the same column order as the one-hot targets
+	generator.generateBatch(2);
+	EXPECT_EQ(4u, generator.targetLabelSequence().nTimeframes());
+	for (u32 t = 0; t < 4; t++)
+		EXPECT_EQ((t == 0 ? 1u : 2u), generator.targetLabelSequence().at(t).size());
+	EXPECT_EQ(3u, generator.targetLabelSequence().at(0).at(0));
+	for (u32 t = 1; t < 4; t++) {
+		EXPECT_EQ(t + 3, generator.targetLabelSequence().at(t).at(0));
+		EXPECT_EQ(t - 1, generator.targetLabelSequence().at(t).at(1));
+	}
+	// the one-hot targets are still available on request
+	EXPECT_EQ(4u, generator.targetSequenceBatch().nTimeframes());
+	for (u32 t = 0; t < 4; t++) {
+		for (u32 i = 0; i < generator.targetLabelSequence().at(t).size(); i++)
+			EXPECT_EQ(generator.targetLabelSequence().at(t).at(i), generator.targetSequenceBatch().at(t).argAbsMax(i));
+	}
+
+	Core::Configuration::reset();
+}
+
 TEST_F(Test, TestMinibatchGenerator, supervisedRegressionSequenceToSequence) {
 
 	Core::Configuration::setParameter("features.aligned-feature-reader.feature-cache", "input.sequences");
@@ -375,3 +426,186 @@ TEST_F(Test, TestMinibatchGenerator, supervisedRegressionSequenceToSequence) {
 
 	Core::Configuration::reset();
 }
+
+TEST_F(Test, TestMinibatchGenerator, prefetchedSingle) {
+
+	Core::Configuration::setParameter("features.aligned-feature-reader.feature-cache", "input.vectors");
+	Core::Configuration::setParameter("features.aligned-feature-reader.label-cache", "labels-1.vectors");
+	Core::Configuration::setParameter("source-type", "single");
+	Core::Configuration::setParameter("target-type", "single");
+	Core::Configuration::setParameter("prefetch-queue-depth", "2");
+
+	Nn::MinibatchGenerator generator(Nn::supervised);
+	generator.initialize();
+	EXPECT_EQ(2u, generator.prefetchQueueDepth());
+	generator.requestBatch(4);
+	generator.requestBatch(4);
+	EXPECT_EQ(2u, generator.nRequestedBatches());
+	u32 dataCount = 0;
+	for (u32 batch = 0; batch < 3; batch++) {
+		// third batch is requested implicitly
+		generator.generateBatch(4);
+		EXPECT_EQ(4u, generator.sourceBatch().nColumns());
+		EXPECT_EQ(4u, generator.targetBatch().nColumns());
+		for (u32 col = 0; col < generator.sourceBatch().nColumns(); col++) {
+			for (u32 d = 0; d < 3; d++) {
+				EXPECT_EQ((dataCount + col) * 3.0f + d, generator.sourceBatch().at(d, col));
+			}
+			for (u32 d = 0; d < 12; d++) {
+				EXPECT_EQ((dataCount + col == d ? 1.0f : 0.0f), generator.targetBatch().at(d, col));
+			}
+		}
+		dataCount += 4;
+		if (batch == 0)
+			generator.requestBatch(4);
+	}
+	EXPECT_EQ(0u, generator.nRequestedBatches());
+
+	Core::Configuration::reset();
+}
+
+TEST_F(Test, TestMinibatchGenerator, doubleBufferedSingle) {
+
+	Core::Configuration::setParameter("features.aligned-feature-reader.feature-cache", "input.vectors");
+	Core::Configuration::setParameter("features.aligned-feature-reader.label-cache", "labels-1.vectors");
+	Core::Configuration::setParameter("source-type", "single");
+	Core::Configuration::setParameter("target-type", "single");
+	Core::Configuration::setParameter("prefetch-queue-depth", "1");
+
+	Nn::MinibatchGenerator generator(Nn::supervised);
+	generator.initialize();
+	u32 dataCount = 0;
+	generator.generateBatch(4);
+	for (u32 batch = 0; batch < 3; batch++) {
+		// the next batch is filled while the current one is in use, so the current one must not change
+		generator.requestBatch(4);
+		EXPECT_EQ(4u, generator.sourceBatch().nColumns());
+		for (u32 col = 0; col < generator.sourceBatch().nColumns(); col++) {
+			for (u32 d = 0; d < 3; d++) {
+				EXPECT_EQ((dataCount + col) * 3.0f + d, generator.sourceBatch().at(d, col));
+			}
+			for (u32 d = 0; d < 12; d++) {
+				EXPECT_EQ((dataCount + col == d ? 1.0f : 0.0f), generator.targetBatch().at(d, col));
+			}
+		}
+		dataCount += 4;
+		generator.generateBatch(4);
+	}
+	EXPECT_EQ(0u, generator.nRequestedBatches());
+
+	Core::Configuration::reset();
+}
+
+TEST_F(Test, TestMinibatchGenerator, prefetchedSequenceToSequence) {
+
+	Core::Configuration::setParameter("features.aligned-feature-reader.feature-cache", "input.sequences");
+	Core::Configuration::setParameter("features.aligned-feature-reader.target-cache", "targets-1.sequences");
+	Core::Configuration::setParameter("source-type", "sequence");
+	Core::Configuration::setParameter("target-type", "sequence");
+	Core::Configuration::setParameter("prefetch-queue-depth", "2");
+
+	Nn::MinibatchGenerator generator(Nn::supervised);
+	generator.initialize();
+	generator.requestBatch(2);
+	generator.requestBatch(2);
+
+	generator.generateBatch(2);
+	EXPECT_EQ(4u, generator.sourceSequenceBatch().nTimeframes());
+	EXPECT_EQ(4u, generator.targetSequenceBatch().nTimeframes());
+	for (u32 d = 0; d < 3; d++) {
+		EXPECT_EQ(9.0f + d, generator.sourceSequenceBatch().at(0).at(d, 0));
+		for (u32 t = 1; t < 4; t++) {
+			EXPECT_EQ((t+3) * 3.0f + d, generator.sourceSequenceBatch().at(t).at(d, 0));
+			EXPECT_EQ((t-1) * 3.0f + d, generator.sourceSequenceBatch().at(t).at(d, 1));
+		}
+	}
+	for (u32 d = 0; d < 2; d++) {
+		EXPECT_EQ(6.0f + d, generator.targetSequenceBatch().at(0).at(d, 0));
+		for (u32 t = 1; t < 4; t++) {
+			EXPECT_EQ((t+3) * 2.0f + d, generator.targetSequenceBatch().at(t).at(d, 0));
+			EXPECT_EQ((t-1) * 2.0f + d, generator.targetSequenceBatch().at(t).at(d, 1));
+		}
+	}
+
+	generator.generateBatch(2);
+	EXPECT_EQ(5u, generator.sourceSequenceBatch().nTimeframes());
+	EXPECT_EQ(5u, generator.targetSequenceBatch().nTimeframes());
+	for (u32 d = 0; d < 3; d++) {
+		EXPECT_EQ(21.0f + d, generator.sourceSequenceBatch().at(0).at(d, 0));
+		EXPECT_EQ(24.0f + d, generator.sourceSequenceBatch().at(1).at(d, 0));
+		for (u32 t = 2; t < 5; t++) {
+			EXPECT_EQ((t+7) * 3.0f + d, generator.sourceSequenceBatch().at(t).at(d, 0));
+			EXPECT_EQ((t-2) * 3.0f + d, generator.sourceSequenceBatch().at(t).at(d, 1));
+		}
+	}
+	for (u32 d = 0; d < 2; d++) {
+		EXPECT_EQ(14.0f + d, generator.targetSequenceBatch().at(0).at(d, 0));
+		EXPECT_EQ(16.0f + d, generator.targetSequenceBatch().at(1).at(d, 0));
+		for (u32 t = 2; t < 5; t++) {
+			EXPECT_EQ((t+7) * 2.0f + d, generator.targetSequenceBatch().at(t).at(d, 0));
+			EXPECT_EQ((t-2) * 2.0f + d, generator.targetSequenceBatch().at(t).at(d, 1));
+		}
+	}
+
+	Core::Configuration::reset();
+}
+
+TEST_F(Test, TestMinibatchGenerator, frameBudgetSequenceBatch) {
+
+	Core::Configuration::setParameter("features.feature-reader.feature-cache", "input.sequences");
+	Core::Configuration::setParameter("source-type", "sequence");
+	Core::Configuration::setParameter("max-batch-frames", "8");
+
+	Nn::MinibatchGenerator generator(Nn::unsupervised);
+	generator.initialize();
+
+	// sequences of length 3 and 4 fit into the budget of 8 frames
+	generator.generateBatch(2);
+	EXPECT_EQ(2u, generator.batchSize());
+	EXPECT_EQ(4u, generator.sourceSequenceBatch().nTimeframes());
+
+	// the sequence of length 5 and the (next) sequence of length 3 need 10 frames
+	generator.generateBatch(2);
+	EXPECT_EQ(1u, generator.batchSize());
+	EXPECT_EQ(5u, generator.sourceSequenceBatch().nTimeframes());
+	EXPECT_EQ(1u, generator.sourceSequenceBatch().at(0).nColumns());
+	EXPECT_EQ(21.0f, generator.sourceSequenceBatch().at(0).at(0, 0));
+
+	generator.generateBatch(2);
+	EXPECT_EQ(2u, generator.batchSize());
+	EXPECT_EQ(4u, generator.sourceSequenceBatch().nTimeframes());
+	EXPECT_EQ(9.0f, generator.sourceSequenceBatch().at(0).at(0, 0));
+
+	Core::Configuration::reset();
+}
+
+TEST_F(Test, TestMinibatchGenerator, bucketedSequenceToSequence) {
+
+	Core::Configuration::setParameter("features.aligned-feature-reader.feature-cache", "input.sequences");
+	Core::Configuration::setParameter("features.aligned-feature-reader.target-cache", "targets-1.sequences");
+	Core::Configuration::setParameter("features.aligned-feature-reader.buffer-size", "3");
+	Core::Configuration::setParameter("features.aligned-feature-reader.bucket-size", "3");
+	Core::Configuration::setParameter("source-type", "sequence");
+	Core::Configuration::setParameter("target-type", "sequence");
+
+	Nn::MinibatchGenerator generator(Nn::supervised);
+	generator.initialize();
+
+	// a single bucket: sequences are read from long to short, targets are reordered accordingly
+	for (u32 epoch = 0; epoch < 2; epoch++) {
+		generator.generateBatch(1);
+		EXPECT_EQ(5u, generator.sourceSequenceBatch().nTimeframes());
+		EXPECT_EQ(21.0f, generator.sourceSequenceBatch().at(0).at(0, 0));
+		EXPECT_EQ(14.0f, generator.targetSequenceBatch().at(0).at(0, 0));
+		generator.generateBatch(1);
+		EXPECT_EQ(4u, generator.sourceSequenceBatch().nTimeframes());
+		EXPECT_EQ(9.0f, generator.sourceSequenceBatch().at(0).at(0, 0));
+		EXPECT_EQ(6.0f, generator.targetSequenceBatch().at(0).at(0, 0));
+		generator.generateBatch(1);
+		EXPECT_EQ(3u, generator.sourceSequenceBatch().nTimeframes());
+		EXPECT_EQ(0.0f, generator.sourceSequenceBatch().at(0).at(0, 0));
+		EXPECT_EQ(0.0f, generator.targetSequenceBatch().at(0).at(0, 0));
+	}
+
+	Core::Configuration::reset();
+}
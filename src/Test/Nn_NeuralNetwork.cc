@@ -154,3 +154,75 @@ TEST_F(Test, TestNeuralNetwork, forwardSequence) {
 	delete network;
 	Core::Configuration::reset();
 }
+
+TEST_F(Test, TestNeuralNetwork, parameterArena)
+{
+	Nn::NeuralNetwork* network = configureRecurrentNetwork();
+	network->initialize(2);
+	modifyRecurrentNetwork(network);
+
+	// two biases and four weight matrices, biases first
+	EXPECT_EQ(network->nParameterBlocks(), 6u);
+	EXPECT_EQ(network->nBiasBlocks(), 2u);
+	u32 size = 0;
+	for (u32 h = 0; h < network->nParameterBlocks(); h++) {
+		const Nn::ParameterBlock& b = network->parameterBlock(h);
+		EXPECT_EQ(b.offset, size);
+		EXPECT_EQ(b.isBias, (h < 2));
+		size += b.size();
+	}
+	EXPECT_EQ(network->parameters().nRows(), size);
+
+	// biases and weights are views on the arena
+	for (u32 l = 0; l < 2; l++) {
+		const Nn::ParameterBlock& b = network->parameterBlock(network->biasHandle(l, 0));
+		for (u32 i = 0; i < network->layer(l).bias(0).nRows(); i++)
+			EXPECT_EQ(network->parameters().at(b.offset + i), network->layer(l).bias(0).at(i));
+	}
+	for (u32 c = 0; c < network->nConnections(); c++) {
+		const Nn::ParameterBlock& b = network->parameterBlock(network->weightsHandle(c));
+		Nn::Matrix& w = network->connection(c).weights();
+		for (u32 i = 0; i < w.nRows(); i++) {
+			for (u32 j = 0; j < w.nColumns(); j++)
+				EXPECT_EQ(network->parameters().at(b.offset + j * w.nRows() + i), w.at(i,j));
+		}
+	}
+
+	// an update of the arena is an update of the parameters
+	network->initComputation();
+	network->parameters().scale(2.0);
+	network->finishComputation();
+	EXPECT_EQ(network->layer(0).weights(0,0).at(1,1), (Float)-6.0);
+	EXPECT_EQ(network->layer(0).bias(0).at(1), (Float)14.0);
+	EXPECT_EQ(network->layer(1).bias(0).at(2), (Float)-2.0);
+
+	delete network;
+	Core::Configuration::reset();
+}
+
+TEST_F(Test, TestNeuralNetwork, shareParameters)
+{
+	Nn::NeuralNetwork* network = configureRecurrentNetwork();
+	network->initialize(2);
+	modifyRecurrentNetwork(network);
+	Nn::NeuralNetwork* replica = configureRecurrentNetwork();
+	replica->initialize(2);
+	replica->shareParameters(*network);
+
+	// the replica sees the parameters of the network
+	EXPECT_EQ(replica->parameters().begin(), network->parameters().begin());
+	EXPECT_EQ(replica->layer(0).weights(0,0).at(1,1), network->layer(0).weights(0,0).at(1,1));
+	EXPECT_EQ(replica->layer(1).bias(0).at(2), network->layer(1).bias(0).at(2));
+
+	// an update via the replica is an update of the network
+	replica->initComputation();
+	replica->parameters().scale(2.0);
+	replica->finishComputation();
+	EXPECT_EQ(network->layer(0).weights(0,0).at(1,1), (Float)-6.0);
+	EXPECT_EQ(network->layer(0).bias(0).at(1), (Float)14.0);
+	EXPECT_EQ(replica->layer(1).bias(0).at(2), (Float)-2.0);
+
+	delete replica;
+	delete network;
+	Core::Configuration::reset();
+}
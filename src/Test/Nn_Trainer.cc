@@ -24,6 +24,7 @@
 #include <Nn/GradientBasedTrainer.hh>
 #include <Nn/Types.hh>
 #include "Nn_TestHelpers.hh"
+#include <math.h>
 
 using namespace std;
 
@@ -32,6 +33,8 @@ class TestNnTrainer : public Test::Fixture
 public:
 	void setUp();
 	void tearDown();
+	void rnnGradients(bool timeBatchedForwarding, bool sequenceTargets, std::vector<Float>& result);
+	void compareTimeBatchedGradients(bool sequenceTargets);
 };
 
 void TestNnTrainer::setUp() {
@@ -112,6 +115,58 @@ TEST_F(Test, TestNnTrainer, CrossEntropyFeedForwardTrainer_processBatch) {
 	Core::Configuration::reset();
 }
 
+TEST_F(Test, TestNnTrainer, SteepestDescentEstimatorWithMomentum) {
+
+	Core::Configuration::setParameter("trainer", "feed-forward-trainer");
+	Core::Configuration::setParameter("training-criterion", "cross-entropy");
+	Core::Configuration::setParameter("trainer.model-update-strategy", "after-epoch");
+	Core::Configuration::setParameter("trainer.epoch-length", "100");
+	Core::Configuration::setParameter("trainer.task", "classification");
+	Core::Configuration::setParameter("estimator.method", "steepest-descent");
+	Core::Configuration::setParameter("estimator.use-momentum", "true");
+	Core::Configuration::setParameter("estimator.momentum", "0.5");
+	Core::Configuration::setParameter("estimator.bias-weight", "0.5");
+	Core::Configuration::setParameter("learning-rate-schedule.initial-learning-rate", "0.1");
+	// dummy caches (not used, just for proper initialization)
+	Core::Configuration::setParameter("features.aligned-feature-reader.feature-cache", "input.vectors");
+	Core::Configuration::setParameter("features.aligned-feature-reader.target-cache", "labels-1.vectors");
+	Core::Configuration::setParameter("source-type", "single");
+	Core::Configuration::setParameter("target-type", "single");
+
+	Nn::Matrix input(2,2);
+	input.at(0,0) = -2;
+	input.at(1,0) = 0.5;
+	input.at(0,1) = 2;
+	input.at(1,1) = 0;
+	Nn::Matrix targets(3,2);
+	targets.initComputation();
+	targets.setToZero();
+	targets.finishComputation();
+	targets.at(0,0) = 1.0;
+	targets.at(2,1) = 1.0;
+
+	Nn::NeuralNetwork* dummy = configureFeedForwardNetwork(); // set config parameters
+	delete dummy;
+	Nn::FeedForwardTrainer* trainer = new Nn::FeedForwardTrainer();
+
+	trainer->initialize();
+	modifyFeedForwardNetwork(&(trainer->network()));
+	Float w0 = trainer->network().layer(0).weights(0,0).at(0,0);
+	Float b0 = trainer->network().layer(0).bias(0).at(0);
+	trainer->processBatch(input, targets);
+	trainer->statistics().normalize();
+	// two updates with the same gradient: p = p0 - learningRate * factor * (1 + (1 + momentum)) * gradient
+	trainer->estimator().estimate(trainer->network(), trainer->statistics());
+	trainer->estimator().estimate(trainer->network(), trainer->statistics());
+	trainer->network().finishComputation();
+
+	EXPECT_DOUBLE_EQ(trainer->network().layer(0).weights(0,0).at(0,0), (f32)(w0 - 0.1 * 2.5 * -0.09243551), 0.000001);
+	EXPECT_DOUBLE_EQ(trainer->network().layer(0).bias(0).at(0), (f32)(b0 - 0.1 * 0.5 * 2.5 * 0.07776014), 0.000001);
+
+	delete trainer;
+	Core::Configuration::reset();
+}
+
 TEST_F(Test, TestNnTrainer, CrossEntropyRnnTrainer_processSequenceBatch) {
 
 	Core::Configuration::setParameter("trainer", "rnn-trainer");
@@ -225,3 +280,121 @@ TEST_F(Test, TestNnTrainer, CrossEntropyRnnTrainer_processSequenceBatch) {
 	delete trainer;
 	Core::Configuration::reset();
 }
+
+/*
+ * network with two non-recurrent layers below a recurrent layer and a connection from the bottom to the output layer,
+ * returns the objective function and all gradients after processing a batch of three sequences of different length
+ */
+void TestNnTrainer::rnnGradients(bool timeBatchedForwarding, bool sequenceTargets, std::vector<Float>& result) {
+	Core::Configuration::setParameter("trainer", "rnn-trainer");
+	Core::Configuration::setParameter("training-criterion", "cross-entropy");
+	Core::Configuration::setParameter("trainer.model-update-strategy", "after-epoch");
+	Core::Configuration::setParameter("trainer.epoch-length", "100");
+	Core::Configuration::setParameter("trainer.task", "classification");
+	Core::Configuration::setParameter("estimator.method", "steepest-descent");
+	// dummy caches (not used, just for proper initialization)
+	Core::Configuration::setParameter("features.aligned-feature-reader.feature-cache", "input.sequences");
+	Core::Configuration::setParameter("features.aligned-feature-reader.target-cache", (sequenceTargets ? "labels-1.sequences" : "labels-2.vectors"));
+	Core::Configuration::setParameter("source-type", "sequence");
+	Core::Configuration::setParameter("target-type", (sequenceTargets ? "sequence" : "single"));
+	Core::Configuration::setParameter("neural-network.input-dimension", "2");
+	Core::Configuration::setParameter("neural-network.connections", "conn-0-1,conn-1-2,conn-2-3,conn-3-3,conn-3-4,conn-1-4");
+	Core::Configuration::setParameter("neural-network.conn-0-1.from", "network-input");
+	Core::Configuration::setParameter("neural-network.conn-0-1.to", "layer-1");
+	Core::Configuration::setParameter("neural-network.conn-1-2.from", "layer-1");
+	Core::Configuration::setParameter("neural-network.conn-1-2.to", "layer-2");
+	Core::Configuration::setParameter("neural-network.conn-2-3.from", "layer-2");
+	Core::Configuration::setParameter("neural-network.conn-2-3.to", "layer-3");
+	Core::Configuration::setParameter("neural-network.conn-3-3.from", "layer-3");
+	Core::Configuration::setParameter("neural-network.conn-3-3.to", "layer-3");
+	Core::Configuration::setParameter("neural-network.conn-3-4.from", "layer-3");
+	Core::Configuration::setParameter("neural-network.conn-3-4.to", "layer-4");
+	Core::Configuration::setParameter("neural-network.conn-1-4.from", "layer-1");
+	Core::Configuration::setParameter("neural-network.conn-1-4.to", "layer-4");
+	Core::Configuration::setParameter("neural-network.layer-1.type", "rectified");
+	Core::Configuration::setParameter("neural-network.layer-1.number-of-units", "4");
+	Core::Configuration::setParameter("neural-network.layer-2.type", "sigmoid");
+	Core::Configuration::setParameter("neural-network.layer-2.number-of-units", "3");
+	Core::Configuration::setParameter("neural-network.layer-3.type", "tanh");
+	Core::Configuration::setParameter("neural-network.layer-3.number-of-units", "2");
+	Core::Configuration::setParameter("neural-network.layer-4.type", "softmax");
+	Core::Configuration::setParameter("neural-network.layer-4.number-of-units", "3");
+	Core::Configuration::setParameter("neural-network.time-batched-forwarding", (timeBatchedForwarding ? "true" : "false"));
+
+	// three sequences of length 1, 2, and 3
+	u32 nColumns[] = { 1, 2, 3 };
+	Nn::MatrixContainer inputSequence;
+	inputSequence.setMaximalMemory(3);
+	Nn::MatrixContainer targetSequence;
+	targetSequence.setMaximalMemory(3);
+	Nn::Matrix targets(3, 3);
+	targets.initComputation();
+	targets.setToZero();
+	targets.finishComputation();
+	for (u32 t = 0; t < 3; t++) {
+		inputSequence.addTimeframe(2, nColumns[t]);
+		targetSequence.addTimeframe(3, nColumns[t]);
+		for (u32 i = 0; i < nColumns[t]; i++) {
+			inputSequence.getLast().at(0, i) = sin(1.0 + t + 2.0 * i);
+			inputSequence.getLast().at(1, i) = cos(0.5 * t - i);
+			for (u32 j = 0; j < 3; j++)
+				targetSequence.getLast().at(j, i) = ((t + i) % 3 == j ? 1.0 : 0.0);
+		}
+	}
+	for (u32 i = 0; i < 3; i++)
+		targets.at(i % 2, i) = 1.0;
+
+	Nn::RnnTrainer* trainer = new Nn::RnnTrainer();
+	trainer->initialize();
+	Nn::NeuralNetwork& network = trainer->network();
+	network.finishComputation();
+	for (u32 l = 0; l < network.nLayer(); l++) {
+		for (u32 i = 0; i < network.layer(l).nIncomingConnections(0); i++) {
+			Nn::Matrix& W = network.layer(l).weights(i, 0);
+			for (u32 row = 0; row < W.nRows(); row++)
+				for (u32 column = 0; column < W.nColumns(); column++)
+					W.at(row, column) = sin(1.0 + l + 2.0 * i + 3.0 * row + 5.0 * column);
+		}
+		for (u32 j = 0; j < network.layer(l).bias(0).nRows(); j++)
+			network.layer(l).bias(0).at(j) = 0.1 * cos(l + 2.0 * j);
+	}
+	if (sequenceTargets)
+		trainer->processSequenceBatch(inputSequence, targetSequence);
+	else
+		trainer->processSequenceBatch(inputSequence, targets);
+	trainer->statistics().finishComputation();
+
+	result.clear();
+	result.push_back(trainer->statistics().objectiveFunction());
+	for (u32 c = 0; c < network.nConnections(); c++) {
+		Nn::Matrix& gradient = trainer->statistics().weightsGradient(network.connection(c).name());
+		for (u32 row = 0; row < gradient.nRows(); row++)
+			for (u32 column = 0; column < gradient.nColumns(); column++)
+				result.push_back(gradient.at(row, column));
+	}
+	for (u32 l = 0; l < network.nLayer(); l++) {
+		Nn::Vector& gradient = trainer->statistics().biasGradient(network.layer(l).name(), 0);
+		for (u32 j = 0; j < gradient.nRows(); j++)
+			result.push_back(gradient.at(j));
+	}
+	delete trainer;
+	Core::Configuration::reset();
+}
+
+void TestNnTrainer::compareTimeBatchedGradients(bool sequenceTargets) {
+	std::vector<Float> reference;
+	std::vector<Float> timeBatched;
+	rnnGradients(false, sequenceTargets, reference);
+	rnnGradients(true, sequenceTargets, timeBatched);
+	EXPECT_EQ(reference.size(), timeBatched.size());
+	for (u32 i = 0; i < reference.size(); i++)
+		EXPECT_DOUBLE_EQ(reference.at(i), timeBatched.at(i), 0.000001);
+}
+
+TEST_F(Test, TestNnTrainer, RnnTrainer_timeBatchedForwarding) {
+	compareTimeBatchedGradients(false);
+}
+
+TEST_F(Test, TestNnTrainer, RnnTrainer_timeBatchedForwardingSequenceTargets) {
+	compareTimeBatchedGradients(true);
+}